@@ -0,0 +1,134 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "benchcamera.h"
+
+#include <QSize>
+#include <QPair>
+#include <string.h>
+
+using namespace cs;
+using namespace cs::parameter;
+
+BenchCamera::BenchCamera(const BenchDataGenerator& generator)
+{
+    const QSize resolution = generator.getResolution();
+
+    m_paras[PARA_HAS_DEPTH] = true;
+    m_paras[PARA_HAS_RGB] = true;
+    m_paras[PARA_DEPTH_HAS_IR] = false;
+    m_paras[PARA_TRIGGER_MODE] = (int)TRIGGER_MODE_OFF;
+
+    m_paras[PARA_DEPTH_STREAM_FORMAT] = (int)STREAM_FORMAT_Z16;
+    m_paras[PARA_DEPTH_RESOLUTION] = resolution;
+    m_paras[PARA_DEPTH_RANGE] = QVariant::fromValue(QPair<float, float>({ BENCH_DEPTH_RANGE_MIN, BENCH_DEPTH_RANGE_MAX }));
+    m_paras[PARA_DEPTH_FILTER_TYPE] = (int)FILTER_CLOSE;
+    m_paras[PARA_DEPTH_FILTER] = 0;
+    m_paras[PARA_DEPTH_FILL_HOLE] = false;
+    m_paras[PARA_DEPTH_SCALE] = generator.getDepthScale();
+    m_paras[PARA_DEPTH_INTRINSICS] = QVariant::fromValue(generator.getDepthIntrinsics());
+
+    m_paras[PARA_RGB_STREAM_FORMAT] = (int)STREAM_FORMAT_RGB8;
+    m_paras[PARA_RGB_RESOLUTION] = resolution;
+    m_paras[PARA_RGB_INTRINSICS] = QVariant::fromValue(generator.getRgbIntrinsics());
+    m_paras[PARA_EXTRINSICS] = QVariant::fromValue(generator.getExtrinsics());
+}
+
+bool BenchCamera::startStream()
+{
+    return true;
+}
+
+bool BenchCamera::stopStream()
+{
+    return true;
+}
+
+bool BenchCamera::restartStream()
+{
+    return true;
+}
+
+bool BenchCamera::restartCamera()
+{
+    return true;
+}
+
+bool BenchCamera::disconnectCamera()
+{
+    return true;
+}
+
+bool BenchCamera::reconnectCamera()
+{
+    return true;
+}
+
+bool BenchCamera::pauseStream()
+{
+    return true;
+}
+
+bool BenchCamera::resumeStream()
+{
+    return true;
+}
+
+bool BenchCamera::softTrigger()
+{
+    return true;
+}
+
+CSCameraInfo BenchCamera::getCameraInfo() const
+{
+    CSCameraInfo info;
+    memset(&info.cameraInfo, 0, sizeof(info.cameraInfo));
+    strncpy(info.cameraInfo.name, "Bench", sizeof(info.cameraInfo.name) - 1);
+    info.model = "Bench";
+    info.connectType = CONNECT_TYPE_USB;
+
+    return info;
+}
+
+int BenchCamera::getCameraState() const
+{
+    return CAMERA_STARTED_STREAM;
+}
+
+void BenchCamera::getCameraPara(CAMERA_PARA_ID paraId, QVariant& value)
+{
+    value = m_paras.value(paraId);
+}
+
+void BenchCamera::setCameraPara(CAMERA_PARA_ID paraId, QVariant value)
+{
+    m_paras[paraId] = value;
+}
+
+void BenchCamera::getCameraParaRange(CAMERA_PARA_ID paraId, QVariant& min, QVariant& max, QVariant& step)
+{
+    Q_UNUSED(paraId);
+    min = max = step = QVariant();
+}
+
+void BenchCamera::getCameraParaItems(CAMERA_PARA_ID paraId, QList<QPair<QString, QVariant>>& list)
+{
+    Q_UNUSED(paraId);
+    list.clear();
+}
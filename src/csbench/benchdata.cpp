@@ -0,0 +1,276 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "benchdata.h"
+
+#include <QRandomGenerator>
+#include <QtMath>
+#include <vector>
+#include <string.h>
+
+using namespace cs;
+
+#define FRAME_RATE      30.0
+#define DEPTH_SCALE     0.1f
+// the focal length is a ratio of the width, so all the resolutions have the same field of view
+#define FOCAL_RATIO     0.8f
+// the distance between the depth and RGB cameras, mm
+#define RGB_BASELINE    25.0f
+
+static Intrinsics genIntrinsics(int width, int height)
+{
+    Intrinsics intrinsics;
+    memset(&intrinsics, 0, sizeof(intrinsics));
+
+    intrinsics.width = width;
+    intrinsics.height = height;
+    intrinsics.fx = width * FOCAL_RATIO;
+    intrinsics.fy = width * FOCAL_RATIO;
+    intrinsics.cx = width / 2.0f;
+    intrinsics.cy = height / 2.0f;
+    intrinsics.one22 = 1.0f;
+
+    return intrinsics;
+}
+
+static void fillRect(std::vector<float>& depth, int width, int height, int left, int top, int right, int bottom)
+{
+    for (int y = qMax(0, top); y < qMin(height, bottom); y++)
+    {
+        for (int x = qMax(0, left); x < qMin(width, right); x++)
+        {
+            depth[y * width + x] = 0.0f;
+        }
+    }
+}
+
+static void fillCircle(std::vector<float>& depth, int width, int height, int centerX, int centerY, int radius)
+{
+    for (int y = qMax(0, centerY - radius); y <= qMin(height - 1, centerY + radius); y++)
+    {
+        for (int x = qMax(0, centerX - radius); x <= qMin(width - 1, centerX + radius); x++)
+        {
+            const int dx = x - centerX;
+            const int dy = y - centerY;
+            if (dx * dx + dy * dy <= radius * radius)
+            {
+                depth[y * width + x] = 0.0f;
+            }
+        }
+    }
+}
+
+FrameData BenchFrame::toFrameData(const Intrinsics& depthIntrinsics, const Intrinsics& rgbIntrinsics
+    , const Extrinsics& extrinsics, float depthScale) const
+{
+    FrameData frameData;
+    frameData.depthIntrinsics = depthIntrinsics;
+    frameData.rgbIntrinsics = rgbIntrinsics;
+    frameData.extrinsics = extrinsics;
+    frameData.depthScale = depthScale;
+
+    StreamData depthData;
+    depthData.dataInfo = { TYPE_DEPTH, STREAM_FORMAT_Z16, width, height, timeStamp };
+    depthData.data = depth;
+    frameData.data.push_back(depthData);
+
+    StreamData rgbData;
+    rgbData.dataInfo = { TYPE_RGB, STREAM_FORMAT_RGB8, width, height, timeStamp };
+    rgbData.data = rgb;
+    frameData.data.push_back(rgbData);
+
+    return frameData;
+}
+
+BenchDataGenerator::BenchDataGenerator(QSize resolution, quint32 seed)
+    : m_resolution(resolution)
+    , m_seed(seed)
+    , m_depthScale(DEPTH_SCALE)
+{
+    m_depthIntrinsics = genIntrinsics(resolution.width(), resolution.height());
+    m_rgbIntrinsics = m_depthIntrinsics;
+
+    memset(&m_extrinsics, 0, sizeof(m_extrinsics));
+    m_extrinsics.rotation[0] = 1.0f;
+    m_extrinsics.rotation[4] = 1.0f;
+    m_extrinsics.rotation[8] = 1.0f;
+    m_extrinsics.translation[0] = -RGB_BASELINE;
+}
+
+BenchFrame BenchDataGenerator::genFrame(int index) const
+{
+    BenchFrame frame;
+    frame.width = m_resolution.width();
+    frame.height = m_resolution.height();
+    frame.timeStamp = index * 1000.0 / FRAME_RATE;
+
+    genDepth(index, frame);
+    genRgb(index, frame);
+
+    return frame;
+}
+
+QSize BenchDataGenerator::getResolution() const
+{
+    return m_resolution;
+}
+
+Intrinsics BenchDataGenerator::getDepthIntrinsics() const
+{
+    return m_depthIntrinsics;
+}
+
+Intrinsics BenchDataGenerator::getRgbIntrinsics() const
+{
+    return m_rgbIntrinsics;
+}
+
+Extrinsics BenchDataGenerator::getExtrinsics() const
+{
+    return m_extrinsics;
+}
+
+float BenchDataGenerator::getDepthScale() const
+{
+    return m_depthScale;
+}
+
+void BenchDataGenerator::genDepth(int index, BenchFrame& frame) const
+{
+    const int width = frame.width;
+    const int height = frame.height;
+    QRandomGenerator random(m_seed + index * 7919);
+
+    // the sphere moves horizontally, so the time domain filter sees changes
+    const float sphereX = width * (0.5f + 0.1f * qSin(index * 0.3f));
+    const float sphereY = height * 0.5f;
+    const float radius = height * 0.2f;
+    const float shadowRadius = radius * 1.15f;
+
+    std::vector<float> depth(width * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            // the wall, mm
+            float z = 900.0f + 300.0f * (y - height * 0.5f) / height + 40.0f * qSin(2.0f * M_PI * 3.0f * x / width);
+
+            const float dx = x - sphereX;
+            const float dy = y - sphereY;
+            const float distance2 = dx * dx + dy * dy;
+            if (distance2 < radius * radius)
+            {
+                z = 600.0f - 150.0f * qSqrt(1.0f - distance2 / (radius * radius));
+            }
+            else if (dx > 0 && distance2 < shadowRadius * shadowRadius)
+            {
+                // the wall is occluded from one of the stereo cameras
+                z = 0.0f;
+            }
+
+            if (x < width * 0.04f)
+            {
+                // the invalid band at the left border
+                z = 0.0f;
+            }
+            else if (z > 0.0f && x > width * 0.85f && y < height * 0.15f)
+            {
+                // a far region which is out of the depth range
+                z = 2500.0f;
+            }
+
+            if (z > 0.0f)
+            {
+                // the noise grows with the square of the depth, the sum of 4 uniforms is nearly gaussian
+                const float sigma = 0.4f + z * z * 1.5e-6f;
+                float gauss = -2.0f;
+                for (int i = 0; i < 4; i++)
+                {
+                    gauss += (float)random.generateDouble();
+                }
+                z += sigma * gauss * 1.7320508f;
+            }
+
+            depth[y * width + x] = z;
+        }
+    }
+
+    // large dark patches, they are too large to be filled
+    const int patchWidth = qMax(1, (int)(width * 0.08f));
+    const int patchHeight = qMax(1, (int)(height * 0.06f));
+    for (int i = 0; i < 3; i++)
+    {
+        const int left = random.bounded(width);
+        const int top = random.bounded(height);
+        fillRect(depth, width, height, left, top, left + patchWidth, top + patchHeight);
+    }
+
+    // small holes which are filled by the fill hole filter
+    const int holeCount = width * height / 5000;
+    for (int i = 0; i < holeCount; i++)
+    {
+        fillCircle(depth, width, height, random.bounded(width), random.bounded(height), 1 + random.bounded(4));
+    }
+
+    // single pixel dropouts
+    const int dropoutCount = width * height / 100;
+    for (int i = 0; i < dropoutCount; i++)
+    {
+        depth[random.bounded(width * height)] = 0.0f;
+    }
+
+    frame.depth.resize(width * height * sizeof(ushort));
+    ushort* depthPtr = (ushort*)frame.depth.data();
+    for (int i = 0; i < width * height; i++)
+    {
+        depthPtr[i] = (ushort)qBound(0, qRound(depth[i] / m_depthScale), 65535);
+    }
+}
+
+void BenchDataGenerator::genRgb(int index, BenchFrame& frame) const
+{
+    const int width = frame.width;
+    const int height = frame.height;
+    QRandomGenerator random(m_seed ^ (0x9E3779B9u + index));
+
+    frame.rgb.resize(width * height * 3);
+    uchar* rgbPtr = (uchar*)frame.rgb.data();
+
+    // a moving checkerboard with shading and sensor noise
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const bool dark = (((x + index * 2) / 32 + y / 32) & 1) != 0;
+            const float base = dark ? 70.0f : 190.0f;
+
+            const float colors[3] =
+            {
+                base * (0.6f + 0.4f * x / width),
+                base,
+                base * (1.0f - 0.4f * y / height)
+            };
+
+            for (int c = 0; c < 3; c++)
+            {
+                *rgbPtr++ = (uchar)qBound(0, qRound(colors[c]) + random.bounded(-6, 7), 255);
+            }
+        }
+    }
+}
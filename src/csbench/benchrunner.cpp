@@ -0,0 +1,179 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "benchrunner.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <algorithm>
+#include <stdio.h>
+
+using namespace cs;
+
+#define WARMUP_ITERATIONS   2
+#define MIN_ITERATIONS      5
+#define MAX_ITERATIONS      100000
+
+QJsonObject BenchResult::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["width"] = resolution.width();
+    object["height"] = resolution.height();
+    object["iterations"] = times.size();
+    object["frames"] = frames * times.size();
+
+    if (times.isEmpty())
+    {
+        return object;
+    }
+
+    QVector<qint64> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (auto time : sorted)
+    {
+        total += time;
+    }
+
+    // the times of a frame
+    const double medianNs = (double)sorted.at(sorted.size() / 2) / frames;
+    const double minNs = (double)sorted.first() / frames;
+    const double meanNs = total / sorted.size() / frames;
+    const double pixels = (double)resolution.width() * resolution.height();
+
+    object["medianNs"] = qRound64(medianNs);
+    object["minNs"] = qRound64(minNs);
+    object["meanNs"] = qRound64(meanNs);
+
+    if (medianNs > 0.0)
+    {
+        object["nsPerPixel"] = (pixels > 0.0) ? medianNs / pixels : 0.0;
+        // bytes per ns to MB per second
+        object["mbPerSecond"] = bytes * 1000.0 / medianNs;
+        object["framesPerSecond"] = 1.0e9 / medianNs;
+    }
+
+    return object;
+}
+
+BenchRunner::BenchRunner(const BenchOptions& options)
+    : m_options(options)
+{
+
+}
+
+const BenchOptions& BenchRunner::getOptions() const
+{
+    return m_options;
+}
+
+bool BenchRunner::isEnabled(QString name) const
+{
+    return !m_options.filter.isValid() || m_options.filter.pattern().isEmpty() || m_options.filter.match(name).hasMatch();
+}
+
+void BenchRunner::run(QString name, QSize resolution, qint64 bytes, std::function<void()> func, std::function<void()> prepare)
+{
+    if (!isEnabled(name))
+    {
+        return;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.resolution = resolution;
+    result.bytes = bytes;
+
+    for (int i = 0; i < WARMUP_ITERATIONS; i++)
+    {
+        if (prepare)
+        {
+            prepare();
+        }
+        func();
+    }
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    QElapsedTimer timer;
+    while (result.times.size() < MAX_ITERATIONS
+        && (result.times.size() < MIN_ITERATIONS || totalTimer.elapsed() < m_options.minTimeMs))
+    {
+        if (prepare)
+        {
+            prepare();
+        }
+
+        timer.start();
+        func();
+        result.times.push_back(timer.nsecsElapsed());
+    }
+
+    addResult(result);
+}
+
+void BenchRunner::addResult(const BenchResult& result)
+{
+    m_results.push_back(result);
+
+    // stdout is used by the report, the progress is written to stderr
+    const QJsonObject object = result.toJson();
+    fprintf(stderr, "%-40s %5dx%-5d %12.3f ms/frame %10.2f frames/s\n", result.name.toLocal8Bit().constData()
+        , result.resolution.width(), result.resolution.height()
+        , object["medianNs"].toDouble() / 1.0e6, object["framesPerSecond"].toDouble());
+}
+
+QJsonObject BenchRunner::genReport() const
+{
+    QJsonObject report;
+    report["tool"] = "cscamera_bench";
+    report["version"] = APP_VERSION;
+    report["qtVersion"] = qVersion();
+    report["os"] = QSysInfo::prettyProductName();
+    report["cpuArchitecture"] = QSysInfo::currentCpuArchitecture();
+    report["threads"] = QThread::idealThreadCount();
+#ifdef _OPENMP
+    report["openmp"] = true;
+#else
+    report["openmp"] = false;
+#endif
+#ifdef QT_DEBUG
+    report["debug"] = true;
+#else
+    report["debug"] = false;
+#endif
+    report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["seed"] = (qint64)m_options.seed;
+    report["minTimeMs"] = m_options.minTimeMs;
+
+    QJsonArray results;
+    for (const auto& result : m_results)
+    {
+        results.append(result.toJson());
+    }
+    report["results"] = results;
+
+    return report;
+}
@@ -0,0 +1,488 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "benchsuite.h"
+#include "benchcamera.h"
+
+#include <QDebug>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QThread>
+#include <string.h>
+#include <vector>
+
+#include "imageutil.h"
+#include "cameracapturetool.h"
+#include "capturedzipparser.h"
+#include "capturerecordwriter.h"
+#include "process/processor.h"
+#include "process/depthpreprocessstrategy.h"
+#include "process/depthprocessstrategy.h"
+#include "process/rgbpreprocessstrategy.h"
+#include "process/rgbprocessstrategy.h"
+#include "process/pointcloudprocessstrategy.h"
+#include "process/depthspatialfilter.h"
+#include "process/timedomainsmooth.h"
+#include "process/depthcolorizer.h"
+#include "process/fillhole.h"
+
+using namespace cs;
+using namespace cs::parameter;
+
+// the frames of each resolution, the time domain filter, the processor and the capture cycle through them
+#define BENCH_FRAME_COUNT       8
+#define TIME_DOMAIN_WINDOW      5
+// the frames added to the capture but not saved yet, less than the cached frames of the capture, so no frame is dropped
+#define MAX_PENDING_FRAMES      16
+
+namespace cs
+{
+struct StrategyConfig
+{
+    QString name;
+    QVector<QPair<int, QVariant>> paras;
+};
+
+// the windows shown in the viewer, the strategies are enabled as CSApplication does
+struct ProcessorLayout
+{
+    QString name;
+    bool depth;
+    bool rgb;
+    bool pointCloud;
+};
+}
+
+BenchInput::BenchInput(const BenchDataGenerator& dataGenerator)
+    : generator(dataGenerator)
+    , resolution(dataGenerator.getResolution())
+    , pixelCount(resolution.width() * resolution.height())
+{
+    for (int i = 0; i < BENCH_FRAME_COUNT; i++)
+    {
+        BenchFrame frame = generator.genFrame(i);
+        frameDatas.push_back(frame.toFrameData(generator.getDepthIntrinsics(), generator.getRgbIntrinsics()
+            , generator.getExtrinsics(), generator.getDepthScale()));
+
+        QByteArray floatDepth(pixelCount * sizeof(float), 0);
+        const ushort* depthPtr = (const ushort*)frame.depth.constData();
+        float* floatPtr = (float*)floatDepth.data();
+        for (int j = 0; j < pixelCount; j++)
+        {
+            floatPtr[j] = depthPtr[j];
+        }
+        floatDepths.push_back(floatDepth);
+
+        QImage image((const uchar*)frame.rgb.constData(), frame.width, frame.height, frame.width * 3, QImage::Format_RGB888);
+        rgbImages.push_back(image.copy());
+
+        frames.push_back(frame);
+    }
+}
+
+BenchSuite::BenchSuite(BenchRunner& runner)
+    : m_runner(runner)
+{
+
+}
+
+void BenchSuite::run()
+{
+    const BenchOptions& options = m_runner.getOptions();
+    for (auto resolution : options.resolutions)
+    {
+        qInfo() << "generate the inputs, resolution:" << resolution;
+
+        BenchDataGenerator generator(resolution, options.seed);
+        BenchInput input(generator);
+
+        benchKernels(input);
+        benchStrategies(input);
+        benchProcessor(input);
+
+        benchCapture(input, "images", false);
+        benchCapture(input, "raw", false);
+        benchCapture(input, "rvl", false);
+        benchCapture(input, "rvl", true);
+    }
+}
+
+void BenchSuite::benchKernels(const BenchInput& input)
+{
+    const QSize resolution = input.resolution;
+    const int width = resolution.width();
+    const int height = resolution.height();
+    const int pixelCount = input.pixelCount;
+    const qint64 depthBytes = pixelCount * sizeof(ushort);
+    const qint64 floatBytes = pixelCount * sizeof(float);
+    const QByteArray& depth = input.frames.first().depth;
+    const QByteArray& floatDepth = input.floatDepths.first();
+    const float depthScale = input.generator.getDepthScale();
+
+    // the filters work in place, the input is restored before every iteration
+    std::vector<ushort> depthBuffer(pixelCount);
+    std::vector<float> floatBuffer(pixelCount);
+    auto copyDepth = [&]()
+    {
+        memcpy(depthBuffer.data(), depth.constData(), depthBytes);
+    };
+    auto copyFloatDepth = [&]()
+    {
+        memcpy(floatBuffer.data(), floatDepth.constData(), floatBytes);
+    };
+
+    DepthFillHole fillHole;
+    m_runner.run("fillHole.u16", resolution, depthBytes, [&]() { fillHole.process(depthBuffer.data(), width, height); }, copyDepth);
+    m_runner.run("fillHole.f32", resolution, floatBytes, [&]() { fillHole.process(floatBuffer.data(), width, height); }, copyFloatDepth);
+
+    DepthSpatialFilter spatialFilter;
+    for (int size : { 3, 7 })
+    {
+        m_runner.run(QString("spatialFilter.average%1").arg(size), resolution, floatBytes
+            , [&]() { spatialFilter.averageBlur(floatBuffer.data(), width, height, size); }, copyFloatDepth);
+    }
+
+    for (int size : { 3, 5, 7 })
+    {
+        m_runner.run(QString("spatialFilter.median%1").arg(size), resolution, floatBytes
+            , [&]() { spatialFilter.medianBlur(floatBuffer.data(), width, height, size); }, copyFloatDepth);
+    }
+
+    TimeDomainSmooth timeDomainSmooth;
+    int frameIndex = 0;
+    m_runner.run(QString("timeDomainSmooth.window%1").arg(TIME_DOMAIN_WINDOW), resolution, floatBytes
+        , [&]() { timeDomainSmooth.process(floatBuffer.data(), width, height, TIME_DOMAIN_WINDOW); }
+        , [&]()
+        {
+            const QByteArray& data = input.floatDepths.at(frameIndex++ % input.floatDepths.size());
+            memcpy(floatBuffer.data(), data.constData(), floatBytes);
+        });
+
+    // the kernels below do not change the input
+    copyDepth();
+    copyFloatDepth();
+
+    std::vector<uchar> rgbBuffer(pixelCount * 3);
+
+    cs::colorizer colorizer;
+    colorizer.setRange(BENCH_DEPTH_RANGE_MIN, BENCH_DEPTH_RANGE_MAX);
+    m_runner.run("colorizer.u16", resolution, depthBytes
+        , [&]() { colorizer.process(depthBuffer.data(), depthScale, rgbBuffer.data(), pixelCount); });
+    m_runner.run("colorizer.f32", resolution, floatBytes
+        , [&]() { colorizer.process(floatBuffer.data(), depthScale, rgbBuffer.data(), pixelCount); });
+
+    DepthColorizer depthColorizer;
+    depthColorizer.setRange(BENCH_DEPTH_RANGE_MIN, BENCH_DEPTH_RANGE_MAX);
+    m_runner.run("depthColorizer.u16", resolution, depthBytes
+        , [&]() { depthColorizer.process(depthBuffer.data(), depthScale, rgbBuffer.data(), width, height); });
+    m_runner.run("depthColorizer.f32", resolution, floatBytes
+        , [&]() { depthColorizer.process(floatBuffer.data(), depthScale, rgbBuffer.data(), width, height); });
+
+    Intrinsics depthIntrinsics = input.generator.getDepthIntrinsics();
+    Intrinsics rgbIntrinsics = input.generator.getRgbIntrinsics();
+    Extrinsics extrinsics = input.generator.getExtrinsics();
+
+    cs::Pointcloud pointCloud;
+    m_runner.run("pointCloud.generatePoints", resolution, floatBytes, [&]() 
+        {
+            pointCloud.generatePoints<float>(floatBuffer.data(), width, height, depthScale, &depthIntrinsics, nullptr, nullptr, true);
+        });
+    m_runner.run("pointCloud.generatePoints.texture", resolution, floatBytes, [&]()
+        {
+            pointCloud.generatePoints<float>(floatBuffer.data(), width, height, depthScale, &depthIntrinsics, &rgbIntrinsics, &extrinsics, true);
+        });
+
+    // the PNG data to decode is encoded once, the encoding may be filtered out
+    QByteArray pngData;
+    if (!ImageUtil::genPngDataFromGrayScale16(width, height, depth, pngData))
+    {
+        qWarning() << "encode png data failed.";
+        return;
+    }
+
+    QByteArray encodedData;
+    m_runner.run("png.encode16", resolution, depthBytes, [&]() { ImageUtil::genPngDataFromGrayScale16(width, height, depth, encodedData); });
+
+    QByteArray pixData;
+    m_runner.run("png.decode16", resolution, depthBytes, [&]()
+        {
+            int decodedWidth, decodedHeight, bitDepth;
+            ImageUtil::genPixDataFromPngData(pngData, decodedWidth, decodedHeight, bitDepth, pixData);
+        });
+}
+
+void BenchSuite::benchStrategies(const BenchInput& input)
+{
+    const qint64 depthBytes = input.pixelCount * sizeof(ushort);
+    const qint64 floatBytes = input.pixelCount * sizeof(float);
+    const qint64 rgbBytes = input.pixelCount * 3;
+
+    // the depth preprocess with the filters of the viewer
+    const QVector<StrategyConfig> configs =
+    {
+        { "strategy.depthPreprocess", {} },
+        { "strategy.depthPreprocess.fillHole", { { PARA_DEPTH_FILL_HOLE, true } } },
+        { "strategy.depthPreprocess.smooth5", { { PARA_DEPTH_FILTER_TYPE, (int)FILTER_SMOOTH }, { PARA_DEPTH_FILTER, 5 } } },
+        { "strategy.depthPreprocess.median5", { { PARA_DEPTH_FILTER_TYPE, (int)FILTER_MEDIAN }, { PARA_DEPTH_FILTER, 5 } } },
+        { QString("strategy.depthPreprocess.timeDomain%1").arg(TIME_DOMAIN_WINDOW)
+            , { { PARA_DEPTH_FILTER_TYPE, (int)FILTER_TDSMOOTH }, { PARA_DEPTH_FILTER, TIME_DOMAIN_WINDOW } } },
+    };
+
+    for (const auto& config : configs)
+    {
+        DepthPreprocessStrategy strategy;
+        strategy.setCamera(genCamera(input, config.paras));
+        benchStrategy(input, config.name, &strategy, depthBytes, false, false);
+    }
+
+    std::shared_ptr<ICSCamera> camera = genCamera(input);
+    {
+        DepthProcessStrategy strategy;
+        strategy.setCamera(camera);
+        benchStrategy(input, "strategy.depth", &strategy, floatBytes, true, false);
+    }
+
+    {
+        RgbPreprocessStrategy strategy;
+        strategy.setCamera(camera);
+        benchStrategy(input, "strategy.rgbPreprocess", &strategy, rgbBytes, false, false);
+    }
+
+    {
+        RgbProcessStrategy strategy;
+        strategy.setCamera(camera);
+        benchStrategy(input, "strategy.rgb", &strategy, rgbBytes, false, true);
+    }
+
+    {
+        // with texture, the camera has RGB
+        PointCloudProcessStrategy strategy;
+        strategy.setCamera(camera);
+        benchStrategy(input, "strategy.pointCloud", &strategy, floatBytes + rgbBytes, true, true);
+    }
+}
+
+void BenchSuite::benchProcessor(const BenchInput& input)
+{
+    const QVector<ProcessorLayout> layouts =
+    {
+        { "processor.depth", true, false, false },
+        { "processor.rgb", false, true, false },
+        { "processor.pointCloud", false, false, true },
+        { "processor.depth+rgb", true, true, false },
+        { "processor.depth+pointCloud", true, false, true },
+        { "processor.rgb+pointCloud", false, true, true },
+        { "processor.depth+rgb+pointCloud", true, true, true },
+    };
+
+    std::shared_ptr<ICSCamera> camera = genCamera(input);
+
+    DepthPreprocessStrategy depthPreprocess;
+    DepthProcessStrategy depth;
+    RgbPreprocessStrategy rgbPreprocess;
+    RgbProcessStrategy rgb;
+    PointCloudProcessStrategy pointCloud;
+
+    // destroyed before the strategies
+    Processor processor;
+    for (ProcessStrategy* strategy : QVector<ProcessStrategy*>({ &pointCloud, &depth, &depthPreprocess, &rgb, &rgbPreprocess }))
+    {
+        strategy->setCamera(camera);
+        processor.addProcessStrategy(strategy);
+    }
+
+    for (const auto& layout : layouts)
+    {
+        depthPreprocess.setStrategyEnable(layout.depth || layout.pointCloud);
+        depth.setStrategyEnable(layout.depth);
+        rgbPreprocess.setStrategyEnable(layout.rgb || layout.pointCloud);
+        rgb.setStrategyEnable(layout.rgb);
+        pointCloud.setStrategyEnable(layout.pointCloud);
+
+        int frameIndex = 0;
+        m_runner.run(layout.name, input.resolution, input.pixelCount * (sizeof(ushort) + 3), [&]()
+            {
+                processor.process(input.frameDatas.at(frameIndex++ % input.frameDatas.size()));
+            });
+    }
+}
+
+void BenchSuite::benchCapture(const BenchInput& input, QString format, bool recordFile)
+{
+    const QString suffix = recordFile ? format + ".record" : format;
+    const QString saveName = "capture.save." + suffix;
+    const QString loadName = "capture.load." + suffix;
+    if (!m_runner.isEnabled(saveName) && !m_runner.isEnabled(loadName))
+    {
+        return;
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+    {
+        qWarning() << "create temporary directory failed:" << dir.errorString();
+        return;
+    }
+
+    CameraCaptureConfig config;
+    config.captureType = CAPTURE_TYPE_MULTIPLE;
+    config.captureNumber = m_runner.getOptions().captureFrames;
+    config.captureDataTypes = { CAMERA_DATA_DEPTH, CAMERA_DATA_RGB };
+    config.saveFormat = format;
+    config.saveRecordFile = recordFile;
+    config.saveDir = dir.path();
+    config.saveName = "bench";
+
+    QVector<OutputDataPort> outputDataPorts;
+    for (int i = 0; i < input.frameDatas.size(); i++)
+    {
+        outputDataPorts.push_back(genOutputDataPort(input, i, true, true));
+    }
+
+    std::shared_ptr<ICSCamera> camera = genCamera(input);
+    CameraCaptureMultiple capture(config);
+    capture.setCamera(camera);
+
+    // the signals are emitted in the capture thread
+    QAtomicInt savedCount(0);
+    QAtomicInt droppedCount(0);
+    QAtomicInt failed(0);
+    QObject::connect(&capture, &CameraCaptureBase::captureNumberUpdated, [&](int captured, int dropped)
+        {
+            savedCount.storeRelease(captured);
+            droppedCount.storeRelease(dropped);
+        });
+    QObject::connect(&capture, &CameraCaptureBase::captureStateChanged, [&](int captureType, int state, QString message)
+        {
+            Q_UNUSED(captureType);
+            if (state == CAPTURE_ERROR)
+            {
+                qWarning() << "capture failed:" << message;
+                failed.storeRelease(1);
+            }
+        });
+
+    QElapsedTimer timer;
+    timer.start();
+    capture.start();
+
+    // add the frames as fast as the capture saves them
+    int addedCount = 0;
+    while (addedCount < config.captureNumber && !capture.isFinished())
+    {
+        if (addedCount - savedCount.loadAcquire() - droppedCount.loadAcquire() < MAX_PENDING_FRAMES)
+        {
+            capture.addOutputData(outputDataPorts.at(addedCount % outputDataPorts.size()));
+            addedCount++;
+        }
+        else
+        {
+            QThread::usleep(100);
+        }
+    }
+
+    capture.wait();
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    if (failed.loadAcquire() || savedCount.loadAcquire() != config.captureNumber)
+    {
+        qWarning() << saveName << "failed, saved frames:" << savedCount.loadAcquire();
+        return;
+    }
+
+    const qint64 frameBytes = input.pixelCount * (sizeof(ushort) + 3);
+    if (m_runner.isEnabled(saveName))
+    {
+        BenchResult result;
+        result.name = saveName;
+        result.resolution = input.resolution;
+        result.bytes = frameBytes;
+        result.frames = config.captureNumber;
+        result.times.push_back(elapsed);
+        m_runner.addResult(result);
+    }
+
+    const QString filePath = config.saveDir + "/" + config.saveName + (recordFile ? RECORD_FILE_SUFFIX : ".zip");
+    CapturedZipParser parser(filePath);
+    if (!parser.checkFileValid() || !parser.parseCaptureInfo() || parser.getFrameCount() <= 0)
+    {
+        qWarning() << "parse the captured file failed:" << filePath;
+        return;
+    }
+
+    // read and decode the depth and RGB of a frame
+    const int frameCount = parser.getFrameCount();
+    int frameIndex = 0;
+    QByteArray pixData;
+    m_runner.run(loadName, input.resolution, frameBytes, [&]()
+        {
+            const int index = frameIndex++ % frameCount;
+            for (int dataType : { CAMERA_DATA_DEPTH, CAMERA_DATA_RGB })
+            {
+                const QByteArray data = parser.getFrameData(index, dataType);
+                if (!parser.decodeFrameData(dataType, data, pixData))
+                {
+                    qWarning() << "decode frame data failed, frame:" << index << ", data type:" << dataType;
+                }
+            }
+        });
+}
+
+void BenchSuite::benchStrategy(const BenchInput& input, QString name, ProcessStrategy* strategy, qint64 bytes, bool withDepth, bool withRgb)
+{
+    int frameIndex = 0;
+    OutputDataPort outputDataPort;
+
+    // the port is filled as the preprocess strategies do, a new port is used for every frame
+    m_runner.run(name, input.resolution, bytes
+        , [&]() { strategy->process(input.frameDatas.at(frameIndex), outputDataPort); }
+        , [&]()
+        {
+            frameIndex = (frameIndex + 1) % input.frameDatas.size();
+            outputDataPort = genOutputDataPort(input, frameIndex, withDepth, withRgb);
+        });
+}
+
+std::shared_ptr<ICSCamera> BenchSuite::genCamera(const BenchInput& input, const QVector<QPair<int, QVariant>>& paras)
+{
+    std::shared_ptr<ICSCamera> camera = std::make_shared<BenchCamera>(input.generator);
+    for (const auto& para : paras)
+    {
+        camera->setCameraPara((CAMERA_PARA_ID)para.first, para.second);
+    }
+
+    return camera;
+}
+
+OutputDataPort BenchSuite::genOutputDataPort(const BenchInput& input, int frameIndex, bool withDepth, bool withRgb)
+{
+    OutputDataPort outputDataPort(input.frameDatas.at(frameIndex));
+    if (withDepth)
+    {
+        outputDataPort.setDepthData(input.floatDepths.at(frameIndex));
+    }
+
+    if (withRgb)
+    {
+        outputDataPort.setRgbImage(input.rgbImages.at(frameIndex));
+    }
+
+    return outputDataPort;
+}
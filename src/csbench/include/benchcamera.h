@@ -0,0 +1,62 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_BENCHCAMERA_H
+#define _CS_BENCHCAMERA_H
+
+#include <QMap>
+#include <QVariant>
+
+#include "icscamera.h"
+#include "benchdata.h"
+
+namespace cs
+{
+
+// A camera without device, it provides the parameters of the synthetic frames to the process strategies
+// and the capture. The parameters can be changed to run the strategies with different settings.
+class BenchCamera : public ICSCamera
+{
+    Q_OBJECT
+public:
+    BenchCamera(const BenchDataGenerator& generator);
+
+    bool startStream() override;
+    bool stopStream() override;
+    bool restartStream() override;
+    bool restartCamera() override;
+    bool disconnectCamera() override;
+    bool reconnectCamera() override;
+    bool pauseStream() override;
+    bool resumeStream() override;
+    bool softTrigger() override;
+    CSCameraInfo getCameraInfo() const override;
+    int getCameraState() const override;
+
+    void getCameraPara(CAMERA_PARA_ID paraId, QVariant& value) override;
+    void setCameraPara(CAMERA_PARA_ID paraId, QVariant value) override;
+    void getCameraParaRange(CAMERA_PARA_ID paraId, QVariant& min, QVariant& max, QVariant& step) override;
+    void getCameraParaItems(CAMERA_PARA_ID paraId, QList<QPair<QString, QVariant>>& list) override;
+private:
+    QMap<int, QVariant> m_paras;
+};
+
+}
+
+#endif // _CS_BENCHCAMERA_H
@@ -0,0 +1,82 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_BENCHDATA_H
+#define _CS_BENCHDATA_H
+
+#include <QByteArray>
+#include <QSize>
+
+#include "cstypes.h"
+
+// the depth range of the synthetic scene, mm
+#define BENCH_DEPTH_RANGE_MIN   50.0f
+#define BENCH_DEPTH_RANGE_MAX   2000.0f
+
+namespace cs
+{
+
+// a frame of the synthetic scene, the depth and RGB have the same resolution
+struct BenchFrame
+{
+    int width = 0;
+    int height = 0;
+    // 16 bits depth codes, 0 is invalid
+    QByteArray depth;
+    // RGB888
+    QByteArray rgb;
+    double timeStamp = 0.0;
+
+    int pixelCount() const { return width * height; }
+    FrameData toFrameData(const Intrinsics& depthIntrinsics, const Intrinsics& rgbIntrinsics
+        , const Extrinsics& extrinsics, float depthScale) const;
+};
+
+// Generates the deterministic inputs of the benchmarks: a wavy wall behind a moving sphere.
+// The depth has the defects of a stereo camera: an invalid band at the left border, the occlusion shadow 
+// beside the sphere, large dark patches, small holes which can be filled, single pixel dropouts,
+// a far region out of the depth range and noise which grows with the depth.
+// The same seed generates the same frames on every platform.
+class BenchDataGenerator
+{
+public:
+    BenchDataGenerator(QSize resolution, quint32 seed);
+
+    BenchFrame genFrame(int index) const;
+
+    QSize getResolution() const;
+    Intrinsics getDepthIntrinsics() const;
+    Intrinsics getRgbIntrinsics() const;
+    Extrinsics getExtrinsics() const;
+    float getDepthScale() const;
+private:
+    void genDepth(int index, BenchFrame& frame) const;
+    void genRgb(int index, BenchFrame& frame) const;
+private:
+    QSize m_resolution;
+    quint32 m_seed;
+    Intrinsics m_depthIntrinsics;
+    Intrinsics m_rgbIntrinsics;
+    Extrinsics m_extrinsics;
+    float m_depthScale;
+};
+
+}
+
+#endif // _CS_BENCHDATA_H
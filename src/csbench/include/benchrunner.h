@@ -0,0 +1,84 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_BENCHRUNNER_H
+#define _CS_BENCHRUNNER_H
+
+#include <QString>
+#include <QSize>
+#include <QVector>
+#include <QRegularExpression>
+#include <QJsonObject>
+#include <functional>
+
+namespace cs
+{
+
+struct BenchOptions
+{
+    QVector<QSize> resolutions;
+    // only the benchmarks whose names match the filter are run
+    QRegularExpression filter;
+    // the minimum time of a benchmark, ms
+    int minTimeMs = 500;
+    // the frames of a capture benchmark
+    int captureFrames = 30;
+    quint32 seed = 0;
+};
+
+struct BenchResult
+{
+    QString name;
+    QSize resolution;
+    // the input bytes of a frame
+    qint64 bytes = 0;
+    // the frames of an iteration
+    int frames = 1;
+    // the time of every iteration, ns
+    QVector<qint64> times;
+
+    QJsonObject toJson() const;
+};
+
+// Runs the benchmarks and collects the results.
+// A benchmark is warmed up first, then it is run until both the minimum time and the minimum iterations are reached.
+// The median time of the iterations is used for ns/pixel, MB/s and frames/s, the minimum and mean are reported too.
+class BenchRunner
+{
+public:
+    BenchRunner(const BenchOptions& options);
+
+    const BenchOptions& getOptions() const;
+    bool isEnabled(QString name) const;
+
+    // prepare is called before every iteration, it's not timed
+    void run(QString name, QSize resolution, qint64 bytes, std::function<void()> func
+        , std::function<void()> prepare = std::function<void()>());
+    // add a result timed by the caller
+    void addResult(const BenchResult& result);
+
+    QJsonObject genReport() const;
+private:
+    BenchOptions m_options;
+    QVector<BenchResult> m_results;
+};
+
+}
+
+#endif // _CS_BENCHRUNNER_H
@@ -0,0 +1,80 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_BENCHSUITE_H
+#define _CS_BENCHSUITE_H
+
+#include <QVector>
+#include <QSize>
+#include <QPair>
+#include <QVariant>
+#include <memory>
+
+#include "benchdata.h"
+#include "benchrunner.h"
+#include "process/outputdataport.h"
+
+namespace cs
+{
+
+class ICSCamera;
+class ProcessStrategy;
+
+// the inputs of the benchmarks of a resolution
+struct BenchInput
+{
+    BenchInput(const BenchDataGenerator& dataGenerator);
+
+    BenchDataGenerator generator;
+    QSize resolution;
+    int pixelCount;
+    QVector<BenchFrame> frames;
+    QVector<FrameData> frameDatas;
+    // float depth of the frames, as the depth preprocess strategy outputs when the filters are closed
+    QVector<QByteArray> floatDepths;
+    // RGB888 images of the frames, as the rgb preprocess strategy outputs
+    QVector<QImage> rgbImages;
+};
+
+// The benchmarks of cscamera, they are run at every resolution of the options:
+// the kernels, every process strategy, the processor with every combination of the strategies, 
+// and the capture of the frames to files and the parsing of the captured files.
+class BenchSuite
+{
+public:
+    BenchSuite(BenchRunner& runner);
+
+    void run();
+private:
+    void benchKernels(const BenchInput& input);
+    void benchStrategies(const BenchInput& input);
+    void benchProcessor(const BenchInput& input);
+    void benchCapture(const BenchInput& input, QString format, bool recordFile);
+
+    // withDepth and withRgb add the outputs of the preprocess strategies to the port
+    void benchStrategy(const BenchInput& input, QString name, ProcessStrategy* strategy, qint64 bytes, bool withDepth, bool withRgb);
+    std::shared_ptr<ICSCamera> genCamera(const BenchInput& input, const QVector<QPair<int, QVariant>>& paras = QVector<QPair<int, QVariant>>());
+    OutputDataPort genOutputDataPort(const BenchInput& input, int frameIndex, bool withDepth, bool withRgb);
+private:
+    BenchRunner& m_runner;
+};
+
+}
+
+#endif // _CS_BENCHSUITE_H
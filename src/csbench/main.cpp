@@ -0,0 +1,190 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QFile>
+#include <QDebug>
+#include <stdio.h>
+#include <cstracer.h>
+
+#include "benchrunner.h"
+#include "benchsuite.h"
+
+#define APP_NAME "cscamera_bench"
+
+// exit codes
+#define EXIT_CODE_SUCCESS       0
+#define EXIT_CODE_FAILED        1
+#define EXIT_CODE_INVALID_ARGS  2
+
+#define DEFAULT_RESOLUTIONS     "640x400,1280x800,1920x1080"
+#define DEFAULT_MIN_TIME        "500"
+#define DEFAULT_CAPTURE_FRAMES  "30"
+#define DEFAULT_SEED            "1"
+
+static bool verboseLog = false;
+
+// stdout is used by the report, the logs are written to stderr
+static void myMessageOutput(QtMsgType type, const QMessageLogContext& context, const QString& msg)
+{
+    if (!verboseLog && (type == QtDebugMsg || type == QtInfoMsg))
+    {
+        return;
+    }
+
+    fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+}
+
+// e.g. "640x400,1280x800"
+static bool parseResolutions(QString text, QVector<QSize>& resolutions)
+{
+    for (const auto& part : text.split(",", QString::SkipEmptyParts))
+    {
+        const QStringList values = part.trimmed().toLower().split("x");
+        if (values.size() != 2)
+        {
+            return false;
+        }
+
+        bool widthOk = false;
+        bool heightOk = false;
+        const int width = values.first().toInt(&widthOk);
+        const int height = values.last().toInt(&heightOk);
+        if (!widthOk || !heightOk || width <= 0 || height <= 0)
+        {
+            return false;
+        }
+
+        resolutions.push_back(QSize(width, height));
+    }
+
+    return !resolutions.isEmpty();
+}
+
+static bool parsePositive(QString text, int& value)
+{
+    bool ok = false;
+    value = text.toInt(&ok);
+    return ok && value > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(APP_NAME);
+
+    qInstallMessageHandler(myMessageOutput);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark the processing and saving of cscamera with synthetic frames.\n"
+        "The report is written to stdout as JSON, the progress is written to stderr.");
+    parser.addHelpOption();
+
+    QCommandLineOption outputOption({ "o", "output" }, "Write the report to the file instead of stdout.", "file");
+    QCommandLineOption resolutionsOption({ "r", "resolutions" }, "The resolutions separated by commas.", "resolutions", DEFAULT_RESOLUTIONS);
+    QCommandLineOption filterOption("filter", "Only run the benchmarks whose names match the regular expression, e.g. \"^(fillHole|processor)\\.\".", "regexp");
+    QCommandLineOption minTimeOption("min-time", "The minimum time of a benchmark, ms.", "ms", DEFAULT_MIN_TIME);
+    QCommandLineOption captureFramesOption("capture-frames", "The frames saved by a capture benchmark.", "count", DEFAULT_CAPTURE_FRAMES);
+    QCommandLineOption seedOption("seed", "The seed of the synthetic frames.", "seed", DEFAULT_SEED);
+    QCommandLineOption traceOption("trace", "Record the trace points and save the latest events of every thread to the file as Chrome trace JSON.", "file");
+    QCommandLineOption verboseOption({ "v", "verbose" }, "Write the info logs to stderr.");
+
+    parser.addOptions({ outputOption, resolutionsOption, filterOption, minTimeOption, captureFramesOption, seedOption, traceOption, verboseOption });
+    parser.process(app);
+
+    verboseLog = parser.isSet(verboseOption);
+
+    cs::BenchOptions options;
+    if (!parseResolutions(parser.value(resolutionsOption), options.resolutions))
+    {
+        fprintf(stderr, "Invalid resolutions: %s\n", parser.value(resolutionsOption).toLocal8Bit().constData());
+        return EXIT_CODE_INVALID_ARGS;
+    }
+
+    if (parser.isSet(filterOption))
+    {
+        options.filter = QRegularExpression(parser.value(filterOption));
+        if (!options.filter.isValid())
+        {
+            fprintf(stderr, "Invalid filter: %s\n", options.filter.errorString().toLocal8Bit().constData());
+            return EXIT_CODE_INVALID_ARGS;
+        }
+    }
+
+    if (!parsePositive(parser.value(minTimeOption), options.minTimeMs))
+    {
+        fprintf(stderr, "Invalid minimum time: %s\n", parser.value(minTimeOption).toLocal8Bit().constData());
+        return EXIT_CODE_INVALID_ARGS;
+    }
+
+    if (!parsePositive(parser.value(captureFramesOption), options.captureFrames))
+    {
+        fprintf(stderr, "Invalid count of capture frames: %s\n", parser.value(captureFramesOption).toLocal8Bit().constData());
+        return EXIT_CODE_INVALID_ARGS;
+    }
+
+    bool ok = false;
+    options.seed = parser.value(seedOption).toUInt(&ok);
+    if (!ok)
+    {
+        fprintf(stderr, "Invalid seed: %s\n", parser.value(seedOption).toLocal8Bit().constData());
+        return EXIT_CODE_INVALID_ARGS;
+    }
+
+    if (parser.isSet(traceOption) && !CSTracer::isSupported())
+    {
+        fprintf(stderr, "The trace points are not compiled, configure with -DUSE_TRACE=ON\n");
+        return EXIT_CODE_INVALID_ARGS;
+    }
+
+    CSTracer::setEnabled(parser.isSet(traceOption));
+
+    cs::BenchRunner runner(options);
+    cs::BenchSuite suite(runner);
+    suite.run();
+
+    if (parser.isSet(traceOption))
+    {
+        CSTracer::setEnabled(false);
+        if (!CSTracer::save(parser.value(traceOption)))
+        {
+            fprintf(stderr, "Save the trace failed: %s\n", parser.value(traceOption).toLocal8Bit().constData());
+            return EXIT_CODE_FAILED;
+        }
+    }
+
+    const QByteArray report = QJsonDocument(runner.genReport()).toJson(QJsonDocument::Indented);
+    if (!parser.isSet(outputOption))
+    {
+        fwrite(report.constData(), 1, report.size(), stdout);
+        fflush(stdout);
+        return EXIT_CODE_SUCCESS;
+    }
+
+    QFile file(parser.value(outputOption));
+    if (!file.open(QIODevice::WriteOnly) || file.write(report) != report.size())
+    {
+        fprintf(stderr, "Write the report failed: %s\n", file.errorString().toLocal8Bit().constData());
+        return EXIT_CODE_FAILED;
+    }
+
+    return EXIT_CODE_SUCCESS;
+}
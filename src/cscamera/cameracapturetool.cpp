@@ -28,11 +28,14 @@
 #include <QVariant>
 
 #include <icscamera.h>
-#include <fstream>
+#include <sstream>
 #include <yaml-cpp/yaml.h>
-#include <JlCompress.h>
 
 #include "outputsaver.h"
+#include "capturezipwriter.h"
+#include "capturerecordwriter.h"
+#include "pipelinestats.h"
+#include <cstracer.h>
 
 using namespace cs;
 
@@ -174,6 +177,12 @@ void CameraCaptureBase::run()
 
     emit captureStateChanged(m_captureConfig.captureType, CAPTURING, tr("Start capturing"));
 
+    m_sequence = 0;
+    if (!onCaptureDataStart())
+    {
+        return;
+    }
+
     int captured = getCapturedCount();
     int skip = getSkipCount();
 
@@ -193,9 +202,12 @@ void CameraCaptureBase::run()
 
             outputSaver = m_outputDatas.dequeue();
             m_outputSaverList.push_back(outputSaver);
+            CS_TRACE_COUNTER("capture cache", m_outputDatas.size());
+            CS_TRACE_COUNTER("capture savers", m_outputSaverList.size());
             m_saverMutex.unlock();
 
             outputSaver->updateSaveIndex();
+            outputSaver->setSequence(m_sequence++);
             outputSaver->updateCaptureConfig(m_captureConfig);
 
             // save a frame in separate thread
@@ -229,10 +241,25 @@ void CameraCaptureBase::saveFinished(OutputSaver* saver)
 
     m_capturedDataCount++;
     m_outputSaverList.removeAll(saver);
+    CS_TRACE_COUNTER("capture savers", m_outputSaverList.size());
 
     emit captureNumberUpdated(m_capturedDataCount, m_skipDataCount);
 }
 
+bool CameraCaptureBase::saveCapturedFile(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner)
+{
+    QString filePath = m_captureConfig.saveDir + QDir::separator() + info.fileName;
+
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
+    {
+        qWarning() << "open file failed, file:" << filePath;
+        return false;
+    }
+
+    return file.write(data) == data.size();
+}
+
 void CameraCaptureBase::setCamera(std::shared_ptr<ICSCamera>& m_camera)
 {
     this->m_camera = m_camera;
@@ -263,6 +290,10 @@ OutputSaver* CameraCaptureBase::genOutputSaver(const OutputDataPort& outputData)
     {
         outputSaver = new RawOutputSaver(this, m_captureConfig, outputData);
     }
+    else if (m_captureConfig.saveFormat == "rvl")
+    {
+        outputSaver = new RvlOutputSaver(this, m_captureConfig, outputData);
+    }
     else
     {
         outputSaver = new ImageOutputSaver(this, m_captureConfig, outputData);
@@ -393,19 +424,11 @@ YAML::Node genYamlNodeFromDataTypes(QVector<CS_CAMERA_DATA_TYPE> captureDataType
     return node;
 }
 
-void CameraCaptureBase::saveCameraPara(QString filePath)
+QByteArray CameraCaptureBase::genCameraPara()
 {
     qInfo() << "save camera parameters";
-  
-    auto bytesData = filePath.toLocal8Bit();
-    std::ofstream fout(bytesData.data());
-
-    if (!fout.is_open())
-    {
-        qWarning() << "open file failed, file:" << filePath;
-        return;
-    }
 
+    std::stringstream fout;
     fout << "%YAML:1.0\n";
     fout << "---\n";
 
@@ -560,19 +583,27 @@ void CameraCaptureBase::saveCameraPara(QString filePath)
     }
 
     fout << rootNode;
+
+    return QByteArray::fromStdString(fout.str());
 }
 
 void CameraCaptureBase::onCaptureDataDone()
 {
     // save camera parameters to file
-    QString savePath = m_captureConfig.saveDir + QDir::separator() + m_captureConfig.saveName + "-CaptureParameters.yaml";
-    saveCameraPara(savePath);
+    QString fileName = m_captureConfig.saveName + "-CaptureParameters.yaml";
+    CapturedFileInfo info;
+    info.fileName = fileName;
+
+    if (!saveCapturedFile(info, genCameraPara(), false))
+    {
+        qWarning() << "save camera parameters failed, file:" << fileName;
+    }
 }
 
 CameraCaptureSingle::CameraCaptureSingle(const CameraCaptureConfig& config)
     : CameraCaptureBase(config, CAPTURE_TYPE_SINGLE)
 {
-    m_realSaveFolder = config.saveDir;
+
 }
 
 void CameraCaptureSingle::getCaptureIndex(const OutputDataPort& output, int& rgbFrameIndex, int& depthFrameIndex, int& pointCloudIndex)
@@ -583,28 +614,48 @@ void CameraCaptureSingle::getCaptureIndex(const OutputDataPort& output, int& rgb
 CameraCaptureMultiple::CameraCaptureMultiple(const CameraCaptureConfig& config)
     : CameraCaptureBase(config, CAPTURE_TYPE_MULTIPLE)
 {
-    m_realSaveFolder = m_captureConfig.saveDir;
-    m_captureConfig.saveDir = genTmpSaveDir(config.saveDir);
+
 }
 
-QString CameraCaptureMultiple::genTmpSaveDir(QString saveDir)
+CameraCaptureMultiple::~CameraCaptureMultiple()
 {
-    QDir dir(saveDir);
-    
-    // make tmp dir 
-    QDateTime timeCurrent = QDateTime::currentDateTime();
-    QString timeStr = timeCurrent.toString("yyMMddhhmmss");
+    if (m_fileWriter)
+    {
+        delete m_fileWriter;
+    }
+}
+
+bool CameraCaptureMultiple::onCaptureDataStart()
+{
+    if (m_fileWriter)
+    {
+        delete m_fileWriter;
+    }
 
-    QString tmpDir = saveDir;
+    if (m_captureConfig.saveRecordFile)
+    {
+        // the camera parameters are saved in the header, the frame count is saved at the end of the record file
+        m_fileWriter = new CaptureRecordWriter(getSaveFilePath(), genCameraPara());
+    }
+    else
+    {
+        m_fileWriter = new CaptureZipWriter(getSaveFilePath());
+    }
 
-    QString tmpName = QString("~capture-%1").arg(timeStr);
-    if (!dir.mkdir(tmpName))
+    if (!m_fileWriter->start())
     {
-        qWarning() << "mkdir failed, dir:" << saveDir << "/" << tmpName;
-        Q_ASSERT(false);
+        qWarning() << "create file failed, file : " << getSaveFilePath();
+        emit captureStateChanged(m_captureConfig.captureType, CAPTURE_ERROR, m_captureConfig.saveRecordFile ? tr("Failed to create record file") : tr("Failed to create zip file"));
+        return false;
     }
 
-    return saveDir + QDir::separator() + tmpName;
+    return true;
+}
+
+QString CameraCaptureMultiple::getSaveFilePath()
+{
+    QString suffix = m_captureConfig.saveRecordFile ? RECORD_FILE_SUFFIX : ".zip";
+    return m_captureConfig.saveDir + QDir::separator() + m_captureConfig.saveName + suffix;
 }
 
 void CameraCaptureMultiple::addOutputData(const OutputDataPort& outputDataPort)
@@ -624,6 +675,8 @@ void CameraCaptureMultiple::addOutputData(const OutputDataPort& outputDataPort)
     if (m_outputDatas.size() >= m_maxCachedCount)
     {
         m_skipDataCount++;
+        PipelineStats::getInstance()->addDrop(DROP_CAPTURE);
+        CS_TRACE_INSTANT_FRAME("CameraCaptureMultiple::dropFrame", outputDataPort.getFrameData().receivedTime);
         qWarning() << "skip one frame, skipDataCount=" << m_skipDataCount << ", (skipDataCount + cachedDataCount) = " << m_cachedDataCount + m_skipDataCount;
 
         emit captureStateChanged(m_captureConfig.captureType, CAPTURE_WARNING, tr("a frame dropped"));
@@ -632,6 +685,7 @@ void CameraCaptureMultiple::addOutputData(const OutputDataPort& outputDataPort)
     {
         m_outputDatas.enqueue(genOutputSaver(outputDataPort));
         m_cachedDataCount++;
+        CS_TRACE_COUNTER("capture cache", m_outputDatas.size());
     }
 }
 
@@ -660,39 +714,68 @@ void CameraCaptureMultiple::getCaptureIndex(const OutputDataPort& output, int& r
     }
 }
 
-void CameraCaptureMultiple::onCaptureDataDone()
+void CameraCaptureMultiple::saveFinished(OutputSaver* saver)
 {
-    // save time stamps to file
-    saveTimeStamps();
+    // all files of the frame are added, the file writer can write the frame now
+    m_fileWriter->commit(saver->getSequence());
 
-    // save camera parameters and capture information
-    QString savePath = m_captureConfig.saveDir + QDir::separator() + "CaptureParameters.yaml";
-    saveCameraPara(savePath);
+    CameraCaptureBase::saveFinished(saver);
+}
 
-    // compress to zip file
-    compressToZip();
+bool CameraCaptureMultiple::saveCapturedFile(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner)
+{
+    m_fileWriter->addEntry(info, data, compress, owner);
+    return true;
 }
 
-void CameraCaptureMultiple::saveTimeStamps()
+void CameraCaptureMultiple::onCaptureDataDone()
 {
-    qInfo() << "save time stamps";
+    if (!m_captureConfig.saveRecordFile)
+    {
+        emit captureStateChanged(m_captureConfig.captureType, CAPTURING, tr("Please wait for the file to be compressed to zip"));
+    }
 
-    QString savePath = m_captureConfig.saveDir + QDir::separator() + "TimeStamps.txt";
+    // write the remaining frames
+    m_fileWriter->waitForFrames();
 
-    if (m_depthTimeStamps.isEmpty() && m_rgbTimeStamps.isEmpty())
+    bool result = true;
+
+    // save time stamps
+    QByteArray timeStamps = genTimeStamps();
+    if (!timeStamps.isEmpty())
     {
-        return;
+        result &= m_fileWriter->addFile("TimeStamps.txt", timeStamps, true);
     }
 
-    QFile file(savePath);
-    file.open(QFile::WriteOnly);
-    if (!file.isOpen())
+    // save camera parameters and capture information
+    result &= m_fileWriter->addFile("CaptureParameters.yaml", genCameraPara(), true);
+
+    result &= m_fileWriter->finish();
+    if (result)
     {
-        qWarning() << "open file failed, file:" << file;
-        return;
+        qInfo() << "Save file success.";
+    }
+    else
+    {
+        qWarning() << "Save file failed, file : " << getSaveFilePath();
+        emit captureStateChanged(m_captureConfig.captureType, CAPTURE_ERROR, m_captureConfig.saveRecordFile ? tr("Failed to save record file") : tr("Failed to compress zip file"));
+    }
+
+    delete m_fileWriter;
+    m_fileWriter = nullptr;
+}
+
+QByteArray CameraCaptureMultiple::genTimeStamps()
+{
+    qInfo() << "save time stamps";
+
+    QByteArray data;
+    if (m_depthTimeStamps.isEmpty() && m_rgbTimeStamps.isEmpty())
+    {
+        return data;
     }
 
-    QTextStream ts(&file);
+    QTextStream ts(&data);
 
     // save depth time stamps
     if (!m_depthTimeStamps.isEmpty())
@@ -721,27 +804,7 @@ void CameraCaptureMultiple::saveTimeStamps()
             ts << s;
         }
     }
-}
-
-void CameraCaptureMultiple::compressToZip()
-{
-    emit captureStateChanged(m_captureConfig.captureType, CAPTURING, tr("Please wait for the file to be compressed to zip"));
-
-    QString m_zipFile = m_realSaveFolder + QDir::separator() + m_captureConfig.saveName + ".zip";
-
-    int result = JlCompress::compressDir(m_zipFile, m_captureConfig.saveDir, false, QDir::Files);
-    if (result)
-    {
-        qInfo() << "Compress zip file success.";
-    }
-    else 
-    {
-        qWarning() << "Compress zip file failed, zip file : " << m_zipFile;
-        emit captureStateChanged(m_captureConfig.captureType, CAPTURE_ERROR, tr("Failed to compress zip file"));
-    }
 
-    // delete tmp folder
-    qInfo() << "delete tmp dir:" << m_captureConfig.saveDir;
-    QDir dir(m_captureConfig.saveDir);
-    dir.removeRecursively();
-}
\ No newline at end of file
+    ts.flush();
+    return data;
+}
@@ -22,26 +22,55 @@
 #include <QImage>
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QTimer>
 #include "capturedzipparser.h"
+#include "frameprefetcher.h"
+
+// play interval of the frames without valid time stamps, in milliseconds
+#define PLAY_DEFAULT_INTERVAL   33
+// a longer gap in the time stamps is shortened to it while playing
+#define PLAY_MAX_INTERVAL       1000
 
 using namespace cs;
 
 CameraPlayer::CameraPlayer(QObject* parent)
     : QThread(parent)
     , m_zipParser(new CapturedZipParser())
+    , m_playTimer(new QTimer(this))
 {
+    // the player opens large captures again and again
+    m_zipParser->setIndexFileEnabled(true);
+
+    m_prefetcher = new FramePrefetcher(m_zipParser);
+
+    m_playTimer->setSingleShot(true);
+    m_playTimer->setTimerType(Qt::PreciseTimer);
+
+    bool suc = true;
+    suc &= (bool)connect(m_prefetcher, &FramePrefetcher::frameReady, this, &CameraPlayer::onFrameReady, Qt::QueuedConnection);
+    suc &= (bool)connect(m_playTimer,  &QTimer::timeout,             this, &CameraPlayer::onPlayTimeout);
+    // the timer belongs to the player thread, stop it before the thread exits
+    suc &= (bool)connect(this, &QThread::finished, m_playTimer, &QTimer::stop, Qt::DirectConnection);
+    Q_ASSERT(suc);
+
     moveToThread(this);
     start();
 }
 
 CameraPlayer::~CameraPlayer()
 {
+    // wait for the decoding frames before the zip parser is deleted
+    delete m_prefetcher;
     delete m_zipParser;
 }
 
 void CameraPlayer::onLoadFile(QString file)
 {
     emit playerStateChanged(PLAYER_LOADING, tr("Loading file..."));
+
+    stopPlaying();
+    m_prefetcher->reset();
+    m_currentFrame = 0;
     m_zipParser->setZipFile(file);
 
     if (!m_zipParser->checkFileValid())
@@ -59,6 +88,8 @@ void CameraPlayer::onLoadFile(QString file)
         return;
     }
 
+    m_prefetcher->setFrameCount(m_zipParser->getFrameCount());
+
     emit playerStateChanged(PLAYER_READY, tr("Ready to play"));
 }
 
@@ -72,129 +103,198 @@ void CameraPlayer::onPalyFrameUpdated(int curFrame, bool force)
     if (m_currentFrame != curFrame || force)
     {
         m_currentFrame = curFrame;
+
+        if (m_isPlaying)
+        {
+            // keep playing from the new frame
+            m_playTimer->stop();
+            m_playDueTime = m_playClock.elapsed();
+        }
+
         updateCurrentFrame();
     }
 }
 
 void CameraPlayer::updateCurrentFrame()
 {
-    QReadLocker locker(&m_lock);
-   
-    for (auto type : m_currentDataTypes)
+    QVector<int> dataTypes;
     {
-        switch (type)
-        {
-        case CAMERA_DATA_L:
-        case CAMERA_DATA_R:
-        case CAMERA_DATA_DEPTH:
-        case CAMERA_DATA_RGB:
-            updateCurrentImage(type);
-            break;
-        case CAMERA_DATA_POINT_CLOUD:
-            updateCurrentPointCloud();
-            break;
-        default:
-            break;
-        }
+        QReadLocker locker(&m_lock);
+        dataTypes = m_currentDataTypes;
+    }
+    m_prefetcher->setDecodeOptions(dataTypes, m_show3dTexture);
+
+    // show the frame if it is decoded already, otherwise it is shown in onFrameReady()
+    m_currentFrameShown = false;
+
+    PlayerFrame frame;
+    if (m_prefetcher->requestFrame(m_currentFrame - 1, frame))
+    {
+        showFrame(frame);
     }
 }
 
-QVector<int> CameraPlayer::getDataTypes()
+void CameraPlayer::onFrameReady(int frameIndex)
 {
-    QVector<int> dataTypes = m_zipParser->getDataTypes();
-    if (dataTypes.contains(CAMERA_DATA_DEPTH) && !dataTypes.contains(CAMERA_DATA_POINT_CLOUD))
+    if (m_currentFrameShown || frameIndex != m_currentFrame - 1)
     {
-        dataTypes.push_back(CAMERA_DATA_POINT_CLOUD);
+        return;
     }
 
-    return dataTypes;
+    PlayerFrame frame;
+    if (m_prefetcher->getFrame(frameIndex, frame))
+    {
+        showFrame(frame);
+    }
 }
 
-int CameraPlayer::getFrameNumber()
+void CameraPlayer::showFrame(const PlayerFrame& frame)
 {
-    return m_zipParser->getFrameCount();
-}
+    m_currentFrameShown = true;
 
-void CameraPlayer::currentDataTypesUpdated(QVector<int> dataTypes)
-{
-    QWriteLocker locker(&m_lock);
-    m_currentDataTypes = dataTypes;
+    for (const auto& outputData : frame.outputs2D)
+    {
+        emit output2DUpdated(outputData);
+    }
+
+    if (frame.hasPointCloud)
+    {
+        // the played frames are not received from a camera
+        emit output3DUpdated(frame.pointCloud, frame.texImage, 0);
+    }
+
+    for (auto type : frame.failedTypes)
+    {
+        if (type == CAMERA_DATA_POINT_CLOUD)
+        {
+            emit playerStateChanged(PLAYER_ERROR, tr("Failed to generate point cloud"));
+        }
+        else
+        {
+            emit playerStateChanged(PLAYER_ERROR, tr("Failed to generate image"));
+        }
+    }
+
+    if (m_isPlaying)
+    {
+        scheduleNextFrame();
+    }
 }
 
-void CameraPlayer::updateCurrentImage(int type)
+void CameraPlayer::onPlayToggled(bool play)
 {
-    // If the timestamp is valid, find the RGB frame index through the timestamp
-    int frameIndex = m_currentFrame - 1;
-    if (type == CAMERA_DATA_RGB && m_zipParser->getIsTimeStampsValid())
+    if (play == m_isPlaying)
     {
-        int rgbIndex = m_zipParser->getRgbFrameIndexByTimeStamp(frameIndex);
-        qInfo() << "update rgb frame, depth index : " << frameIndex << ", rgb index:" << rgbIndex;
+        return;
+    }
 
-        frameIndex = rgbIndex;
+    if (!play)
+    {
+        stopPlaying();
+        return;
     }
 
-    QImage image = m_zipParser->getImageOfFrame(frameIndex, type);
-    if (image.isNull())
+    const int frameCount = m_zipParser->getFrameCount();
+    if (frameCount < 1)
     {
-        qWarning() << "Failed to generate image";
-        emit playerStateChanged(PLAYER_ERROR, tr("Failed to generate image"));
+        emit playingChanged(false);
         return;
     }
 
-    OutputData2D outputData;
-    outputData.image = image;
-    outputData.info.cameraDataType = type;
+    m_isPlaying = true;
+    m_playClock.start();
+    m_playDueTime = 0;
+    emit playingChanged(true);
+
+    if (m_currentFrame >= frameCount || m_currentFrame < 1)
+    {
+        // play from the first frame again
+        m_currentFrame = 1;
+        emit playFrameChanged(m_currentFrame);
+        updateCurrentFrame();
+    }
+    else if (m_currentFrameShown)
+    {
+        scheduleNextFrame();
+    }
+}
 
-    emit output2DUpdated(outputData);
+void CameraPlayer::stopPlaying()
+{
+    m_playTimer->stop();
+    if (m_isPlaying)
+    {
+        m_isPlaying = false;
+        emit playingChanged(false);
+    }
 }
 
-void CameraPlayer::updateCurrentPointCloud()
+void CameraPlayer::scheduleNextFrame()
 {
-    auto dataTypes = m_zipParser->getDataTypes();
-    Pointcloud pc;
-    QImage texImage;
+    if (m_currentFrame >= m_zipParser->getFrameCount())
+    {
+        stopPlaying();
+        return;
+    }
 
-    if (dataTypes.contains(CAMERA_DATA_POINT_CLOUD))
+    // If the current frame is shown late, the frames after it are delayed too, no frame is skipped
+    const qint64 elapsed = m_playClock.elapsed();
+    if (m_playDueTime < elapsed)
     {
-        // generate Pointcloud from ply file
-        if (!m_zipParser->getPointCloud(m_currentFrame - 1, pc, texImage))
-        {
-            emit playerStateChanged(PLAYER_ERROR, tr("Failed to generate point cloud"));
-            return;
-        }
+        m_playDueTime = elapsed;
+    }
 
-        if (texImage.isNull())
-        {
-            // generate Pointcloud from depth data 
-            int rgbFrame = m_currentFrame - 1;
-            // If the timestamp is valid, find the RGB frame index through the timestamp
-            if (m_show3dTexture && m_zipParser->getIsTimeStampsValid())
-            {
-                rgbFrame = m_zipParser->getRgbFrameIndexByTimeStamp(m_currentFrame - 1);
-            }
-
-            texImage = m_zipParser->getImageOfFrame(rgbFrame, CAMERA_DATA_RGB);
-        }
+    m_playDueTime += getPlayInterval(m_currentFrame);
+    m_playTimer->start(int(m_playDueTime - elapsed));
+}
+
+void CameraPlayer::onPlayTimeout()
+{
+    if (!m_isPlaying)
+    {
+        return;
     }
-    else 
+
+    m_currentFrame++;
+    emit playFrameChanged(m_currentFrame);
+    updateCurrentFrame();
+}
+
+int CameraPlayer::getPlayInterval(int curFrame)
+{
+    // the interval between the time stamps of the current frame and the next frame
+    const int dataType = m_zipParser->getDataTypes().contains(CAMERA_DATA_DEPTH) ? CAMERA_DATA_DEPTH : CAMERA_DATA_RGB;
+    const int timeStamp = m_zipParser->getTimeStampOfFrame(curFrame - 1, dataType);
+    const int nextTimeStamp = m_zipParser->getTimeStampOfFrame(curFrame, dataType);
+
+    if (timeStamp > 0 && nextTimeStamp > timeStamp)
     {
-        // generate Pointcloud from depth data 
-        int rgbFrame = m_currentFrame - 1;
-        // If the timestamp is valid, find the RGB frame index through the timestamp
-        if (m_show3dTexture && m_zipParser->getIsTimeStampsValid())
-        {
-            rgbFrame = m_zipParser->getRgbFrameIndexByTimeStamp(m_currentFrame - 1);
-        }
+        return qMin(nextTimeStamp - timeStamp, PLAY_MAX_INTERVAL);
+    }
 
-        if (!m_zipParser->generatePointCloud(m_currentFrame - 1, rgbFrame, m_show3dTexture, pc, texImage))
-        {
-            qWarning() << "Failed to generate point cloud";
-            emit playerStateChanged(PLAYER_ERROR, tr("Failed to generate point cloud"));
-            return;
-        }
+    return PLAY_DEFAULT_INTERVAL;
+}
+
+QVector<int> CameraPlayer::getDataTypes()
+{
+    QVector<int> dataTypes = m_zipParser->getDataTypes();
+    if (dataTypes.contains(CAMERA_DATA_DEPTH) && !dataTypes.contains(CAMERA_DATA_POINT_CLOUD))
+    {
+        dataTypes.push_back(CAMERA_DATA_POINT_CLOUD);
     }
 
-    emit output3DUpdated(pc, texImage);
+    return dataTypes;
+}
+
+int CameraPlayer::getFrameNumber()
+{
+    return m_zipParser->getFrameCount();
+}
+
+void CameraPlayer::currentDataTypesUpdated(QVector<int> dataTypes)
+{
+    QWriteLocker locker(&m_lock);
+    m_currentDataTypes = dataTypes;
 }
 
 void CameraPlayer::onShow3DTextureChanged(bool show)
@@ -78,6 +78,34 @@ std::shared_ptr<ICSCamera> CameraThread::getCamera() const
     return m_cameraProxy;
 }
 
+void CameraThread::setSimulatedCamera(bool enable, const SimulatedCameraConfig& config)
+{
+    m_lock.lockForWrite();
+    m_simulatedCameraEnabled = enable;
+    m_simulatedCameraConfig = config;
+
+    auto it = m_cameraInfoList.begin();
+    while (it != m_cameraInfoList.end())
+    {
+        if (isSimulatedCamera((*it).serial))
+        {
+            it = m_cameraInfoList.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (enable)
+    {
+        m_cameraInfoList.push_back(SimulatedCamera::genCameraInfo());
+    }
+    m_lock.unlock();
+
+    notifyCameraListUpdated();
+}
+
 void CameraThread::updateCameraInfoList(const std::vector<CameraInfo>& added, const std::vector<CameraInfo>& removed)
 {
     m_lock.lockForWrite();
@@ -284,6 +312,33 @@ void CameraThread::bindCamera(CSCamera* camera)
     qobject_cast<CameraProxy*>(m_cameraProxy.get())->bindCamera(camera);
 }
 
+void CameraThread::bindCamera(SimulatedCamera* camera)
+{
+    camera->setCameraThread(this);
+    qobject_cast<CameraProxy*>(m_cameraProxy.get())->bindCamera(camera);
+}
+
+bool CameraThread::connectSimulatedCamera()
+{
+    m_lock.lockForRead();
+    SimulatedCamera* camera = new SimulatedCamera(m_simulatedCameraConfig);
+    m_lock.unlock();
+
+    if (!camera->connectCamera())
+    {
+        camera->deleteLater();
+        return false;
+    }
+
+    bindCamera(camera);
+    return true;
+}
+
+bool CameraThread::isSimulatedCamera(const QString& serial) const
+{
+    return serial == SIMULATED_CAMERA_SERIAL;
+}
+
 void CameraThread::onDisconnectCamera()
 {
     qInfo() << "try to disconnect camera";
@@ -342,6 +397,19 @@ void CameraThread::onConnectCamera(QString info)
     // 4. connecting
     emit cameraStateChanged(CAMERA_CONNECTING);
     qInfo() << "begin connect camera";
+    if (isSimulatedCamera(realSerial))
+    {
+        if (!connectSimulatedCamera())
+        {
+            emit cameraStateChanged(CAMERA_CONNECTFAILED);
+            return;
+        }
+
+        emit cameraStateChanged(CAMERA_CONNECTED);
+        qInfo() << "connect simulated camera end";
+        return;
+    }
+
     CSCamera* m_camera = new CSCamera();
     if (!m_camera->connectCamera(cameraInfo))
     {
@@ -360,6 +428,12 @@ void CameraThread::onRestartCamera()
 {
     qInfo() << "try to restart camera";
     m_cameraProxy->restartCamera();
+
+    // the simulated camera is not reported by the SDK after restarting, so reconnect it directly
+    if (isSimulatedCamera(m_cameraProxy->getCameraInfo().cameraInfo.serial))
+    {
+        emit reconnectCamera();
+    }
     qInfo() << "restart camera end";
 }
 
@@ -434,6 +508,13 @@ void CameraThread::onQueryCameras()
         }
     }
 
+    // the simulated camera is not queried from the SDK
+    if (m_simulatedCameraEnabled)
+    {
+        m_cameraInfoList.push_back(SimulatedCamera::genCameraInfo());
+        find |= isSimulatedCamera(curCameraSerial);
+    }
+
     // 4. unbind the camera if not find 
     if (!find)
     {
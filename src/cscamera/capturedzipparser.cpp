@@ -18,14 +18,20 @@
 ********************************************************************************/
 
 #include "capturedzipparser.h"
+#include "plywriter.h"
+#include "rvlcodec.h"
+#include "plyreader.h"
 #include <imageutil.h>
-#include <JlCompress.h>
 #include <yaml-cpp/yaml.h>
 #include <QDebug>
 #include <QMap>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
 #include <math.h>
 #include <QTextStream>
 #include <limits.h>
+#include <string.h>
 
 using namespace cs;
 
@@ -114,59 +120,100 @@ CapturedZipParser::~CapturedZipParser()
 void CapturedZipParser::setZipFile(QString filePath)
 {
     m_zipFile = filePath;
+    m_zipReader.close();
+    m_recordReader.close();
+}
+
+void CapturedZipParser::setIndexFileEnabled(bool enabled)
+{
+    m_indexFileEnabled = enabled;
+}
+
+bool CapturedZipParser::openZipFile()
+{
+    if (isRecordFile())
+    {
+        if (m_recordReader.isOpen())
+        {
+            return true;
+        }
+
+        if (!m_recordReader.open(m_zipFile))
+        {
+            qWarning() << "Open record file failed, file:" << m_zipFile;
+            return false;
+        }
+
+        return true;
+    }
+
+    if (m_zipReader.isOpen())
+    {
+        return true;
+    }
+
+    if (!m_zipReader.open(m_zipFile, m_indexFileEnabled))
+    {
+        qWarning() << "Open zip file failed, file:" << m_zipFile;
+        return false;
+    }
+
+    return true;
 }
 
 bool CapturedZipParser::checkFileValid()
 {
     qInfo() << "check zip file is valid or not";
 
-    QuaZip zip(m_zipFile);
-    zip.open(QuaZip::mdUnzip);
-    if (!zip.isOpen())
+    if (!openZipFile())
     {
-        qWarning() << "Open zip file failed, file:" << m_zipFile;
         return false;
     }
 
-    bool result = zip.setCurrentFile("CaptureParameters.yaml");
-    zip.close();
+    // the camera parameters are saved in the header of the record file
+    return isRecordFile() || containsFile("CaptureParameters.yaml");
+}
 
-    return result;
+bool CapturedZipParser::isRecordFile()
+{
+    return m_zipFile.endsWith(RECORD_FILE_SUFFIX, Qt::CaseInsensitive);
+}
+
+bool CapturedZipParser::containsFile(QString name)
+{
+    return isRecordFile() ? m_recordReader.contains(name) : m_zipReader.contains(name);
+}
+
+bool CapturedZipParser::readFile(QString name, QByteArray& data)
+{
+    return isRecordFile() ? m_recordReader.readEntry(name, data) : m_zipReader.readEntry(name, data);
 }
 
 QByteArray CapturedZipParser::getFrameData(int frameIndex, int dataType)
 {
     QByteArray data;
-    do
+    if (!openZipFile())
     {
-        bool result = true;
-
-        QuaZip zip(m_zipFile);
-        result = zip.open(QuaZip::mdUnzip);
-        if (!result)
-        {
-            qWarning() << "open zip file failed, file:" << m_zipFile;
-            break;
-        }
-
-        QString fileName = getFileName(frameIndex, dataType);
-        result = zip.setCurrentFile(fileName);
-        if (!result)
-        {
-            qWarning() << "set current file failed, file name:" << fileName;
-            break;
-        }
+        return data;
+    }
 
-        QuaZipFile file(&zip);
-        result = file.open(QIODevice::ReadOnly);
-        if (!result)
+    // the chunk of the frame is found by the index of the record file without the file name
+    if (isRecordFile())
+    {
+        if (!m_recordReader.readFrame(frameIndex, dataType, data))
         {
-            qWarning() << "open file failed, file name:" << fileName;
-            break;
+            qWarning() << "read frame failed, frame index:" << frameIndex << ", data type:" << dataType;
+            data.clear();
         }
-        data = file.readAll();
+        return data;
+    }
 
-    } while (false);
+    QString fileName = getFileName(frameIndex, dataType);
+    if (!m_zipReader.readEntry(fileName, data))
+    {
+        qWarning() << "read file failed, file name:" << fileName;
+        data.clear();
+    }
 
     return data;
 }
@@ -185,6 +232,19 @@ QImage CapturedZipParser::getImageOfFrame(int frameIndex, int dataType)
         QImage image = convertPixels2QImage(data, dataType);
         return image;
     }
+    else if (isEncodedByRvl(dataType))
+    {
+        int width, height, bitDepth;
+        QByteArray pixData;
+        if (!RvlCodec::decode(data, width, height, bitDepth, pixData))
+        {
+            qWarning() << "decode rvl data failed.";
+            return QImage();
+        }
+
+        QImage image = convertPixels2QImage(pixData, dataType);
+        return image;
+    }
     else
     {
         QImage image = convertPng2QImage(data, dataType);
@@ -195,183 +255,173 @@ QImage CapturedZipParser::getImageOfFrame(int frameIndex, int dataType)
 // generate PoinCloud from .ply file
 bool CapturedZipParser::getPointCloud(int frameIndex, Pointcloud& pc, QImage& texImage)
 {
-    bool result = true;
-    do 
+    QByteArray data = getFrameData(frameIndex, CAMERA_DATA_POINT_CLOUD);
+    if (data.isEmpty())
     {
-        QuaZip zip(m_zipFile);
-        result = zip.open(QuaZip::mdUnzip);
-        if (!result)
-        {
-            qWarning() << "open zip file failed, file:" << m_zipFile;
-            break;
-        }
-
-        QString fileName = getFileName(frameIndex, CAMERA_DATA_POINT_CLOUD);
-        result = zip.setCurrentFile(fileName);
-        if (!result)
-        {
-            qWarning() << "set current file failed, file name:" << fileName;
-            break;
-        }
-
-        QuaZipFile file(&zip);
-        result = file.open(QIODevice::ReadOnly);
-        if (!result)
-        {
-            qWarning() << "open file failed, file name:" << fileName;
-            break;
-        }
+        return false;
+    }
 
-        QTextStream ts(&file);
-        int vertexCount = 0;
-        bool hasTexture = false;
-        bool hasNormal = false;
-        // read header
-        while (!ts.atEnd())
-        {
-            QString line = ts.readLine();
-            if (line.startsWith("element vertex"))
-            {
-                auto arr = line.split(" ");
-                if (arr.size() >= 3)
-                {
-                    vertexCount = arr[2].toInt();
-                }
-                continue;
-            }
+    QByteArray colors;
+    if (!PlyReader::readPointCloud(data, pc, colors))
+    {
+        qWarning() << "read point cloud failed, frame index:" << frameIndex;
+        return false;
+    }
 
-            // read header end
-            if (line.startsWith("end_header"))
-            {
-                break;
-            }
+    if (colors.isEmpty())
+    {
+        return true;
+    }
 
-            // check has texture info or not
-            if (line.contains("red"))
-            {
-                hasTexture = true;
-            }
+    // the renderer and the writer take colors from a texture, lay the vertex colors out as the rows of the texture
+    const int vertexCount = pc.size();
+    const int texWidth = (m_depthResolution.width() > 0) ? m_depthResolution.width() : 1024;
+    const int texHeight = (vertexCount + texWidth - 1) / texWidth;
+    if (texHeight == 0)
+    {
+        return true;
+    }
 
-            if (line.contains("nx"))
-            {
-                hasNormal = true;
-            }
-        }
+    texImage = QImage(texWidth, texHeight, QImage::Format_RGB888);
+    texImage.fill(Qt::black);
 
-        std::vector<float3>& points = pc.getVertices();
-        std::vector<float2>& textures = pc.getTexcoords();
-        std::vector<float3>& normals = pc.getNormals();
+    uchar* texBits = texImage.bits();
+    const int bytesPerLine = texImage.bytesPerLine();
+    std::vector<float2>& texcoords = pc.getTexcoords();
+    texcoords.resize(vertexCount);
 
-        float3 p(0, 0, 0);
-        float3 n(0, 0, 0);
-        int3 rgb(0, 0, 0);
-        int texWidth = 0, texHeight = 0;
+#pragma omp parallel for
+    for (int y = 0; y < texHeight; y++)
+    {
+        const int first = y * texWidth;
+        const int count = qMin(texWidth, vertexCount - first);
+        memcpy(texBits + y * bytesPerLine, colors.constData() + first * 3, count * 3);
 
-        QByteArray textureData;
-        if (hasTexture)
+        for (int x = 0; x < count; x++)
         {
-            texWidth = m_depthResolution.width();
-            texHeight = vertexCount / texWidth + ((vertexCount % texWidth) == 0 ? 0 : 1);
-            textureData.resize(texWidth * texHeight * 3); // RGB888
+            texcoords[first + x] = float2(x * 1.0f / texWidth, y * 1.0f / texHeight);
         }
+    }
 
-        points.clear();
-        textures.clear();
-        normals.clear();
-
-        int vIndex = 0;
-        uchar* texPtr = (uchar*)textureData.data();
-
-        int w = 0, h = 0;
-        // read point data
-        while (!ts.atEnd() && vIndex < vertexCount)
-        {
-            ts >> p.x >> p.y >> p.z;
-            points.push_back(p);
-
-            if (hasNormal)
-            {
-                ts >> n.x >> n.y >> n.z;
-                normals.push_back(n);
-            }
-
-            if (hasTexture)
-            {
-                ts >> rgb.x >> rgb.y >> rgb.z;
-                float2 texPos(0, 0);
+    return true;
+}
 
-                texPtr[3 * vIndex] = rgb.x;
-                texPtr[3 * vIndex + 1] = rgb.y;
-                texPtr[3 * vIndex + 2] = rgb.z;
+bool CapturedZipParser::generatePointCloud(int depthIndex, int rgbIndex, bool withTexture, Pointcloud& pc, QImage& tex)
+{
+    QByteArray data = getFrameData(depthIndex, CAMERA_DATA_DEPTH);
+    if (data.isNull() || data.isEmpty())
+    {
+        qWarning() << "depth frame data is empty";
+        return false;
+    }
 
-                texPos.u = w * 1.0f / texWidth;
-                texPos.v = h * 1.0f / texHeight;
-                textures.push_back(texPos);
+    QByteArray pixData;
+    if (!decodeFrameData(CAMERA_DATA_DEPTH, data, pixData))
+    {
+        return false;
+    }
 
-                w++;
-                if (w == texWidth)
-                {
-                    h++;
-                    w = 0;
-                }
-            }
+    if (withTexture)
+    {
+        tex = getImageOfFrame(rgbIndex, CAMERA_DATA_RGB);
+    }
 
-            vIndex++;
-        }
+    return generatePointCloud(pixData, withTexture, pc);
+}
 
-        if (hasTexture)
-        {
-            QImage image = QImage(texPtr, texWidth, texHeight, QImage::Format_RGB888);
-            texImage = image.copy(image.rect());
-        }
+bool CapturedZipParser::generatePointCloud(const QByteArray& depthPixels, bool withTexture, Pointcloud& pc)
+{
+    int width = m_depthResolution.width();
+    int height = m_depthResolution.height();
 
-        zip.close();
-        file.close();
-    } while (false);
+    if (depthPixels.size() < width * height * (int)sizeof(ushort))
+    {
+        qWarning() << "the size of depth pixels is invalid";
+        return false;
+    }
 
+    if (withTexture)
+    {
+        pc.generatePoints<ushort>((ushort*)depthPixels.constData(), width, height, m_depthScale, &m_depthIntrinsics, &m_rgbIntrinsics, &m_extrinsics, true);
+    }
+    else
+    {
+        pc.generatePoints<ushort>((ushort*)depthPixels.constData(), width, height, m_depthScale, &m_depthIntrinsics, nullptr, nullptr, true);
+    }
 
-    return result;
+    return true;
 }
 
-bool CapturedZipParser::generatePointCloud(int depthIndex, int rgbIndex, bool withTexture, Pointcloud& pc, QImage& tex)
+bool CapturedZipParser::decodeFrameData(int dataType, const QByteArray& data, QByteArray& pixData)
 {
-    ushort* dataPtr = nullptr;
+    if (isRawFormat())
+    {
+        pixData = data;
+        return true;
+    }
 
-    QByteArray data = getFrameData(depthIndex, CAMERA_DATA_DEPTH);
-    if (data.isNull() || data.isEmpty())
+    int width, height, bitDepth;
+    if (isEncodedByRvl(dataType))
     {
-        qWarning() << "depth frame data is empty";
-        return false;
+        if (!RvlCodec::decode(data, width, height, bitDepth, pixData))
+        {
+            qWarning() << "decode rvl data failed.";
+            return false;
+        }
+        return true;
     }
 
-    QByteArray pixData = data;
-    if (!isRawFormat())
+    // depth is saved as 16 bits PNG
+    if (dataType == CAMERA_DATA_DEPTH)
     {
-        int width, height, bitDepth;
         if (!ImageUtil::genPixDataFromPngData(data, width, height, bitDepth, pixData))
         {
             qWarning() << "generate pixel data failed.";
             return false;
         }
+        return true;
     }
-    dataPtr = (ushort*)pixData.data();
 
-    int width = m_depthResolution.width();
-    int height = m_depthResolution.height();
-
-    if (withTexture)
+    QImage image = QImage::fromData(data, "PNG");
+    if (image.isNull())
     {
-        tex = getImageOfFrame(rgbIndex, CAMERA_DATA_RGB);
-        pc.generatePoints<ushort>((ushort*)pixData.data(), width, height, m_depthScale, &m_depthIntrinsics, &m_rgbIntrinsics, &m_extrinsics, true);
+        qWarning() << "decode png data failed.";
+        return false;
     }
-    else
+
+    image = image.convertToFormat((dataType == CAMERA_DATA_RGB) ? QImage::Format_RGB888 : QImage::Format_Grayscale8);
+
+    // remove the padding of the lines
+    const int lineSize = image.width() * ((dataType == CAMERA_DATA_RGB) ? 3 : 1);
+    pixData.resize(lineSize * image.height());
+    for (int y = 0; y < image.height(); y++)
     {
-        pc.generatePoints<ushort>((ushort*)pixData.data(), width, height, m_depthScale, &m_depthIntrinsics, nullptr, nullptr, true);
+        memcpy(pixData.data() + y * lineSize, image.constScanLine(y), lineSize);
     }
 
     return true;
 }
 
+QSize CapturedZipParser::getResolution(int dataType)
+{
+    return (dataType == CAMERA_DATA_RGB) ? m_rgbResolution : m_depthResolution;
+}
+
+Intrinsics CapturedZipParser::getIntrinsics(int dataType)
+{
+    return (dataType == CAMERA_DATA_RGB) ? m_rgbIntrinsics : m_depthIntrinsics;
+}
+
+Extrinsics CapturedZipParser::getExtrinsics()
+{
+    return m_extrinsics;
+}
+
+float CapturedZipParser::getDepthScale()
+{
+    return m_depthScale;
+}
+
 QImage CapturedZipParser::convertPng2QImage(QByteArray data, int dataType)
 {
     QImage image;
@@ -425,11 +475,11 @@ QImage CapturedZipParser::convertPixels2QImage(QByteArray data, int dataType)
 
 QImage CapturedZipParser::convertData2QImage(int width, int height, QByteArray data)
 {
-    cs::colorizer color;
-    color.setRange(m_depthMin, m_depthMax);
-
     QImage image = QImage(width, height, QImage::Format_RGB888);
-    color.process<ushort>((ushort*)data.data(), m_depthScale, image.bits(), width * height);
+
+    QMutexLocker locker(&m_colorizerMutex);
+    m_colorizer.setRange(m_depthMin, m_depthMax);
+    m_colorizer.process((const ushort*)data.constData(), m_depthScale, image.bits(), width, height);
     return image;
 }
 
@@ -439,16 +489,28 @@ bool CapturedZipParser::parseCaptureInfo()
 
     bool result = true;
 
-    QuaZip zip(m_zipFile);
-    zip.open(QuaZip::mdUnzip);
-    zip.setCurrentFile("CaptureParameters.yaml");
+    QByteArray yamlData;
+    if (!openZipFile())
+    {
+        return false;
+    }
 
-    QuaZipFile file(&zip);
-    file.open(QIODevice::ReadOnly);
+    if (!readFile("CaptureParameters.yaml", yamlData))
+    {
+        // the record file is not finished if the capture is interrupted, use the camera parameters in the header
+        if (isRecordFile())
+        {
+            yamlData = m_recordReader.getCameraPara();
+        }
 
-    YAML::Node node = YAML::Load((const char*)file.readAll().data());
-    file.close();
-    zip.close();
+        if (yamlData.isEmpty())
+        {
+            qWarning() << "read CaptureParameters.yaml failed";
+            return false;
+        }
+    }
+
+    YAML::Node node = YAML::Load(yamlData.constData());
 
     try
     {
@@ -457,6 +519,10 @@ bool CapturedZipParser::parseCaptureInfo()
 
         // frame number
         m_capturedFrameCount = node["Frame Number"].as<int>();
+        if (isRecordFile())
+        {
+            m_capturedFrameCount = qMax(m_capturedFrameCount, m_recordReader.getFrameCount());
+        }
 
         // data types
         YAML::Node data = node["Data Types"].as<YAML::Node>();
@@ -560,29 +626,20 @@ bool CapturedZipParser::parseTimeStamps()
 
     do
     {
-        QuaZip zip(m_zipFile);
-        if (!zip.open(QuaZip::mdUnzip))
-        {
-            result = false;
-            break;
-        }
-
-        if (!zip.setCurrentFile("TimeStamps.txt"))
+        QByteArray data;
+        if (!openZipFile() || !containsFile("TimeStamps.txt") || !readFile("TimeStamps.txt", data))
         {
-            zip.close();
-            result = false;
-            break;
-        }
+            if (isRecordFile())
+            {
+                parseRecordTimeStamps();
+                break;
+            }
 
-        QuaZipFile file(&zip);
-        file.open(QIODevice::ReadOnly);
-        if (!file.isOpen())
-        {
             result = false;
             break;
         }
 
-        QTextStream ss(&file);
+        QTextStream ss(data);
 
         int i = 0;
         bool findHeader = false;
@@ -660,6 +717,32 @@ bool CapturedZipParser::parseTimeStamps()
     return result;
 }
 
+// the time stamps are saved in the chunks of the record file too
+void CapturedZipParser::parseRecordTimeStamps()
+{
+    const int depthTypes[] = { CAMERA_DATA_DEPTH, CAMERA_DATA_L, CAMERA_DATA_POINT_CLOUD };
+
+    m_depthTimeStamps.clear();
+    m_rgbTimeStamps.clear();
+    for (int i = 0; i < m_capturedFrameCount; i++)
+    {
+        double timeStamp = 0.0;
+        for (int type : depthTypes)
+        {
+            if (m_recordReader.getTimeStamp(i, type, timeStamp))
+            {
+                m_depthTimeStamps.push_back(qRound(timeStamp));
+                break;
+            }
+        }
+
+        if (m_recordReader.getTimeStamp(i, CAMERA_DATA_RGB, timeStamp))
+        {
+            m_rgbTimeStamps.push_back(qRound(timeStamp));
+        }
+    }
+}
+
 bool CapturedZipParser::checkTimeStampsValid()
 {
     int zeroCount = 0;
@@ -697,6 +780,17 @@ bool CapturedZipParser::isRawFormat()
     return m_dataFormat == "raw";
 }
 
+bool CapturedZipParser::isRvlFormat()
+{
+    return m_dataFormat == "rvl";
+}
+
+// RGB is saved as PNG in rvl format
+bool CapturedZipParser::isEncodedByRvl(int dataType)
+{
+    return isRvlFormat() && dataType != CAMERA_DATA_RGB;
+}
+
 QString CapturedZipParser::getCaptureName()
 {
     return m_captureName;
@@ -710,7 +804,7 @@ bool CapturedZipParser::getIsTimeStampsValid()
 QString CapturedZipParser::getFileName(int frameIndex, int dataType)
 {
     QString fileName;
-    QString suffix = isRawFormat() ? ".raw" : ".png";
+    QString suffix = getSuffix(dataType);
     switch (dataType)
     {
     case CAMERA_DATA_L:
@@ -740,6 +834,7 @@ QString CapturedZipParser::getFileName(int frameIndex, int dataType)
 QString CapturedZipParser::getFileName(int dataType, QString name)
 {
     QString fileName;
+    // the rvl data is decoded and saved as PNG, see saveImageData
     QString suffix = isRawFormat() ? ".raw" : ".png";
     switch (dataType)
     {
@@ -767,6 +862,16 @@ QString CapturedZipParser::getFileName(int dataType, QString name)
     return fileName;
 }
 
+QString CapturedZipParser::getSuffix(int dataType)
+{
+    if (isRawFormat())
+    {
+        return ".raw";
+    }
+
+    return isEncodedByRvl(dataType) ? ".rvl" : ".png";
+}
+
 bool CapturedZipParser::saveFrameToLocal(int frameIndex, bool withTexture, QString filePath)
 {
     QFileInfo info(filePath);
@@ -814,7 +919,20 @@ bool CapturedZipParser::saveImageData(int frameIndex, int dataType, QString file
     {
         return false;
     }
-    if (isRawFormat())
+
+    if (isEncodedByRvl(dataType))
+    {
+        int width, height, bitDepth;
+        QByteArray pixData;
+        if (!RvlCodec::decode(data, width, height, bitDepth, pixData))
+        {
+            qWarning() << "decode rvl data failed.";
+            return false;
+        }
+        data = pixData;
+    }
+
+    if (isRawFormat() || isEncodedByRvl(dataType))
     {
         if (dataType == CAMERA_DATA_DEPTH)
         {
@@ -843,6 +961,7 @@ bool CapturedZipParser::saveImageData(int frameIndex, int dataType, QString file
 
         file.write(data);
         file.close();
+        return true;
     }
 }
 
@@ -863,19 +982,7 @@ bool CapturedZipParser::savePointCloud(int frameIndex, bool withTexture, QString
         return false;
     }
 
-    QByteArray pathData = filePath.toLocal8Bit();
-    std::string realPath = pathData.data();
-
-    if (withTexture && !texImage.isNull())
-    {
-        pc.exportToFile(realPath, texImage.bits(), texImage.width(), texImage.height());
-    }
-    else
-    {
-        pc.exportToFile(realPath, nullptr, 0, 0);
-    }
-
-    return true;
+    return PlyWriter::savePointCloud(filePath, pc, withTexture ? texImage : QImage());
 }
 
 // Find Rules: Compare RGB and depth timestamp to find the nearest one
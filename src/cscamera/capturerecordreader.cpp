@@ -0,0 +1,392 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "capturerecordreader.h"
+#include "capturerecordwriter.h"
+
+#include <QMutexLocker>
+#include <QtEndian>
+#include <QDebug>
+#include <string.h>
+
+using namespace cs;
+
+static inline quint16 readU16(const char* p)
+{
+    return qFromLittleEndian<quint16>((const uchar*)p);
+}
+
+static inline quint32 readU32(const char* p)
+{
+    return qFromLittleEndian<quint32>((const uchar*)p);
+}
+
+static inline quint64 readU64(const char* p)
+{
+    return qFromLittleEndian<quint64>((const uchar*)p);
+}
+
+static inline double readF64(const char* p)
+{
+    quint64 bits = readU64(p);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+CaptureRecordReader::CaptureRecordReader()
+{
+
+}
+
+CaptureRecordReader::~CaptureRecordReader()
+{
+    close();
+}
+
+bool CaptureRecordReader::open(QString recordFile)
+{
+    close();
+
+    QMutexLocker locker(&m_mutex);
+
+    m_file.setFileName(recordFile);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "open record file failed, file:" << recordFile;
+        return false;
+    }
+
+    m_fileSize = m_file.size();
+    m_mappedData = (const char*)m_file.map(0, m_fileSize);
+    if (!m_mappedData)
+    {
+        qWarning() << "map record file failed, read it by file, file:" << recordFile;
+    }
+
+    if (!parseHeader())
+    {
+        qWarning() << "invalid record file, file:" << recordFile;
+        locker.unlock();
+        close();
+        return false;
+    }
+
+    if (!parseIndex())
+    {
+        qWarning() << "the index of record file is not found, scan the chunks, file:" << recordFile;
+        if (!scanChunks())
+        {
+            qWarning() << "some chunks of record file are broken, file:" << recordFile;
+        }
+    }
+
+    m_isOpen = true;
+    return true;
+}
+
+void CaptureRecordReader::close()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_mappedData)
+    {
+        m_file.unmap((uchar*)m_mappedData);
+        m_mappedData = nullptr;
+    }
+
+    if (m_file.isOpen())
+    {
+        m_file.close();
+    }
+
+    m_fileSize = 0;
+    m_isOpen = false;
+    m_cameraPara.clear();
+    m_chunksOffset = 0;
+    m_chunks.clear();
+    m_nameIndex.clear();
+    m_frameIndex.clear();
+    m_frameCount = 0;
+}
+
+bool CaptureRecordReader::isOpen()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isOpen;
+}
+
+bool CaptureRecordReader::contains(QString name)
+{
+    return m_nameIndex.contains(name);
+}
+
+bool CaptureRecordReader::readEntry(QString name, QByteArray& data)
+{
+    auto it = m_nameIndex.constFind(name);
+    if (it == m_nameIndex.constEnd())
+    {
+        return false;
+    }
+
+    return readChunkData(m_chunks.at(it.value()), data);
+}
+
+bool CaptureRecordReader::readFrame(int frameIndex, int dataType, QByteArray& data)
+{
+    auto it = m_frameIndex.constFind(genFrameKey(frameIndex, dataType));
+    if (it == m_frameIndex.constEnd())
+    {
+        return false;
+    }
+
+    return readChunkData(m_chunks.at(it.value()), data);
+}
+
+bool CaptureRecordReader::getTimeStamp(int frameIndex, int dataType, double& timeStamp)
+{
+    auto it = m_frameIndex.constFind(genFrameKey(frameIndex, dataType));
+    if (it == m_frameIndex.constEnd())
+    {
+        return false;
+    }
+
+    timeStamp = m_chunks.at(it.value()).timeStamp;
+    return true;
+}
+
+int CaptureRecordReader::getFrameCount()
+{
+    return m_frameCount;
+}
+
+QByteArray CaptureRecordReader::getCameraPara()
+{
+    return m_cameraPara;
+}
+
+bool CaptureRecordReader::parseHeader()
+{
+    char header[RECORD_HEADER_SIZE];
+    if (!readData(0, RECORD_HEADER_SIZE, header))
+    {
+        return false;
+    }
+
+    if (readU32(header) != RECORD_FILE_MAGIC)
+    {
+        return false;
+    }
+
+    const quint32 version = readU32(header + 4);
+    if (version > RECORD_FILE_VERSION)
+    {
+        qWarning() << "unsupported record file version:" << version;
+        return false;
+    }
+
+    const qint64 headerSize = readU32(header + 8);
+    const qint64 paraSize = readU32(header + 12);
+    if (headerSize < RECORD_HEADER_SIZE + paraSize || headerSize > m_fileSize)
+    {
+        return false;
+    }
+
+    m_cameraPara.resize(paraSize);
+    if (!readData(RECORD_HEADER_SIZE, paraSize, m_cameraPara.data()))
+    {
+        return false;
+    }
+
+    m_chunksOffset = headerSize;
+    return true;
+}
+
+bool CaptureRecordReader::parseIndex()
+{
+    if (m_fileSize < m_chunksOffset + RECORD_INDEX_HEADER_SIZE + RECORD_TRAILER_SIZE)
+    {
+        return false;
+    }
+
+    char trailer[RECORD_TRAILER_SIZE];
+    if (!readData(m_fileSize - RECORD_TRAILER_SIZE, RECORD_TRAILER_SIZE, trailer) || readU32(trailer + 12) != RECORD_TRAILER_MAGIC)
+    {
+        return false;
+    }
+
+    const qint64 indexOffset = readU64(trailer);
+    const qint64 indexSize = m_fileSize - RECORD_TRAILER_SIZE - indexOffset;
+    if (indexOffset < m_chunksOffset || indexSize < RECORD_INDEX_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    QByteArray index(indexSize, Qt::Uninitialized);
+    if (!readData(indexOffset, indexSize, index.data()))
+    {
+        return false;
+    }
+
+    const char* p = index.constData();
+    const char* end = p + indexSize;
+    const quint32 chunkCount = readU32(p + 4);
+    if (readU32(p) != RECORD_INDEX_MAGIC || chunkCount != readU32(trailer + 8))
+    {
+        return false;
+    }
+    p += RECORD_INDEX_HEADER_SIZE;
+
+    m_chunks.reserve(chunkCount);
+    for (quint32 i = 0; i < chunkCount; i++)
+    {
+        if (end - p < RECORD_INDEX_ENTRY_SIZE)
+        {
+            break;
+        }
+
+        const qint64 chunkOffset = readU64(p);
+        const int nameSize = readU16(p + 32);
+        if (end - p < RECORD_INDEX_ENTRY_SIZE + nameSize)
+        {
+            break;
+        }
+
+        RecordChunk chunk;
+        chunk.dataOffset = chunkOffset + RECORD_CHUNK_HEADER_SIZE + nameSize;
+        chunk.dataSize = readU64(p + 8);
+        chunk.timeStamp = readF64(p + 16);
+        chunk.frameIndex = (int)readU32(p + 24);
+        chunk.dataType = readU16(p + 28);
+        chunk.codec = readU16(p + 30);
+
+        if (chunkOffset < m_chunksOffset || chunk.dataOffset + chunk.dataSize > indexOffset)
+        {
+            break;
+        }
+
+        addChunk(QString::fromUtf8(p + RECORD_INDEX_ENTRY_SIZE, nameSize), chunk);
+        p += RECORD_INDEX_ENTRY_SIZE + nameSize;
+    }
+
+    if (m_chunks.size() != (int)chunkCount)
+    {
+        m_chunks.clear();
+        m_nameIndex.clear();
+        m_frameIndex.clear();
+        m_frameCount = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool CaptureRecordReader::scanChunks()
+{
+    qint64 offset = m_chunksOffset;
+    while (offset + RECORD_CHUNK_HEADER_SIZE <= m_fileSize)
+    {
+        char header[RECORD_CHUNK_HEADER_SIZE];
+        if (!readData(offset, RECORD_CHUNK_HEADER_SIZE, header))
+        {
+            return false;
+        }
+
+        // the index is reached, or the last chunk is not written completely
+        if (readU32(header) != RECORD_CHUNK_MAGIC)
+        {
+            return readU32(header) == RECORD_INDEX_MAGIC;
+        }
+
+        const int nameSize = readU16(header + 12);
+
+        RecordChunk chunk;
+        chunk.frameIndex = (int)readU32(header + 4);
+        chunk.dataType = readU16(header + 8);
+        chunk.codec = readU16(header + 10);
+        chunk.dataSize = readU64(header + 16);
+        chunk.timeStamp = readF64(header + 24);
+        chunk.dataOffset = offset + RECORD_CHUNK_HEADER_SIZE + nameSize;
+
+        if (chunk.dataSize < 0 || chunk.dataOffset + chunk.dataSize > m_fileSize)
+        {
+            return false;
+        }
+
+        QByteArray name(nameSize, Qt::Uninitialized);
+        if (!readData(offset + RECORD_CHUNK_HEADER_SIZE, nameSize, name.data()))
+        {
+            return false;
+        }
+
+        addChunk(QString::fromUtf8(name), chunk);
+        offset = chunk.dataOffset + chunk.dataSize;
+    }
+
+    return offset == m_fileSize;
+}
+
+void CaptureRecordReader::addChunk(QString name, const RecordChunk& chunk)
+{
+    const int index = m_chunks.size();
+    m_chunks.push_back(chunk);
+    m_nameIndex[name] = index;
+
+    if (chunk.frameIndex >= 0)
+    {
+        m_frameIndex[genFrameKey(chunk.frameIndex, chunk.dataType)] = index;
+        m_frameCount = qMax(m_frameCount, chunk.frameIndex + 1);
+    }
+}
+
+bool CaptureRecordReader::readData(qint64 offset, qint64 size, char* data)
+{
+    if (offset < 0 || size < 0 || offset + size > m_fileSize)
+    {
+        return false;
+    }
+
+    if (m_mappedData)
+    {
+        memcpy(data, m_mappedData + offset, size);
+        return true;
+    }
+
+    return m_file.seek(offset) && m_file.read(data, size) == size;
+}
+
+bool CaptureRecordReader::readChunkData(const RecordChunk& chunk, QByteArray& data)
+{
+    data.resize(chunk.dataSize);
+
+    // the mapped file is read by several threads without lock
+    if (m_mappedData)
+    {
+        return readData(chunk.dataOffset, chunk.dataSize, data.data());
+    }
+
+    QMutexLocker locker(&m_mutex);
+    return readData(chunk.dataOffset, chunk.dataSize, data.data());
+}
+
+qint64 CaptureRecordReader::genFrameKey(int frameIndex, int dataType)
+{
+    return ((qint64)dataType << 32) | (quint32)frameIndex;
+}
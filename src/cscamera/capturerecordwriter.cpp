@@ -0,0 +1,326 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "capturerecordwriter.h"
+
+#include <QMutexLocker>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <string.h>
+
+using namespace cs;
+
+// the savers wait while more than this is waiting to be written
+#define MAX_PENDING_BYTES (512 * 1024 * 1024)
+
+static inline void writeU16(QByteArray& data, quint16 value)
+{
+    uchar bytes[2];
+    qToLittleEndian<quint16>(value, bytes);
+    data.append((const char*)bytes, sizeof(bytes));
+}
+
+static inline void writeU32(QByteArray& data, quint32 value)
+{
+    uchar bytes[4];
+    qToLittleEndian<quint32>(value, bytes);
+    data.append((const char*)bytes, sizeof(bytes));
+}
+
+static inline void writeU64(QByteArray& data, quint64 value)
+{
+    uchar bytes[8];
+    qToLittleEndian<quint64>(value, bytes);
+    data.append((const char*)bytes, sizeof(bytes));
+}
+
+static inline void writeF64(QByteArray& data, double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    writeU64(data, bits);
+}
+
+CaptureRecordWriter::CaptureRecordWriter(QString recordFile, const QByteArray& cameraPara)
+    : m_recordFile(recordFile)
+    , m_cameraPara(cameraPara)
+{
+
+}
+
+CaptureRecordWriter::~CaptureRecordWriter()
+{
+    if (m_file.isOpen())
+    {
+        // the record file without index is still readable
+        waitForFrames();
+        m_file.close();
+    }
+}
+
+bool CaptureRecordWriter::start()
+{
+    m_file.setFileName(m_recordFile);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "create record file failed, file : " << m_recordFile << ", error : " << m_file.errorString();
+        return false;
+    }
+
+    m_stopping = false;
+    m_error = false;
+    m_writing = false;
+    m_nextSequence = 0;
+    m_writtenChunks.clear();
+
+    QByteArray header;
+    writeU32(header, RECORD_FILE_MAGIC);
+    writeU32(header, RECORD_FILE_VERSION);
+    writeU32(header, RECORD_HEADER_SIZE + m_cameraPara.size());
+    writeU32(header, m_cameraPara.size());
+    header.append(RECORD_HEADER_SIZE - header.size(), '\0');
+    header.append(m_cameraPara);
+
+    if (m_file.write(header) != header.size())
+    {
+        qWarning() << "write record header failed, file : " << m_recordFile << ", error : " << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    return true;
+}
+
+void CaptureRecordWriter::addEntry(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner)
+{
+    RecordChunk chunk;
+    chunk.info = info;
+    chunk.codec = getCodec(info.fileName);
+    chunk.data = data;
+    chunk.owner = owner;
+
+    QMutexLocker locker(&m_mutex);
+    m_pendingBytes += data.size();
+    m_pendingChunks[info.sequence].push_back(chunk);
+}
+
+void CaptureRecordWriter::commit(int sequence)
+{
+    QMutexLocker locker(&m_mutex);
+    m_committedSequences.insert(sequence);
+
+    // the saver thread which commits the next frame writes it, and the frames after it which are committed already
+    if (!m_writing)
+    {
+        writeFrames(locker);
+    }
+
+    // the frame is committed, so waiting here can not block the frames before it
+    while (m_pendingBytes > MAX_PENDING_BYTES && !m_stopping)
+    {
+        m_frameWritten.wait(&m_mutex);
+    }
+}
+
+void CaptureRecordWriter::waitForFrames()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stopping = true;
+    m_frameWritten.wakeAll();
+
+    while (m_writing)
+    {
+        m_frameWritten.wait(&m_mutex);
+    }
+
+    // the frames removed from the saving queue leave gaps in the sequences
+    writeFrames(locker);
+
+    // chunks of frames which are never committed
+    m_pendingChunks.clear();
+    m_pendingBytes = 0;
+}
+
+bool CaptureRecordWriter::addFile(QString name, const QByteArray& data, bool compress)
+{
+    Q_ASSERT(!m_writing);
+
+    RecordChunk chunk;
+    chunk.info.fileName = name;
+    chunk.codec = getCodec(name);
+    chunk.data = data;
+
+    if (!writeChunk(chunk))
+    {
+        m_error = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool CaptureRecordWriter::finish()
+{
+    Q_ASSERT(!m_writing);
+
+    if (!m_file.isOpen())
+    {
+        return false;
+    }
+
+    if (!writeIndex())
+    {
+        qWarning() << "write record index failed, file : " << m_recordFile << ", error : " << m_file.errorString();
+        m_error = true;
+    }
+
+    m_file.close();
+    if (m_file.error() != QFileDevice::NoError)
+    {
+        qWarning() << "close record file failed, file : " << m_recordFile << ", error : " << m_file.errorString();
+        m_error = true;
+    }
+
+    return !m_error;
+}
+
+int CaptureRecordWriter::getCodec(QString fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "png")
+    {
+        return RECORD_CODEC_PNG;
+    }
+    else if (suffix == "rvl")
+    {
+        return RECORD_CODEC_RVL;
+    }
+    else if (suffix == "raw")
+    {
+        return RECORD_CODEC_RAW;
+    }
+    else if (suffix == "ply")
+    {
+        return RECORD_CODEC_PLY;
+    }
+
+    return RECORD_CODEC_NONE;
+}
+
+void CaptureRecordWriter::writeFrames(QMutexLocker& locker)
+{
+    m_writing = true;
+    while (!m_committedSequences.isEmpty())
+    {
+        if (!m_committedSequences.contains(m_nextSequence))
+        {
+            if (!m_stopping)
+            {
+                break;
+            }
+
+            m_nextSequence = *std::min_element(m_committedSequences.begin(), m_committedSequences.end());
+        }
+
+        m_committedSequences.remove(m_nextSequence);
+        QList<RecordChunk> chunks = m_pendingChunks.take(m_nextSequence);
+        m_nextSequence++;
+
+        // write the frame without blocking the other savers
+        locker.unlock();
+        bool result = true;
+        qint64 writtenBytes = 0;
+        for (auto& chunk : chunks)
+        {
+            result &= writeChunk(chunk);
+            writtenBytes += chunk.data.size();
+        }
+        locker.relock();
+
+        m_error |= !result;
+        m_pendingBytes -= writtenBytes;
+        m_frameWritten.wakeAll();
+    }
+    m_writing = false;
+    m_frameWritten.wakeAll();
+}
+
+bool CaptureRecordWriter::writeChunk(RecordChunk& chunk)
+{
+    const QByteArray name = chunk.info.fileName.toUtf8();
+
+    QByteArray header;
+    header.reserve(RECORD_CHUNK_HEADER_SIZE + name.size());
+    writeU32(header, RECORD_CHUNK_MAGIC);
+    writeU32(header, (quint32)chunk.info.frameIndex);
+    writeU16(header, (quint16)chunk.info.dataType);
+    writeU16(header, (quint16)chunk.codec);
+    writeU16(header, (quint16)name.size());
+    writeU16(header, 0);
+    writeU64(header, (quint64)chunk.data.size());
+    writeF64(header, chunk.info.timeStamp);
+    header.append(name);
+
+    chunk.offset = m_file.pos();
+    if (m_file.write(header) != header.size() || m_file.write(chunk.data) != chunk.data.size())
+    {
+        qWarning() << "write record chunk failed, chunk : " << chunk.info.fileName << ", error : " << m_file.errorString();
+        return false;
+    }
+
+    // keep the data out of the index
+    RecordChunk writtenChunk = chunk;
+    writtenChunk.dataSize = chunk.data.size();
+    writtenChunk.data.clear();
+    writtenChunk.owner.clear();
+    m_writtenChunks.push_back(writtenChunk);
+
+    return true;
+}
+
+bool CaptureRecordWriter::writeIndex()
+{
+    const qint64 indexOffset = m_file.pos();
+
+    QByteArray index;
+    writeU32(index, RECORD_INDEX_MAGIC);
+    writeU32(index, m_writtenChunks.size());
+    for (const auto& chunk : m_writtenChunks)
+    {
+        const QByteArray name = chunk.info.fileName.toUtf8();
+
+        writeU64(index, chunk.offset);
+        writeU64(index, chunk.dataSize);
+        writeF64(index, chunk.info.timeStamp);
+        writeU32(index, (quint32)chunk.info.frameIndex);
+        writeU16(index, (quint16)chunk.info.dataType);
+        writeU16(index, (quint16)chunk.codec);
+        writeU16(index, (quint16)name.size());
+        index.append(name);
+    }
+
+    writeU64(index, indexOffset);
+    writeU32(index, m_writtenChunks.size());
+    writeU32(index, RECORD_TRAILER_MAGIC);
+
+    return m_file.write(index) == index.size() && m_file.flush();
+}
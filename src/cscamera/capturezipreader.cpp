@@ -0,0 +1,568 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "capturezipreader.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QBuffer>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <QDebug>
+#include <quazip.h>
+#include <quazipfile.h>
+#include <quacrc32.h>
+
+using namespace cs;
+
+#define ZIP_LOCAL_HEADER_SIGNATURE          0x04034b50
+#define ZIP_CENTRAL_HEADER_SIGNATURE        0x02014b50
+#define ZIP_END_SIGNATURE                   0x06054b50
+#define ZIP64_END_LOCATOR_SIGNATURE         0x07064b50
+#define ZIP64_END_SIGNATURE                 0x06064b50
+#define ZIP64_EXTRA_ID                      0x0001
+
+#define ZIP_LOCAL_HEADER_SIZE               30
+#define ZIP_CENTRAL_HEADER_SIZE             46
+#define ZIP_END_SIZE                        22
+#define ZIP64_END_LOCATOR_SIZE              20
+#define ZIP64_END_SIZE                      56
+#define ZIP_MAX_COMMENT_SIZE                0xFFFF
+#define ZIP_UTF8_FLAG                       0x0800
+
+#define INDEX_FILE_SUFFIX                   ".index"
+#define INDEX_FILE_MAGIC                    0x43535A49
+#define INDEX_FILE_VERSION                  1
+// magic, version, zip size, zip modified time and entry count
+#define INDEX_FILE_HEADER_SIZE              28
+// an empty name, the offset, the sizes, crc and method
+#define INDEX_ENTRY_MIN_SIZE                34
+
+static inline quint16 readU16(const char* p)
+{
+    return qFromLittleEndian<quint16>((const uchar*)p);
+}
+
+static inline quint32 readU32(const char* p)
+{
+    return qFromLittleEndian<quint32>((const uchar*)p);
+}
+
+static inline quint64 readU64(const char* p)
+{
+    return qFromLittleEndian<quint64>((const uchar*)p);
+}
+
+static inline void writeU16(QByteArray& data, quint16 value)
+{
+    uchar bytes[2];
+    qToLittleEndian<quint16>(value, bytes);
+    data.append((const char*)bytes, sizeof(bytes));
+}
+
+static inline void writeU32(QByteArray& data, quint32 value)
+{
+    uchar bytes[4];
+    qToLittleEndian<quint32>(value, bytes);
+    data.append((const char*)bytes, sizeof(bytes));
+}
+
+CaptureZipReader::CaptureZipReader()
+{
+
+}
+
+CaptureZipReader::~CaptureZipReader()
+{
+    close();
+}
+
+bool CaptureZipReader::open(QString zipFile, bool useIndexFile)
+{
+    close();
+
+    QMutexLocker locker(&m_mutex);
+
+    QFileInfo info(zipFile);
+    const qint64 zipSize = info.size();
+    const qint64 zipModified = info.lastModified().toMSecsSinceEpoch();
+    const QString indexFile = zipFile + INDEX_FILE_SUFFIX;
+
+    if (useIndexFile && loadIndexFile(indexFile, zipSize, zipModified))
+    {
+        m_zipFile = zipFile;
+        m_isOpen = true;
+        return true;
+    }
+
+    QFile file(zipFile);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "open zip file failed, file:" << zipFile;
+        return false;
+    }
+
+    if (!parseCentralDirectory(file))
+    {
+        qWarning() << "parse zip file failed, file:" << zipFile;
+        m_entries.clear();
+        return false;
+    }
+
+    if (useIndexFile)
+    {
+        saveIndexFile(indexFile, zipSize, zipModified);
+    }
+
+    m_zipFile = zipFile;
+    m_isOpen = true;
+    return true;
+}
+
+void CaptureZipReader::close()
+{
+    QMutexLocker locker(&m_mutex);
+
+    qDeleteAll(m_freeFiles);
+    m_freeFiles.clear();
+    m_entries.clear();
+    m_zipFile.clear();
+    m_isOpen = false;
+}
+
+bool CaptureZipReader::isOpen()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isOpen;
+}
+
+bool CaptureZipReader::contains(QString name)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(name);
+}
+
+bool CaptureZipReader::readEntry(QString name, QByteArray& data)
+{
+    ZipEntry entry;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.constFind(name);
+        if (it == m_entries.constEnd())
+        {
+            qWarning() << "entry not found, name:" << name;
+            return false;
+        }
+        entry = it.value();
+    }
+
+    QFile* file = acquireFile();
+    if (!file)
+    {
+        return false;
+    }
+
+    bool result = readEntryData(*file, entry, data);
+    releaseFile(file);
+
+    if (!result)
+    {
+        qWarning() << "read entry failed, name:" << name;
+    }
+
+    return result;
+}
+
+bool CaptureZipReader::parseCentralDirectory(QFile& file)
+{
+    const qint64 fileSize = file.size();
+    if (fileSize < ZIP_END_SIZE)
+    {
+        return false;
+    }
+
+    // the end of central directory record is followed by the comment
+    const qint64 tailSize = qMin<qint64>(fileSize, ZIP_END_SIZE + ZIP_MAX_COMMENT_SIZE + ZIP64_END_LOCATOR_SIZE);
+    file.seek(fileSize - tailSize);
+    const QByteArray tail = file.read(tailSize);
+    if (tail.size() != tailSize)
+    {
+        return false;
+    }
+
+    int endPos = -1;
+    for (int i = tail.size() - ZIP_END_SIZE; i >= 0; i--)
+    {
+        if (readU32(tail.constData() + i) == ZIP_END_SIGNATURE)
+        {
+            endPos = i;
+            break;
+        }
+    }
+
+    if (endPos < 0)
+    {
+        return false;
+    }
+
+    const char* end = tail.constData() + endPos;
+    quint64 entryCount = readU16(end + 10);
+    quint64 directorySize = readU32(end + 12);
+    quint64 directoryOffset = readU32(end + 16);
+
+    // zip64 end of central directory
+    if (endPos >= ZIP64_END_LOCATOR_SIZE && readU32(end - ZIP64_END_LOCATOR_SIZE) == ZIP64_END_LOCATOR_SIGNATURE)
+    {
+        const qint64 zip64EndOffset = readU64(end - ZIP64_END_LOCATOR_SIZE + 8);
+
+        file.seek(zip64EndOffset);
+        const QByteArray zip64End = file.read(ZIP64_END_SIZE);
+        if (zip64End.size() != ZIP64_END_SIZE || readU32(zip64End.constData()) != ZIP64_END_SIGNATURE)
+        {
+            return false;
+        }
+
+        entryCount = readU64(zip64End.constData() + 32);
+        directorySize = readU64(zip64End.constData() + 40);
+        directoryOffset = readU64(zip64End.constData() + 48);
+    }
+
+    if (directoryOffset + directorySize > (quint64)fileSize)
+    {
+        return false;
+    }
+
+    file.seek(directoryOffset);
+    const QByteArray directory = file.read(directorySize);
+    if ((quint64)directory.size() != directorySize)
+    {
+        return false;
+    }
+
+    // a central directory header takes 46 bytes at least
+    if (entryCount > directorySize / ZIP_CENTRAL_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    m_entries.clear();
+    m_entries.reserve((int)entryCount);
+
+    const char* p = directory.constData();
+    const char* directoryEnd = p + directory.size();
+    for (quint64 i = 0; i < entryCount; i++)
+    {
+        if (directoryEnd - p < ZIP_CENTRAL_HEADER_SIZE || readU32(p) != ZIP_CENTRAL_HEADER_SIGNATURE)
+        {
+            return false;
+        }
+
+        const quint16 flags = readU16(p + 8);
+        const quint16 nameSize = readU16(p + 28);
+        const quint16 extraSize = readU16(p + 30);
+        const quint16 commentSize = readU16(p + 32);
+
+        const int headerSize = ZIP_CENTRAL_HEADER_SIZE + nameSize + extraSize + commentSize;
+        if (directoryEnd - p < headerSize)
+        {
+            return false;
+        }
+
+        ZipEntry entry;
+        entry.method = readU16(p + 10);
+        entry.crc = readU32(p + 16);
+        entry.compressedSize = readU32(p + 20);
+        entry.uncompressedSize = readU32(p + 24);
+        entry.localHeaderOffset = readU32(p + 42);
+
+        const char* name = p + ZIP_CENTRAL_HEADER_SIZE;
+        const QString entryName = (flags & ZIP_UTF8_FLAG) ? QString::fromUtf8(name, nameSize) : QString::fromLocal8Bit(name, nameSize);
+
+        // the sizes and offset are in the zip64 extra field if they do not fit in 32 bits
+        const char* extra = name + nameSize;
+        const char* extraEnd = extra + extraSize;
+        while (extraEnd - extra >= 4)
+        {
+            const quint16 id = readU16(extra);
+            const quint16 size = readU16(extra + 2);
+            const char* field = extra + 4;
+            const char* fieldEnd = field + qMin<int>(size, extraEnd - field);
+
+            if (id == ZIP64_EXTRA_ID)
+            {
+                if (entry.uncompressedSize == 0xFFFFFFFF && fieldEnd - field >= 8)
+                {
+                    entry.uncompressedSize = readU64(field);
+                    field += 8;
+                }
+
+                if (entry.compressedSize == 0xFFFFFFFF && fieldEnd - field >= 8)
+                {
+                    entry.compressedSize = readU64(field);
+                    field += 8;
+                }
+
+                if (entry.localHeaderOffset == 0xFFFFFFFF && fieldEnd - field >= 8)
+                {
+                    entry.localHeaderOffset = readU64(field);
+                }
+                break;
+            }
+
+            extra = fieldEnd;
+        }
+
+        m_entries.insert(entryName, entry);
+        p += headerSize;
+    }
+
+    return true;
+}
+
+bool CaptureZipReader::loadIndexFile(QString indexFile, qint64 zipSize, qint64 zipModified)
+{
+    QFile file(indexFile);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0, entryCount = 0;
+    qint64 size = 0, modified = 0;
+    stream >> magic >> version >> size >> modified >> entryCount;
+
+    // the zip file is changed after the index file is saved
+    if (magic != INDEX_FILE_MAGIC || version != INDEX_FILE_VERSION || size != zipSize || modified != zipModified)
+    {
+        return false;
+    }
+
+    // the entry count is not trusted before it is checked against the file size
+    if (entryCount > (file.size() - INDEX_FILE_HEADER_SIZE) / INDEX_ENTRY_MIN_SIZE)
+    {
+        return false;
+    }
+
+    m_entries.clear();
+    m_entries.reserve(entryCount);
+    for (quint32 i = 0; i < entryCount && stream.status() == QDataStream::Ok; i++)
+    {
+        QString name;
+        ZipEntry entry;
+        stream >> name >> entry.localHeaderOffset >> entry.compressedSize >> entry.uncompressedSize >> entry.crc >> entry.method;
+        m_entries.insert(name, entry);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        qWarning() << "load index file failed, file:" << indexFile;
+        m_entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void CaptureZipReader::saveIndexFile(QString indexFile, qint64 zipSize, qint64 zipModified)
+{
+    // the index is only a cache, the capture folder may be read-only
+    QFile file(indexFile);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << (quint32)INDEX_FILE_MAGIC << (quint32)INDEX_FILE_VERSION << zipSize << zipModified << (quint32)m_entries.size();
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+    {
+        const ZipEntry& entry = it.value();
+        stream << it.key() << entry.localHeaderOffset << entry.compressedSize << entry.uncompressedSize << entry.crc << entry.method;
+    }
+
+    // do not leave a truncated index file
+    if (stream.status() != QDataStream::Ok)
+    {
+        file.remove();
+    }
+}
+
+bool CaptureZipReader::readEntryData(QFile& file, const ZipEntry& entry, QByteArray& data)
+{
+    if (!file.seek(entry.localHeaderOffset))
+    {
+        return false;
+    }
+
+    // the local extra field may differ from the one in central directory
+    const QByteArray header = file.read(ZIP_LOCAL_HEADER_SIZE);
+    if (header.size() != ZIP_LOCAL_HEADER_SIZE || readU32(header.constData()) != ZIP_LOCAL_HEADER_SIGNATURE)
+    {
+        return false;
+    }
+
+    const qint64 dataOffset = entry.localHeaderOffset + ZIP_LOCAL_HEADER_SIZE + readU16(header.constData() + 26) + readU16(header.constData() + 28);
+    if (!file.seek(dataOffset))
+    {
+        return false;
+    }
+
+    QByteArray compressedData = file.read(entry.compressedSize);
+    if (compressedData.size() != entry.compressedSize)
+    {
+        return false;
+    }
+
+    // stored
+    if (entry.method == 0)
+    {
+        data = compressedData;
+        return QuaCrc32().calculate(data) == entry.crc;
+    }
+
+    return inflateEntry(entry, compressedData, data);
+}
+
+// The functions of zlib are not exported by quazip on all platforms, so the deflated data is
+// put into a zip of the single entry in memory and read by QuaZipFile, which checks the crc as well.
+bool CaptureZipReader::inflateEntry(const ZipEntry& entry, const QByteArray& compressedData, QByteArray& data)
+{
+    if (entry.compressedSize >= 0xFFFFFFFF || entry.uncompressedSize >= 0xFFFFFFFF)
+    {
+        qWarning() << "the entry is too large to inflate";
+        return false;
+    }
+
+    const QByteArray name("entry");
+
+    QByteArray zipData;
+    zipData.reserve(ZIP_LOCAL_HEADER_SIZE + ZIP_CENTRAL_HEADER_SIZE + ZIP_END_SIZE + 2 * name.size() + compressedData.size());
+
+    // local header
+    writeU32(zipData, ZIP_LOCAL_HEADER_SIGNATURE);
+    writeU16(zipData, 20);
+    writeU16(zipData, 0);
+    writeU16(zipData, entry.method);
+    writeU32(zipData, 0);
+    writeU32(zipData, entry.crc);
+    writeU32(zipData, entry.compressedSize);
+    writeU32(zipData, entry.uncompressedSize);
+    writeU16(zipData, name.size());
+    writeU16(zipData, 0);
+    zipData.append(name);
+    zipData.append(compressedData);
+
+    // central directory
+    const quint32 directoryOffset = zipData.size();
+    writeU32(zipData, ZIP_CENTRAL_HEADER_SIGNATURE);
+    writeU16(zipData, 20);
+    writeU16(zipData, 20);
+    writeU16(zipData, 0);
+    writeU16(zipData, entry.method);
+    writeU32(zipData, 0);
+    writeU32(zipData, entry.crc);
+    writeU32(zipData, entry.compressedSize);
+    writeU32(zipData, entry.uncompressedSize);
+    writeU16(zipData, name.size());
+    writeU16(zipData, 0);
+    writeU16(zipData, 0);
+    writeU16(zipData, 0);
+    writeU16(zipData, 0);
+    writeU32(zipData, 0);
+    writeU32(zipData, 0);
+    zipData.append(name);
+
+    // end of central directory
+    const quint32 directorySize = zipData.size() - directoryOffset;
+    writeU32(zipData, ZIP_END_SIGNATURE);
+    writeU16(zipData, 0);
+    writeU16(zipData, 0);
+    writeU16(zipData, 1);
+    writeU16(zipData, 1);
+    writeU32(zipData, directorySize);
+    writeU32(zipData, directoryOffset);
+    writeU16(zipData, 0);
+
+    QBuffer buffer(&zipData);
+    QuaZip zip(&buffer);
+    if (!zip.open(QuaZip::mdUnzip) || !zip.goToFirstFile())
+    {
+        return false;
+    }
+
+    QuaZipFile file(&zip);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    data = file.readAll();
+    file.close();
+
+    // the crc is checked when closing the file
+    bool result = (file.getZipError() == UNZ_OK) && (data.size() == entry.uncompressedSize);
+    zip.close();
+
+    return result;
+}
+
+QFile* CaptureZipReader::acquireFile()
+{
+    QString zipFile;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_freeFiles.isEmpty())
+        {
+            return m_freeFiles.takeLast();
+        }
+        zipFile = m_zipFile;
+    }
+
+    QFile* file = new QFile(zipFile);
+    if (!file->open(QIODevice::ReadOnly))
+    {
+        qWarning() << "open zip file failed, file:" << zipFile;
+        delete file;
+        return nullptr;
+    }
+
+    return file;
+}
+
+void CaptureZipReader::releaseFile(QFile* file)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // the zip file is closed or reopened while reading
+    if (file->fileName() != m_zipFile)
+    {
+        delete file;
+        return;
+    }
+
+    m_freeFiles.push_back(file);
+}
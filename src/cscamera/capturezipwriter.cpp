@@ -0,0 +1,239 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "capturezipwriter.h"
+
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <quazipfile.h>
+#include <quazipnewinfo.h>
+#include <quacrc32.h>
+
+using namespace cs;
+
+// the savers wait while more than this is waiting to be written
+#define MAX_PENDING_BYTES (512 * 1024 * 1024)
+
+// qCompress output: 4 bytes of uncompressed size, 2 bytes of zlib header, raw deflate data, 4 bytes of adler32
+#define QCOMPRESS_HEADER_SIZE 6
+#define QCOMPRESS_TRAILER_SIZE 4
+
+CaptureZipWriter::CaptureZipWriter(QString zipFile)
+    : m_zipFile(zipFile)
+{
+
+}
+
+CaptureZipWriter::~CaptureZipWriter()
+{
+    if (isRunning())
+    {
+        waitForFrames();
+    }
+
+    if (m_zip.isOpen())
+    {
+        m_zip.close();
+    }
+}
+
+bool CaptureZipWriter::start()
+{
+    m_zip.setZipName(m_zipFile);
+    // captures may be larger than 4GB
+    m_zip.setZip64Enabled(true);
+
+    if (!m_zip.open(QuaZip::mdCreate))
+    {
+        qWarning() << "create zip file failed, file : " << m_zipFile << ", error : " << m_zip.getZipError();
+        return false;
+    }
+
+    m_stopping = false;
+    m_error = false;
+    m_nextSequence = 0;
+
+    QThread::start();
+    return true;
+}
+
+void CaptureZipWriter::addEntry(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner)
+{
+    // compress in the saver thread
+    ZipEntry entry = genEntry(info.fileName, data, compress);
+    if (entry.method == 0)
+    {
+        entry.owner = owner;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_pendingBytes += entry.data.size();
+    m_pendingEntries[info.sequence].push_back(entry);
+}
+
+void CaptureZipWriter::commit(int sequence)
+{
+    QMutexLocker locker(&m_mutex);
+    m_committedSequences.insert(sequence);
+    m_frameCommitted.wakeAll();
+
+    // the frame is committed, so waiting here can not block the frames before it
+    while (m_pendingBytes > MAX_PENDING_BYTES && !m_stopping)
+    {
+        m_frameWritten.wait(&m_mutex);
+    }
+}
+
+void CaptureZipWriter::waitForFrames()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_frameCommitted.wakeAll();
+        m_frameWritten.wakeAll();
+    }
+
+    wait();
+}
+
+bool CaptureZipWriter::addFile(QString name, const QByteArray& data, bool compress)
+{
+    Q_ASSERT(!isRunning());
+
+    if (!writeEntry(genEntry(name, data, compress)))
+    {
+        m_error = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool CaptureZipWriter::finish()
+{
+    Q_ASSERT(!isRunning());
+
+    m_zip.close();
+    if (m_zip.getZipError() != UNZ_OK)
+    {
+        qWarning() << "close zip file failed, file : " << m_zipFile << ", error : " << m_zip.getZipError();
+        m_error = true;
+    }
+
+    return !m_error;
+}
+
+void CaptureZipWriter::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (true)
+    {
+        if (!m_committedSequences.contains(m_nextSequence))
+        {
+            if (!m_stopping)
+            {
+                m_frameCommitted.wait(&m_mutex);
+                continue;
+            }
+
+            if (m_committedSequences.isEmpty())
+            {
+                break;
+            }
+
+            // the frames removed from the saving queue leave gaps in the sequences
+            m_nextSequence = *std::min_element(m_committedSequences.begin(), m_committedSequences.end());
+        }
+
+        m_committedSequences.remove(m_nextSequence);
+        QList<ZipEntry> entries = m_pendingEntries.take(m_nextSequence);
+        m_nextSequence++;
+
+        // write the frame without blocking the savers
+        locker.unlock();
+        bool result = true;
+        qint64 writtenBytes = 0;
+        for (const auto& entry : entries)
+        {
+            result &= writeEntry(entry);
+            writtenBytes += entry.data.size();
+        }
+        locker.relock();
+
+        m_error |= !result;
+        m_pendingBytes -= writtenBytes;
+        m_frameWritten.wakeAll();
+    }
+
+    // entries of frames which are never committed
+    m_pendingEntries.clear();
+    m_pendingBytes = 0;
+}
+
+CaptureZipWriter::ZipEntry CaptureZipWriter::genEntry(QString name, const QByteArray& data, bool compress)
+{
+    ZipEntry entry;
+    entry.name = name;
+    entry.crc = QuaCrc32().calculate(data);
+    entry.uncompressedSize = data.size();
+
+    QByteArray compressedData = compress ? qCompress(data) : QByteArray();
+    const int deflateSize = compressedData.size() - QCOMPRESS_HEADER_SIZE - QCOMPRESS_TRAILER_SIZE;
+
+    // store the data if deflate does not make it smaller
+    if (compress && deflateSize > 0 && deflateSize < data.size())
+    {
+        entry.method = Z_DEFLATED;
+        entry.data = compressedData.mid(QCOMPRESS_HEADER_SIZE, deflateSize);
+    }
+    else
+    {
+        entry.method = 0;
+        entry.data = data;
+    }
+
+    return entry;
+}
+
+bool CaptureZipWriter::writeEntry(const ZipEntry& entry)
+{
+    QuaZipNewInfo info(entry.name);
+    info.uncompressedSize = entry.uncompressedSize;
+
+    // the data is compressed already, write it in raw mode
+    QuaZipFile file(&m_zip);
+    if (!file.open(QIODevice::WriteOnly, info, nullptr, entry.crc, entry.method, Z_DEFAULT_COMPRESSION, true))
+    {
+        qWarning() << "open zip entry failed, entry : " << entry.name << ", error : " << file.getZipError();
+        return false;
+    }
+
+    const bool result = (file.write(entry.data) == entry.data.size());
+    file.close();
+
+    if (!result || file.getZipError() != UNZ_OK)
+    {
+        qWarning() << "write zip entry failed, entry : " << entry.name << ", error : " << file.getZipError();
+        return false;
+    }
+
+    return true;
+}
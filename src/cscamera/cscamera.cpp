@@ -19,6 +19,7 @@
 
 #include "cscamera.h"
 #include "cameraparaid.h"
+#include "pipelinestats.h"
 
 #include <QDebug>
 #include <QSize>
@@ -29,6 +30,7 @@
 #include <QMetaEnum>
 #include <algorithm>
 #include <3DCamera.hpp>
+#include <cstracer.h>
 
 static CSRange DEPTH_RANGE_LIMIT = { 0, 65535 };
 static CSRange CAMERA_HDR_LEVEL_RANGE = { 2,8 };
@@ -175,6 +177,9 @@ static void depthCallback(cs::IFramePtr frame, void* usrData)
     CSCamera* camera = (CSCamera*)usrData;
 
     FrameData frameData;
+    frameData.receivedTime = PipelineStats::now();
+    CS_TRACE_INSTANT_FRAME("frame received", frameData.receivedTime);
+    CS_TRACE_SCOPE_FRAME("CSCamera::depthCallback", frameData.receivedTime);
     camera->onProcessFrame(TYPE_DEPTH, frame, frameData.data);
    
     emit camera->framedDataUpdated(frameData);
@@ -185,6 +190,9 @@ static void rgbCallback(cs::IFramePtr frame, void* usrData)
     CSCamera* camera = (CSCamera*)usrData;
 
     FrameData frameData;
+    frameData.receivedTime = PipelineStats::now();
+    CS_TRACE_INSTANT_FRAME("frame received", frameData.receivedTime);
+    CS_TRACE_SCOPE_FRAME("CSCamera::rgbCallback", frameData.receivedTime);
     camera->onProcessFrame(TYPE_RGB, frame, frameData.data);
     emit camera->framedDataUpdated(frameData);
 }
@@ -204,6 +212,10 @@ void CSCamera::StreamThread::run()
 
         if (frameData.data.size() > 0)
         {
+            frameData.receivedTime = PipelineStats::now();
+            CS_TRACE_INSTANT_FRAME("frame received", frameData.receivedTime);
+            CS_TRACE_SCOPE_FRAME("StreamThread::notifyFrame", frameData.receivedTime);
+
             frameData.rgbIntrinsics = m_camera.m_rgbIntrinsics;
             frameData.depthIntrinsics = m_camera.m_depthIntrinsics;
             frameData.extrinsics = m_camera.m_extrinsics;
@@ -215,6 +227,7 @@ void CSCamera::StreamThread::run()
         if (ret == ERROR_DEVICE_NOT_CONNECT)
         {
             // If the return value indicates that the camera is not connected, add a delay.
+            CS_TRACE_SCOPE("StreamThread::waitConnected");
             QThread::msleep(200);
         }
     }
@@ -259,10 +272,14 @@ CSCamera::~CSCamera()
 bool CSCamera::restartStream()
 {
     qInfo() << "begin restart stream.";
+    CS_TRACE_SCOPE("CSCamera::restartStream");
     
     // start stream after stop stream
     bool result = stopStream();
-    QThread::msleep(200);
+    {
+        CS_TRACE_SCOPE("CSCamera::restartStream sleep");
+        QThread::msleep(200);
+    }
     result &= startStream();
 
     qDebug() << "restartStream end!";
@@ -394,6 +411,8 @@ bool CSCamera::startDepthStream()
         qWarning("start depth format:%2d, width:%4d, height:%4d, fps:%2.1f", info.format, info.width, info.height, info.fps);
     }
 
+    m_depthBufferPool.reset(FrameBufferPool::calcFrameSize(info.format, info.width, info.height));
+
     m_hasIrStream = m_isDepthStreamSup && ((info.format == STREAM_FORMAT_Z16Y8Y8) || (info.format == STREAM_FORMAT_PAIR));
     m_hasDepthStream = m_isDepthStreamSup && (info.format != STREAM_FORMAT_PAIR);
 
@@ -417,6 +436,8 @@ bool CSCamera::startRgbStream()
         return false;
     }
 
+    m_rgbBufferPool.reset(FrameBufferPool::calcFrameSize(info.format, info.width, info.height));
+
     return ret == SUCCESS;
 }
 
@@ -635,6 +656,7 @@ bool CSCamera::softTrigger()
         return false;
     }
 
+    CS_TRACE_SCOPE("CSCamera::softTrigger");
     int frameCount = (m_filterType == FILTER_TDSMOOTH) ? m_filterValue : 1;
   
     bool result = true;
@@ -656,6 +678,9 @@ bool CSCamera::softTrigger()
     // notify
     if (frameData.data.size() > 0)
     {
+        frameData.receivedTime = PipelineStats::now();
+        CS_TRACE_INSTANT_FRAME("frame received", frameData.receivedTime);
+
         frameData.rgbIntrinsics = m_rgbIntrinsics;
         frameData.depthIntrinsics = m_depthIntrinsics;
         frameData.extrinsics = m_extrinsics;
@@ -806,6 +831,7 @@ void CSCamera::initDefaultStreamInfo()
 
 int CSCamera::doGetFrame(QVector<StreamData>& streamDatas, int timeout)
 {
+    CS_TRACE_SCOPE("CSCamera::getFrame");
     auto ret = SUCCESS;
 
     if (m_isRgbStreamSup)
@@ -849,13 +875,13 @@ bool CSCamera::onProcessFrame(STREAM_DATA_TYPE streamDataType, const IFramePtr&
         return false;
     }
 
+    CS_TRACE_SCOPE("CSCamera::copyFrame");
     StreamDataInfo streamDataInfo = { streamDataType, frame->getFormat(),frame->getWidth(), frame->getHeight(), frame->getTimeStamp()};
     const int dataSize = frame->getSize();
 
-    //copy data
-    QByteArray data;
-    data.resize(dataSize);
-    memcpy(data.data(), frame->getData(), dataSize);
+    //copy data to a recycled buffer
+    FrameBufferPool& pool = (streamDataType == TYPE_RGB) ? m_rgbBufferPool : m_depthBufferPool;
+    QByteArray data = pool.acquire(frame->getData(), dataSize);
 
     StreamData streamData = { streamDataInfo, data };
 
@@ -19,14 +19,48 @@
 
 #include "formatconverter.h"
 #include "capturedzipparser.h"
+#include "plywriter.h"
 
 #include <QDir>
 #include <QDebug>
+#include <QRunnable>
+#include <QMutexLocker>
+
+#define MAX_CONVERT_THREAD      8
+// frames submitted but not reported yet, it limits the memory used by the decoded frames
+#define MAX_CONVERT_INFLIGHT    (2 * MAX_CONVERT_THREAD)
+
+namespace cs
+{
+class FrameConvertTask : public QRunnable
+{
+public:
+    FrameConvertTask(FormatConverter* converter, int frameIndex, bool withTexture)
+        : m_converter(converter)
+        , m_frameIndex(frameIndex)
+        , m_withTexture(withTexture)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_converter->runConvertTask(m_frameIndex, m_withTexture);
+    }
+private:
+    FormatConverter* m_converter;
+    int m_frameIndex;
+    bool m_withTexture;
+};
+}
 
 using namespace cs;
 
 FormatConverter::FormatConverter()
 {
+    int maxThread = QThread::idealThreadCount() > MAX_CONVERT_THREAD ? MAX_CONVERT_THREAD : QThread::idealThreadCount();
+    m_threadPool.setMaxThreadCount(qMax(1, maxThread));
+
     moveToThread(this);
     start();
 
@@ -35,6 +69,7 @@ FormatConverter::FormatConverter()
 
 FormatConverter::~FormatConverter()
 {
+    m_threadPool.waitForDone();
     if (m_capturedZipParser)
     {
         delete m_capturedZipParser;
@@ -135,57 +170,71 @@ void FormatConverter::onConvert()
             }
         }
 
-        int couvertCount = 0;
         const int totalCount = m_capturedZipParser->getFrameCount();
-        QString fileName = m_capturedZipParser->getCaptureName();
+        const bool convertWithTexture = m_withTexture && m_hasRGBData;
 
         int successCount = 0;
-        bool convertWithTexture = m_withTexture && m_hasRGBData;
+        // the next frame to convert, and the next frame to report
+        int submitCount = 0;
+        int reportCount = 0;
 
-        for (couvertCount = 0; couvertCount < totalCount; couvertCount++)
+        m_frameResults.clear();
+        while (reportCount < totalCount)
         {
-            if (getInterruptConvert())
+            int result;
             {
-                break;
+                QMutexLocker locker(&m_convertMutex);
+
+                // keep a bounded window of frames in flight
+                while (!getInterruptConvert() && submitCount < totalCount && submitCount - reportCount < MAX_CONVERT_INFLIGHT)
+                {
+                    m_threadPool.start(new FrameConvertTask(this, submitCount, convertWithTexture));
+                    submitCount++;
+                }
+
+                // interrupted, all the submitted frames are reported
+                if (reportCount == submitCount)
+                {
+                    break;
+                }
+
+                while (!m_frameResults.contains(reportCount))
+                {
+                    m_frameConverted.wait(&m_convertMutex);
+                }
+                result = m_frameResults.take(reportCount);
             }
 
-            Pointcloud pc;
-            QImage texImage;
-            int rgbIndex = couvertCount;
-
-            // If the timestamp is valid, find the RGB frame index through the timestamp
-            if (convertWithTexture  && m_capturedZipParser->getIsTimeStampsValid())
+            // report the results in frame order
+            const int frameIndex = reportCount++;
+            switch (result)
+            {
+            case FRAME_CONVERT_SUCCESS:
             {
-                rgbIndex = m_capturedZipParser->getRgbFrameIndexByTimeStamp(couvertCount);
+                successCount++;
+                int progress = successCount * 1.0 / totalCount * 100;
+                emit convertStateChanged(CONVERTING, progress, tr("Converting..."));
+                break;
             }
-
-            if (!m_capturedZipParser->generatePointCloud(couvertCount, rgbIndex, convertWithTexture, pc, texImage))
+            case FRAME_GENERATE_FAILED:
             {
-                qWarning() << "Failed to generate point cloud";
-                int progress = couvertCount * 1.0 / totalCount * 100;
+                int progress = frameIndex * 1.0 / totalCount * 100;
                 emit convertStateChanged(CONVERT_ERROR, progress, tr("Failed to generate point cloud"));
-                continue;
+                break;
             }
-
-            QString savePath = QString("%1/%2-%3.ply").arg(m_outputDirectory).arg(fileName).arg(couvertCount, 4, 10, QChar('0'));
-            QByteArray pathData = savePath.toLocal8Bit();
-            std::string savePathNew = pathData.data();
-
-            if (convertWithTexture && !texImage.isNull())
+            case FRAME_SAVE_FAILED:
             {
-                pc.exportToFile(savePathNew, texImage.bits(), texImage.width(), texImage.height());
+                int progress = frameIndex * 1.0 / totalCount * 100;
+                emit convertStateChanged(CONVERT_ERROR, progress, tr("Failed to save point cloud"));
+                break;
             }
-            else
-            {
-                pc.exportToFile(savePathNew, nullptr, 0, 0);
+            default:
+                break;
             }
-
-            successCount++;
-
-            int progress = successCount * 1.0 / totalCount * 100;
-            emit convertStateChanged(CONVERTING, progress, tr("Converting..."));
         }
 
+        m_threadPool.waitForDone();
+
         int progress = successCount * 1.0 / totalCount * 100;
         auto state = (successCount == totalCount) ? CONVERT_SUCCESS : CONVERT_FAILED;
         emit convertStateChanged(state, progress, QString(tr("Conversion completed, %1 successful, %2 failed").arg(successCount).arg(totalCount - successCount)));
@@ -196,6 +245,44 @@ void FormatConverter::onConvert()
     setIsConverting(false);
 }
 
+void FormatConverter::runConvertTask(int frameIndex, bool withTexture)
+{
+    // the frames not started are skipped after interrupted
+    int result = getInterruptConvert() ? FRAME_CONVERT_CANCELED : convertFrame(frameIndex, withTexture);
+
+    QMutexLocker locker(&m_convertMutex);
+    m_frameResults[frameIndex] = result;
+    m_frameConverted.wakeAll();
+}
+
+int FormatConverter::convertFrame(int frameIndex, bool withTexture)
+{
+    Pointcloud pc;
+    QImage texImage;
+    int rgbIndex = frameIndex;
+
+    // If the timestamp is valid, find the RGB frame index through the timestamp
+    if (withTexture && m_capturedZipParser->getIsTimeStampsValid())
+    {
+        rgbIndex = m_capturedZipParser->getRgbFrameIndexByTimeStamp(frameIndex);
+    }
+
+    if (!m_capturedZipParser->generatePointCloud(frameIndex, rgbIndex, withTexture, pc, texImage))
+    {
+        qWarning() << "Failed to generate point cloud";
+        return FRAME_GENERATE_FAILED;
+    }
+
+    QString fileName = m_capturedZipParser->getCaptureName();
+    QString savePath = QString("%1/%2-%3.ply").arg(m_outputDirectory).arg(fileName).arg(frameIndex, 4, 10, QChar('0'));
+    if (!PlyWriter::savePointCloud(savePath, pc, withTexture ? texImage : QImage()))
+    {
+        return FRAME_SAVE_FAILED;
+    }
+
+    return FRAME_CONVERT_SUCCESS;
+}
+
 bool FormatConverter::getIsConverting()
 {
     return m_isConverting;
@@ -0,0 +1,122 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "framebufferpool.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+using namespace cs;
+
+FrameBufferPool::FrameBufferPool(int maxBufferCount)
+    : m_maxBufferCount(maxBufferCount)
+{
+
+}
+
+void FrameBufferPool::reset(int bufferSize, int preallocCount)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // buffers still used by consumers are released by them
+    m_buffers.clear();
+    m_bufferSize = bufferSize;
+    m_unpooledCount = 0;
+
+    if (m_bufferSize <= 0)
+    {
+        return;
+    }
+
+    preallocCount = qMin(preallocCount, m_maxBufferCount);
+    for (int i = 0; i < preallocCount; i++)
+    {
+        QByteArray buffer;
+        buffer.reserve(m_bufferSize);
+        m_buffers.push_back(buffer);
+    }
+}
+
+void FrameBufferPool::clear()
+{
+    reset(0, 0);
+}
+
+QByteArray FrameBufferPool::acquire(const void* data, int size)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // a detached buffer is only referenced by the pool
+    for (auto& buffer : m_buffers)
+    {
+        if (buffer.isDetached() && buffer.capacity() >= size)
+        {
+            buffer.resize(size);
+            memcpy(buffer.data(), data, size);
+            return buffer;
+        }
+    }
+
+    if (m_buffers.size() < m_maxBufferCount)
+    {
+        QByteArray buffer;
+        buffer.reserve(qMax(size, m_bufferSize));
+        buffer.resize(size);
+        memcpy(buffer.data(), data, size);
+        m_buffers.push_back(buffer);
+
+        return m_buffers.last();
+    }
+
+    m_unpooledCount++;
+    return QByteArray((const char*)data, size);
+}
+
+int FrameBufferPool::calcFrameSize(STREAM_FORMAT format, int width, int height)
+{
+    const int pixels = width * height;
+    switch (format)
+    {
+    case STREAM_FORMAT_Z16:
+        return pixels * 2;
+    case STREAM_FORMAT_Z16Y8Y8:
+        return pixels * 4;
+    case STREAM_FORMAT_PAIR:
+        return pixels * 2;
+    case STREAM_FORMAT_XZ32:
+        return pixels * 4;
+    case STREAM_FORMAT_RGB8:
+    case STREAM_FORMAT_MJPG:
+        return pixels * 3;
+    default:
+        return 0;
+    }
+}
+
+int FrameBufferPool::getAllocatedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_buffers.size();
+}
+
+int FrameBufferPool::getUnpooledCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_unpooledCount;
+}
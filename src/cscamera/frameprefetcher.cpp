@@ -0,0 +1,397 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "frameprefetcher.h"
+#include <QDebug>
+#include <QThread>
+#include <QRunnable>
+#include <QMutexLocker>
+
+#include "capturedzipparser.h"
+
+#define MAX_PREFETCH_THREAD     4
+// frames decoded ahead of the playhead in the scrub direction, and behind it
+#define PREFETCH_AHEAD_FRAMES   8
+#define PREFETCH_BEHIND_FRAMES  2
+// the largest step between the prefetched frames when the playhead jumps
+#define PREFETCH_MAX_STRIDE     4
+#define PREFETCH_CACHE_SIZE     (512 * 1024 * 1024LL)
+
+namespace cs
+{
+class FrameDecodeTask : public QRunnable
+{
+public:
+    FrameDecodeTask(FramePrefetcher* prefetcher, int frameIndex, int generation)
+        : m_prefetcher(prefetcher)
+        , m_frameIndex(frameIndex)
+        , m_generation(generation)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_prefetcher->runDecodeTask(m_frameIndex, m_generation);
+    }
+private:
+    FramePrefetcher* m_prefetcher;
+    int m_frameIndex;
+    int m_generation;
+};
+}
+
+using namespace cs;
+
+FramePrefetcher::FramePrefetcher(CapturedZipParser* zipParser, QObject* parent)
+    : QObject(parent)
+    , m_zipParser(zipParser)
+    , m_cacheSize(PREFETCH_CACHE_SIZE)
+{
+    Q_ASSERT(m_zipParser);
+
+    int maxThread = QThread::idealThreadCount() > MAX_PREFETCH_THREAD ? MAX_PREFETCH_THREAD : QThread::idealThreadCount();
+    m_threadPool.setMaxThreadCount(qMax(1, maxThread));
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+    reset();
+}
+
+void FramePrefetcher::setDecodeOptions(QVector<int> dataTypes, bool withTexture)
+{
+    QMutexLocker locker(&m_mutex);
+    if (dataTypes == m_dataTypes && withTexture == m_withTexture)
+    {
+        return;
+    }
+
+    m_dataTypes = dataTypes;
+    m_withTexture = withTexture;
+
+    // the results of the frames being decoded are dropped by the generation
+    m_generation++;
+    m_threadPool.clear();
+    m_queuedFrames.clear();
+    m_decodingFrames.clear();
+    m_cachedFrames.clear();
+    m_cachedBytes = 0;
+}
+
+void FramePrefetcher::setFrameCount(int frameCount)
+{
+    QMutexLocker locker(&m_mutex);
+    m_frameCount = frameCount;
+}
+
+void FramePrefetcher::setCacheSize(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cacheSize = bytes;
+    evictFrames();
+}
+
+void FramePrefetcher::reset()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_generation++;
+        m_threadPool.clear();
+        m_queuedFrames.clear();
+        m_decodingFrames.clear();
+    }
+
+    // the running tasks use the zip parser, wait for them before the zip file is changed
+    m_threadPool.waitForDone();
+
+    QMutexLocker locker(&m_mutex);
+    m_cachedFrames.clear();
+    m_cachedBytes = 0;
+    m_currentFrame = -1;
+    m_direction = 1;
+    m_stride = 1;
+}
+
+bool FramePrefetcher::requestFrame(int frameIndex, PlayerFrame& frame)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // predict the scrub direction and step by the last move of the playhead
+    if (m_currentFrame >= 0 && frameIndex != m_currentFrame)
+    {
+        const int delta = frameIndex - m_currentFrame;
+        m_direction = (delta > 0) ? 1 : -1;
+        m_stride = qBound(1, qAbs(delta), PREFETCH_MAX_STRIDE);
+    }
+    m_currentFrame = frameIndex;
+
+    // the queued requests of the previous playhead are stale
+    m_threadPool.clear();
+    m_queuedFrames.clear();
+
+    QVector<int> frames = genPrefetchFrames(frameIndex);
+
+    // touch the cached frames from the farthest one, so the nearest frames are evicted last
+    for (int i = frames.size() - 1; i >= 0; i--)
+    {
+        auto it = m_cachedFrames.find(frames[i]);
+        if (it != m_cachedFrames.end())
+        {
+            it->lastUsed = ++m_useCounter;
+        }
+    }
+
+    int priority = frames.size();
+    for (int index : frames)
+    {
+        priority--;
+        if (m_cachedFrames.contains(index) || m_decodingFrames.contains(index))
+        {
+            continue;
+        }
+
+        m_queuedFrames.insert(index);
+        m_threadPool.start(new FrameDecodeTask(this, index, m_generation), priority);
+    }
+
+    auto it = m_cachedFrames.find(frameIndex);
+    if (it == m_cachedFrames.end())
+    {
+        return false;
+    }
+
+    frame = it->frame;
+    return true;
+}
+
+bool FramePrefetcher::getFrame(int frameIndex, PlayerFrame& frame)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_cachedFrames.find(frameIndex);
+    if (it == m_cachedFrames.end())
+    {
+        return false;
+    }
+
+    it->lastUsed = ++m_useCounter;
+    frame = it->frame;
+    return true;
+}
+
+QVector<int> FramePrefetcher::genPrefetchFrames(int frameIndex)
+{
+    QVector<int> frames;
+    if (frameIndex < 0 || frameIndex >= m_frameCount)
+    {
+        return frames;
+    }
+
+    frames.push_back(frameIndex);
+
+    // prefetch fewer frames if the cache can not hold them
+    int ahead = PREFETCH_AHEAD_FRAMES;
+    int behind = PREFETCH_BEHIND_FRAMES;
+    if (!m_cachedFrames.isEmpty() && m_cachedBytes > 0)
+    {
+        const qint64 frameBytes = m_cachedBytes / m_cachedFrames.size();
+        const int maxFrames = (int)qMin<qint64>(m_cacheSize / qMax<qint64>(1, frameBytes), PREFETCH_AHEAD_FRAMES + PREFETCH_BEHIND_FRAMES + 1);
+
+        ahead = qMin(ahead, qMax(0, maxFrames - 1));
+        behind = qMin(behind, qMax(0, maxFrames - 1 - ahead));
+    }
+
+    for (int i = 1; i <= ahead; i++)
+    {
+        const int index = frameIndex + m_direction * m_stride * i;
+        if (index < 0 || index >= m_frameCount)
+        {
+            break;
+        }
+        frames.push_back(index);
+    }
+
+    for (int i = 1; i <= behind; i++)
+    {
+        const int index = frameIndex - m_direction * i;
+        if (index < 0 || index >= m_frameCount)
+        {
+            break;
+        }
+        frames.push_back(index);
+    }
+
+    return frames;
+}
+
+void FramePrefetcher::evictFrames()
+{
+    while (m_cachedBytes > m_cacheSize && m_cachedFrames.size() > 1)
+    {
+        // the frame at the playhead is kept, it may not be shown yet
+        auto lru = m_cachedFrames.end();
+        for (auto it = m_cachedFrames.begin(); it != m_cachedFrames.end(); ++it)
+        {
+            if (it.key() != m_currentFrame && (lru == m_cachedFrames.end() || it->lastUsed < lru->lastUsed))
+            {
+                lru = it;
+            }
+        }
+
+        if (lru == m_cachedFrames.end())
+        {
+            break;
+        }
+
+        m_cachedBytes -= lru->frame.bytes;
+        m_cachedFrames.erase(lru);
+    }
+}
+
+void FramePrefetcher::runDecodeTask(int frameIndex, int generation)
+{
+    QVector<int> dataTypes;
+    bool withTexture;
+    {
+        QMutexLocker locker(&m_mutex);
+        // check the generation first, the frame may be queued again by a newer request
+        if (generation != m_generation || !m_queuedFrames.remove(frameIndex) || m_cachedFrames.contains(frameIndex))
+        {
+            return;
+        }
+
+        m_decodingFrames.insert(frameIndex);
+        dataTypes = m_dataTypes;
+        withTexture = m_withTexture;
+    }
+
+    PlayerFrame frame;
+    decodeFrame(frameIndex, dataTypes, withTexture, frame);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (generation != m_generation)
+        {
+            return;
+        }
+        m_decodingFrames.remove(frameIndex);
+
+        // the frames failed to decode are cached too, so they are not decoded again and again
+        CachedFrame& cachedFrame = m_cachedFrames[frameIndex];
+        cachedFrame.frame = frame;
+        cachedFrame.lastUsed = ++m_useCounter;
+        m_cachedBytes += frame.bytes;
+
+        evictFrames();
+    }
+
+    emit frameReady(frameIndex);
+}
+
+void FramePrefetcher::decodeFrame(int frameIndex, const QVector<int>& dataTypes, bool withTexture, PlayerFrame& frame)
+{
+    // If the timestamp is valid, find the RGB frame index through the timestamp
+    int rgbIndex = frameIndex;
+    if (m_zipParser->getIsTimeStampsValid())
+    {
+        rgbIndex = m_zipParser->getRgbFrameIndexByTimeStamp(frameIndex);
+    }
+
+    for (auto type : dataTypes)
+    {
+        switch (type)
+        {
+        case CAMERA_DATA_L:
+        case CAMERA_DATA_R:
+        case CAMERA_DATA_DEPTH:
+        case CAMERA_DATA_RGB:
+        {
+            if (type == CAMERA_DATA_RGB)
+            {
+                qInfo() << "update rgb frame, depth index : " << frameIndex << ", rgb index:" << rgbIndex;
+            }
+
+            QImage image = m_zipParser->getImageOfFrame((type == CAMERA_DATA_RGB) ? rgbIndex : frameIndex, type);
+            if (image.isNull())
+            {
+                qWarning() << "Failed to generate image";
+                frame.failedTypes.push_back(type);
+                break;
+            }
+
+            OutputData2D outputData;
+            outputData.image = image;
+            outputData.info.cameraDataType = type;
+
+            frame.outputs2D.push_back(outputData);
+            frame.bytes += image.sizeInBytes();
+            break;
+        }
+        case CAMERA_DATA_POINT_CLOUD:
+        {
+            if (!decodePointCloud(frameIndex, withTexture, frame.pointCloud, frame.texImage))
+            {
+                qWarning() << "Failed to generate point cloud";
+                frame.failedTypes.push_back(type);
+                break;
+            }
+
+            frame.hasPointCloud = true;
+            frame.bytes += frame.pointCloud.getVertices().size() * sizeof(float3)
+                + frame.pointCloud.getNormals().size() * sizeof(float3)
+                + frame.pointCloud.getTexcoords().size() * sizeof(float2)
+                + frame.texImage.sizeInBytes();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+bool FramePrefetcher::decodePointCloud(int frameIndex, bool withTexture, Pointcloud& pc, QImage& texImage)
+{
+    // If the timestamp is valid, find the RGB frame index through the timestamp
+    int rgbFrame = frameIndex;
+    if (withTexture && m_zipParser->getIsTimeStampsValid())
+    {
+        rgbFrame = m_zipParser->getRgbFrameIndexByTimeStamp(frameIndex);
+    }
+
+    if (m_zipParser->getDataTypes().contains(CAMERA_DATA_POINT_CLOUD))
+    {
+        // generate Pointcloud from ply file
+        if (!m_zipParser->getPointCloud(frameIndex, pc, texImage))
+        {
+            return false;
+        }
+
+        if (texImage.isNull())
+        {
+            texImage = m_zipParser->getImageOfFrame(rgbFrame, CAMERA_DATA_RGB);
+        }
+
+        return true;
+    }
+
+    // generate Pointcloud from depth data
+    return m_zipParser->generatePointCloud(frameIndex, rgbFrame, withTexture, pc, texImage);
+}
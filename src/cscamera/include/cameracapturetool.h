@@ -30,6 +30,7 @@
 #include "cstypes.h"
 #include "cscameraapi.h"
 #include "process/processor.h"
+#include "capturefilewriter.h"
 
 namespace cs 
 {
@@ -50,7 +51,7 @@ enum CAPTURE_STATE
     CAPTURE_WARNING,
     CAPTURE_ERROR
 };
-class CameraCaptureBase : public QThread
+class CS_CAMERA_EXPORT CameraCaptureBase : public QThread
 {
     Q_OBJECT
 public:
@@ -63,7 +64,9 @@ public:
     virtual void getCaptureIndex(const OutputDataPort& output, int& rgbFrameIndex, int& depthFrameIndex, int& pointCloudIndex) {}
 
     void run() override;
-    void saveFinished(OutputSaver* saver);
+    virtual void saveFinished(OutputSaver* saver);
+    // called by OutputSaver, data may be a slice of owner, see CaptureFileWriter::addEntry
+    virtual bool saveCapturedFile(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner = QByteArray());
 
     void setCamera(std::shared_ptr<ICSCamera>& camera);
     void setCameraCaptureConfig(const CameraCaptureConfig& config);
@@ -71,8 +74,9 @@ signals:
     void captureStateChanged(int captureType, int state, QString message);
     void captureNumberUpdated(int, int);
 protected:
+    virtual bool onCaptureDataStart() { return true; }
     virtual void onCaptureDataDone();
-    void saveCameraPara(QString filePath);
+    QByteArray genCameraPara();
     int getCapturedCount();
     int getSkipCount();
 
@@ -103,8 +107,8 @@ protected:
 
     std::shared_ptr<ICSCamera> m_camera;
 
-    // real save folder
-    QString m_realSaveFolder;
+    // sequence of the next frame to save
+    int m_sequence = 0;
 };
 
 // save a frame of data
@@ -119,20 +123,25 @@ protected:
 };
 
 // save multi-frame data
-class CameraCaptureMultiple : public CameraCaptureBase
+class CS_CAMERA_EXPORT CameraCaptureMultiple : public CameraCaptureBase
 {
     Q_OBJECT
 public:
     CameraCaptureMultiple(const CameraCaptureConfig& config);
+    ~CameraCaptureMultiple();
     void addOutputData(const OutputDataPort& outputDataPort) override;
     void getCaptureIndex(const OutputDataPort& output, int& rgbFrameIndex, int& depthFrameIndex, int& pointCloudIndex) override;
-
+    void saveFinished(OutputSaver* saver) override;
+    bool saveCapturedFile(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner = QByteArray()) override;
 protected:
+    bool onCaptureDataStart() override;
     void onCaptureDataDone() override;
-    void saveTimeStamps();
-    void compressToZip();
-    QString genTmpSaveDir(QString saveDir);
+    QByteArray genTimeStamps();
+    QString getSaveFilePath();
 private:
+    // the captured files are written to the zip file or the record file directly
+    CaptureFileWriter* m_fileWriter = nullptr;
+
     int m_capturedRgbCount = 0;
     int m_capturedDepthCount = 0;
     int m_capturePointCloudCount = 0;
@@ -23,15 +23,20 @@
 #include <QThread>
 #include <QString>
 #include <QReadWriteLock> 
+#include <QElapsedTimer>
 
 #include "cstypes.h"
 #include "cscameraapi.h"
 #include <hpp/Types.hpp>
 #include <hpp/Processing.hpp>
 
+class QTimer;
+
 namespace cs
 {
 class CapturedZipParser;
+class FramePrefetcher;
+struct PlayerFrame;
 class CS_CAMERA_EXPORT CameraPlayer : public QThread
 {
     Q_OBJECT
@@ -59,22 +64,41 @@ public slots:
     void onLoadFile(QString file);
     void onPalyFrameUpdated(int curFrame, bool force = false);
     void onSaveCurrentFrame(QString filePath);
+    // play the frames at the pace of the time stamps from the current frame
+    void onPlayToggled(bool play);
 signals:
     void playerStateChanged(int state, QString msg);
     void output2DUpdated(OutputData2D outputData);
-    void output3DUpdated(cs::Pointcloud pointCloud, const QImage& image);
+    void output3DUpdated(cs::Pointcloud pointCloud, const QImage& image, qint64 receivedTime);
+    // the current frame is moved by playing
+    void playFrameChanged(int curFrame);
+    void playingChanged(bool playing);
+private slots:
+    void onFrameReady(int frameIndex);
+    void onPlayTimeout();
 private:
     void updateCurrentFrame();
-    void updateCurrentImage(int type);
-    void updateCurrentPointCloud();
+    void showFrame(const PlayerFrame& frame);
+    void stopPlaying();
+    void scheduleNextFrame();
+    int getPlayInterval(int curFrame);
 
 private:
 
     CapturedZipParser* m_zipParser = nullptr;
+    FramePrefetcher* m_prefetcher = nullptr;
     int m_currentFrame = 0;
+    // the current frame is shown, or waits for the prefetcher
+    bool m_currentFrameShown = false;
     QVector<int> m_currentDataTypes;
     bool m_show3dTexture = true;
 
+    bool m_isPlaying = false;
+    QTimer* m_playTimer = nullptr;
+    QElapsedTimer m_playClock;
+    // the time of m_playClock the next frame should be shown
+    qint64 m_playDueTime = 0;
+
     QReadWriteLock m_lock;
 };
 }
@@ -28,6 +28,7 @@
 
 #include "cscameraapi.h"
 #include "cscamera.h"
+#include "simulatedcamera.h"
 
 namespace cs {
 
@@ -44,6 +45,8 @@ public:
     static void onCameraAlarm(const char* jsonData, int iDataLen, void* userData);
     void updateCameraInfoList(const std::vector<CameraInfo>& added, const std::vector<CameraInfo>& removed);
     std::shared_ptr<ICSCamera> getCamera() const;
+    // add a simulated camera to the camera list, it is connected as the other cameras
+    void setSimulatedCamera(bool enable, const SimulatedCameraConfig& config = SimulatedCameraConfig());
     
     static void enableSdkLog(QString logDir);
     static void initialize(void* user);
@@ -78,6 +81,9 @@ private:
     
     void unBindCamera();
     void bindCamera(CSCamera* camera);
+    void bindCamera(SimulatedCamera* camera);
+    bool connectSimulatedCamera();
+    bool isSimulatedCamera(const QString& serial) const;
     
     bool findCameraInfo(const QString& serial, CameraInfo& cameraInfo);
     bool isNetConnect(QString uuid);
@@ -87,6 +93,9 @@ private:
     QList<CameraInfo> m_cameraInfoList;
     QReadWriteLock m_lock;
     QTimer m_cameraRestartTimer;
+
+    bool m_simulatedCameraEnabled = false;
+    SimulatedCameraConfig m_simulatedCameraConfig;
 };
 
 }
@@ -23,10 +23,14 @@
 #include <QVector>
 #include <QString>
 #include <QImage>
+#include <QMutex>
 
 #include "cstypes.h"
 #include "cscameraapi.h"
 #include <hpp/Processing.hpp>
+#include "process/depthcolorizer.h"
+#include "capturezipreader.h"
+#include "capturerecordreader.h"
 
 namespace cs
 {
@@ -39,6 +43,8 @@ public:
     ~CapturedZipParser();
 
     void setZipFile(QString filePath);
+    // save the entry index of the zip file to a sidecar file, the zip file is opened quickly next time
+    void setIndexFileEnabled(bool enabled);
     bool checkFileValid();
     bool parseCaptureInfo();
     bool parseTimeStamps();
@@ -49,19 +55,41 @@ public:
     bool getPointCloud(int frameIndex, Pointcloud& pc, QImage& texImage);
 
     bool generatePointCloud(int depthIndex, int rgbIndex, bool withTexture, Pointcloud& pc, QImage& tex);
+    // generate the point cloud from the decoded depth pixels
+    bool generatePointCloud(const QByteArray& depthPixels, bool withTexture, Pointcloud& pc);
+    // decode the frame data to pixels: 16 bits for depth, 8 bits for IR, RGB888 for RGB
+    bool decodeFrameData(int dataType, const QByteArray& data, QByteArray& pixData);
     bool saveFrameToLocal(int frameIndex, bool withTexture, QString filePath);
     int getRgbFrameIndexByTimeStamp(int depthIndex);
+    int getTimeStampOfFrame(int frameIndex, int dataType);
 
     bool enablePointCloudTexture();
     // get parameters
     QVector<int> getDataTypes();
     int getFrameCount();
     bool isRawFormat();
+    bool isRvlFormat();
+    // RGB is saved as PNG in rvl format
+    bool isEncodedByRvl(int dataType);
+    QSize getResolution(int dataType);
+    // camera parameters of the capture
+    Intrinsics getIntrinsics(int dataType);
+    Extrinsics getExtrinsics();
+    float getDepthScale();
     QString getCaptureName();
     bool getIsTimeStampsValid();
 private:
+    bool openZipFile();
+    bool isRecordFile();
+    bool containsFile(QString name);
+    bool readFile(QString name, QByteArray& data);
+    void parseRecordTimeStamps();
+    // name of the entry in the capture
     QString getFileName(int frameIndex, int dataType);
+    // name of the exported file
     QString getFileName(int dataType, QString name);
+    // suffix of the entries in the capture
+    QString getSuffix(int dataType);
 
     QImage convertPng2QImage(QByteArray data, int dataType);
     QImage convertPixels2QImage(QByteArray data, int dataType);
@@ -71,16 +99,20 @@ private:
     bool savePointCloud(int frameIndex, bool withTexture, QString filePath);
 
     // time stamp
-    int getTimeStampOfFrame(int frameIndex, int dataType);
     int getNearestRgbFrame(int depthIndex, int timeStamp);
 private:
     // zip file path
     QString m_zipFile = "";
+    // the zip file is opened once, and the entries are read by the index
+    CaptureZipReader m_zipReader;
+    bool m_indexFileEnabled = false;
+    // the record file is mapped, and the frames are read by the index of it
+    CaptureRecordReader m_recordReader;
     // name of capture 
     QString m_captureName = "";
     // captured data types
     QVector<int> m_dataTypes;
-    // captured data format: images or raw
+    // captured data format: images, raw or rvl
     QString m_dataFormat = "";
     // resolution
     QSize m_depthResolution = QSize(0, 0);
@@ -101,6 +133,10 @@ private:
     float m_depthScale = 0.0f;
     float m_depthMin = 0.0f;
     float m_depthMax = 0.0f;
+
+    // the frames are decoded by several threads in the player
+    QMutex m_colorizerMutex;
+    DepthColorizer m_colorizer;
 };
 
 }
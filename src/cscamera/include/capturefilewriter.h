@@ -0,0 +1,71 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_CAPTUREFILEWRITER_H
+#define _CS_CAPTUREFILEWRITER_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "cstypes.h"
+
+namespace cs
+{
+
+// a file of the capture saved by OutputSaver
+struct CapturedFileInfo
+{
+    // the order in which the frame is captured, -1 for the files of the whole capture
+    int sequence = -1;
+    int dataType = CAMERA_DATA_UNKNOW;
+    // frame index of the data type, -1 for the files of the whole capture
+    int frameIndex = -1;
+    // time stamp of the stream, ms
+    double timeStamp = 0.0;
+    QString fileName;
+};
+
+// Writes the files of a multi-frame capture into a single file while capturing.
+// The savers add the files of a frame and commit the frame, and the frames are written in the captured order.
+class CaptureFileWriter
+{
+public:
+    virtual ~CaptureFileWriter() {}
+
+    // create the file
+    virtual bool start() = 0;
+
+    // called by the savers, compress is false for the data that is compressed already, e.g. PNG and JPEG
+    // data may be a slice of owner made by QByteArray::fromRawData, owner is kept until the data is written
+    virtual void addEntry(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner) = 0;
+    // all the entries of the frame are added
+    virtual void commit(int sequence) = 0;
+
+    // write the committed frames
+    virtual void waitForFrames() = 0;
+    // write a file after the frames, waitForFrames() must be called first
+    virtual bool addFile(QString name, const QByteArray& data, bool compress) = 0;
+    // close the file, return false if any entry failed
+    virtual bool finish() = 0;
+};
+
+}
+
+#endif //_CS_CAPTUREFILEWRITER_H
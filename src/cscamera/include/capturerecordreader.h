@@ -0,0 +1,100 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_CAPTURERECORDREADER_H
+#define _CS_CAPTURERECORDREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+
+namespace cs
+{
+
+// Reads the chunks of a record file written by CaptureRecordWriter.
+// The record file is mapped into memory, and a chunk is found by its name or by its frame index and data type from the index.
+// The index is rebuilt by scanning the chunks if the record file is not finished, e.g. the capture is interrupted.
+class CaptureRecordReader
+{
+public:
+    CaptureRecordReader();
+    ~CaptureRecordReader();
+
+    bool open(QString recordFile);
+    void close();
+    bool isOpen();
+
+    bool contains(QString name);
+    bool readEntry(QString name, QByteArray& data);
+
+    // frameIndex is the frame index of the data type
+    bool readFrame(int frameIndex, int dataType, QByteArray& data);
+    bool getTimeStamp(int frameIndex, int dataType, double& timeStamp);
+    // the max frame count of the data types
+    int getFrameCount();
+
+    // the camera parameters saved in the header
+    QByteArray getCameraPara();
+private:
+    struct RecordChunk
+    {
+        qint64 dataOffset = 0;
+        qint64 dataSize = 0;
+        double timeStamp = 0.0;
+        int frameIndex = -1;
+        int dataType = 0;
+        int codec = 0;
+    };
+
+    bool parseHeader();
+    bool parseIndex();
+    bool scanChunks();
+    void addChunk(QString name, const RecordChunk& chunk);
+
+    bool readData(qint64 offset, qint64 size, char* data);
+    bool readChunkData(const RecordChunk& chunk, QByteArray& data);
+
+    static qint64 genFrameKey(int frameIndex, int dataType);
+private:
+    QFile m_file;
+    qint64 m_fileSize = 0;
+    // the whole record file is mapped, or read by m_file if it can not be mapped
+    const char* m_mappedData = nullptr;
+    bool m_isOpen = false;
+
+    // guards m_file when the record file is not mapped
+    QMutex m_mutex;
+
+    QByteArray m_cameraPara;
+    qint64 m_chunksOffset = 0;
+
+    QVector<RecordChunk> m_chunks;
+    // the later chunk wins if the names are the same
+    QHash<QString, int> m_nameIndex;
+    QHash<qint64, int> m_frameIndex;
+    int m_frameCount = 0;
+};
+
+}
+
+#endif //_CS_CAPTURERECORDREADER_H
@@ -0,0 +1,131 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_CAPTURERECORDWRITER_H
+#define _CS_CAPTURERECORDWRITER_H
+
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QMap>
+#include <QSet>
+
+#include "capturefilewriter.h"
+
+#define RECORD_FILE_SUFFIX              ".csr"
+
+#define RECORD_FILE_MAGIC               0x43525343
+#define RECORD_CHUNK_MAGIC              0x4B435343
+#define RECORD_INDEX_MAGIC              0x49435343
+#define RECORD_TRAILER_MAGIC            0x45435343
+#define RECORD_FILE_VERSION             1
+
+#define RECORD_HEADER_SIZE              32
+#define RECORD_CHUNK_HEADER_SIZE        32
+#define RECORD_INDEX_HEADER_SIZE        8
+#define RECORD_INDEX_ENTRY_SIZE         34
+#define RECORD_TRAILER_SIZE             16
+
+namespace cs
+{
+
+// codec of the data in a chunk
+enum RECORD_CODEC
+{
+    RECORD_CODEC_NONE = 0,
+    RECORD_CODEC_RAW,
+    RECORD_CODEC_PNG,
+    RECORD_CODEC_RVL,
+    RECORD_CODEC_PLY
+};
+
+// Writes a multi-frame capture into a record file, which is appended only and read by mapping it into memory.
+// The layout of the file, all the values are little endian:
+//   header  : magic, version, header size, size of the camera parameters, the camera parameters in yaml
+//   chunks  : magic, frame index, data type, codec, name size, data size, time stamp, name, data
+//   index   : magic, chunk count, a record of each chunk to seek to the data directly
+//   trailer : index offset, chunk count, magic
+// The data is not compressed again, and the chunks can be found by scanning the file if the index is not written.
+class CaptureRecordWriter : public CaptureFileWriter
+{
+public:
+    CaptureRecordWriter(QString recordFile, const QByteArray& cameraPara);
+    ~CaptureRecordWriter();
+
+    // create the record file and write the header
+    bool start() override;
+
+    // the data is written as it is, compress is ignored
+    void addEntry(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner) override;
+    // the frames are written in the saver threads which commit them
+    void commit(int sequence) override;
+
+    void waitForFrames() override;
+    bool addFile(QString name, const QByteArray& data, bool compress) override;
+    // write the index and close the record file, return false if any chunk failed
+    bool finish() override;
+private:
+    struct RecordChunk
+    {
+        CapturedFileInfo info;
+        int codec = RECORD_CODEC_NONE;
+        QByteArray data;
+        // the buffer data points into, kept until the chunk is written
+        QByteArray owner;
+        qint64 dataSize = 0;
+        // offset of the chunk in the record file
+        qint64 offset = 0;
+    };
+
+    static int getCodec(QString fileName);
+
+    void writeFrames(QMutexLocker& locker);
+    bool writeChunk(RecordChunk& chunk);
+    bool writeIndex();
+private:
+    QString m_recordFile;
+    QByteArray m_cameraPara;
+    QFile m_file;
+
+    QMutex m_mutex;
+    QWaitCondition m_frameWritten;
+
+    // chunks of the frames not written yet
+    QMap<int, QList<RecordChunk>> m_pendingChunks;
+    QSet<int> m_committedSequences;
+    int m_nextSequence = 0;
+    qint64 m_pendingBytes = 0;
+    // a saver thread is writing the committed frames
+    bool m_writing = false;
+
+    bool m_stopping = false;
+    bool m_error = false;
+
+    // the written chunks without data, saved as the index
+    QVector<RecordChunk> m_writtenChunks;
+};
+
+}
+
+#endif //_CS_CAPTURERECORDWRITER_H
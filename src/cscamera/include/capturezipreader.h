@@ -0,0 +1,83 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_CAPTUREZIPREADER_H
+#define _CS_CAPTUREZIPREADER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+class QFile;
+
+namespace cs
+{
+
+// Reads the entries of a zip file with an index built once.
+// The central directory is parsed when the zip file is opened, and an entry is read by seeking to its local header directly.
+// Concurrent reads use separate file handles, and the index can be saved to a sidecar file to open the zip file again quickly.
+class CaptureZipReader
+{
+public:
+    CaptureZipReader();
+    ~CaptureZipReader();
+
+    // useIndexFile: load the index from "<zipFile>.index", or save the index to it after parsing
+    bool open(QString zipFile, bool useIndexFile = false);
+    void close();
+    bool isOpen();
+
+    bool contains(QString name);
+    bool readEntry(QString name, QByteArray& data);
+private:
+    struct ZipEntry
+    {
+        qint64 localHeaderOffset = 0;
+        qint64 compressedSize = 0;
+        qint64 uncompressedSize = 0;
+        quint32 crc = 0;
+        quint16 method = 0;
+    };
+
+    bool parseCentralDirectory(QFile& file);
+    bool loadIndexFile(QString indexFile, qint64 zipSize, qint64 zipModified);
+    void saveIndexFile(QString indexFile, qint64 zipSize, qint64 zipModified);
+
+    bool readEntryData(QFile& file, const ZipEntry& entry, QByteArray& data);
+    bool inflateEntry(const ZipEntry& entry, const QByteArray& compressedData, QByteArray& data);
+
+    QFile* acquireFile();
+    void releaseFile(QFile* file);
+private:
+    QString m_zipFile;
+    bool m_isOpen = false;
+
+    QMutex m_mutex;
+    // entry name to entry
+    QHash<QString, ZipEntry> m_entries;
+    // file handles not in use
+    QList<QFile*> m_freeFiles;
+};
+
+}
+
+#endif //_CS_CAPTUREZIPREADER_H
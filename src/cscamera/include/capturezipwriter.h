@@ -0,0 +1,97 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_CAPTUREZIPWRITER_H
+#define _CS_CAPTUREZIPWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QSet>
+
+#include <quazip.h>
+
+#include "capturefilewriter.h"
+
+namespace cs
+{
+
+// Writes the files of a multi-frame capture into a zip while capturing.
+// The savers add the files of a frame and commit the frame, the data is deflated in the saver threads,
+// and the writer thread appends the entries of the committed frames in frame order.
+class CaptureZipWriter : public QThread, public CaptureFileWriter
+{
+    Q_OBJECT
+public:
+    CaptureZipWriter(QString zipFile);
+    ~CaptureZipWriter();
+
+    // create the zip file and start the writer thread
+    bool start() override;
+
+    void addEntry(const CapturedFileInfo& info, const QByteArray& data, bool compress, const QByteArray& owner) override;
+    void commit(int sequence) override;
+
+    // write the committed frames and stop the writer thread
+    void waitForFrames() override;
+    bool addFile(QString name, const QByteArray& data, bool compress) override;
+    // close the zip file, return false if any entry failed
+    bool finish() override;
+protected:
+    void run() override;
+private:
+    struct ZipEntry
+    {
+        QString name;
+        QByteArray data;
+        // the buffer data points into when it is stored without compression
+        QByteArray owner;
+        quint32 crc = 0;
+        qint64 uncompressedSize = 0;
+        int method = 0;
+    };
+
+    ZipEntry genEntry(QString name, const QByteArray& data, bool compress);
+    bool writeEntry(const ZipEntry& entry);
+private:
+    QString m_zipFile;
+    QuaZip m_zip;
+
+    QMutex m_mutex;
+    QWaitCondition m_frameCommitted;
+    QWaitCondition m_frameWritten;
+
+    // entries of the frames not written yet
+    QMap<int, QList<ZipEntry>> m_pendingEntries;
+    QSet<int> m_committedSequences;
+    int m_nextSequence = 0;
+    qint64 m_pendingBytes = 0;
+
+    bool m_stopping = false;
+    bool m_error = false;
+};
+
+}
+
+#endif //_CS_CAPTUREZIPWRITER_H
@@ -32,6 +32,7 @@
 
 #include "icscamera.h"
 #include "cstypes.h"
+#include "framebufferpool.h"
 
 #define GET_FRAME_TIME_OUT 10         //ms
 
@@ -189,6 +190,10 @@ private:
 
     QThread* m_cameraThread;
     mutable QReadWriteLock m_lock;
+
+    // recycled buffers of the frames
+    FrameBufferPool m_depthBufferPool;
+    FrameBufferPool m_rgbBufferPool;
 };
 }
 
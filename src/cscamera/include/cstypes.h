@@ -77,6 +77,9 @@ struct FrameData
     float depthScale;
 
     QVector<StreamData> data;
+
+    // monotonic time(PipelineStats::now()) when the frame is received from the camera, 0 if unknown
+    qint64 receivedTime = 0;
 };
 
 Q_DECLARE_METATYPE(FrameData);
@@ -96,12 +99,16 @@ struct OutputInfo2D
     int cameraDataType = CAMERA_DATA_UNKNOW;
     QVector3D vertex = { 1.0f, 1.0f, 1.0f };
     float depthScale = 0.0f;
+    // receivedTime of the frame the output is processed from
+    qint64 receivedTime = 0;
 };
 
 struct OutputData2D
 {
     QImage image;
     OutputInfo2D info;
+    // image scaled to the size of its render widget off the ui thread, null if not prepared
+    QImage displayImage;
 
     bool isEmpty() const 
     {
@@ -166,7 +173,10 @@ struct CameraCaptureConfig
     int captureNumber = 1;
     QVector<CS_CAMERA_DATA_TYPE> captureDataTypes;
     bool savePointCloudWithTexture = false;
+    bool savePointCloudBinary = false;
     QString saveFormat;
+    // save the frames to a record file instead of a zip file
+    bool saveRecordFile = false;
     QString saveDir;
     QString saveName;
 };
@@ -18,12 +18,18 @@
 ********************************************************************************/
 
 #include <QThread>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMap>
+#include <atomic>
 #include "cscameraapi.h"
 
 namespace cs
 {
 
 class CapturedZipParser;
+class FrameConvertTask;
 class CS_CAMERA_EXPORT FormatConverter : public QThread
 {
     Q_OBJECT
@@ -60,6 +66,19 @@ public slots:
 signals:
     void convertStateChanged(int state, int progress, QString message);
     void loadFileSignal();
+private:
+    friend class FrameConvertTask;
+
+    enum FRAME_CONVERT_RESULT
+    {
+        FRAME_CONVERT_SUCCESS,
+        FRAME_GENERATE_FAILED,
+        FRAME_SAVE_FAILED,
+        FRAME_CONVERT_CANCELED
+    };
+
+    void runConvertTask(int frameIndex, bool withTexture);
+    int convertFrame(int frameIndex, bool withTexture);
 private:
     // zip file
     QString m_sourceFile;
@@ -71,7 +90,15 @@ private:
     CapturedZipParser* m_capturedZipParser = nullptr;
 
     bool m_isConverting = false;
-    bool m_interruptConvert = false;
+    // read by the convert tasks
+    std::atomic<bool> m_interruptConvert { false };
+
+    // the frames are converted in parallel, and the results are reported in frame order
+    QThreadPool m_threadPool;
+    QMutex m_convertMutex;
+    QWaitCondition m_frameConverted;
+    // frame index to FRAME_CONVERT_RESULT, of the frames not reported yet
+    QMap<int, int> m_frameResults;
     
     bool m_isFileValid = false;
     bool m_hasRGBData = false;
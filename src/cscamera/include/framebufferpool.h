@@ -0,0 +1,65 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_FRAMEBUFFERPOOL_H
+#define _CS_FRAMEBUFFERPOOL_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+
+#include "cstypes.h"
+#include "cscameraapi.h"
+
+namespace cs
+{
+
+// A pool of recycled frame buffers. 
+// The buffers handed out are implicitly shared QByteArrays, a buffer returns to the pool 
+// when the last consumer (StreamData, OutputDataPort, OutputSaver...) releases its copy.
+class CS_CAMERA_EXPORT FrameBufferPool
+{
+public:
+    FrameBufferPool(int maxBufferCount = 8);
+
+    // drop all buffers and preallocate buffers of bufferSize bytes
+    void reset(int bufferSize, int preallocCount = 2);
+    void clear();
+
+    // copy the data into a recycled buffer, the buffer must be filled before it is shared
+    QByteArray acquire(const void* data, int size);
+
+    // bytes of a frame with the format and resolution, the upper bound for compressed formats
+    static int calcFrameSize(STREAM_FORMAT format, int width, int height);
+
+    int getAllocatedCount() const;
+    int getUnpooledCount() const;
+private:
+    mutable QMutex m_mutex;
+    QVector<QByteArray> m_buffers;
+    const int m_maxBufferCount;
+    int m_bufferSize = 0;
+
+    // buffers allocated outside the pool because all pooled buffers were in use
+    int m_unpooledCount = 0;
+};
+
+}
+
+#endif //_CS_FRAMEBUFFERPOOL_H
@@ -0,0 +1,116 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_FRAMEPREFETCHER_H
+#define _CS_FRAMEPREFETCHER_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+
+#include "cstypes.h"
+#include "cscameraapi.h"
+#include <hpp/Processing.hpp>
+
+namespace cs
+{
+class CapturedZipParser;
+
+// decoded data of a captured frame, ready to be shown
+struct PlayerFrame
+{
+    QVector<OutputData2D> outputs2D;
+    bool hasPointCloud = false;
+    Pointcloud pointCloud;
+    QImage texImage;
+    // the data types failed to be decoded
+    QVector<int> failedTypes;
+    // memory used by the decoded data
+    qint64 bytes = 0;
+};
+
+// Decodes the frames around the playhead on worker threads, and keeps the decoded frames in a memory-bounded LRU cache.
+// The frames ahead in the scrub direction are decoded first, the queued requests are dropped when the playhead moves,
+// and the cache is cleared when the decode options change.
+class CS_CAMERA_EXPORT FramePrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    FramePrefetcher(CapturedZipParser* zipParser, QObject* parent = nullptr);
+    ~FramePrefetcher();
+
+    // the cache is cleared if the data types or the texture option change
+    void setDecodeOptions(QVector<int> dataTypes, bool withTexture);
+    void setFrameCount(int frameCount);
+    void setCacheSize(qint64 bytes);
+    // cancel all the requests, wait for the running ones and clear the cache
+    void reset();
+
+    // move the playhead to frameIndex and prefetch the frames around it,
+    // returns true with the decoded frame if it is cached, otherwise frameReady() is emitted when it is decoded
+    bool requestFrame(int frameIndex, PlayerFrame& frame);
+    // get the decoded frame without moving the playhead
+    bool getFrame(int frameIndex, PlayerFrame& frame);
+signals:
+    void frameReady(int frameIndex);
+private:
+    friend class FrameDecodeTask;
+
+    void runDecodeTask(int frameIndex, int generation);
+    void decodeFrame(int frameIndex, const QVector<int>& dataTypes, bool withTexture, PlayerFrame& frame);
+    bool decodePointCloud(int frameIndex, bool withTexture, Pointcloud& pc, QImage& texImage);
+    QVector<int> genPrefetchFrames(int frameIndex);
+    void evictFrames();
+private:
+    struct CachedFrame
+    {
+        PlayerFrame frame;
+        quint64 lastUsed = 0;
+    };
+
+    CapturedZipParser* m_zipParser;
+    QThreadPool m_threadPool;
+
+    QMutex m_mutex;
+    // increased when the cached frames become invalid, the results of the older requests are dropped
+    int m_generation = 0;
+    QVector<int> m_dataTypes;
+    bool m_withTexture = true;
+    int m_frameCount = 0;
+
+    QHash<int, CachedFrame> m_cachedFrames;
+    qint64 m_cacheSize;
+    qint64 m_cachedBytes = 0;
+    quint64 m_useCounter = 0;
+    // frames queued in thread pool, and frames being decoded
+    QSet<int> m_queuedFrames;
+    QSet<int> m_decodingFrames;
+
+    // playhead and the predicted scrub direction
+    int m_currentFrame = -1;
+    int m_direction = 1;
+    int m_stride = 1;
+};
+}
+
+#endif //_CS_FRAMEPREFETCHER_H
@@ -37,6 +37,9 @@ public:
 
     void updateCaptureConfig(const CameraCaptureConfig& config);
     void updateSaveIndex();
+
+    void setSequence(int sequence);
+    int getSequence() const;
 protected:
     void setSaveIndex(int rgbFrameIndex, int depthFrameIndex, int pointCloudIndex);
     void savePointCloud();
@@ -50,7 +53,14 @@ protected:
 
     void savePointCloud(cs::Pointcloud& pointCloud, QImage& texImage);
 
-    QString getSavePath(CS_CAMERA_DATA_TYPE dataType);
+    QString getSaveFileName(CS_CAMERA_DATA_TYPE dataType);
+    virtual QString getSuffix2D(CS_CAMERA_DATA_TYPE dataType);
+    int getFrameIndex(CS_CAMERA_DATA_TYPE dataType);
+    double getTimeStamp(CS_CAMERA_DATA_TYPE dataType);
+    bool saveFile(CS_CAMERA_DATA_TYPE dataType, QString fileName, const QByteArray& data, bool compress);
+    // save a part of buffer without copying it
+    bool saveFile(CS_CAMERA_DATA_TYPE dataType, QString fileName, const QByteArray& buffer, int offset, int size, bool compress);
+    bool saveImage(CS_CAMERA_DATA_TYPE dataType, QString fileName, const QImage& image);
 
 protected:
     CameraCaptureBase* m_cameraCapture = nullptr;
@@ -61,6 +71,9 @@ protected:
     int m_rgbFrameIndex = -1;
     int m_depthFrameIndex = -1;
     int m_pointCloudIndex = -1;
+
+    // the order in which the frame is captured
+    int m_sequence = -1;
 };
 
 class ImageOutputSaver : public OutputSaver
@@ -71,7 +84,18 @@ public:
     void saveOutputDepth(StreamData& streamData) override;
     void saveOutputIr(StreamData& streamData) override;
 private:
-    void saveGrayScale16(StreamData& streamData, QString path);
+    void saveGrayScale16(StreamData& streamData, QString fileName);
+};
+
+// depth and IR are encoded by RvlCodec, RGB is saved as PNG
+class RvlOutputSaver : public ImageOutputSaver
+{
+public:
+    RvlOutputSaver(CameraCaptureBase* cameraCapture, const CameraCaptureConfig& config, const OutputDataPort& output);
+    void saveOutputDepth(StreamData& streamData) override;
+    void saveOutputIr(StreamData& streamData) override;
+protected:
+    QString getSuffix2D(CS_CAMERA_DATA_TYPE dataType) override;
 };
 
 class RawOutputSaver : public OutputSaver
@@ -81,8 +105,6 @@ public:
     void saveOutputRGB(StreamData& streamData) override;
     void saveOutputDepth(StreamData& streamData) override;
     void saveOutputIr(StreamData& streamData) override;
-private:
-    void saveDataToFile(QString filePath, QByteArray data);
 };
 
 }
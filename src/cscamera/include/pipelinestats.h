@@ -0,0 +1,142 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_PIPELINESTATS_H
+#define _CS_PIPELINESTATS_H
+
+#include <QVector>
+#include <QString>
+#include <atomic>
+
+#include "cscameraapi.h"
+
+// buckets of a latency histogram, 8 buckets for every power of two microseconds, up to about 4 hours
+#define HISTOGRAM_SUB_BUCKET_BITS       3
+#define HISTOGRAM_BUCKET_COUNT          256
+
+namespace cs
+{
+
+enum PIPELINE_STAGE
+{
+    // from the receipt of the frame to the dequeue in ProcessThread
+    STAGE_QUEUE = 0,
+    // from the dequeue to the end of all process strategies
+    STAGE_PROCESS,
+    // the duration of each process strategy, in the order of PROCESS_STRA_TYPE
+    STAGE_STRATEGY_DEPTH,
+    STAGE_STRATEGY_RGB,
+    STAGE_STRATEGY_POINT_CLOUD,
+    STAGE_STRATEGY_DEPTH_PREPROCESS,
+    STAGE_STRATEGY_RGB_PREPROCESS,
+    // from the receipt of the frame to the end of its saving
+    STAGE_SAVE,
+    // from the receipt of the frame to its output shown in a render widget
+    STAGE_RENDER,
+    STAGE_COUNT
+};
+
+enum PIPELINE_DROP
+{
+    // frames dropped or replaced in the queue of ProcessThread
+    DROP_PROCESS_QUEUE = 0,
+    // frames skipped by QUEUE_POLICY_EVERY_NTH
+    DROP_PROCESS_SKIPPED,
+    // frames dropped by CameraCaptureMultiple because its cache was full
+    DROP_CAPTURE,
+    DROP_COUNT
+};
+
+struct CS_CAMERA_EXPORT LatencySnapshot
+{
+    QVector<quint64> buckets;
+    quint64 count = 0;
+    quint64 totalNs = 0;
+    // the max latency since the last reset, it is not changed by the subtraction
+    qint64 maxNs = 0;
+
+    // latency of the percentile(0 ~ 100) in nanoseconds, 0 if empty
+    qint64 percentile(double p) const;
+    qint64 meanNs() const;
+
+    // the histogram of the records between other and this
+    LatencySnapshot operator-(const LatencySnapshot& other) const;
+};
+
+// A lock-free histogram of latencies, record() may be called by any thread.
+// The buckets are log-linear, so a percentile is at most 1/16 off the recorded latency.
+class CS_CAMERA_EXPORT LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 ns);
+    LatencySnapshot snapshot() const;
+    void reset();
+
+    static int getBucketIndex(qint64 ns);
+    // the middle of the bucket in nanoseconds
+    static qint64 getBucketValue(int index);
+private:
+    std::atomic<quint64> m_buckets[HISTOGRAM_BUCKET_COUNT];
+    std::atomic<quint64> m_count;
+    std::atomic<quint64> m_totalNs;
+    std::atomic<qint64> m_maxNs;
+};
+
+struct CS_CAMERA_EXPORT PipelineStatsSnapshot
+{
+    // monotonic time of the snapshot in nanoseconds
+    qint64 time = 0;
+    LatencySnapshot stages[STAGE_COUNT];
+    quint64 drops[DROP_COUNT] = {};
+
+    PipelineStatsSnapshot operator-(const PipelineStatsSnapshot& other) const;
+};
+
+// Latencies and drops of the frame pipeline: camera -> ProcessThread -> process strategies -> capture / render.
+// The frames are stamped with PipelineStats::now() when they are received from the camera (FrameData::receivedTime),
+// the frames not stamped (e.g. played from a file) are left out of the stages measured from the receipt.
+class CS_CAMERA_EXPORT PipelineStats
+{
+public:
+    static PipelineStats* getInstance();
+
+    // monotonic time in nanoseconds
+    static qint64 now();
+    static QString getStageName(int stage);
+    static QString getDropName(int drop);
+
+    void record(PIPELINE_STAGE stage, qint64 ns);
+    // record the latency from the time to now, ignored if the time is not set
+    void recordSince(PIPELINE_STAGE stage, qint64 time);
+    void addDrop(PIPELINE_DROP drop, quint64 count = 1);
+
+    PipelineStatsSnapshot snapshot() const;
+    void reset();
+private:
+    PipelineStats();
+private:
+    LatencyHistogram m_stages[STAGE_COUNT];
+    std::atomic<quint64> m_drops[DROP_COUNT];
+};
+
+}
+
+#endif //_CS_PIPELINESTATS_H
@@ -0,0 +1,42 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_PLYREADER_H
+#define _CS_PLYREADER_H
+
+#include <QByteArray>
+#include <hpp/Processing.hpp>
+
+namespace cs
+{
+
+// Reads point clouds from PLY data, the ascii and the binary little endian formats are supported.
+// The header is parsed to locate the x/y/z, nx/ny/nz and red/green/blue properties of the vertex element,
+// the arrays are sized by the vertex count once, and the body is parsed by chunks in parallel.
+class PlyReader
+{
+public:
+    // colors: RGB888 color of each vertex, it is empty if the vertices have no color
+    static bool readPointCloud(const QByteArray& data, Pointcloud& pointCloud, QByteArray& colors);
+};
+
+}
+
+#endif //_CS_PLYREADER_H
@@ -0,0 +1,46 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_PLYWRITER_H
+#define _CS_PLYWRITER_H
+
+#include <QString>
+#include <QImage>
+#include <QIODevice>
+#include <hpp/Processing.hpp>
+#include "cscameraapi.h"
+
+namespace cs
+{
+
+// Writes point clouds as PLY files, the layout is the same as cs::Pointcloud::exportToFile.
+// The rows are formatted into large buffers by chunks in parallel, and each buffer is written at once.
+class CS_CAMERA_EXPORT PlyWriter
+{
+public:
+    // texImage is the RGB888 texture, the point cloud is saved without color if it is null
+    static bool savePointCloud(QString filePath, Pointcloud& pointCloud, const QImage& texImage, bool binary = false);
+    // write the PLY data to an opened device, e.g. a QBuffer
+    static bool savePointCloud(QIODevice& device, Pointcloud& pointCloud, const QImage& texImage, bool binary = false);
+};
+
+}
+
+#endif //_CS_PLYWRITER_H
@@ -0,0 +1,60 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_DEPTHCOLORIZER_H
+#define _CS_DEPTHCOLORIZER_H
+
+#include <vector>
+#include <QtGlobal>
+#include <hpp/Processing.hpp>
+
+#include "cscameraapi.h"
+
+namespace cs
+{
+
+// Converts depth data into RGB888 with the color map of cs::colorizer.
+// The colors of all the 65536 depth codes are cached in a table which is rebuilt when the range or scale changes,
+// so a depth code is colorized with one lookup. Float depth which is not an integer falls back to cs::colorizer.
+class CS_CAMERA_EXPORT DepthColorizer
+{
+public:
+    DepthColorizer();
+
+    void setRange(int zmin, int zmax);
+    void process(const ushort* depthData, float scale, uchar* rgbData, int width, int height);
+    void process(const float* depthData, float scale, uchar* rgbData, int width, int height);
+private:
+    void updateTable(float scale);
+private:
+    cs::colorizer m_colorizer;
+
+    int m_zmin;
+    int m_zmax;
+    float m_scale;
+    bool m_tableValid;
+
+    // RGB888 color of each depth code
+    std::vector<uchar> m_table;
+};
+
+}
+
+#endif //_CS_DEPTHCOLORIZER_H
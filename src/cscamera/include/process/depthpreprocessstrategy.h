@@ -0,0 +1,60 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_DEPTH_PREPROCESSSTRATEGY_H
+#define _CS_DEPTH_PREPROCESSSTRATEGY_H
+
+#include <QObject>
+#include "processstrategy.h"
+#include "timedomainsmooth.h"
+#include "fillhole.h"
+#include "depthspatialfilter.h"
+#include "cscameraapi.h"
+
+namespace cs
+{
+
+// Converts the depth stream to float and applies fill hole and filters once per frame,
+// the result is attached to the OutputDataPort for the depth and point cloud strategies.
+class CS_CAMERA_EXPORT DepthPreprocessStrategy : public ProcessStrategy
+{
+    Q_OBJECT
+public:
+    DepthPreprocessStrategy();
+    void doProcess(const FrameData& frameData, OutputDataPort& outputDataPort) override;
+    void onLoadCameraPara() override;
+
+private:
+    bool onProcessDepthData(const ushort* dataPtr, int length, int width, int height, QByteArray& output);
+
+private:
+    TimeDomainSmooth m_timeDomainSmooth;
+    DepthFillHole m_depthFillHole;
+    DepthSpatialFilter m_spatialFilter;
+
+    bool m_fillHole;
+    int m_filterValue;
+    int m_filterType;
+
+    TRIGGER_MODE m_trigger = TRIGGER_MODE_OFF;
+};
+
+}
+
+#endif //_CS_DEPTH_PREPROCESSSTRATEGY_H
@@ -23,8 +23,8 @@
 #include <QObject>
 #include <QPointF>
 #include <QPair>
-#include <QList>
 #include "processstrategy.h"
+#include "depthcolorizer.h"
 #include "cscameraapi.h"
 
 namespace cs
@@ -35,6 +35,7 @@ class CS_CAMERA_EXPORT DepthProcessStrategy : public ProcessStrategy
     Q_OBJECT
     Q_PROPERTY(bool calcDepthCoord READ getCalcDepthCoord WRITE setCalcDepthCoord)
     Q_PROPERTY(QPointF depthCoordCalcPos READ getDepthCoordCalcPos WRITE setDepthCoordCalcPos)
+    Q_PROPERTY(bool outputDepth READ getOutputDepth WRITE setOutputDepth)
 public:
     DepthProcessStrategy();
     DepthProcessStrategy(PROCESS_STRA_TYPE type);
@@ -45,39 +46,34 @@ public:
     void setCalcDepthCoord(bool calc);
     QPointF getDepthCoordCalcPos() const;
     void  setDepthCoordCalcPos(QPointF pos);
+    bool getOutputDepth() const;
+    void setOutputDepth(bool output);
+
+    // the preprocessed depth is not needed if only the IR images are output
+    QVector<int> getDependentStrategys() const override;
 
 protected:
-    bool onProcessDepthData(const ushort* dataPtr, int length, int width, int height, QByteArray& output);
     void generateDepthImage(const QByteArray& output, int width, int height, QImage& depthImage);
 protected:
     float m_depthScale;
     Intrinsics m_depthIntrinsics;
 
 private:
-    QVector<OutputData2D> onProcessZ16(const StreamData& frameData);
-    QVector<OutputData2D> onProcessZ16Y8Y8(const StreamData& frameData);
+    QVector<OutputData2D> onProcessZ16(const StreamData& frameData, const QByteArray& depthData);
+    QVector<OutputData2D> onProcessZ16Y8Y8(const StreamData& frameData, const QByteArray& depthData);
     QVector<OutputData2D> onProcessPAIR(const StreamData& frameData);
    
-    OutputData2D processDepthData(const ushort* dataPtr, int length, int width, int height);
+    OutputData2D processDepthData(const QByteArray& depthData, int width, int height);
     OutputData2D onProcessLData(const char* dataPtr, int length, int width, int height);
     OutputData2D onProcessRData(const char* dataPtr, int length, int width, int height);
 
-    bool timeDomainSmooth(float* dataPtr, int length, int width, int height);
-
 protected:
     bool m_calcDepthCoord;
     QPointF m_depthCoordCalcPos;
-    
-    // for time domain smooth
-    QList<QByteArray> m_filterCachedData;
+    bool m_outputDepth;
     QPair<float, float> m_depthRange;
 
-    bool m_fillHole;
-    int m_filterValue;
-    int m_filterType;
-
-    TRIGGER_MODE m_trigger = TRIGGER_MODE_OFF;
-    cs::colorizer m_colorizer;
+    DepthColorizer m_colorizer;
 };
 
 }
@@ -0,0 +1,67 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_DEPTHSPATIALFILTER_H
+#define _CS_DEPTHSPATIALFILTER_H
+
+#include <vector>
+#include <QtGlobal>
+
+#include "cscameraapi.h"
+
+namespace cs
+{
+
+// Spatial filters of depth frames, the results are the same as filter::AverageBlur and filter::MedianBlur:
+// a pixel is filtered only if all the values in its window are valid (>= 1), and a result is written back only if it is > 1.
+// The average is a sliding box sum, the median uses sorting networks for 3x3 and 5x5 windows 
+// and a sliding histogram for the other sizes. The scratch memory is kept for the next frame.
+class CS_CAMERA_EXPORT DepthSpatialFilter
+{
+public:
+    DepthSpatialFilter();
+
+    void averageBlur(float* dataPtr, int width, int height, int filterSize);
+    void medianBlur(float* dataPtr, int width, int height, int filterSize);
+private:
+    void sumRows(const float* dataPtr, int width, int height, int filterSize);
+    void medianNetwork(const float* dataPtr, int width, int height, int filterSize);
+    void medianHistogram(const float* dataPtr, int width, int height, int filterSize);
+    void writeBack(float* dataPtr, int width, int height, int filterSize);
+private:
+    // sums of the valid values and the valid counts in the horizontal window of each pixel
+    std::vector<double> m_rowSum;
+    std::vector<int> m_rowCount;
+
+    // vertical sliding sums of each row block
+    std::vector<double> m_columnSum;
+    std::vector<int> m_columnCount;
+
+    // filtered values, 0 if the window is not valid
+    std::vector<float> m_output;
+
+    // fine and coarse histograms of each row block
+    std::vector<ushort> m_histograms;
+    std::vector<ushort> m_coarseHistograms;
+};
+
+}
+
+#endif //_CS_DEPTHSPATIALFILTER_H
@@ -20,271 +20,359 @@
 #ifndef _FILLHOLE_H_
 #define _FILLHOLE_H_
 #include <vector>
+#include <algorithm>
+#include <math.h>
 
-struct  _block
+namespace cs
 {
-    int  start;
-    int  end;
-    int  num;
-    int     flag;
-};
 
-template<class T>
-void fillRow(T*  mask, int width, std::vector<struct  _block> *  row_cluster)
+// Fill the small holes of a depth map.
+// The holes (zero pixels) are labeled by run-length union-find, a component is filled if it does not touch 
+// the image border, its area is less than maxArea and the depth spread around it is not more than maxSpread.
+// The scratch memory is kept for the next frame.
+class DepthFillHole
 {
-    bool  isStart = false;
-    struct  _block    res;
-    res.flag = 0;
-    for (int i = 0; i < width; i++)
+public:
+    DepthFillHole(int maxArea = 200, int maxSpread = 500)
+        : m_maxArea(maxArea)
+        , m_maxSpread(maxSpread)
+    {
+    }
+
+    template<class T>
+    void process(T* depth, int width, int height);
+
+private:
+    struct Run
+    {
+        int start;
+        int end;
+        int row;
+        int node;
+    };
+
+    template<class T>
+    void findRuns(const T* depth, int width, int height);
+    void labelRuns(int height);
+    template<class T>
+    void fillComponents(T* depth, int width, int height);
+
+    int newNode(int key, int row)
     {
-        if (mask[i] != 0)
+        m_parent.push_back((int)m_parent.size());
+        m_key.push_back(key);
+        m_rowStamp.push_back(row);
+        return (int)m_parent.size() - 1;
+    }
+
+    int findRoot(int node)
+    {
+        int root = node;
+        while (m_parent[root] != root)
         {
-            if (!isStart)
-            {
-                isStart = true;
-                res.start = i;
-            }
+            root = m_parent[root];
         }
-        else
+
+        // path compression
+        while (m_parent[node] != root)
         {
-            if (isStart)
-            {
-                res.end = i - 1;
-                res.num = res.end - res.start + 1;
-                row_cluster->push_back(res);
-                isStart = false;
-            }
+            int next = m_parent[node];
+            m_parent[node] = root;
+            node = next;
         }
+        return root;
     }
 
-    if (isStart)
+    static bool isHole(float v)
     {
-        res.end = width - 1;
-        res.num = res.end - res.start + 1;
-        row_cluster->push_back(res);
+        return fabs(v) < 1e-6;
     }
-}
 
-bool  isConnect(struct  _block  block1, struct  _block  block2)
+private:
+    const int m_maxArea;
+    const int m_maxSpread;
+
+    // runs of holes, sorted by row and start
+    std::vector<Run> m_runs;
+    // runs of row i are in [m_rowOffsets[i], m_rowOffsets[i + 1])
+    std::vector<int> m_rowOffsets;
+
+    // union-find nodes
+    std::vector<int> m_parent;
+    // the order in which the components are filled
+    std::vector<int> m_key;
+    // the last row which has a run referencing the node
+    std::vector<int> m_rowStamp;
+
+    // per root statistics
+    std::vector<int> m_area;
+    std::vector<char> m_border;
+    std::vector<int> m_component;
+
+    // candidate components and their runs
+    std::vector<int> m_candidates;
+    std::vector<int> m_componentOffsets;
+    std::vector<int> m_componentRuns;
+    std::vector<int> m_runPos;
+};
+
+template<class T>
+void DepthFillHole::process(T* depth, int width, int height)
 {
-    int max = (block1.end > block2.end) ? block1.end : block2.end;//std::max(block1.end, block2.end);
-    int min = (block1.start < block2.start) ? block1.start : block2.start;//std::min(block1.start, block2.start);
-    if ((max - min + 1) < (block1.num + block2.num))
-        return  true;
-    else
-        return  false;
-}
+    if (width <= 2 || height <= 2)
+    {
+        return;
+    }
 
+    findRuns(depth, width, height);
+    labelRuns(height);
+    fillComponents(depth, width, height);
+}
 
 template<class T>
-void depthFillHole(T* depth, int width, int height)    //????
+void DepthFillHole::findRuns(const T* depth, int width, int height)
 {
-    //cv::Mat  mask = cv::Mat::zeros(height, width, CV_16SC1);
-    T* ptr_depth = depth;
-    T* ptr_mask = (T*)malloc(height * width * sizeof(T)); //(short*)mask.data;
-    memset(ptr_mask, 0, height * width * sizeof(T));
+    m_rowOffsets.assign(height + 1, 0);
 
+    // count the runs of every row
 #pragma omp parallel for
-    for (int i = 0; i < height * width; i++)
+    for (int y = 0; y < height; y++)
     {
-        if (fabs(ptr_depth[i]) < 1e-6)
-            ptr_mask[i] = -1;
+        const T* rowPtr = depth + y * width;
+        int count = 0;
+        bool inRun = false;
+        for (int x = 0; x < width; x++)
+        {
+            const bool hole = isHole(rowPtr[x]);
+            count += (hole && !inRun);
+            inRun = hole;
+        }
+        m_rowOffsets[y + 1] = count;
     }
 
-    int   label = 1;
-    std::vector<std::vector<struct  _block> *>    row_clusters;
-
-    for (int i = 0; i < height; i++)
+    for (int y = 0; y < height; y++)
     {
-        std::vector<struct  _block> *tmp = new  std::vector<struct  _block>();
-        row_clusters.push_back(tmp);
+        m_rowOffsets[y + 1] += m_rowOffsets[y];
     }
 
-    //?????????????
-#pragma omp parallel for
-    for (int i = 0; i < height; i++)
-        fillRow<T>(ptr_mask + i * width, width, row_clusters[i]);
+    m_runs.resize(m_rowOffsets[height]);
 
-    //?????????
-    for (int i = 0; i < row_clusters[0]->size(); i++)
+#pragma omp parallel for
+    for (int y = 0; y < height; y++)
     {
-        for (int j = row_clusters[0]->at(i).start; j <= row_clusters[0]->at(i).end; j++)
+        const T* rowPtr = depth + y * width;
+        Run* runPtr = m_runs.data() + m_rowOffsets[y];
+        int x = 0;
+        while (x < width)
         {
-            row_clusters[0]->at(i).flag = label;
+            if (!isHole(rowPtr[x]))
+            {
+                x++;
+                continue;
+            }
+
+            Run run;
+            run.start = x;
+            while (x < width && isHole(rowPtr[x]))
+            {
+                x++;
+            }
+            run.end = x - 1;
+            run.row = y;
+            run.node = -1;
+            *runPtr++ = run;
         }
-        label++;
     }
-    for (int i = 1; i < height; i++)
+}
+
+// Label the runs row by row, two runs in adjacent rows are connected if they share a column.
+// When a run joins two labels, the runs of the current row keep the old label, 
+// it's the same as the labeling the filter has always used.
+inline void DepthFillHole::labelRuns(int height)
+{
+    m_parent.clear();
+    m_key.clear();
+    m_rowStamp.clear();
+
+    int label = 1;
+    for (int y = 0; y < height; y++)
     {
-        T* tmp_mask_pre = ptr_mask + (i - 1) * width;
-        T* tmp_mask_next = ptr_mask + i * width;
-        for (int t = 0; t < row_clusters[i]->size(); t++)
+        const int curBegin = m_rowOffsets[y];
+        const int curEnd = m_rowOffsets[y + 1];
+        const int preBegin = (y > 0) ? m_rowOffsets[y - 1] : 0;
+        const int preEnd = (y > 0) ? m_rowOffsets[y] : 0;
+
+        int preFirst = preBegin;
+        for (int t = curBegin; t < curEnd; t++)
         {
-            std::vector<struct  _block> *cur = row_clusters[i];
-            std::vector<struct  _block> *pre = row_clusters[i - 1];
+            Run& cur = m_runs[t];
 
-            bool  flag1 = true;
-            for (int j = 0; j < pre->size(); j++)
+            // skip the runs of the previous row which end before the current run
+            while (preFirst < preEnd && m_runs[preFirst].end < cur.start)
             {
-                if (isConnect(cur->at(t), pre->at(j)))
+                preFirst++;
+            }
+
+            for (int j = preFirst; j < preEnd && m_runs[j].start <= cur.end; j++)
+            {
+                const int preLabel = findRoot(m_runs[j].node);
+                if (cur.node < 0)
                 {
-                    flag1 = false;
-                    if (cur->at(t).flag == 0)
-                        cur->at(t).flag = pre->at(j).flag;
-                    else
+                    cur.node = preLabel;
+                    m_rowStamp[preLabel] = y;
+                }
+                else if (preLabel != cur.node)
+                {
+                    // runs of the current row which have preLabel keep their label
+                    if (m_rowStamp[preLabel] == y)
                     {
-                        int  tmp_flag = pre->at(j).flag;
-
-                        for (int n = i - 1; n >= 0; n--)
+                        const int detached = newNode(m_key[preLabel], y);
+                        for (int k = curBegin; k < t; k++)
                         {
-                            std::vector<struct  _block> *cur1 = row_clusters[n];
-
-                            bool  flag = true;
-                            for (int m = 0; m < cur1->size(); m++)
+                            if (m_runs[k].node == preLabel)
                             {
-                                if (cur1->at(m).flag == tmp_flag)
-                                {
-                                    cur1->at(m).flag = cur->at(t).flag;
-                                    flag = false;
-                                }
+                                m_runs[k].node = detached;
                             }
-                            if (flag)
-                                break;
                         }
                     }
+
+                    m_parent[preLabel] = cur.node;
                 }
             }
 
-            if (flag1)
+            if (cur.node < 0)
             {
-                cur->at(t).flag = label++;
+                cur.node = newNode(label++, y);
             }
         }
     }
+}
 
+template<class T>
+void DepthFillHole::fillComponents(T* depth, int width, int height)
+{
+    const int nodeCount = (int)m_parent.size();
+    m_area.assign(nodeCount, 0);
+    m_border.assign(nodeCount, 0);
+    m_component.assign(nodeCount, -1);
 
-#pragma omp parallel for    
-    for (int i = 1; i < label; i++)
+    // area and border contact of the components
+    for (auto& run : m_runs)
     {
-        std::vector<std::pair<int, int>>   clusters;
-        bool  isStart = false;
-        for (int y = 0; y < row_clusters.size(); y++)
+        run.node = findRoot(run.node);
+        m_area[run.node] += run.end - run.start + 1;
+        if (run.start == 0 || run.end == width - 1 || run.row == 0 || run.row == height - 1)
         {
-            bool  isHave = false;
-            for (int x = 0; x < row_clusters[y]->size(); x++)
-            {
-                if (row_clusters[y]->at(x).flag == i)
-                {
-                    isStart = true;
-
-                    if (((row_clusters[y]->at(x).start == 0) || (row_clusters[y]->at(x).end == (width - 1))) ||
-                        ((y == 0) || (y == (height - 1))))
-                    {
-                        isHave = false;
-                        clusters.clear();
-                        break;
-                    }
-                    else
-                    {
-                        clusters.push_back(std::pair<int, int>(y, x));
-                        isHave = true;
-                    }
-
-                }
-            }
+            m_border[run.node] = 1;
+        }
+    }
 
-            if (isStart && (!isHave))
-            {
-                if (clusters.size() > 0)
-                {
-                    int  num = 0;
-                    for (int k = 0; k < clusters.size(); k++)
-                        num += row_clusters[clusters[k].first]->at(clusters[k].second).num;
+    m_candidates.clear();
+    for (int i = 0; i < nodeCount; i++)
+    {
+        if (m_parent[i] == i && m_area[i] > 0 && m_area[i] < m_maxArea && !m_border[i])
+        {
+            m_candidates.push_back(i);
+        }
+    }
 
-                    if (num < 200)
-                    {
+    std::sort(m_candidates.begin(), m_candidates.end(), [&](int a, int b) { return m_key[a] < m_key[b]; });
 
-                        //printf("................................%d\n", i);
+    // group the runs by candidate component
+    const int candidateCount = (int)m_candidates.size();
+    m_componentOffsets.assign(candidateCount + 1, 0);
+    for (int i = 0; i < candidateCount; i++)
+    {
+        m_component[m_candidates[i]] = i;
+    }
 
-                        int  max_v = -1;
-                        int  min_v = 100000;
-                        for (int k = 0; k < clusters.size(); k++)
-                        {
-                            int  row = clusters[k].first;
-                            int  start_c = row_clusters[row]->at(clusters[k].second).start;
-                            int  end_c = row_clusters[row]->at(clusters[k].second).end;
-
-                            int  tmp = row * width;
-                            T z1 = depth[tmp + start_c - 1];
-                            T z2 = depth[tmp + end_c + 1];
-                            //printf("row:%d, start:%d,end:%d,z1:%d,z2:%d\n", row, start_c, end_c,z1,z2);
-
-                            if (z1 > max_v)  max_v = z1;
-                            if (z1 < min_v)   min_v = z1;
-                            if (z2 > max_v)  max_v = z2;
-                            if (z2 < min_v)   min_v = z2;
-                            for (int p = 0; p < 2; p++)
-                            {
-                                int tmp1 = tmp;
-                                if (p == 0) tmp1 -= width;
-                                else    tmp1 += width;
-                                for (int k = start_c; k <= end_c; k++)
-                                {
-                                    int depth1 = depth[tmp1 + k];
-                                    if (depth1 != 0)
-                                    {
-                                        if (depth1 > max_v)  max_v = depth1;
-                                        if (depth1 < min_v)   min_v = depth1;
-                                    }
-                                }
+    for (const auto& run : m_runs)
+    {
+        const int c = m_component[run.node];
+        if (c >= 0)
+        {
+            m_componentOffsets[c + 1]++;
+        }
+    }
 
-                            }
-                        }
+    for (int i = 0; i < candidateCount; i++)
+    {
+        m_componentOffsets[i + 1] += m_componentOffsets[i];
+    }
 
-                        if ((max_v - min_v) > 500)
-                            continue;
+    m_componentRuns.resize(m_componentOffsets[candidateCount]);
+    m_runPos.assign(m_componentOffsets.begin(), m_componentOffsets.end() - 1);
+    for (int r = 0; r < (int)m_runs.size(); r++)
+    {
+        const int c = m_component[m_runs[r].node];
+        if (c >= 0)
+        {
+            m_componentRuns[m_runPos[c]++] = r;
+        }
+    }
 
+    for (int c = 0; c < candidateCount; c++)
+    {
+        const int begin = m_componentOffsets[c];
+        const int end = m_componentOffsets[c + 1];
 
-                        for (int k = 0; k < clusters.size(); k++)
-                        {
-                            int  row = clusters[k].first;
-                            int  start_c = row_clusters[row]->at(clusters[k].second).start;
-                            int  end_c = row_clusters[row]->at(clusters[k].second).end;
+        // depth spread around the component
+        int maxV = -1;
+        int minV = 100000;
+        for (int i = begin; i < end; i++)
+        {
+            const Run& run = m_runs[m_componentRuns[i]];
+            const int offset = run.row * width;
+            const T z1 = depth[offset + run.start - 1];
+            const T z2 = depth[offset + run.end + 1];
 
-                            int  tmp = row * width;
-                            T z1 = depth[tmp + start_c - 1];
-                            T z2 = depth[tmp + end_c + 1];
-                            //printf("row:%d, start:%d,end:%d,z1:%d,z2:%d\n", row, start_c, end_c,z1,z2);
+            if (z1 > maxV) maxV = z1;
+            if (z1 < minV) minV = z1;
+            if (z2 > maxV) maxV = z2;
+            if (z2 < minV) minV = z2;
 
-                            if ((z1 != 0) || (z2 != 0))
-                            {
-                                for (int k = start_c; k <= end_c; k++)
-                                {
-                                    if (depth[tmp + k] == 0)
-                                    {
-                                        depth[tmp + k] = (float)(z2 - z1) * (float)(k - start_c + 1) / (float)(end_c - start_c + 2) + z1;
-                                    }
-                                }
-                            }
-                        }
+            for (int p = 0; p < 2; p++)
+            {
+                const int offset1 = (p == 0) ? (offset - width) : (offset + width);
+                for (int k = run.start; k <= run.end; k++)
+                {
+                    int d = depth[offset1 + k];
+                    if (d != 0)
+                    {
+                        if (d > maxV) maxV = d;
+                        if (d < minV) minV = d;
                     }
                 }
-
-
-                break;
             }
         }
-    }
 
+        if ((maxV - minV) > m_maxSpread)
+        {
+            continue;
+        }
 
-    for (int i = 0; i < height; i++)
-    {
-        row_clusters[i]->clear();
-        delete  row_clusters[i];
+        // linear interpolation between the left and right neighbours of every run
+        for (int i = begin; i < end; i++)
+        {
+            const Run& run = m_runs[m_componentRuns[i]];
+            const int offset = run.row * width;
+            const T z1 = depth[offset + run.start - 1];
+            const T z2 = depth[offset + run.end + 1];
+
+            if ((z1 != 0) || (z2 != 0))
+            {
+                for (int k = run.start; k <= run.end; k++)
+                {
+                    if (depth[offset + k] == 0)
+                    {
+                        depth[offset + k] = (float)(z2 - z1) * (float)(k - run.start + 1) / (float)(run.end - run.start + 2) + z1;
+                    }
+                }
+            }
+        }
     }
-    row_clusters.clear();
-    free(ptr_mask);
+}
 
 }
 
-#endif // !_FILLHOLE_H_
+#endif // !_FILLHOLE_H_
\ No newline at end of file
@@ -23,9 +23,10 @@
 #include <QMap>
 
 #include "cstypes.h"
+#include "cscameraapi.h"
 #include <hpp/Processing.hpp>
 
-class OutputDataPort
+class CS_CAMERA_EXPORT OutputDataPort
 {
 public:
     OutputDataPort();
@@ -35,20 +36,33 @@ public:
 
     bool isEmpty() const;
     bool hasData(CS_CAMERA_DATA_TYPE dataType) const;
+    bool hasDepthData() const;
+    bool hasRgbImage() const;
 
     cs::Pointcloud getPointCloud();
     OutputData2D getOutputData2D(CS_CAMERA_DATA_TYPE dataType);
     QMap<CS_CAMERA_DATA_TYPE, OutputData2D> getOutputData2Ds();
     FrameData getFrameData() const;
+    const QByteArray& getDepthData() const;
+    QImage getRgbImage() const;
 
     void setFrameData(const FrameData& frameData);
     void setPointCloud(const cs::Pointcloud& pointCloud);
+    void setDepthData(const QByteArray& depthData);
+    void setRgbImage(const QImage& image);
     void addOutputData2D(const OutputData2D& outputData2D);
     void addOutputData2D(const QVector<OutputData2D>& outputData2Ds);
+
+    // merge the outputs of other into this port
+    void merge(const OutputDataPort& other);
 private:
     FrameData m_frameData;
     QMap<CS_CAMERA_DATA_TYPE, OutputData2D> m_outputData2DMap;
     mutable cs::Pointcloud m_pointCloud;
+    // filtered float depth, produced once by the depth preprocess strategy
+    QByteArray m_depthData;
+    // decoded RGB888 image, produced once by the rgb preprocess strategy
+    QImage m_rgbImage;
 };
 
 #endif // _CS_OUTPUTDATAPORT_H
\ No newline at end of file
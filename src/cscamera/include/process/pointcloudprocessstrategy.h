@@ -40,8 +40,8 @@ public:
     bool getWithTexture() const;
     void setWithTexture(bool with);
 private:
-    void generatePointCloud(const StreamData& depthData, Pointcloud& pc);
-    void generateTexture(const StreamData& rgbData, QImage& texImage);
+    void generatePointCloud(const StreamData& depthData, const QByteArray& floatData, Pointcloud& pc);
+    void generateTexture(const StreamData& rgbData, const OutputDataPort& outputDataPort, QImage& texImage);
 private:
     Intrinsics m_rgbIntrinsics;
     Extrinsics m_extrinsics;
@@ -22,6 +22,7 @@
 #include <QObject>
 #include <QVector>
 #include <QMutex>
+#include <QThreadPool>
 #include <memory>
 
 #include "cscameraapi.h"
@@ -53,9 +54,21 @@ public:
     void addProcessEndLisener(ProcessEndListener* listener);
     void removeProcessEndLisener(ProcessEndListener* listener);
 private:
-    QVector<ProcessStrategy*> m_processStrategys; 
+    typedef QVector<ProcessStrategy*> ProcessStrategyList;
+
+    std::shared_ptr<const ProcessStrategyList> getProcessStrategys() const;
+    void runProcessStrategys(const QVector<ProcessStrategy*>& strategys, const FrameData& frameData, OutputDataPort& outputDataPort);
+private:
+    // read without lock by process(), replaced as a whole by add/remove
+    std::shared_ptr<const ProcessStrategyList> m_processStrategys;
+    // serializes the writers of m_processStrategys
+    QMutex m_strategyMutex;
+    // held while a frame is processed
+    QMutex m_processMutex;
     QMutex m_mutex;
     QVector<ProcessEndListener*> m_processEndLiseners;
+
+    QThreadPool m_threadPool;
 };
 }
 
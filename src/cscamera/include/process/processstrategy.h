@@ -38,7 +38,9 @@ enum  PROCESS_STRA_TYPE
 {
     STRATEGY_DEPTH,
     STRATEGY_RGB,
-    STRATEGY_CLOUD_POINT
+    STRATEGY_CLOUD_POINT,
+    STRATEGY_DEPTH_PREPROCESS,
+    STRATEGY_RGB_PREPROCESS
 };
 
 class ICSCamera;
@@ -55,9 +57,10 @@ public:
     virtual void onLoadCameraPara() {}
     void setStrategyEnable(bool enable);
     int isStrategyEnable();
+    virtual QVector<int> getDependentStrategys() const;
 signals:
     void output2DUpdated(OutputData2D outputData);
-    void output3DUpdated(cs::Pointcloud pointCloud, const QImage& image);
+    void output3DUpdated(cs::Pointcloud pointCloud, const QImage& image, qint64 receivedTime);
 
 protected:
     virtual void doProcess(const FrameData& frameData, OutputDataPort& outputDataPort) = 0;
@@ -77,8 +80,12 @@ protected:
     QMutex m_mutex;
     PROCESS_STRA_TYPE m_strategyType;
     bool m_strategyEnable = true;
+    // receivedTime of the frame being processed, passed on to the outputs
+    qint64 m_receivedTime = 0;
 
     QVector<int> m_dependentParameters;
+    // strategys whose output is consumed by this strategy, they are processed before this strategy
+    QVector<int> m_dependentStrategys;
 };
 
 }
@@ -22,7 +22,8 @@
 
 #include <QThread>
 #include <QMutex>
-#include <QQueue>
+#include <QWaitCondition>
+#include <QVector>
 #include <memory>
 
 #include "cstypes.h"
@@ -30,6 +31,27 @@
 
 namespace cs 
 {
+
+enum FRAME_QUEUE_POLICY
+{
+    // keep only the newest frame, for live preview
+    QUEUE_POLICY_LATEST,
+    // keep every frame, the producer waits while the queue is full, for capture
+    QUEUE_POLICY_FIFO,
+    // keep one of every N frames, drop the oldest while the queue is full
+    QUEUE_POLICY_EVERY_NTH
+};
+
+struct FrameQueueStats
+{
+    quint64 receivedCount = 0;
+    quint64 processedCount = 0;
+    // frames dropped because the queue was full or replaced by a newer frame
+    quint64 droppedCount = 0;
+    // frames skipped by QUEUE_POLICY_EVERY_NTH
+    quint64 skippedCount = 0;
+};
+
 class Processor;
 class CS_CAMERA_EXPORT ProcessThread : public QThread
 {
@@ -38,11 +60,30 @@ public:
     ProcessThread(std::shared_ptr<Processor> processor);
     ~ProcessThread();
     void run() override;
+
+    void setQueuePolicy(FRAME_QUEUE_POLICY policy, int everyNth = 1);
+    FrameQueueStats getQueueStats();
+    void resetQueueStats();
 public slots:
     void onFrameDataUpdated(FrameData frameData);
+private:
+    void pushFrame(const FrameData& frameData);
+    void popFrame(FrameData& frameData);
 private:
     QMutex m_mutex;
-    QQueue<FrameData> m_cachedFrameData;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+
+    // ring buffer of cached frames
+    QVector<FrameData> m_cachedFrameData;
+    int m_head = 0;
+    int m_count = 0;
+
+    FRAME_QUEUE_POLICY m_queuePolicy = QUEUE_POLICY_LATEST;
+    int m_everyNth = 1;
+    quint64 m_frameIndex = 0;
+    FrameQueueStats m_queueStats;
+
     std::shared_ptr<Processor> m_processorPtr;
 };
 }
@@ -35,8 +35,7 @@ public:
     void doProcess(const FrameData& frameData, OutputDataPort& outputDataPort) override;
 
 private:
-    OutputData2D onProcessRGB8(const StreamData& frameData);
-    OutputData2D onProcessMJPG(const StreamData& frameData);
+    OutputData2D onProcessRGB(const StreamData& frameData, const OutputDataPort& outputDataPort);
 };
 
 }
@@ -0,0 +1,63 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_TIMEDOMAINSMOOTH_H
+#define _CS_TIMEDOMAINSMOOTH_H
+
+#include <vector>
+#include <QtGlobal>
+
+#include "cscameraapi.h"
+
+namespace cs
+{
+
+// Time domain smooth of depth frames, the output is the average of the valid (> 0) values 
+// of the last N frames. The running sum and valid count planes are updated incrementally,
+// so the cost per pixel does not depend on N.
+class CS_CAMERA_EXPORT TimeDomainSmooth
+{
+public:
+    TimeDomainSmooth();
+
+    // return false if less than window frames are cached
+    bool process(float* dataPtr, int width, int height, int window);
+    void reset();
+    int getCachedCount() const;
+private:
+    void resize(int width, int height, int window);
+    void addFrame(int slot);
+    void removeFrame(int slot);
+private:
+    int m_width = 0;
+    int m_height = 0;
+    int m_window = 0;
+
+    // ring buffer of the cached frames, the oldest frame is at m_head
+    std::vector<float> m_frames;
+    int m_head = 0;
+    int m_count = 0;
+
+    std::vector<double> m_sum;
+    std::vector<int> m_validCount;
+};
+
+}
+
+#endif //_CS_TIMEDOMAINSMOOTH_H
@@ -0,0 +1,48 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_RVLCODEC_H
+#define _CS_RVLCODEC_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+namespace cs
+{
+
+// Lossless codec for depth and IR images, based on the run length variable length (RVL) scheme.
+// Runs of zero pixels and runs of valid pixels are counted, the valid pixels are stored as the difference
+// to the previous valid pixel, and all the numbers are written as variable length nibbles.
+// The image is split into bands of rows which are encoded and decoded in parallel.
+class RvlCodec
+{
+public:
+    // encode 16 bits depth data
+    static bool encode(const ushort* data, int width, int height, QByteArray& output);
+    // encode 8 bits IR data
+    static bool encode(const uchar* data, int width, int height, QByteArray& output);
+
+    // decode the data of encode(), bitDepth is 16 for depth and 8 for IR
+    static bool decode(const QByteArray& data, int& width, int& height, int& bitDepth, QByteArray& pixData);
+};
+
+}
+
+#endif //_CS_RVLCODEC_H
@@ -0,0 +1,172 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_SIMULATEDCAMERA_H
+#define _CS_SIMULATEDCAMERA_H
+
+#include <QObject>
+#include <QThread>
+#include <QMap>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+#include "icscamera.h"
+#include "cstypes.h"
+#include "cscameraapi.h"
+
+#define SIMULATED_CAMERA_SERIAL "SIMULATED"
+// the environment variable to enable the simulated camera, the value is the config of it
+#define SIMULATED_CAMERA_ENV    "CS_SIMULATED_CAMERA"
+
+namespace cs {
+
+class CapturedZipParser;
+
+struct CS_CAMERA_EXPORT SimulatedCameraConfig
+{
+    // the captured file to replay, a synthetic scene is generated if it is empty
+    QString sourceFile;
+    // the frames per second
+    float fps = 10.0f;
+    // the maximum random delay of a frame, ms
+    int jitter = 0;
+    // the probability to drop a frame, 0 ~ 1
+    float dropRate = 0.0f;
+    // the jitter and the dropped frames are the same in each run with the same seed
+    quint32 seed = 0;
+    // the synthetic scene has a RGB stream or not
+    bool hasRgb = true;
+
+    // parse the config from a string, e.g. "file=capture.zip;fps=30;jitter=5;drop=0.01;seed=1;rgb=0"
+    static SimulatedCameraConfig fromString(QString str);
+};
+
+// A camera without the device, the frames are replayed from a captured file or generated from a synthetic scene
+class SimulatedCamera : public ICSCamera
+{
+    Q_OBJECT
+public:
+    SimulatedCamera(const SimulatedCameraConfig& config);
+    ~SimulatedCamera();
+    // the camera info in the camera list
+    static CameraInfo genCameraInfo();
+
+    void getCameraPara(CAMERA_PARA_ID paraId, QVariant& value) override;
+    void setCameraPara(CAMERA_PARA_ID paraId, QVariant value) override;
+    void getCameraParaRange(CAMERA_PARA_ID paraId, QVariant& min, QVariant& max, QVariant& step) override;
+    void getCameraParaItems(CAMERA_PARA_ID paraId, QList<QPair<QString, QVariant>>& list) override;
+
+    bool connectCamera();
+    bool disconnectCamera() override;
+    bool reconnectCamera() override;
+    bool restartCamera() override;
+
+    bool startStream() override;
+    bool stopStream() override;
+    bool restartStream() override;
+    bool pauseStream() override;
+    bool resumeStream() override;
+    bool softTrigger() override;
+
+    void setCameraThread(QThread* thread);
+
+    CSCameraInfo getCameraInfo() const override;
+    int getCameraState() const override;
+private:
+    void setCameraState(CAMERA_STATE state);
+    bool loadSource();
+    void initCameraInfo();
+    void initDefaultPara();
+    void initStreamInfos();
+
+    bool genFrame(int frameIndex, FrameData& frameData);
+    bool genDepthStream(int frameIndex, double timeStamp, STREAM_FORMAT format, QSize resolution, StreamData& streamData);
+    bool genRgbStream(int frameIndex, double timeStamp, STREAM_FORMAT format, QSize resolution, StreamData& streamData);
+
+    bool readSourceDepth(int frameIndex, int width, int height, bool withIr, QByteArray& depth, QByteArray& irL, QByteArray& irR);
+    bool readSourceRgb(int frameIndex, int width, int height, QByteArray& rgb);
+    void genSyntheticDepth(int width, int height, double timeStamp, QByteArray& depth);
+    void genSyntheticIr(int width, int height, const QByteArray& depth, QByteArray& irL, QByteArray& irR);
+    void genSyntheticRgb(int width, int height, double timeStamp, QByteArray& rgb);
+
+    void getFormats(STREAM_TYPE sType, QList<QPair<QString, QVariant>>& list) const;
+    void getResolutions(STREAM_TYPE sType, QList<QPair<QString, QVariant>>& list) const;
+    void setFormat(STREAM_TYPE sType, STREAM_FORMAT format);
+    void setFilterType(int filterType);
+    void updateStreamType();
+
+    void onTriggerModeChanged(bool isSoftTrigger);
+    void stopStreamThread();
+    void startStreamThread();
+private:
+    class StreamThread : public QThread
+    {
+    public:
+        StreamThread(SimulatedCamera& camera);
+        ~StreamThread();
+        void run() override;
+    private:
+        SimulatedCamera& m_camera;
+    };
+
+private:
+    SimulatedCameraConfig m_config;
+
+    CAMERA_STATE m_cameraState;
+    CSCameraInfo m_cameraInfo;
+
+    // the captured file to replay
+    CapturedZipParser* m_parser;
+    int m_sourceFrameCount;
+    QVector<int> m_sourceDataTypes;
+
+    bool m_isDepthStreamSup;
+    bool m_isRgbStreamSup;
+    QList<StreamInfo> m_depthStreamInfos;
+    QList<StreamInfo> m_rgbStreamInfos;
+
+    Intrinsics m_depthIntrinsics;
+    Intrinsics m_rgbIntrinsics;
+    Extrinsics m_extrinsics;
+    float m_depthScale;
+
+    // the parameters of the camera, the same as the default parameters of CSCamera
+    QMap<CAMERA_PARA_ID, QVariant> m_paras;
+    mutable QMutex m_mutex;
+
+    // the streams of the source frames, the frames are not read again when replaying in a loop
+    QHash<int, QVector<StreamData>> m_frameCache;
+    qint64 m_frameCacheSize;
+    // increased when the cached streams are out of date
+    int m_frameCacheVersion;
+
+    int m_frameIndex;
+    QRandomGenerator m_random;
+    QElapsedTimer m_streamTimer;
+
+    StreamThread* m_streamThread;
+    friend StreamThread;
+
+    QThread* m_cameraThread;
+};
+}
+
+#endif // _CS_SIMULATEDCAMERA_H
@@ -19,10 +19,15 @@
 
 #include "outputsaver.h"
 #include <QDebug>
-#include <QFile>
+#include <QBuffer>
 
 #include <imageutil.h>
+#include <cstracer.h>
 #include "cameracapturetool.h"
+#include "plywriter.h"
+#include "rvlcodec.h"
+#include "process/rgbpreprocessstrategy.h"
+#include "pipelinestats.h"
 
 using namespace cs;
 OutputSaver::OutputSaver(CameraCaptureBase* cameraCapture, const CameraCaptureConfig& config, const OutputDataPort& output)
@@ -41,12 +46,15 @@ OutputSaver::~OutputSaver()
 
 void OutputSaver::run()
 {
+    CS_TRACE_SCOPE_FRAME("OutputSaver::run", m_outputDataPort.getFrameData().receivedTime);
+
     // save 2D datas
     saveOutput2D();
 
     // save point cloud
     savePointCloud();
 
+    PipelineStats::getInstance()->recordSince(STAGE_SAVE, m_outputDataPort.getFrameData().receivedTime);
     m_cameraCapture->saveFinished(this);
 }
 
@@ -62,6 +70,16 @@ void OutputSaver::updateSaveIndex()
     setSaveIndex(rgbFrameIndex, depthFrameIndex, pointCloudIndex);
 }
 
+void OutputSaver::setSequence(int sequence)
+{
+    m_sequence = sequence;
+}
+
+int OutputSaver::getSequence() const
+{
+    return m_sequence;
+}
+
 void OutputSaver::setSaveIndex(int rgbFrameIndex, int depthFrameIndex, int pointCloudIndex)
 {
     this->m_rgbFrameIndex = rgbFrameIndex;
@@ -75,6 +93,7 @@ void OutputSaver::savePointCloud()
     {
         return;
     }
+    CS_TRACE_SCOPE("OutputSaver::savePointCloud");
 
     if (!m_outputDataPort.hasData(CAMERA_DATA_POINT_CLOUD) && !m_outputDataPort.hasData(CAMERA_DATA_DEPTH))
     {
@@ -84,28 +103,26 @@ void OutputSaver::savePointCloud()
     QImage texImage;
     auto frameData = m_outputDataPort.getFrameData();
 
-    // generate texture image from frame data
+    // reuse the decoded rgb image, generate texture image from frame data if not decoded yet
     if (m_captureConfig.savePointCloudWithTexture)
     {
-        for (auto& streamData : frameData.data)
+        if (m_outputDataPort.hasRgbImage())
         {
-            STREAM_FORMAT format = streamData.dataInfo.format;
-
-            if (format == STREAM_FORMAT_RGB8)
-            {
-                QImage image = QImage((uchar*)streamData.data.data(), streamData.dataInfo.width, streamData.dataInfo.height, QImage::Format_RGB888);
-                texImage = image.copy(image.rect());
-            }
-            else if (format == STREAM_FORMAT_MJPG)
+            texImage = m_outputDataPort.getRgbImage();
+        }
+        else
+        {
+            for (auto& streamData : frameData.data)
             {
-                QImage image;
-                image.loadFromData(streamData.data, "JPG");
-                texImage = image;
+                if (RgbPreprocessStrategy::decodeRgbData(streamData, texImage))
+                {
+                    break;
+                }
             }
         }
     }
 
-    bool saveTexture = texImage.isNull();
+    bool saveTexture = !texImage.isNull();
 
     if (m_outputDataPort.hasData(CAMERA_DATA_POINT_CLOUD))
     {
@@ -133,11 +150,11 @@ void OutputSaver::savePointCloud()
                     Intrinsics rgbIntrinsics = frameData.rgbIntrinsics;
                     Extrinsics extrinsics = frameData.extrinsics;
 
-                    pc.generatePoints<ushort>((ushort*)streamData.data.data(), width, height, depthScale, &depthIntrinsics, &rgbIntrinsics, &extrinsics, true);
+                    pc.generatePoints<ushort>((ushort*)streamData.data.constData(), width, height, depthScale, &depthIntrinsics, &rgbIntrinsics, &extrinsics, true);
                 }
                 else 
                 {
-                    pc.generatePoints<ushort>((ushort*)streamData.data.data(), width, height, depthScale, &depthIntrinsics, nullptr, nullptr, true);
+                    pc.generatePoints<ushort>((ushort*)streamData.data.constData(), width, height, depthScale, &depthIntrinsics, nullptr, nullptr, true);
                 }
                 break;
             }
@@ -152,6 +169,7 @@ void OutputSaver::savePointCloud()
 
 void OutputSaver::saveOutput2D()
 {
+    CS_TRACE_SCOPE("OutputSaver::saveOutput2D");
     FrameData frameData = m_outputDataPort.getFrameData();
     for (auto& streamData : frameData.data)
     {
@@ -180,42 +198,91 @@ void OutputSaver::saveOutput2D(StreamData& streamData)
 
 void OutputSaver::savePointCloud(cs::Pointcloud& pointCloud, QImage& texImage)
 {
-    QString savePath = getSavePath(CAMERA_DATA_POINT_CLOUD);
-    QByteArray pathData = savePath.toLocal8Bit();
-    std::string realPath = pathData.data();
+    QString fileName = getSaveFileName(CAMERA_DATA_POINT_CLOUD);
 
-    if (texImage.isNull())
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    if (!PlyWriter::savePointCloud(buffer, pointCloud, texImage, m_captureConfig.savePointCloudBinary))
     {
-        pointCloud.exportToFile(realPath, nullptr, 0, 0);
+        qWarning() << "save point cloud failed:" << fileName;
+        return;
     }
-    else 
+
+    saveFile(CAMERA_DATA_POINT_CLOUD, fileName, buffer.data(), true);
+}
+
+bool OutputSaver::saveFile(CS_CAMERA_DATA_TYPE dataType, QString fileName, const QByteArray& data, bool compress)
+{
+    return saveFile(dataType, fileName, data, 0, data.size(), compress);
+}
+
+bool OutputSaver::saveFile(CS_CAMERA_DATA_TYPE dataType, QString fileName, const QByteArray& buffer, int offset, int size, bool compress)
+{
+    Q_ASSERT(offset >= 0 && size >= 0 && offset + size <= buffer.size());
+
+    CapturedFileInfo info;
+    info.sequence = m_sequence;
+    info.dataType = dataType;
+    info.frameIndex = getFrameIndex(dataType);
+    info.timeStamp = getTimeStamp(dataType);
+    info.fileName = fileName;
+
+    bool result = false;
+    if (offset == 0 && size == buffer.size())
+    {
+        result = m_cameraCapture->saveCapturedFile(info, buffer, compress);
+    }
+    else
+    {
+        // the slice does not own the data, the buffer is kept by the writer until the slice is written
+        const QByteArray data = QByteArray::fromRawData(buffer.constData() + offset, size);
+        result = m_cameraCapture->saveCapturedFile(info, data, compress, buffer);
+    }
+
+    if (!result)
+    {
+        qWarning() << "save file failed:" << fileName;
+        return false;
+    }
+
+    return true;
+}
+
+bool OutputSaver::saveImage(CS_CAMERA_DATA_TYPE dataType, QString fileName, const QImage& image)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "PNG"))
     {
-        pointCloud.exportToFile(realPath, texImage.bits(), texImage.width(), texImage.height());
+        qWarning() << "save image failed:" << fileName;
+        return false;
     }
+
+    // PNG is compressed already
+    return saveFile(dataType, fileName, buffer.data(), false);
 }
 
-QString OutputSaver::getSavePath(CS_CAMERA_DATA_TYPE dataType)
+QString OutputSaver::getSaveFileName(CS_CAMERA_DATA_TYPE dataType)
 {
     QString fileName = m_captureConfig.saveName;
-    QString savePath;
 
     switch (dataType)
     {
     case CAMERA_DATA_L:
         fileName = (m_depthFrameIndex < 0) ? QString("%1-ir-L").arg(fileName) : QString("%1-ir-L-%2").arg(fileName).arg(m_depthFrameIndex, 4, 10, QChar('0'));
-        fileName += m_suffix2D;
+        fileName += getSuffix2D(dataType);
         break;
     case CAMERA_DATA_R:
         fileName = (m_depthFrameIndex < 0) ? QString("%1-ir-R").arg(fileName) : QString("%1-ir-R-%2").arg(fileName).arg(m_depthFrameIndex, 4, 10, QChar('0'));
-        fileName += m_suffix2D;
+        fileName += getSuffix2D(dataType);
         break;
     case CAMERA_DATA_DEPTH:
         fileName = (m_depthFrameIndex < 0) ? QString("%1-depth").arg(fileName) : QString("%1-depth-%2").arg(fileName).arg(m_depthFrameIndex, 4, 10, QChar('0'));
-        fileName += m_suffix2D;
+        fileName += getSuffix2D(dataType);
         break;
     case CAMERA_DATA_RGB:
         fileName = (m_rgbFrameIndex < 0) ? QString("%1-RGB").arg(fileName) : QString("%1-RGB-%2").arg(fileName).arg(m_rgbFrameIndex, 4, 10, QChar('0'));
-        fileName += m_suffix2D;
+        fileName += getSuffix2D(dataType);
         break;
     case CAMERA_DATA_POINT_CLOUD:
         fileName = (m_pointCloudIndex < 0) ? QString("%1.ply").arg(fileName) : QString("%1-%2.ply").arg(fileName).arg(m_pointCloudIndex, 4, 10, QChar('0'));
@@ -224,9 +291,42 @@ QString OutputSaver::getSavePath(CS_CAMERA_DATA_TYPE dataType)
         break;
     }
 
-    savePath = QString("%1/%2").arg(m_captureConfig.saveDir).arg(fileName);
+    return fileName;
+}
 
-    return savePath;
+QString OutputSaver::getSuffix2D(CS_CAMERA_DATA_TYPE dataType)
+{
+    return m_suffix2D;
+}
+
+int OutputSaver::getFrameIndex(CS_CAMERA_DATA_TYPE dataType)
+{
+    switch (dataType)
+    {
+    case CAMERA_DATA_RGB:
+        return m_rgbFrameIndex;
+    case CAMERA_DATA_POINT_CLOUD:
+        return m_pointCloudIndex;
+    default:
+        return m_depthFrameIndex;
+    }
+}
+
+// RGB is from the RGB stream, the others are from the depth stream
+double OutputSaver::getTimeStamp(CS_CAMERA_DATA_TYPE dataType)
+{
+    const STREAM_DATA_TYPE streamDataType = (dataType == CAMERA_DATA_RGB) ? TYPE_RGB : TYPE_DEPTH;
+
+    FrameData frameData = m_outputDataPort.getFrameData();
+    for (const auto& streamData : frameData.data)
+    {
+        if (streamData.dataInfo.streamDataType == streamDataType)
+        {
+            return streamData.dataInfo.timeStamp;
+        }
+    }
+
+    return 0.0;
 }
 
 ImageOutputSaver::ImageOutputSaver(CameraCaptureBase* cameraCapture, const CameraCaptureConfig& config, const OutputDataPort& output)
@@ -243,30 +343,24 @@ void ImageOutputSaver::saveOutputRGB(StreamData& streamData)
     case STREAM_FORMAT_MJPG:
     {
         CS_CAMERA_DATA_TYPE dataType = CAMERA_DATA_RGB;
-        QString savePath = getSavePath(dataType);
+        QString fileName = getSaveFileName(dataType);
 
         QImage image;
         if (m_outputDataPort.hasData(dataType))
         {
             image = m_outputDataPort.getOutputData2D(dataType).image;
         }
+        else if (m_outputDataPort.hasRgbImage())
+        {
+            image = m_outputDataPort.getRgbImage();
+        }
         else
         {
             // save from streamData
-            if (streamData.dataInfo.format == STREAM_FORMAT_RGB8)
-            {
-                image = QImage((uchar*)streamData.data.data(), streamData.dataInfo.width, streamData.dataInfo.height, QImage::Format_RGB888);
-            }
-            else
-            {
-                image.loadFromData(streamData.data, "JPG");
-            }
+            RgbPreprocessStrategy::decodeRgbData(streamData, image);
         }
 
-        if (!image.save(savePath, "PNG"))
-        {
-            qWarning() << "save image failed:" << savePath;
-        }
+        saveImage(dataType, fileName, image);
         break;
     }
     default:
@@ -283,8 +377,8 @@ void ImageOutputSaver::saveOutputDepth(StreamData& streamData)
     {
         CS_CAMERA_DATA_TYPE dataType = CAMERA_DATA_DEPTH;
 
-        QString savePath = getSavePath(dataType);
-        saveGrayScale16(streamData, savePath);
+        QString fileName = getSaveFileName(dataType);
+        saveGrayScale16(streamData, fileName);
         break;
     }
     default:
@@ -292,9 +386,16 @@ void ImageOutputSaver::saveOutputDepth(StreamData& streamData)
     }
 }
 
-void ImageOutputSaver::saveGrayScale16(StreamData& streamData, QString path)
+void ImageOutputSaver::saveGrayScale16(StreamData& streamData, QString fileName)
 {
-    ImageUtil::saveGrayScale16ByLibpng(streamData.dataInfo.width, streamData.dataInfo.height, streamData.data, path);
+    QByteArray pngData;
+    if (!ImageUtil::genPngDataFromGrayScale16(streamData.dataInfo.width, streamData.dataInfo.height, streamData.data, pngData))
+    {
+        qWarning() << "save image failed:" << fileName;
+        return;
+    }
+
+    saveFile(CAMERA_DATA_DEPTH, fileName, pngData, false);
 }
 
 void ImageOutputSaver::saveOutputIr(StreamData& streamData)
@@ -315,7 +416,7 @@ void ImageOutputSaver::saveOutputIr(StreamData& streamData)
         for (auto pair : saveInfos)
         {
             CS_CAMERA_DATA_TYPE dataType = pair.first;
-            QString savePath = getSavePath(dataType);
+            QString fileName = getSaveFileName(dataType);
 
             const int width = streamData.dataInfo.width;
             const int height = streamData.dataInfo.height;
@@ -329,13 +430,87 @@ void ImageOutputSaver::saveOutputIr(StreamData& streamData)
             }
             else
             {
-                image = QImage((uchar*)streamData.data.data() + offset2, width, height, QImage::Format_Grayscale8);
+                image = QImage((const uchar*)streamData.data.constData() + offset2, width, height, QImage::Format_Grayscale8);
             }
 
-            if (!image.save(savePath, "PNG"))
+            saveImage(dataType, fileName, image);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+RvlOutputSaver::RvlOutputSaver(CameraCaptureBase* cameraCapture, const CameraCaptureConfig& config, const OutputDataPort& output)
+    : ImageOutputSaver(cameraCapture, config, output)
+{
+    m_suffix2D = ".rvl";
+}
+
+QString RvlOutputSaver::getSuffix2D(CS_CAMERA_DATA_TYPE dataType)
+{
+    return (dataType == CAMERA_DATA_RGB) ? QString(".png") : m_suffix2D;
+}
+
+void RvlOutputSaver::saveOutputDepth(StreamData& streamData)
+{
+    switch (streamData.dataInfo.format)
+    {
+    case STREAM_FORMAT_Z16:
+    case STREAM_FORMAT_Z16Y8Y8:
+    {
+        QString fileName = getSaveFileName(CAMERA_DATA_DEPTH);
+
+        // the depth data is the first half of Z16Y8Y8
+        QByteArray rvlData;
+        if (!RvlCodec::encode((const ushort*)streamData.data.constData(), streamData.dataInfo.width, streamData.dataInfo.height, rvlData))
+        {
+            qWarning() << "encode depth failed:" << fileName;
+            break;
+        }
+
+        saveFile(CAMERA_DATA_DEPTH, fileName, rvlData, false);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void RvlOutputSaver::saveOutputIr(StreamData& streamData)
+{
+    switch (streamData.dataInfo.format)
+    {
+    case STREAM_FORMAT_Z16Y8Y8:
+    case STREAM_FORMAT_PAIR:
+    {
+        QVector<QPair<CS_CAMERA_DATA_TYPE, int>> saveInfos =
+        {
+            { CAMERA_DATA_L, 0},
+            { CAMERA_DATA_R, 1}
+        };
+
+        const int offset = (streamData.dataInfo.format == STREAM_FORMAT_Z16Y8Y8) ? (streamData.data.size() / 2) : 0;
+
+        for (auto pair : saveInfos)
+        {
+            CS_CAMERA_DATA_TYPE dataType = pair.first;
+            QString fileName = getSaveFileName(dataType);
+
+            const int width = streamData.dataInfo.width;
+            const int height = streamData.dataInfo.height;
+
+            const int offset2 = pair.second * width * height + offset;
+
+            QByteArray rvlData;
+            if (!RvlCodec::encode((const uchar*)streamData.data.constData() + offset2, width, height, rvlData))
             {
-                qWarning() << "save image failed:" << savePath;
+                qWarning() << "encode IR failed:" << fileName;
+                continue;
             }
+
+            saveFile(dataType, fileName, rvlData, false);
         }
         break;
     }
@@ -357,8 +532,10 @@ void RawOutputSaver::saveOutputRGB(StreamData& streamData)
     case STREAM_FORMAT_RGB8:
     case STREAM_FORMAT_MJPG:
     {
-        QString savePath = getSavePath(CAMERA_DATA_RGB);
-        saveDataToFile(savePath, streamData.data);
+        QString fileName = getSaveFileName(CAMERA_DATA_RGB);
+
+        // MJPG is compressed already
+        saveFile(CAMERA_DATA_RGB, fileName, streamData.data, streamData.dataInfo.format != STREAM_FORMAT_MJPG);
         break;
     }
     default:
@@ -373,18 +550,17 @@ void RawOutputSaver::saveOutputDepth(StreamData& streamData)
     case STREAM_FORMAT_Z16:
     case STREAM_FORMAT_Z16Y8Y8:
     {
-        QByteArray saveData;
-        QString savePath = getSavePath(CAMERA_DATA_DEPTH);
+        QString fileName = getSaveFileName(CAMERA_DATA_DEPTH);
+
+        // the depth data is the first half of Z16Y8Y8
         if (streamData.dataInfo.format == STREAM_FORMAT_Z16)
         {
-            saveData = streamData.data;
+            saveFile(CAMERA_DATA_DEPTH, fileName, streamData.data, true);
         }
-        else 
+        else
         {
-            saveData = streamData.data.left(streamData.data.size() / 2);
+            saveFile(CAMERA_DATA_DEPTH, fileName, streamData.data, 0, streamData.data.size() / 2, true);
         }
-
-        saveDataToFile(savePath, saveData);
         break;  
     }
     default:
@@ -410,15 +586,14 @@ void RawOutputSaver::saveOutputIr(StreamData& streamData)
         for (auto pair : saveInfos)
         {
             CS_CAMERA_DATA_TYPE dataType = pair.first;
-            QString savePath = getSavePath(dataType);
+            QString fileName = getSaveFileName(dataType);
 
             const int width = streamData.dataInfo.width;
             const int height = streamData.dataInfo.height;
 
             const int offset2 = pair.second * width * height + offset;
 
-            QByteArray data = streamData.data.mid(offset2, width * height);
-            saveDataToFile(savePath, data);
+            saveFile(dataType, fileName, streamData.data, offset2, width * height, true);
         }
         break;
     }
@@ -426,18 +601,3 @@ void RawOutputSaver::saveOutputIr(StreamData& streamData)
         break;
     }
 }
-
-void RawOutputSaver::saveDataToFile(QString filePath, QByteArray data)
-{
-    QFile file(filePath);
-    file.open(QFile::WriteOnly);
-    if (!file.isOpen())
-    {
-        qWarning() << "open file failed, file:" << filePath;
-        return;
-    }
-
-    file.write(data);
-    file.flush();
-    file.close();
-}
@@ -0,0 +1,267 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "pipelinestats.h"
+
+#include <QtAlgorithms>
+#include <QtMath>
+#include <chrono>
+
+using namespace cs;
+
+#define SUB_BUCKET_COUNT    (1 << HISTOGRAM_SUB_BUCKET_BITS)
+
+qint64 LatencySnapshot::percentile(double p) const
+{
+    if (count == 0 || buckets.isEmpty())
+    {
+        return 0;
+    }
+
+    // rank of the percentile, 1 ~ count
+    const quint64 rank = qBound<quint64>(1, (quint64)qCeil(p / 100.0 * count), count);
+
+    quint64 accumulated = 0;
+    for (int i = 0; i < buckets.size(); i++)
+    {
+        accumulated += buckets[i];
+        if (accumulated >= rank)
+        {
+            return LatencyHistogram::getBucketValue(i);
+        }
+    }
+
+    return LatencyHistogram::getBucketValue(buckets.size() - 1);
+}
+
+qint64 LatencySnapshot::meanNs() const
+{
+    return (count > 0) ? (qint64)(totalNs / count) : 0;
+}
+
+LatencySnapshot LatencySnapshot::operator-(const LatencySnapshot& other) const
+{
+    LatencySnapshot result = *this;
+    if (other.buckets.size() != buckets.size())
+    {
+        return result;
+    }
+
+    for (int i = 0; i < buckets.size(); i++)
+    {
+        // a reset between the snapshots makes the counts smaller
+        result.buckets[i] = (buckets[i] >= other.buckets[i]) ? buckets[i] - other.buckets[i] : buckets[i];
+    }
+    result.count = (count >= other.count) ? count - other.count : count;
+    result.totalNs = (totalNs >= other.totalNs) ? totalNs - other.totalNs : totalNs;
+
+    return result;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(qint64 ns)
+{
+    ns = qMax<qint64>(ns, 0);
+
+    m_buckets[getBucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_totalNs.fetch_add((quint64)ns, std::memory_order_relaxed);
+
+    qint64 maxNs = m_maxNs.load(std::memory_order_relaxed);
+    while (ns > maxNs && !m_maxNs.compare_exchange_weak(maxNs, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+LatencySnapshot LatencyHistogram::snapshot() const
+{
+    // the buckets are read one by one, a record during the snapshot may be counted partially
+    LatencySnapshot result;
+    result.buckets.resize(HISTOGRAM_BUCKET_COUNT);
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        result.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    result.count = m_count.load(std::memory_order_relaxed);
+    result.totalNs = m_totalNs.load(std::memory_order_relaxed);
+    result.maxNs = m_maxNs.load(std::memory_order_relaxed);
+
+    return result;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_totalNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::getBucketIndex(qint64 ns)
+{
+    const quint64 us = (quint64)qMax<qint64>(ns, 0) / 1000;
+
+    // 1 us for each bucket below SUB_BUCKET_COUNT us
+    if (us < SUB_BUCKET_COUNT)
+    {
+        return (int)us;
+    }
+
+    // SUB_BUCKET_COUNT buckets between 2^power and 2^(power + 1)
+    const int power = 63 - (int)qCountLeadingZeroBits(us);
+    const int shift = power - HISTOGRAM_SUB_BUCKET_BITS;
+    const int index = ((shift + 1) << HISTOGRAM_SUB_BUCKET_BITS) + (int)((us >> shift) & (SUB_BUCKET_COUNT - 1));
+
+    return qMin(index, HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+qint64 LatencyHistogram::getBucketValue(int index)
+{
+    index = qBound(0, index, HISTOGRAM_BUCKET_COUNT - 1);
+
+    if (index < SUB_BUCKET_COUNT)
+    {
+        return index * 1000 + 500;
+    }
+
+    const int shift = (index >> HISTOGRAM_SUB_BUCKET_BITS) - 1;
+    const quint64 lower = (quint64)(SUB_BUCKET_COUNT + (index & (SUB_BUCKET_COUNT - 1))) << shift;
+    const quint64 width = (quint64)1 << shift;
+
+    return (qint64)((lower * 1000) + (width * 1000) / 2);
+}
+
+PipelineStatsSnapshot PipelineStatsSnapshot::operator-(const PipelineStatsSnapshot& other) const
+{
+    PipelineStatsSnapshot result = *this;
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        result.stages[i] = stages[i] - other.stages[i];
+    }
+    for (int i = 0; i < DROP_COUNT; i++)
+    {
+        result.drops[i] = (drops[i] >= other.drops[i]) ? drops[i] - other.drops[i] : drops[i];
+    }
+
+    return result;
+}
+
+PipelineStats* PipelineStats::getInstance()
+{
+    static PipelineStats stats;
+    return &stats;
+}
+
+PipelineStats::PipelineStats()
+{
+    for (auto& drop : m_drops)
+    {
+        drop.store(0, std::memory_order_relaxed);
+    }
+}
+
+qint64 PipelineStats::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+QString PipelineStats::getStageName(int stage)
+{
+    static const char* names[STAGE_COUNT] =
+    {
+        "queue",
+        "process",
+        "depth",
+        "rgb",
+        "pointCloud",
+        "depthPreprocess",
+        "rgbPreprocess",
+        "save",
+        "render"
+    };
+
+    return (stage >= 0 && stage < STAGE_COUNT) ? QString(names[stage]) : QString();
+}
+
+QString PipelineStats::getDropName(int drop)
+{
+    static const char* names[DROP_COUNT] =
+    {
+        "processQueue",
+        "processSkipped",
+        "capture"
+    };
+
+    return (drop >= 0 && drop < DROP_COUNT) ? QString(names[drop]) : QString();
+}
+
+void PipelineStats::record(PIPELINE_STAGE stage, qint64 ns)
+{
+    Q_ASSERT(stage >= 0 && stage < STAGE_COUNT);
+    m_stages[stage].record(ns);
+}
+
+void PipelineStats::recordSince(PIPELINE_STAGE stage, qint64 time)
+{
+    if (time > 0)
+    {
+        record(stage, now() - time);
+    }
+}
+
+void PipelineStats::addDrop(PIPELINE_DROP drop, quint64 count)
+{
+    Q_ASSERT(drop >= 0 && drop < DROP_COUNT);
+    m_drops[drop].fetch_add(count, std::memory_order_relaxed);
+}
+
+PipelineStatsSnapshot PipelineStats::snapshot() const
+{
+    PipelineStatsSnapshot result;
+    result.time = now();
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        result.stages[i] = m_stages[i].snapshot();
+    }
+    for (int i = 0; i < DROP_COUNT; i++)
+    {
+        result.drops[i] = m_drops[i].load(std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+void PipelineStats::reset()
+{
+    for (auto& stage : m_stages)
+    {
+        stage.reset();
+    }
+    for (auto& drop : m_drops)
+    {
+        drop.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,653 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "plyreader.h"
+
+#include <QDebug>
+#include <QList>
+#include <QVector>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <vector>
+
+using namespace cs;
+
+// ascii bodies smaller than it are parsed by one thread
+#define PLY_MIN_PARALLEL_SIZE (1024 * 1024)
+// ascii body is split into chunks parsed in parallel
+#define PLY_ASCII_CHUNKS 64
+
+namespace
+{
+enum PLY_PROPERTY_TYPE
+{
+    PLY_INT8,
+    PLY_UINT8,
+    PLY_INT16,
+    PLY_UINT16,
+    PLY_INT32,
+    PLY_UINT32,
+    PLY_FLOAT32,
+    PLY_FLOAT64,
+    PLY_UNKNOWN
+};
+
+// the array a vertex property is read into
+enum PLY_PROPERTY_TARGET
+{
+    TARGET_NONE,
+    TARGET_VERTEX,
+    TARGET_NORMAL,
+    TARGET_COLOR
+};
+
+struct PlyProperty
+{
+    int type = PLY_UNKNOWN;
+    // offset in the binary row
+    int offset = 0;
+    int target = TARGET_NONE;
+    // component of the target, 0 ~ 2
+    int component = 0;
+};
+
+struct PlyElement
+{
+    QByteArray name;
+    qint64 count = 0;
+    // size of the binary row, or -1 if the element has a list property
+    int stride = 0;
+    QVector<PlyProperty> properties;
+};
+
+struct PlyHeader
+{
+    bool binary = false;
+    QList<PlyElement> elements;
+    // offset of the body
+    int bodyOffset = 0;
+};
+}
+
+static const double POW10_TABLE[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int getPropertyType(const QByteArray& name)
+{
+    if (name == "char" || name == "int8")
+    {
+        return PLY_INT8;
+    }
+    if (name == "uchar" || name == "uint8")
+    {
+        return PLY_UINT8;
+    }
+    if (name == "short" || name == "int16")
+    {
+        return PLY_INT16;
+    }
+    if (name == "ushort" || name == "uint16")
+    {
+        return PLY_UINT16;
+    }
+    if (name == "int" || name == "int32")
+    {
+        return PLY_INT32;
+    }
+    if (name == "uint" || name == "uint32")
+    {
+        return PLY_UINT32;
+    }
+    if (name == "float" || name == "float32")
+    {
+        return PLY_FLOAT32;
+    }
+    if (name == "double" || name == "float64")
+    {
+        return PLY_FLOAT64;
+    }
+
+    return PLY_UNKNOWN;
+}
+
+static int getPropertySize(int type)
+{
+    static const int sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+    return (type >= 0 && type < PLY_UNKNOWN) ? sizes[type] : 0;
+}
+
+static void setPropertyTarget(PlyProperty& property, const QByteArray& name)
+{
+    static const char* names[3][3] =
+    {
+        { "x", "y", "z" },
+        { "nx", "ny", "nz" },
+        { "red", "green", "blue" }
+    };
+
+    for (int target = 0; target < 3; target++)
+    {
+        for (int component = 0; component < 3; component++)
+        {
+            if (name == names[target][component])
+            {
+                property.target = TARGET_VERTEX + target;
+                property.component = component;
+                return;
+            }
+        }
+    }
+
+    if (name == "r" || name == "g" || name == "b")
+    {
+        property.target = TARGET_COLOR;
+        property.component = (name == "r") ? 0 : ((name == "g") ? 1 : 2);
+    }
+}
+
+static bool parseHeader(const QByteArray& data, PlyHeader& header)
+{
+    int lineStart = 0;
+    int lineIndex = 0;
+    while (lineStart < data.size())
+    {
+        int lineEnd = data.indexOf('\n', lineStart);
+        if (lineEnd < 0)
+        {
+            qWarning() << "the ply header is not ended";
+            return false;
+        }
+
+        QList<QByteArray> words = data.mid(lineStart, lineEnd - lineStart).simplified().split(' ');
+        lineStart = lineEnd + 1;
+
+        if (lineIndex++ == 0)
+        {
+            if (words.first() != "ply")
+            {
+                qWarning() << "not a ply file";
+                return false;
+            }
+            continue;
+        }
+
+        const QByteArray& keyword = words.first();
+        if (keyword == "format")
+        {
+            if (words.size() < 2 || (words[1] != "ascii" && words[1] != "binary_little_endian"))
+            {
+                qWarning() << "unsupported ply format : " << (words.size() < 2 ? QByteArray() : words[1]);
+                return false;
+            }
+            header.binary = (words[1] == "binary_little_endian");
+        }
+        else if (keyword == "element")
+        {
+            if (words.size() < 3)
+            {
+                qWarning() << "illegal ply element";
+                return false;
+            }
+
+            PlyElement element;
+            element.name = words[1];
+            element.count = words[2].toLongLong();
+            header.elements.push_back(element);
+        }
+        else if (keyword == "property")
+        {
+            if (header.elements.isEmpty() || words.size() < 3)
+            {
+                qWarning() << "illegal ply property";
+                return false;
+            }
+
+            PlyElement& element = header.elements.last();
+            if (words[1] == "list")
+            {
+                // the rows of the element have variable sizes
+                element.stride = -1;
+                continue;
+            }
+
+            PlyProperty property;
+            property.type = getPropertyType(words[1]);
+            if (property.type == PLY_UNKNOWN)
+            {
+                qWarning() << "unsupported ply property type : " << words[1];
+                return false;
+            }
+
+            property.offset = element.stride;
+            setPropertyTarget(property, words[2]);
+            element.properties.push_back(property);
+
+            if (element.stride >= 0)
+            {
+                element.stride += getPropertySize(property.type);
+            }
+        }
+        else if (keyword == "end_header")
+        {
+            header.bodyOffset = lineStart;
+            return true;
+        }
+    }
+
+    qWarning() << "the ply header is not ended";
+    return false;
+}
+
+static inline double readBinaryValue(const char* p, int type)
+{
+    switch (type)
+    {
+    case PLY_INT8:
+        return *(const qint8*)p;
+    case PLY_UINT8:
+        return *(const quint8*)p;
+    case PLY_INT16:
+    {
+        qint16 v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case PLY_UINT16:
+    {
+        quint16 v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case PLY_INT32:
+    {
+        qint32 v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case PLY_UINT32:
+    {
+        quint32 v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case PLY_FLOAT32:
+    {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case PLY_FLOAT64:
+    {
+        double v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    default:
+        return 0;
+    }
+}
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// parse a decimal number, the digits beyond the precision of double are dropped
+static inline bool parseNumber(const char*& p, const char* end, double& value)
+{
+    while (p < end && isSpace(*p))
+    {
+        p++;
+    }
+
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+
+    quint64 mantissa = 0;
+    int digitCount = 0;
+    int exponent = 0;
+    bool hasDigit = false;
+
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        if (digitCount < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digitCount += (mantissa != 0) ? 1 : 0;
+        }
+        else
+        {
+            exponent++;
+        }
+        hasDigit = true;
+        p++;
+    }
+
+    if (p < end && *p == '.')
+    {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            if (digitCount < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digitCount += (mantissa != 0) ? 1 : 0;
+                exponent--;
+            }
+            hasDigit = true;
+            p++;
+        }
+    }
+
+    if (!hasDigit)
+    {
+        // nan, inf and so on
+        char* numberEnd = nullptr;
+        value = strtod(start, &numberEnd);
+        if (numberEnd == start || numberEnd > end)
+        {
+            return false;
+        }
+
+        p = numberEnd;
+        return true;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negativeExp = (*p == '-');
+            p++;
+        }
+
+        int e = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            e = (e < 10000) ? (e * 10 + (*p - '0')) : e;
+            p++;
+        }
+        exponent += negativeExp ? -e : e;
+    }
+
+    value = (double)mantissa;
+    if (exponent < 0)
+    {
+        value = (exponent >= -22) ? value / POW10_TABLE[-exponent] : value * pow(10.0, exponent);
+    }
+    else if (exponent > 0)
+    {
+        value = (exponent <= 22) ? value * POW10_TABLE[exponent] : value * pow(10.0, exponent);
+    }
+
+    value = negative ? -value : value;
+    return true;
+}
+
+static inline void setValue(const PlyProperty& property, double value, qint64 index, float* vertices, float* normals, uchar* colors)
+{
+    switch (property.target)
+    {
+    case TARGET_VERTEX:
+        vertices[index * 3 + property.component] = (float)value;
+        break;
+    case TARGET_NORMAL:
+        normals[index * 3 + property.component] = (float)value;
+        break;
+    case TARGET_COLOR:
+    {
+        // float colors are in [0, 1]
+        if (property.type == PLY_FLOAT32 || property.type == PLY_FLOAT64)
+        {
+            value *= 255;
+        }
+        value = (value < 0) ? 0 : ((value > 255) ? 255 : value);
+        colors[index * 3 + property.component] = (uchar)(value + 0.5);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// parse the vertex rows in [begin, end) of the ascii body, the first row is vertex firstIndex
+static bool parseAsciiRows(const char* begin, const char* end, qint64 firstIndex, qint64 vertexCount, const QVector<PlyProperty>& properties,
+    float* vertices, float* normals, uchar* colors)
+{
+    const char* p = begin;
+    qint64 index = firstIndex;
+    while (p < end && index < vertexCount)
+    {
+        for (const auto& property : properties)
+        {
+            double value;
+            if (!parseNumber(p, end, value))
+            {
+                qWarning() << "parse ply vertex failed, vertex : " << index;
+                return false;
+            }
+            setValue(property, value, index, vertices, normals, colors);
+        }
+
+        // skip the rest of the row
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        p = lineEnd ? lineEnd + 1 : end;
+        index++;
+    }
+
+    return true;
+}
+
+static bool readAsciiBody(const char* body, const char* end, const PlyHeader& header, int vertexElement,
+    float* vertices, float* normals, uchar* colors)
+{
+    // skip the rows of the elements before vertex
+    const char* p = body;
+    for (int i = 0; i < vertexElement; i++)
+    {
+        for (qint64 row = 0; row < header.elements[i].count && p < end; row++)
+        {
+            const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+            p = lineEnd ? lineEnd + 1 : end;
+        }
+    }
+
+    const PlyElement& element = header.elements[vertexElement];
+
+    // split the body into chunks at the line ends, and count the rows of each chunk to know its first vertex
+    const int chunkCount = (end - p < PLY_MIN_PARALLEL_SIZE) ? 1 : PLY_ASCII_CHUNKS;
+    std::vector<const char*> chunkBegins(chunkCount + 1, end);
+    chunkBegins[0] = p;
+    for (int i = 1; i < chunkCount; i++)
+    {
+        const char* pos = qMax(chunkBegins[i - 1], p + (end - p) * i / chunkCount);
+        const char* lineEnd = (pos < end) ? (const char*)memchr(pos, '\n', end - pos) : nullptr;
+        chunkBegins[i] = lineEnd ? lineEnd + 1 : end;
+    }
+
+    std::vector<qint64> chunkRows(chunkCount + 1, 0);
+#pragma omp parallel for
+    for (int i = 0; i < chunkCount; i++)
+    {
+        qint64 rows = 0;
+        const char* q = chunkBegins[i];
+        while (q < chunkBegins[i + 1])
+        {
+            const char* lineEnd = (const char*)memchr(q, '\n', chunkBegins[i + 1] - q);
+            q = lineEnd ? lineEnd + 1 : chunkBegins[i + 1];
+            rows++;
+        }
+        chunkRows[i + 1] = rows;
+    }
+
+    for (int i = 0; i < chunkCount; i++)
+    {
+        chunkRows[i + 1] += chunkRows[i];
+    }
+
+    if (chunkRows[chunkCount] < element.count)
+    {
+        qWarning() << "the ply vertices are incomplete";
+        return false;
+    }
+
+    bool result = true;
+#pragma omp parallel for
+    for (int i = 0; i < chunkCount; i++)
+    {
+        if (chunkRows[i] < element.count
+            && !parseAsciiRows(chunkBegins[i], chunkBegins[i + 1], chunkRows[i], element.count, element.properties, vertices, normals, colors))
+        {
+#pragma omp critical
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+static bool readBinaryBody(const char* body, const char* end, const PlyHeader& header, int vertexElement,
+    float* vertices, float* normals, uchar* colors)
+{
+    // skip the rows of the elements before vertex
+    const char* p = body;
+    for (int i = 0; i < vertexElement; i++)
+    {
+        const PlyElement& element = header.elements[i];
+        if (element.stride < 0)
+        {
+            qWarning() << "unsupported ply element with list property before vertex : " << element.name;
+            return false;
+        }
+        p += element.count * element.stride;
+    }
+
+    const PlyElement& element = header.elements[vertexElement];
+    if (p > end || (end - p) / element.stride < element.count)
+    {
+        qWarning() << "the ply vertices are incomplete";
+        return false;
+    }
+
+    const int vertexCount = (int)element.count;
+    const int stride = element.stride;
+#pragma omp parallel for
+    for (int i = 0; i < vertexCount; i++)
+    {
+        const char* row = p + (qint64)i * stride;
+        for (const auto& property : element.properties)
+        {
+            setValue(property, readBinaryValue(row + property.offset, property.type), i, vertices, normals, colors);
+        }
+    }
+
+    return true;
+}
+
+bool PlyReader::readPointCloud(const QByteArray& data, Pointcloud& pointCloud, QByteArray& colors)
+{
+    PlyHeader header;
+    if (!parseHeader(data, header))
+    {
+        return false;
+    }
+
+    int vertexElement = -1;
+    for (int i = 0; i < header.elements.size(); i++)
+    {
+        if (header.elements[i].name == "vertex")
+        {
+            vertexElement = i;
+            break;
+        }
+    }
+
+    if (vertexElement < 0)
+    {
+        qWarning() << "no vertex element in ply";
+        return false;
+    }
+
+    const PlyElement& element = header.elements[vertexElement];
+    if (element.stride <= 0 || element.count < 0 || element.count > INT_MAX / 3)
+    {
+        qWarning() << "unsupported ply vertex element, count : " << element.count;
+        return false;
+    }
+
+    bool hasVertex = false, hasNormal = false, hasColor = false;
+    for (const auto& property : element.properties)
+    {
+        hasVertex |= (property.target == TARGET_VERTEX);
+        hasNormal |= (property.target == TARGET_NORMAL);
+        hasColor |= (property.target == TARGET_COLOR);
+    }
+
+    if (!hasVertex)
+    {
+        qWarning() << "no vertex coordinate in ply";
+        return false;
+    }
+
+    // size the arrays once, the body is parsed into them directly
+    const int vertexCount = (int)element.count;
+    std::vector<float3>& points = pointCloud.getVertices();
+    std::vector<float3>& normals = pointCloud.getNormals();
+    pointCloud.getTexcoords().clear();
+
+    points.assign(vertexCount, float3(0, 0, 0));
+    normals.assign(hasNormal ? vertexCount : 0, float3(0, 0, 0));
+    colors.clear();
+    if (hasColor)
+    {
+        colors.fill(0, vertexCount * 3);
+    }
+
+    float* vertexPtr = (float*)points.data();
+    float* normalPtr = hasNormal ? (float*)normals.data() : nullptr;
+    uchar* colorPtr = hasColor ? (uchar*)colors.data() : nullptr;
+
+    const char* body = data.constData() + header.bodyOffset;
+    const char* end = data.constData() + data.size();
+
+    const bool result = header.binary ? readBinaryBody(body, end, header, vertexElement, vertexPtr, normalPtr, colorPtr)
+        : readAsciiBody(body, end, header, vertexElement, vertexPtr, normalPtr, colorPtr);
+
+    if (!result)
+    {
+        points.clear();
+        normals.clear();
+        colors.clear();
+    }
+
+    return result;
+}
@@ -0,0 +1,296 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "plywriter.h"
+
+#include <QFile>
+#include <QDebug>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+using namespace cs;
+
+// points formatted by a chunk
+#define PLY_CHUNK_POINTS 16384
+// chunks formatted in parallel before they are written
+#define PLY_ROUND_CHUNKS 16
+// max length of an ascii row: 6 floats and 3 colors
+#define PLY_MAX_ASCII_ROW 128
+
+static const double POW10_TABLE[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+// the same text as std::ostream << value with the default precision, i.e. "%g"
+static inline int formatFloat(char* buffer, float value)
+{
+    double v = value;
+    if (v == 0)
+    {
+        return signbit(v) ? sprintf(buffer, "-0") : sprintf(buffer, "0");
+    }
+
+    // v * 10^9 is exact in double, so the exponent and the rounding below are exact too
+    const double scaled = fabs(v) * POW10_TABLE[9];
+    if (!(scaled >= POW10_TABLE[5] && scaled < POW10_TABLE[15]))
+    {
+        // out of the fixed notation range, inf or nan
+        return sprintf(buffer, "%g", v);
+    }
+
+    int exponent = 5;
+    while (scaled < POW10_TABLE[exponent + 9])
+    {
+        exponent--;
+    }
+
+    // 6 significant digits, rounded half to even as printf does
+    long long digits = (long long)rint(fabs(v) * POW10_TABLE[5 - exponent]);
+    if (digits >= 1000000)
+    {
+        digits /= 10;
+        exponent++;
+        if (exponent > 5)
+        {
+            return sprintf(buffer, "%g", v);
+        }
+    }
+
+    char digitText[6];
+    for (int i = 5; i >= 0; i--)
+    {
+        digitText[i] = (char)('0' + digits % 10);
+        digits /= 10;
+    }
+
+    int digitCount = 6;
+    while (digitCount > 1 && digitText[digitCount - 1] == '0' && digitCount > exponent + 1)
+    {
+        digitCount--;
+    }
+
+    char* p = buffer;
+    if (v < 0)
+    {
+        *p++ = '-';
+    }
+
+    if (exponent >= 0)
+    {
+        for (int i = 0; i < digitCount; i++)
+        {
+            if (i == exponent + 1)
+            {
+                *p++ = '.';
+            }
+            *p++ = digitText[i];
+        }
+    }
+    else
+    {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = 0; i < -exponent - 1; i++)
+        {
+            *p++ = '0';
+        }
+
+        for (int i = 0; i < digitCount; i++)
+        {
+            *p++ = digitText[i];
+        }
+    }
+
+    return (int)(p - buffer);
+}
+
+static inline int formatColor(char* buffer, uchar value)
+{
+    char* p = buffer;
+    if (value >= 100)
+    {
+        *p++ = (char)('0' + value / 100);
+    }
+
+    if (value >= 10)
+    {
+        *p++ = (char)('0' + value / 10 % 10);
+    }
+
+    *p++ = (char)('0' + value % 10);
+    return (int)(p - buffer);
+}
+
+static inline const uchar* getTexColor(const QImage& texImage, const float2& texcoord)
+{
+    const int width = texImage.width();
+    const int height = texImage.height();
+
+    int x = int(texcoord.u * width);
+    x = (x >= width) ? width - 1 : x;
+    x = (x < 0) ? 0 : x;
+
+    int y = int(texcoord.v * height);
+    y = (y >= height) ? height - 1 : y;
+    y = (y < 0) ? 0 : y;
+
+    return texImage.constScanLine(y) + x * 3;
+}
+
+static QByteArray generateHeader(int pointCount, bool withTexture, bool binary)
+{
+    QByteArray header;
+    header += "ply\n";
+    header += binary ? "format binary_little_endian 1.0\n" : "format ascii 1.0\n";
+    header += "comment pointcloud saved from 3DCamera\n";
+    header += QByteArray("element vertex ") + QByteArray::number(pointCount) + "\n";
+    header += "property float x\n";
+    header += "property float y\n";
+    header += "property float z\n";
+    header += "property float nx\n";
+    header += "property float ny\n";
+    header += "property float nz\n";
+    if (withTexture)
+    {
+        header += "property uchar red\n";
+        header += "property uchar green\n";
+        header += "property uchar blue\n";
+    }
+    header += "end_header\n";
+
+    return header;
+}
+
+bool PlyWriter::savePointCloud(QString filePath, Pointcloud& pointCloud, const QImage& texImage, bool binary)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "open file failed, file path : " << filePath;
+        return false;
+    }
+
+    const bool result = savePointCloud(file, pointCloud, texImage, binary);
+    file.close();
+
+    return result;
+}
+
+bool PlyWriter::savePointCloud(QIODevice& device, Pointcloud& pointCloud, const QImage& texImage, bool binary)
+{
+    const bool withTexture = !texImage.isNull();
+    const QImage tex = (!withTexture || texImage.format() == QImage::Format_RGB888) ? texImage : texImage.convertToFormat(QImage::Format_RGB888);
+
+    const std::vector<float3>& vertices = pointCloud.getVertices();
+    const std::vector<float3>& normals = pointCloud.getNormals();
+    const std::vector<float2>& texcoords = pointCloud.getTexcoords();
+    const int pointCount = pointCloud.size();
+
+    if (withTexture && (int)texcoords.size() < pointCount)
+    {
+        qWarning() << "the texture coordinates do not match the points";
+        return false;
+    }
+
+    if (device.write(generateHeader(pointCount, withTexture, binary)) < 0)
+    {
+        qWarning() << "write point cloud failed, error : " << device.errorString();
+        return false;
+    }
+
+    const int rowSize = binary ? (6 * sizeof(float) + (withTexture ? 3 : 0)) : PLY_MAX_ASCII_ROW;
+    const int chunkCount = (pointCount + PLY_CHUNK_POINTS - 1) / PLY_CHUNK_POINTS;
+
+    std::vector<std::vector<char>> buffers(qMin(chunkCount, PLY_ROUND_CHUNKS));
+    std::vector<int> bufferSizes(buffers.size());
+    for (auto& buffer : buffers)
+    {
+        buffer.resize((size_t)PLY_CHUNK_POINTS * rowSize);
+    }
+
+    for (int firstChunk = 0; firstChunk < chunkCount; firstChunk += PLY_ROUND_CHUNKS)
+    {
+        const int roundChunks = qMin(PLY_ROUND_CHUNKS, chunkCount - firstChunk);
+
+#pragma omp parallel for
+        for (int chunk = 0; chunk < roundChunks; chunk++)
+        {
+            const int begin = (firstChunk + chunk) * PLY_CHUNK_POINTS;
+            const int end = qMin(begin + PLY_CHUNK_POINTS, pointCount);
+            char* p = buffers[chunk].data();
+
+            for (int i = begin; i < end; i++)
+            {
+                const float3& vertex = vertices[i];
+                const float3& normal = normals[i];
+                const uchar* color = withTexture ? getTexColor(tex, texcoords[i]) : nullptr;
+
+                if (binary)
+                {
+                    // we assume little endian architecture on your device
+                    const float values[6] = { vertex.x, vertex.y, vertex.z, normal.x, normal.y, normal.z };
+                    memcpy(p, values, sizeof(values));
+                    p += sizeof(values);
+
+                    if (color)
+                    {
+                        memcpy(p, color, 3);
+                        p += 3;
+                    }
+                }
+                else
+                {
+                    const float values[6] = { vertex.x, vertex.y, vertex.z, normal.x, normal.y, normal.z };
+                    for (int j = 0; j < 6; j++)
+                    {
+                        p += formatFloat(p, values[j]);
+                        *p++ = ' ';
+                    }
+
+                    if (color)
+                    {
+                        for (int j = 0; j < 3; j++)
+                        {
+                            p += formatColor(p, color[j]);
+                            *p++ = ' ';
+                        }
+                    }
+                    *p++ = '\n';
+                }
+            }
+
+            bufferSizes[chunk] = (int)(p - buffers[chunk].data());
+        }
+
+        for (int chunk = 0; chunk < roundChunks; chunk++)
+        {
+            if (device.write(buffers[chunk].data(), bufferSizes[chunk]) != bufferSizes[chunk])
+            {
+                qWarning() << "write point cloud failed, error : " << device.errorString();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,122 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "process/depthcolorizer.h"
+
+#include <string.h>
+#include <cstracer.h>
+
+using namespace cs;
+
+#define DEPTH_CODE_COUNT 65536
+
+DepthColorizer::DepthColorizer()
+    : m_zmin(0)
+    , m_zmax(0)
+    , m_scale(0.0f)
+    , m_tableValid(false)
+{
+
+}
+
+void DepthColorizer::setRange(int zmin, int zmax)
+{
+    if (zmin != m_zmin || zmax != m_zmax)
+    {
+        m_zmin = zmin;
+        m_zmax = zmax;
+        m_tableValid = false;
+    }
+}
+
+void DepthColorizer::process(const ushort* depthData, float scale, uchar* rgbData, int width, int height)
+{
+    CS_TRACE_SCOPE("DepthColorizer::process");
+    updateTable(scale);
+
+    const uchar* tablePtr = m_table.data();
+#pragma omp parallel for
+    for (int y = 0; y < height; y++)
+    {
+        const ushort* rowPtr = depthData + (size_t)y * width;
+        uchar* rgbPtr = rgbData + (size_t)y * width * 3;
+        for (int x = 0; x < width; x++)
+        {
+            const uchar* color = tablePtr + rowPtr[x] * 3;
+            rgbPtr[x * 3 + 0] = color[0];
+            rgbPtr[x * 3 + 1] = color[1];
+            rgbPtr[x * 3 + 2] = color[2];
+        }
+    }
+}
+
+void DepthColorizer::process(const float* depthData, float scale, uchar* rgbData, int width, int height)
+{
+    CS_TRACE_SCOPE("DepthColorizer::process");
+    updateTable(scale);
+
+    const uchar* tablePtr = m_table.data();
+#pragma omp parallel for
+    for (int y = 0; y < height; y++)
+    {
+        const float* rowPtr = depthData + (size_t)y * width;
+        uchar* rgbPtr = rgbData + (size_t)y * width * 3;
+        for (int x = 0; x < width; x++)
+        {
+            float depth = rowPtr[x];
+            const int code = (int)depth;
+
+            // the filters may leave depth between the codes
+            if (code >= 0 && code < DEPTH_CODE_COUNT && code == depth)
+            {
+                const uchar* color = tablePtr + code * 3;
+                rgbPtr[x * 3 + 0] = color[0];
+                rgbPtr[x * 3 + 1] = color[1];
+                rgbPtr[x * 3 + 2] = color[2];
+            }
+            else
+            {
+                m_colorizer.process<float>(&depth, scale, rgbPtr + x * 3, 1);
+            }
+        }
+    }
+}
+
+void DepthColorizer::updateTable(float scale)
+{
+    if (m_tableValid && scale == m_scale)
+    {
+        return;
+    }
+
+    m_scale = scale;
+    m_tableValid = true;
+
+    // colorize every depth code once, so the table gives the same colors as cs::colorizer
+    std::vector<float> codes(DEPTH_CODE_COUNT);
+    for (int i = 0; i < DEPTH_CODE_COUNT; i++)
+    {
+        codes[i] = (float)i;
+    }
+
+    m_table.resize(DEPTH_CODE_COUNT * 3);
+    m_colorizer.setRange(m_zmin, m_zmax);
+    m_colorizer.process<float>(codes.data(), m_scale, m_table.data(), DEPTH_CODE_COUNT);
+}
@@ -0,0 +1,166 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "process/depthpreprocessstrategy.h"
+
+#include <QVariant>
+#include <QDebug>
+#include <cstracer.h>
+
+#include "icscamera.h"
+#include "cameraparaid.h"
+
+using namespace cs;
+
+DepthPreprocessStrategy::DepthPreprocessStrategy()
+    : ProcessStrategy(STRATEGY_DEPTH_PREPROCESS)
+    , m_fillHole(false)
+    , m_filterValue(0)
+    , m_filterType(0)
+{
+    m_dependentParameters.push_back(PARA_DEPTH_FILL_HOLE);
+    m_dependentParameters.push_back(PARA_DEPTH_FILTER_TYPE);
+    m_dependentParameters.push_back(PARA_DEPTH_FILTER);
+    m_dependentParameters.push_back(PARA_TRIGGER_MODE);
+}
+
+void DepthPreprocessStrategy::doProcess(const FrameData& frameData, OutputDataPort& outputDataPort)
+{
+    // If in single-trigger mode and time-domain filtering is enabled, 
+    // the cached data of the time-domain filter needs to be cleared.
+    if (m_trigger != TRIGGER_MODE_OFF && m_filterType == FILTER_TDSMOOTH)
+    {
+        m_timeDomainSmooth.reset();
+    }
+
+    for (const auto& data : frameData.data)
+    {
+        switch (data.dataInfo.format)
+        {
+        case STREAM_FORMAT_Z16:
+        case STREAM_FORMAT_Z16Y8Y8:
+        case STREAM_FORMAT_XZ32:
+        {
+            const int width = data.dataInfo.width;
+            const int height = data.dataInfo.height;
+            Q_ASSERT(data.data.size() >= width * height * sizeof(ushort));
+
+            // an empty depth data marks the frame as skipped by the filter
+            QByteArray output;
+            if (!onProcessDepthData((const ushort*)data.data.data(), width * height, width, height, output))
+            {
+                output.clear();
+            }
+
+            outputDataPort.setDepthData(output);
+            return;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+bool DepthPreprocessStrategy::onProcessDepthData(const ushort* dataPtr, int length, int width, int height, QByteArray& output)
+{
+    //tran to float
+    output.resize(length * sizeof(float));
+    float* floatPtr = (float*)output.data();
+    {
+        CS_TRACE_SCOPE("DepthPreprocessStrategy::toFloat");
+        copyData<const ushort, float>(dataPtr, floatPtr, length);
+    }
+
+    //fill hole
+    if (m_fillHole)
+    {
+        CS_TRACE_SCOPE("DepthFillHole::process");
+        m_depthFillHole.process(floatPtr, width, height);
+    }
+
+    // filter
+    FILTER_TYPE type = (FILTER_TYPE)m_filterType;
+    switch (type)
+    {
+    case FILTER_SMOOTH:
+        m_spatialFilter.averageBlur(floatPtr, width, height, m_filterValue);
+        break;
+    case FILTER_MEDIAN:
+        m_spatialFilter.medianBlur(floatPtr, width, height, m_filterValue);
+        break;
+    case FILTER_TDSMOOTH:
+        if (!m_timeDomainSmooth.process(floatPtr, width, height, m_filterValue))
+        {
+            return false;
+        }
+
+        // clear data in trigger mode
+        if (m_trigger == TRIGGER_MODE_SOFTWAER)
+        {
+            m_timeDomainSmooth.reset();
+        }
+        break;
+    default:
+        break;
+    }
+ 
+    return true;
+}
+
+void DepthPreprocessStrategy::onLoadCameraPara()
+{
+    for (auto para : m_dependentParameters)
+    {
+        auto emPara = (CAMERA_PARA_ID)para;
+
+        QVariant value;
+        m_cameraPtr->getCameraPara(emPara, value);
+        switch (para)
+        {
+        case PARA_DEPTH_FILL_HOLE:
+            m_fillHole = value.toBool();
+            break;
+        case PARA_DEPTH_FILTER:
+            m_filterValue = value.toInt();
+            break;
+        case PARA_DEPTH_FILTER_TYPE:
+            m_filterType = value.toInt();
+            if (m_filterType != FILTER_TDSMOOTH)
+            {
+                qInfo() << "Clear filter cached data";
+                m_timeDomainSmooth.reset();
+            }
+            break;
+        case PARA_TRIGGER_MODE:
+        {
+            auto isTrigger = (TRIGGER_MODE)value.toInt();
+
+            if (m_filterType == FILTER_TDSMOOTH && m_trigger != isTrigger)
+            {
+                qInfo() << "Clear filter cached data";
+                m_timeDomainSmooth.reset();
+            }
+            m_trigger = isTrigger;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
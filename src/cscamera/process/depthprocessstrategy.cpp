@@ -27,7 +27,6 @@
 
 #include "icscamera.h"
 #include "cameraparaid.h"
-#include "process/fillhole.h"
 
 using namespace cs;
 
@@ -41,28 +40,24 @@ DepthProcessStrategy::DepthProcessStrategy(PROCESS_STRA_TYPE type)
     : ProcessStrategy(type)
     , m_calcDepthCoord(false)
     , m_depthCoordCalcPos(QPointF(-1.0f, -1.0f))
-    , m_fillHole(false)
-    , m_filterValue(0)
-    , m_filterType(0)
+    , m_outputDepth(true)
 {
     m_dependentParameters.push_back(PARA_DEPTH_RANGE);
     m_dependentParameters.push_back(PARA_DEPTH_SCALE);
     m_dependentParameters.push_back(PARA_DEPTH_INTRINSICS);
-    m_dependentParameters.push_back(PARA_DEPTH_FILL_HOLE);
-    m_dependentParameters.push_back(PARA_DEPTH_FILTER_TYPE);
-    m_dependentParameters.push_back(PARA_DEPTH_FILTER);
-    m_dependentParameters.push_back(PARA_TRIGGER_MODE);
+
+    m_dependentStrategys.push_back(STRATEGY_DEPTH_PREPROCESS);
 }
 
 void DepthProcessStrategy::doProcess(const FrameData& frameData, OutputDataPort& outputDataPort)
 {
     const auto& streamDatas = frameData.data;
-    
-    // If in single-trigger mode and time-domain filtering is enabled, 
-    // the cached data of the time-domain filter needs to be cleared.
-    if (m_trigger != TRIGGER_MODE_OFF && m_filterType == FILTER_TDSMOOTH)
+
+    // an empty depth data skips the depth image
+    QByteArray depthData;
+    if (m_outputDepth)
     {
-        m_filterCachedData.clear();
+        depthData = outputDataPort.getDepthData();
     }
 
     for (const auto& data : streamDatas)
@@ -73,10 +68,10 @@ void DepthProcessStrategy::doProcess(const FrameData& frameData, OutputDataPort&
         switch (format)
         {
         case STREAM_FORMAT_Z16:
-            outputData2Ds = onProcessZ16(data);
+            outputData2Ds = onProcessZ16(data, depthData);
             break;
         case STREAM_FORMAT_Z16Y8Y8:
-            outputData2Ds = onProcessZ16Y8Y8(data);
+            outputData2Ds = onProcessZ16Y8Y8(data, depthData);
             break;
         case STREAM_FORMAT_PAIR:
             outputData2Ds = onProcessPAIR(data);
@@ -92,29 +87,29 @@ void DepthProcessStrategy::doProcess(const FrameData& frameData, OutputDataPort&
     } 
 }
 
-OutputData2D DepthProcessStrategy::processDepthData(const ushort* dataPtr, int length, int width, int height)
+OutputData2D DepthProcessStrategy::processDepthData(const QByteArray& depthData, int width, int height)
 {
-    QByteArray output;
-
-    if (!onProcessDepthData(dataPtr, length, width, height, output))
+    // skipped by the depth preprocess, e.g. time domain smooth is not ready
+    if (depthData.size() != width * height * sizeof(float))
     {
         // return empty OutputData2D
         return OutputData2D();
     }
 
     QImage image;
-    generateDepthImage(output, width, height, image);
+    generateDepthImage(depthData, width, height, image);
 
     OutputData2D outputData;
     outputData.image = image;
     outputData.info.cameraDataType = CAMERA_DATA_DEPTH;
+    outputData.info.receivedTime = m_receivedTime;
 
     // calc point info
     if (m_calcDepthCoord)
     {
         int x = m_depthCoordCalcPos.x() * width;
         int y = m_depthCoordCalcPos.y() * height;
-        float* floatPtr = (float*)output.data();
+        const float* floatPtr = (const float*)depthData.data();
 
         if (!(x < 0 || y < 0 || x >= width || y >= height))
         {
@@ -141,101 +136,7 @@ void DepthProcessStrategy::generateDepthImage(const QByteArray& output, int widt
     m_colorizer.setRange(m_depthRange.first, m_depthRange.second);
     depthImage = QImage(width, height, QImage::Format_RGB888);
 
-    m_colorizer.process<float>((float*)output.data(), m_depthScale, depthImage.bits(), width * height);
-}
-
-bool DepthProcessStrategy::onProcessDepthData(const ushort* dataPtr, int length, int width, int height, QByteArray& output)
-{
-    //tran to float
-    output.resize(length * sizeof(float));
-    float* floatPtr = (float*)output.data();
-    copyData<const ushort, float>(dataPtr, floatPtr, length);
-
-    //fill hole
-    if (m_fillHole)
-    {
-        depthFillHole(floatPtr, width, height);
-    }
-
-    // filter
-    FILTER_TYPE type = (FILTER_TYPE)m_filterType;
-    switch (type)
-    {
-    case FILTER_SMOOTH:
-        filter::AverageBlur<float>(floatPtr, width, height, m_filterValue);
-        break;
-    case FILTER_MEDIAN:
-        filter::MedianBlur<float>(floatPtr, width, height, m_filterValue);
-        break;
-    case FILTER_TDSMOOTH:
-        if (!timeDomainSmooth(floatPtr, length, width, height))
-        {
-            return false;
-        }
-        break;
-    default:
-        break;
-    }
- 
-    return true;
-}
-
-bool DepthProcessStrategy::timeDomainSmooth(float* dataPtr, int length, int width, int height)
-{
-    while (m_filterCachedData.size() >= m_filterValue)
-    {
-        m_filterCachedData.pop_front();
-    }
-
-    //copy data
-    QByteArray curFrame;
-    curFrame.resize(length * sizeof(float));
-    memcpy(curFrame.data(), dataPtr, curFrame.size());
-
-    m_filterCachedData.push_back(curFrame);
-
-    if (m_filterCachedData.size() < m_filterValue)
-    {
-        return false;
-    }
-
-    // smooth
-    const int size = width * height;
-    QList<float*> list;
-    for (auto& data : m_filterCachedData)
-    {
-        if(data.size() == size * sizeof(float))
-        {
-            list.push_back((float*)data.data());
-        }
-    }
-
-    const int frameSize = list.size();
-#pragma omp parallel for
-    for (int i = 0; i < size; i++)
-    {
-        float sum = 0;
-        int count = 0;
-
-        for (int j = 0; j < frameSize; j++)
-        {
-            const auto& v = (list[j])[i];
-            if (v > 0)
-            {
-                sum += v;
-                count++;
-            }
-        }
-        dataPtr[i] = count > 0 ? (sum / count) : 0;
-    }
-    
-    // clear data in trigger mode
-    if (m_trigger == TRIGGER_MODE_SOFTWAER && m_filterCachedData.size() >= m_filterValue)
-    {
-        m_filterCachedData.clear();
-    }
-
-    return true;
+    m_colorizer.process((const float*)output.constData(), m_depthScale, depthImage.bits(), width, height);
 }
 
 OutputData2D DepthProcessStrategy::onProcessLData(const char* dataPtr, int length, int width, int height)
@@ -246,6 +147,7 @@ OutputData2D DepthProcessStrategy::onProcessLData(const char* dataPtr, int lengt
     OutputData2D outputData;
     outputData.image = imageL;
     outputData.info.cameraDataType = CAMERA_DATA_L;
+    outputData.info.receivedTime = m_receivedTime;
     emit output2DUpdated(outputData);
 
     return outputData;
@@ -259,18 +161,19 @@ OutputData2D DepthProcessStrategy::onProcessRData(const char* dataPtr, int lengt
     OutputData2D outputData;
     outputData.image = imageR;
     outputData.info.cameraDataType = CAMERA_DATA_R;
+    outputData.info.receivedTime = m_receivedTime;
     emit output2DUpdated(outputData);
     
     return outputData;
 }
 
-QVector<OutputData2D> DepthProcessStrategy::onProcessZ16(const StreamData& streamData)
+QVector<OutputData2D> DepthProcessStrategy::onProcessZ16(const StreamData& streamData, const QByteArray& depthData)
 {
     const int& width = streamData.dataInfo.width;
     const int& height = streamData.dataInfo.height;
     Q_ASSERT(streamData.data.size() == width * height * sizeof(ushort));
 
-    OutputData2D outputData = processDepthData((const ushort*)streamData.data.data(), width * height, width, height);
+    OutputData2D outputData = processDepthData(depthData, width, height);
     QVector<OutputData2D> outputDatas;
 
     // add to outputDatas if not empty
@@ -283,7 +186,7 @@ QVector<OutputData2D> DepthProcessStrategy::onProcessZ16(const StreamData& strea
     return outputDatas;
 }
 
-QVector<OutputData2D> DepthProcessStrategy::onProcessZ16Y8Y8(const StreamData& streamData)
+QVector<OutputData2D> DepthProcessStrategy::onProcessZ16Y8Y8(const StreamData& streamData, const QByteArray& depthData)
 {
     const int& width = streamData.dataInfo.width;
     const int& height = streamData.dataInfo.height;
@@ -294,7 +197,7 @@ QVector<OutputData2D> DepthProcessStrategy::onProcessZ16Y8Y8(const StreamData& s
 
     QVector<OutputData2D> outputDatas;
     //depth
-    OutputData2D outputData = processDepthData((const ushort*)streamData.data.data() + dataOffset, width * height, width, height);
+    OutputData2D outputData = processDepthData(depthData, width, height);
     
     // add to outputDatas if not empty
     if (!outputData.isEmpty())
@@ -364,32 +267,6 @@ void DepthProcessStrategy::onLoadCameraPara()
         case PARA_DEPTH_INTRINSICS:
             m_depthIntrinsics = value.value<Intrinsics>();
             break;
-        case PARA_DEPTH_FILL_HOLE:
-            m_fillHole = value.toBool();
-            break;
-        case PARA_DEPTH_FILTER:
-            m_filterValue = value.toInt();
-            break;
-        case PARA_DEPTH_FILTER_TYPE:
-            m_filterType = value.toInt();
-            if (m_filterType != FILTER_TDSMOOTH)
-            {
-                qInfo() << "Clear filter cached data";
-                m_filterCachedData.clear();
-            }
-            break;
-        case PARA_TRIGGER_MODE:
-        {
-            auto isTrigger = (TRIGGER_MODE)value.toInt();
-
-            if (m_filterType == FILTER_TDSMOOTH && m_trigger != isTrigger)
-            {
-                qInfo() << "Clear filter cached data";
-                m_filterCachedData.clear();
-            }
-            m_trigger = isTrigger;
-            break;
-        }
         default:
             break;
         }
@@ -421,4 +298,19 @@ QPointF DepthProcessStrategy::getDepthCoordCalcPos() const
 void  DepthProcessStrategy::setDepthCoordCalcPos(QPointF pos)
 {
     m_depthCoordCalcPos = pos;
+}
+
+bool DepthProcessStrategy::getOutputDepth() const
+{
+    return m_outputDepth;
+}
+
+void DepthProcessStrategy::setOutputDepth(bool output)
+{
+    m_outputDepth = output;
+}
+
+QVector<int> DepthProcessStrategy::getDependentStrategys() const
+{
+    return m_outputDepth ? ProcessStrategy::getDependentStrategys() : QVector<int>();
 }
\ No newline at end of file
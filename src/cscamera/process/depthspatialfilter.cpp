@@ -0,0 +1,413 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "process/depthspatialfilter.h"
+
+#include <string.h>
+#include <algorithm>
+#include <cstracer.h>
+
+using namespace cs;
+
+// rows of a block in the vertical pass of the average
+#define AVERAGE_BLOCK_ROWS 32
+// pixels gathered at a time by the median networks
+#define NETWORK_CHUNK 64
+// number of histograms, the rows are split into blocks, one histogram per block
+#define HISTOGRAM_COUNT 16
+#define HISTOGRAM_SIZE 65536
+#define COARSE_SHIFT 4
+
+// exchanges of the median networks of 9 and 25 values, the median is in the middle after the exchanges
+static const int MEDIAN9_NETWORK[][2] =
+{
+    { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 1 }, { 3, 4 }, { 6, 7 }, { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 3 },
+    { 5, 8 }, { 4, 7 }, { 3, 6 }, { 1, 4 }, { 2, 5 }, { 4, 7 }, { 4, 2 }, { 6, 4 }, { 4, 2 }
+};
+
+static const int MEDIAN25_NETWORK[][2] =
+{
+    { 0, 1 },   { 3, 4 },   { 2, 4 },   { 2, 3 },   { 6, 7 },   { 5, 7 },   { 5, 6 },   { 9, 10 },  { 8, 10 },  { 8, 9 },
+    { 12, 13 }, { 11, 13 }, { 11, 12 }, { 15, 16 }, { 14, 16 }, { 14, 15 }, { 18, 19 }, { 17, 19 }, { 17, 18 }, { 21, 22 },
+    { 20, 22 }, { 20, 21 }, { 23, 24 }, { 2, 5 },   { 3, 6 },   { 0, 6 },   { 0, 3 },   { 4, 7 },   { 1, 7 },   { 1, 4 },
+    { 11, 14 }, { 8, 14 },  { 8, 11 },  { 12, 15 }, { 9, 15 },  { 9, 12 },  { 13, 16 }, { 10, 16 }, { 10, 13 }, { 20, 23 },
+    { 17, 23 }, { 17, 20 }, { 21, 24 }, { 18, 24 }, { 18, 21 }, { 19, 22 }, { 8, 17 },  { 9, 18 },  { 0, 18 },  { 0, 9 },
+    { 10, 19 }, { 1, 19 },  { 1, 10 },  { 11, 20 }, { 2, 20 },  { 2, 11 },  { 12, 21 }, { 3, 21 },  { 3, 12 },  { 13, 22 },
+    { 4, 22 },  { 4, 13 },  { 14, 23 }, { 5, 23 },  { 5, 14 },  { 15, 24 }, { 6, 24 },  { 6, 15 },  { 7, 16 },  { 7, 19 },
+    { 13, 21 }, { 15, 23 }, { 7, 13 },  { 7, 15 },  { 1, 9 },   { 3, 11 },  { 5, 17 },  { 11, 17 }, { 9, 17 },  { 4, 10 },
+    { 6, 12 },  { 7, 14 },  { 4, 6 },   { 4, 7 },   { 12, 14 }, { 10, 14 }, { 6, 7 },   { 10, 12 }, { 6, 10 },  { 6, 17 },
+    { 12, 17 }, { 7, 17 },  { 7, 10 },  { 12, 18 }, { 7, 12 },  { 10, 18 }, { 12, 20 }, { 10, 20 }, { 10, 12 }
+};
+
+static inline void sortPair(float* __restrict a, float* __restrict b)
+{
+    for (int i = 0; i < NETWORK_CHUNK; i++)
+    {
+        const float low = std::min(a[i], b[i]);
+        const float high = std::max(a[i], b[i]);
+        a[i] = low;
+        b[i] = high;
+    }
+}
+
+static inline bool isValid(float value)
+{
+    return value >= 1;
+}
+
+static inline int toBin(float value)
+{
+    if (!isValid(value))
+    {
+        return 0;
+    }
+
+    return value < HISTOGRAM_SIZE - 1 ? (int)value : HISTOGRAM_SIZE - 1;
+}
+
+// add (delta = 1) or remove (delta = -1) a column of the window to the histogram
+static inline void updateHistogram(const float* columnPtr, int width, int filterSize, int delta
+    , ushort* histogram, ushort* coarseHistogram, int coarseBin, int& belowCount, int& fractionCount)
+{
+    for (int i = 0; i < filterSize; i++)
+    {
+        const float value = columnPtr[(size_t)i * width];
+        const int bin = toBin(value);
+
+        histogram[bin] += delta;
+        coarseHistogram[bin >> COARSE_SHIFT] += delta;
+        belowCount += ((bin >> COARSE_SHIFT) < coarseBin) ? delta : 0;
+        fractionCount += (value != (float)bin) ? delta : 0;
+    }
+}
+
+DepthSpatialFilter::DepthSpatialFilter()
+{
+
+}
+
+void DepthSpatialFilter::averageBlur(float* dataPtr, int width, int height, int filterSize)
+{
+    CS_TRACE_SCOPE("DepthSpatialFilter::averageBlur");
+    const int radius = filterSize / 2;
+    if (filterSize <= 1 || width - radius <= radius || height - radius <= radius)
+    {
+        return;
+    }
+
+    sumRows(dataPtr, width, height, filterSize);
+
+    // the row sums are ready, so the vertical pass can write the results to the depth data directly
+    const int windowSize = filterSize * filterSize;
+    const int beginX = radius;
+    const int endX = width - radius;
+    const int blockCount = (height - radius * 2 + AVERAGE_BLOCK_ROWS - 1) / AVERAGE_BLOCK_ROWS;
+
+    m_columnSum.resize((size_t)blockCount * width);
+    m_columnCount.resize((size_t)blockCount * width);
+
+#pragma omp parallel for
+    for (int block = 0; block < blockCount; block++)
+    {
+        const int beginY = radius + block * AVERAGE_BLOCK_ROWS;
+        const int endY = qMin(beginY + AVERAGE_BLOCK_ROWS, height - radius);
+
+        double* sumPtr = m_columnSum.data() + (size_t)block * width;
+        int* countPtr = m_columnCount.data() + (size_t)block * width;
+        std::fill(sumPtr, sumPtr + width, 0.0);
+        std::fill(countPtr, countPtr + width, 0);
+
+        for (int y = beginY - radius; y < beginY - radius + filterSize - 1; y++)
+        {
+            const double* rowSumPtr = m_rowSum.data() + (size_t)y * width;
+            const int* rowCountPtr = m_rowCount.data() + (size_t)y * width;
+            for (int x = beginX; x < endX; x++)
+            {
+                sumPtr[x] += rowSumPtr[x];
+                countPtr[x] += rowCountPtr[x];
+            }
+        }
+
+        for (int y = beginY; y < endY; y++)
+        {
+            const double* inSumPtr = m_rowSum.data() + (size_t)(y - radius + filterSize - 1) * width;
+            const int* inCountPtr = m_rowCount.data() + (size_t)(y - radius + filterSize - 1) * width;
+            const double* outSumPtr = m_rowSum.data() + (size_t)(y - radius) * width;
+            const int* outCountPtr = m_rowCount.data() + (size_t)(y - radius) * width;
+            float* rowPtr = dataPtr + (size_t)y * width;
+
+            for (int x = beginX; x < endX; x++)
+            {
+                const double sum = sumPtr[x] + inSumPtr[x];
+                const int count = countPtr[x] + inCountPtr[x];
+                const float value = (float)(sum / windowSize);
+                if (count == windowSize && value > 1)
+                {
+                    rowPtr[x] = value;
+                }
+
+                sumPtr[x] = sum - outSumPtr[x];
+                countPtr[x] = count - outCountPtr[x];
+            }
+        }
+    }
+}
+
+void DepthSpatialFilter::medianBlur(float* dataPtr, int width, int height, int filterSize)
+{
+    CS_TRACE_SCOPE("DepthSpatialFilter::medianBlur");
+    const int radius = filterSize / 2;
+    if (filterSize <= 1 || width - radius <= radius || height - radius <= radius)
+    {
+        return;
+    }
+
+    m_output.resize((size_t)width * height);
+
+    if (filterSize == 3 || filterSize == 5)
+    {
+        sumRows(dataPtr, width, height, filterSize);
+        medianNetwork(dataPtr, width, height, filterSize);
+    }
+    else
+    {
+        medianHistogram(dataPtr, width, height, filterSize);
+    }
+
+    writeBack(dataPtr, width, height, filterSize);
+}
+
+void DepthSpatialFilter::sumRows(const float* dataPtr, int width, int height, int filterSize)
+{
+    const int radius = filterSize / 2;
+
+    m_rowSum.resize((size_t)width * height);
+    m_rowCount.resize((size_t)width * height);
+
+    // the values are at least 1 and come from 16 bit depth, so the double sums are exact 
+    // and sliding the window does not accumulate rounding errors
+#pragma omp parallel for
+    for (int y = 0; y < height; y++)
+    {
+        const float* rowPtr = dataPtr + (size_t)y * width;
+        double* sumPtr = m_rowSum.data() + (size_t)y * width;
+        int* countPtr = m_rowCount.data() + (size_t)y * width;
+
+        double sum = 0;
+        int count = 0;
+        for (int x = 0; x < filterSize - 1; x++)
+        {
+            const float value = rowPtr[x];
+            sum += isValid(value) ? value : 0;
+            count += isValid(value);
+        }
+
+        for (int x = radius; x < width - radius; x++)
+        {
+            const float in = rowPtr[x - radius + filterSize - 1];
+            sum += isValid(in) ? in : 0;
+            count += isValid(in);
+
+            sumPtr[x] = sum;
+            countPtr[x] = count;
+
+            const float out = rowPtr[x - radius];
+            sum -= isValid(out) ? out : 0;
+            count -= isValid(out);
+        }
+    }
+}
+
+void DepthSpatialFilter::medianNetwork(const float* dataPtr, int width, int height, int filterSize)
+{
+    Q_ASSERT(filterSize == 3 || filterSize == 5);
+
+    const int radius = filterSize / 2;
+    const int windowSize = filterSize * filterSize;
+    const int (*network)[2] = (filterSize == 3) ? MEDIAN9_NETWORK : MEDIAN25_NETWORK;
+    const int exchangeCount = (filterSize == 3) ? (int)(sizeof(MEDIAN9_NETWORK) / sizeof(MEDIAN9_NETWORK[0]))
+                                                : (int)(sizeof(MEDIAN25_NETWORK) / sizeof(MEDIAN25_NETWORK[0]));
+    float* outputPtr = m_output.data();
+
+    // the networks run on a chunk of pixels at a time, so every exchange is a vectorizable min/max loop
+#pragma omp parallel for
+    for (int y = radius; y < height - radius; y++)
+    {
+        float values[25][NETWORK_CHUNK];
+        int counts[NETWORK_CHUNK];
+
+        for (int beginX = radius; beginX < width - radius; beginX += NETWORK_CHUNK)
+        {
+            const int n = qMin(NETWORK_CHUNK, width - radius - beginX);
+            memset(counts, 0, sizeof(counts));
+            // the exchanges always run on a full chunk
+            if (n < NETWORK_CHUNK)
+            {
+                memset(values, 0, sizeof(values));
+            }
+
+            for (int i = 0; i < filterSize; i++)
+            {
+                const size_t rowOffset = (size_t)(y + i - radius) * width;
+                for (int j = 0; j < filterSize; j++)
+                {
+                    memcpy(values[i * filterSize + j], dataPtr + rowOffset + beginX - radius + j, n * sizeof(float));
+                }
+
+                const int* rowCountPtr = m_rowCount.data() + rowOffset + beginX;
+                for (int x = 0; x < n; x++)
+                {
+                    counts[x] += rowCountPtr[x];
+                }
+            }
+
+            for (int k = 0; k < exchangeCount; k++)
+            {
+                sortPair(values[network[k][0]], values[network[k][1]]);
+            }
+
+            const float* medianPtr = values[windowSize / 2];
+            float* rowOutputPtr = outputPtr + (size_t)y * width + beginX;
+            for (int x = 0; x < n; x++)
+            {
+                rowOutputPtr[x] = (counts[x] == windowSize) ? medianPtr[x] : 0;
+            }
+        }
+    }
+}
+
+void DepthSpatialFilter::medianHistogram(const float* dataPtr, int width, int height, int filterSize)
+{
+    const int radius = filterSize / 2;
+    const int windowSize = filterSize * filterSize;
+    // the median is the (windowSize / 2)th value in descending order
+    const int rank = windowSize - 1 - windowSize / 2;
+    const int rowCount = height - radius * 2;
+    const int blockCount = qMin(rowCount, HISTOGRAM_COUNT);
+    const int coarseSize = HISTOGRAM_SIZE >> COARSE_SHIFT;
+
+    // the histograms are empty again after each row, so they are only cleared when allocated
+    m_histograms.resize((size_t)HISTOGRAM_COUNT * HISTOGRAM_SIZE, 0);
+    m_coarseHistograms.resize((size_t)HISTOGRAM_COUNT * coarseSize, 0);
+    float* outputPtr = m_output.data();
+
+#pragma omp parallel for
+    for (int block = 0; block < blockCount; block++)
+    {
+        ushort* histogram = m_histograms.data() + (size_t)block * HISTOGRAM_SIZE;
+        ushort* coarseHistogram = m_coarseHistograms.data() + (size_t)block * coarseSize;
+        std::vector<float> window(windowSize);
+
+        const int beginY = radius + rowCount * block / blockCount;
+        const int endY = radius + rowCount * (block + 1) / blockCount;
+        for (int y = beginY; y < endY; y++)
+        {
+            const float* topPtr = dataPtr + (size_t)(y - radius) * width;
+            float* rowOutputPtr = outputPtr + (size_t)y * width;
+
+            // the coarse bin of the last median and the count of the values below it
+            int coarseBin = 0;
+            int belowCount = 0;
+            // count of the values that are not integers, the median of a window without them is its bin
+            int fractionCount = 0;
+
+            for (int x = 0; x < filterSize - 1; x++)
+            {
+                updateHistogram(topPtr + x, width, filterSize, 1, histogram, coarseHistogram, coarseBin, belowCount, fractionCount);
+            }
+
+            for (int x = radius; x < width - radius; x++)
+            {
+                updateHistogram(topPtr + x - radius + filterSize - 1, width, filterSize, 1
+                    , histogram, coarseHistogram, coarseBin, belowCount, fractionCount);
+
+                float value = 0;
+                // bin 0 holds the invalid values
+                if (histogram[0] == 0)
+                {
+                    while (belowCount > rank)
+                    {
+                        coarseBin--;
+                        belowCount -= coarseHistogram[coarseBin];
+                    }
+
+                    while (belowCount + coarseHistogram[coarseBin] <= rank)
+                    {
+                        belowCount += coarseHistogram[coarseBin];
+                        coarseBin++;
+                    }
+
+                    int count = belowCount;
+                    int bin = coarseBin << COARSE_SHIFT;
+                    while (count + histogram[bin] <= rank)
+                    {
+                        count += histogram[bin];
+                        bin++;
+                    }
+
+                    if (fractionCount == 0)
+                    {
+                        value = (float)bin;
+                    }
+                    else
+                    {
+                        for (int i = 0; i < filterSize; i++)
+                        {
+                            memcpy(window.data() + i * filterSize, topPtr + (size_t)i * width + x - radius, filterSize * sizeof(float));
+                        }
+
+                        std::nth_element(window.begin(), window.begin() + rank, window.end());
+                        value = window[rank];
+                    }
+                }
+                rowOutputPtr[x] = value;
+
+                updateHistogram(topPtr + x - radius, width, filterSize, -1
+                    , histogram, coarseHistogram, coarseBin, belowCount, fractionCount);
+            }
+
+            const int lastColumn = width - radius * 2;
+            for (int x = lastColumn; x < lastColumn + filterSize - 1; x++)
+            {
+                updateHistogram(topPtr + x, width, filterSize, -1, histogram, coarseHistogram, coarseBin, belowCount, fractionCount);
+            }
+        }
+    }
+}
+
+void DepthSpatialFilter::writeBack(float* dataPtr, int width, int height, int filterSize)
+{
+    const int radius = filterSize / 2;
+    const float* outputPtr = m_output.data();
+
+#pragma omp parallel for
+    for (int y = radius; y < height - radius; y++)
+    {
+        const size_t offset = (size_t)y * width;
+        for (int x = radius; x < width - radius; x++)
+        {
+            const float value = outputPtr[offset + x];
+            if (value > 1)
+            {
+                dataPtr[offset + x] = value;
+            }
+        }
+    }
+}
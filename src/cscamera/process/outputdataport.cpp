@@ -35,6 +35,8 @@ OutputDataPort::OutputDataPort(const OutputDataPort& other)
     m_outputData2DMap = other.m_outputData2DMap;
     m_pointCloud = other.m_pointCloud;
     m_frameData = other.m_frameData;
+    m_depthData = other.m_depthData;
+    m_rgbImage = other.m_rgbImage;
 }
 
 OutputDataPort::~OutputDataPort()
@@ -59,6 +61,26 @@ bool OutputDataPort::hasData(CS_CAMERA_DATA_TYPE dataType) const
     }
 }
 
+bool OutputDataPort::hasDepthData() const
+{
+    return !m_depthData.isEmpty();
+}
+
+const QByteArray& OutputDataPort::getDepthData() const
+{
+    return m_depthData;
+}
+
+bool OutputDataPort::hasRgbImage() const
+{
+    return !m_rgbImage.isNull();
+}
+
+QImage OutputDataPort::getRgbImage() const
+{
+    return m_rgbImage;
+}
+
 cs::Pointcloud OutputDataPort::getPointCloud()
 {
     return m_pointCloud;
@@ -89,6 +111,16 @@ void OutputDataPort::setPointCloud(const cs::Pointcloud& pointCloud)
     this->m_pointCloud = pointCloud;
 }
 
+void OutputDataPort::setDepthData(const QByteArray& depthData)
+{
+    this->m_depthData = depthData;
+}
+
+void OutputDataPort::setRgbImage(const QImage& image)
+{
+    this->m_rgbImage = image;
+}
+
 void OutputDataPort::addOutputData2D(const OutputData2D& outputData2D)
 {
     CS_CAMERA_DATA_TYPE dataType = (CS_CAMERA_DATA_TYPE)outputData2D.info.cameraDataType;
@@ -106,4 +138,27 @@ void OutputDataPort::addOutputData2D(const QVector<OutputData2D>& outputData2Ds)
 void OutputDataPort::setFrameData(const FrameData& frameData)
 {
     this->m_frameData = frameData;
+}
+
+void OutputDataPort::merge(const OutputDataPort& other)
+{
+    for (auto it = other.m_outputData2DMap.cbegin(); it != other.m_outputData2DMap.cend(); ++it)
+    {
+        m_outputData2DMap[it.key()] = it.value();
+    }
+
+    if (other.hasData(CAMERA_DATA_POINT_CLOUD) && !hasData(CAMERA_DATA_POINT_CLOUD))
+    {
+        m_pointCloud = other.m_pointCloud;
+    }
+
+    if (other.hasDepthData())
+    {
+        m_depthData = other.m_depthData;
+    }
+
+    if (other.hasRgbImage())
+    {
+        m_rgbImage = other.m_rgbImage;
+    }
 }
\ No newline at end of file
@@ -22,6 +22,8 @@
 #include <hpp/Processing.hpp>
 #include "icscamera.h"
 #include "cameraparaid.h"
+#include "process/rgbpreprocessstrategy.h"
+#include <cstracer.h>
 
 using namespace cs;
 
@@ -32,6 +34,8 @@ PointCloudProcessStrategy::PointCloudProcessStrategy()
     m_dependentParameters.push_back(PARA_RGB_INTRINSICS);
     m_dependentParameters.push_back(PARA_EXTRINSICS);
     m_dependentParameters.push_back(PARA_HAS_RGB);
+
+    m_dependentStrategys.push_back(STRATEGY_RGB_PREPROCESS);
 }
 
 void PointCloudProcessStrategy::doProcess(const FrameData& frameData, OutputDataPort& outputDataPort)
@@ -48,13 +52,6 @@ void PointCloudProcessStrategy::doProcess(const FrameData& frameData, OutputData
         return;
     }
 
-    // If in single-trigger mode and time-domain filtering is enabled, 
-    // the cached data of the time-domain filter needs to be cleared.
-    if (m_trigger != TRIGGER_MODE_OFF && m_filterType == FILTER_TDSMOOTH)
-    {
-        m_filterCachedData.clear();
-    }
-
     Pointcloud pc;
     bool processedDepth = false;
 
@@ -66,7 +63,7 @@ void PointCloudProcessStrategy::doProcess(const FrameData& frameData, OutputData
         case STREAM_FORMAT_Z16:
         case STREAM_FORMAT_Z16Y8Y8:
         case STREAM_FORMAT_XZ32:
-            generatePointCloud(streamData, pc);
+            generatePointCloud(streamData, outputDataPort.getDepthData(), pc);
             processedDepth = true;
             break;
         default:
@@ -85,7 +82,7 @@ void PointCloudProcessStrategy::doProcess(const FrameData& frameData, OutputData
             {
             case STREAM_FORMAT_RGB8:
             case STREAM_FORMAT_MJPG:
-                generateTexture(streamData, texImage);
+                generateTexture(streamData, outputDataPort, texImage);
                 break;
             default:
                 break;
@@ -95,7 +92,7 @@ void PointCloudProcessStrategy::doProcess(const FrameData& frameData, OutputData
 
     if (processedDepth)
     {
-        emit output3DUpdated(pc, texImage);
+        emit output3DUpdated(pc, texImage, frameData.receivedTime);
         outputDataPort.setPointCloud(pc);
     }
 }
@@ -137,22 +134,21 @@ void PointCloudProcessStrategy::setWithTexture(bool with)
     m_withTexture = with;
 }
 
-void PointCloudProcessStrategy::generatePointCloud(const StreamData& depthData, Pointcloud& pc)
+void PointCloudProcessStrategy::generatePointCloud(const StreamData& depthData, const QByteArray& floatData, Pointcloud& pc)
 {
     // Point Cloud
     const int width = depthData.dataInfo.width;
     const int height = depthData.dataInfo.height;
-    const ushort* dataPtr = (const ushort*)depthData.data.data();
 
     Q_ASSERT(depthData.data.size() >= width * height * sizeof(ushort));
 
-    // depth process
-    QByteArray floatData;
-    if (!onProcessDepthData(dataPtr, width * height, width, height, floatData))
+    // skipped by the depth preprocess, e.g. time domain smooth is not ready
+    if (floatData.size() != width * height * sizeof(float))
     {
         return;
     }
     
+    CS_TRACE_SCOPE("Pointcloud::generatePoints");
     float* floatPtr = (float*)floatData.data();
     bool hasTex = m_withTexture && depthData.data.size() > 1;
 
@@ -178,29 +174,19 @@ void PointCloudProcessStrategy::generatePointCloud(const StreamData& depthData,
     }
 }
 
-void PointCloudProcessStrategy::generateTexture(const StreamData& rgbData, QImage& texImage)
+void PointCloudProcessStrategy::generateTexture(const StreamData& rgbData, const OutputDataPort& outputDataPort, QImage& texImage)
 {
     // rgb process
     if (m_withTexture)
     {
-        STREAM_FORMAT format = rgbData.dataInfo.format;
-
-        if (format == STREAM_FORMAT_RGB8)
+        // reuse the image decoded by the rgb preprocess strategy
+        if (outputDataPort.hasRgbImage())
         {
-            QImage image = QImage((uchar*)rgbData.data.data(), rgbData.dataInfo.width, rgbData.dataInfo.height, QImage::Format_RGB888);
-            texImage = image.copy(image.rect());
+            texImage = outputDataPort.getRgbImage();
         }
-        else if (format == STREAM_FORMAT_MJPG)
+        else if (!RgbPreprocessStrategy::decodeRgbData(rgbData, texImage))
         {
-            QImage image;
-            image.loadFromData(rgbData.data, "JPG");
-            image = image.convertToFormat(QImage::Format_RGB888);
-
-            texImage = image;
-        }
-        else {
             qDebug() << "invalid stream format.";
-            Q_ASSERT(false);
         }
     }
 }
\ No newline at end of file
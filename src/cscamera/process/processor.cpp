@@ -22,18 +22,58 @@
 
 #include <QDebug>
 #include <QMutexLocker>
+#include <QThread>
+#include <QRunnable>
+#include <atomic>
+#include <cstracer.h>
+
+#define MAX_PROCESS_THREAD 4
+
 using namespace cs;
 
+namespace
+{
+class ProcessStrategyTask : public QRunnable
+{
+public:
+    ProcessStrategyTask(ProcessStrategy* strategy, const FrameData& frameData, OutputDataPort& outputDataPort)
+        : m_strategy(strategy)
+        , m_frameData(frameData)
+        , m_outputDataPort(outputDataPort)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_strategy->process(m_frameData, m_outputDataPort);
+    }
+private:
+    ProcessStrategy* m_strategy;
+    const FrameData& m_frameData;
+    OutputDataPort& m_outputDataPort;
+};
+}
+
 Processor::Processor()
+    : m_processStrategys(std::make_shared<const ProcessStrategyList>())
 {
+    int maxThread = QThread::idealThreadCount() > MAX_PROCESS_THREAD ? MAX_PROCESS_THREAD : QThread::idealThreadCount();
+    m_threadPool.setMaxThreadCount(qMax(1, maxThread));
 }
 
 Processor::~Processor()
 {
-    m_processStrategys.clear();
+    m_threadPool.waitForDone();
+    std::atomic_store(&m_processStrategys, std::make_shared<const ProcessStrategyList>());
     qDebug() << "~Processor";
 }
 
+std::shared_ptr<const Processor::ProcessStrategyList> Processor::getProcessStrategys() const
+{
+    return std::atomic_load(&m_processStrategys);
+}
+
 void Processor::addProcessStrategy(ProcessStrategy* strategy)
 {
     if (strategy == nullptr)
@@ -42,14 +82,17 @@ void Processor::addProcessStrategy(ProcessStrategy* strategy)
         return;
     }
 
-    QMutexLocker locker(&m_mutex);
-    if (m_processStrategys.contains(strategy))
+    QMutexLocker locker(&m_strategyMutex);
+    auto strategys = getProcessStrategys();
+    if (strategys->contains(strategy))
     {
         qWarning() << "Already contained strategy : " << strategy;
     }
     else 
     {
-        m_processStrategys.push_back(strategy);
+        auto newStrategys = std::make_shared<ProcessStrategyList>(*strategys);
+        newStrategys->push_back(strategy);
+        std::atomic_store(&m_processStrategys, std::shared_ptr<const ProcessStrategyList>(newStrategys));
     }
 }
 
@@ -61,14 +104,20 @@ void Processor::removeProcessStrategy(ProcessStrategy* strategy)
         return;
     }
 
-    QMutexLocker locker(&m_mutex);
-    if (!m_processStrategys.contains(strategy))
+    QMutexLocker locker(&m_strategyMutex);
+    auto strategys = getProcessStrategys();
+    if (!strategys->contains(strategy))
     {
         qWarning() << "processStrategys do not contain strategy type: " << strategy->getProcessStraType();
     }
     else 
     {
-        m_processStrategys.removeAll(strategy);
+        auto newStrategys = std::make_shared<ProcessStrategyList>(*strategys);
+        newStrategys->removeAll(strategy);
+        std::atomic_store(&m_processStrategys, std::shared_ptr<const ProcessStrategyList>(newStrategys));
+
+        // the caller may delete the strategy, wait for the frame which is still using it
+        QMutexLocker processLocker(&m_processMutex);
     }
 }
 
@@ -112,20 +161,96 @@ void Processor::removeProcessEndLisener(ProcessEndListener* listener)
 
 void Processor::process(const FrameData& frameData)
 {
-    QMutexLocker locker(&m_mutex);
+    QMutexLocker processLocker(&m_processMutex);
+    CS_TRACE_SCOPE_FRAME("Processor::process", frameData.receivedTime);
 
-    OutputDataPort outputDataPort(frameData);
-    for (auto stra : m_processStrategys)
+    QVector<ProcessStrategy*> pendings;
+    for (auto stra : *getProcessStrategys())
     {
         if (stra->isStrategyEnable())
         {
-            stra->process(frameData, outputDataPort);
+            pendings.push_back(stra);
+        }
+    }
+
+    OutputDataPort outputDataPort(frameData);
+
+    // Run the strategies as a dependency graph: every round runs the strategies 
+    // whose dependencies are finished, e.g. the preprocess strategies first, then depth, rgb and point cloud.
+    while (!pendings.isEmpty())
+    {
+        QVector<int> pendingTypes;
+        for (auto stra : pendings)
+        {
+            pendingTypes.push_back(stra->getProcessStraType());
+        }
+
+        QVector<ProcessStrategy*> readys;
+        for (auto stra : pendings)
+        {
+            bool ready = true;
+            for (auto type : stra->getDependentStrategys())
+            {
+                if (type != stra->getProcessStraType() && pendingTypes.contains(type))
+                {
+                    ready = false;
+                    break;
+                }
+            }
+
+            if (ready)
+            {
+                readys.push_back(stra);
+            }
+        }
+
+        if (readys.isEmpty())
+        {
+            qWarning() << "circular dependency in process strategys";
+            readys = pendings;
+        }
+
+        runProcessStrategys(readys, frameData, outputDataPort);
+
+        for (auto stra : readys)
+        {
+            pendings.removeAll(stra);
         }
     }
 
     // to do some thing after process, for example save data
+    QMutexLocker locker(&m_mutex);
+    CS_TRACE_SCOPE_FRAME("Processor::processEnd", frameData.receivedTime);
     for (auto lisener : m_processEndLiseners)
     {
         lisener->process(outputDataPort);
     }
-}
\ No newline at end of file
+}
+
+void Processor::runProcessStrategys(const QVector<ProcessStrategy*>& strategys, const FrameData& frameData, OutputDataPort& outputDataPort)
+{
+    if (strategys.size() == 1)
+    {
+        strategys.first()->process(frameData, outputDataPort);
+        return;
+    }
+
+    // every strategy writes into its own port, the ports are merged after all of them finished
+    QVector<OutputDataPort> outputDataPorts(strategys.size(), outputDataPort);
+    for (int i = 1; i < strategys.size(); i++)
+    {
+        m_threadPool.start(new ProcessStrategyTask(strategys[i], frameData, outputDataPorts[i]));
+    }
+
+    strategys.first()->process(frameData, outputDataPorts.first());
+    {
+        CS_TRACE_SCOPE("Processor::waitStrategys");
+        m_threadPool.waitForDone();
+    }
+
+    CS_TRACE_SCOPE("Processor::mergeOutputs");
+    for (auto& port : outputDataPorts)
+    {
+        outputDataPort.merge(port);
+    }
+}
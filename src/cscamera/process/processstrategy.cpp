@@ -19,8 +19,10 @@
 
 #include "process/processstrategy.h"
 #include "icscamera.h"
+#include "pipelinestats.h"
 
 #include <QMutexLocker>
+#include <cstracer.h>
 
 using namespace cs;
 
@@ -60,7 +62,24 @@ void ProcessStrategy::process(const FrameData& frameData, OutputDataPort& output
         onLoadCameraPara();
     }
 
+    m_receivedTime = frameData.receivedTime;
+
+#ifdef CS_TRACE_ENABLED
+    // the names of the trace events in the order of PROCESS_STRA_TYPE
+    static const char* traceNames[] =
+    {
+        "DepthProcessStrategy::process",
+        "RgbProcessStrategy::process",
+        "PointCloudProcessStrategy::process",
+        "DepthPreprocessStrategy::process",
+        "RgbPreprocessStrategy::process"
+    };
+    CS_TRACE_SCOPE_FRAME(traceNames[m_strategyType], frameData.receivedTime);
+#endif
+
+    const qint64 startTime = PipelineStats::now();
     doProcess(frameData, outputDataPort);
+    PipelineStats::getInstance()->recordSince((PIPELINE_STAGE)(STAGE_STRATEGY_DEPTH + m_strategyType), startTime);
 }
 
 PROCESS_STRA_TYPE ProcessStrategy::getProcessStraType()
@@ -76,4 +95,9 @@ void ProcessStrategy::setStrategyEnable(bool enable)
 int ProcessStrategy::isStrategyEnable()
 {
     return m_strategyEnable;
+}
+
+QVector<int> ProcessStrategy::getDependentStrategys() const
+{
+    return m_dependentStrategys;
 }
\ No newline at end of file
@@ -21,15 +21,20 @@
 
 #include <QDebug>
 #include <QMutexLocker>
+#include <cstracer.h>
 
 #include "process/processor.h"
+#include "pipelinestats.h"
 
 #define MAX_CACHED_FRAME 5
+// max time the producer waits for a free slot in fifo mode
+#define MAX_WAIT_FULL_MS 100
 
 using namespace cs;
 
 ProcessThread::ProcessThread(std::shared_ptr<Processor> processor)
-    : m_processorPtr(processor)
+    : m_cachedFrameData(MAX_CACHED_FRAME)
+    , m_processorPtr(processor)
 {
     setObjectName("ProcessThread");
     moveToThread(this);
@@ -37,7 +42,12 @@ ProcessThread::ProcessThread(std::shared_ptr<Processor> processor)
 
 ProcessThread::~ProcessThread()
 {
+    m_mutex.lock();
     requestInterruption();
+    m_notEmpty.wakeAll();
+    m_notFull.wakeAll();
+    m_mutex.unlock();
+
     wait();
     qDebug() << "~ProcessThread";
 }
@@ -50,19 +60,33 @@ void ProcessThread::run()
         FrameData data;
 
         m_mutex.lock();
-        if (!m_cachedFrameData.isEmpty()) {
-            data = m_cachedFrameData.dequeue();
+        while (m_count == 0 && !isInterruptionRequested())
+        {
+            m_notEmpty.wait(&m_mutex);
+        }
+
+        if (m_count > 0) 
+        {
+            popFrame(data);
             hasData = true;
         }
         m_mutex.unlock();
 
         if (hasData)
         {
+            CS_TRACE_SCOPE_FRAME("ProcessThread::process", data.receivedTime);
+            auto stats = PipelineStats::getInstance();
+            const qint64 dequeueTime = PipelineStats::now();
+            if (data.receivedTime > 0)
+            {
+                stats->record(STAGE_QUEUE, dequeueTime - data.receivedTime);
+            }
+
             m_processorPtr->process(data);
-        }
-        else 
-        {
-            QThread::msleep(2);
+            stats->recordSince(STAGE_PROCESS, dequeueTime);
+
+            QMutexLocker locker(&m_mutex);
+            m_queueStats.processedCount++;
         }
     }
 }
@@ -70,17 +94,110 @@ void ProcessThread::run()
 // exec not on ProcessThread
 void ProcessThread::onFrameDataUpdated(FrameData frameData)
 {
+    CS_TRACE_SCOPE_FRAME("ProcessThread::enqueue", frameData.receivedTime);
     QMutexLocker locker(&m_mutex);
     if (!isRunning()) 
     {
         start();
     }
 
-    if (m_cachedFrameData.size() >= MAX_CACHED_FRAME)
+    m_queueStats.receivedCount++;
+
+    switch (m_queuePolicy)
+    {
+    case QUEUE_POLICY_LATEST:
+        // replace the frames which are not processed yet
+        if (m_count > 0)
+        {
+            CS_TRACE_INSTANT("ProcessThread::replaceFrames");
+        }
+        m_queueStats.droppedCount += m_count;
+        PipelineStats::getInstance()->addDrop(DROP_PROCESS_QUEUE, m_count);
+        // release the frame buffers of the dropped frames
+        for (int i = 0; i < m_count; i++)
+        {
+            m_cachedFrameData[(m_head + i) % m_cachedFrameData.size()] = FrameData();
+        }
+        m_head = 0;
+        m_count = 0;
+        break;
+    case QUEUE_POLICY_FIFO:
+        while (m_count >= m_cachedFrameData.size() && !isInterruptionRequested())
+        {
+            CS_TRACE_SCOPE("ProcessThread::waitNotFull");
+            if (!m_notFull.wait(&m_mutex, MAX_WAIT_FULL_MS))
+            {
+                break;
+            }
+        }
+        break;
+    case QUEUE_POLICY_EVERY_NTH:
+        if ((m_frameIndex++ % m_everyNth) != 0)
+        {
+            m_queueStats.skippedCount++;
+            PipelineStats::getInstance()->addDrop(DROP_PROCESS_SKIPPED);
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
+    // drop the oldest frame
+    if (m_count >= m_cachedFrameData.size())
     {
-        qWarning() << "dequeue, skip one frame";
-        m_cachedFrameData.dequeue();
+        FrameData dropped;
+        popFrame(dropped);
+        m_queueStats.droppedCount++;
+        PipelineStats::getInstance()->addDrop(DROP_PROCESS_QUEUE);
+        CS_TRACE_INSTANT_FRAME("ProcessThread::dropFrame", dropped.receivedTime);
     }
 
-    m_cachedFrameData.enqueue(frameData);
+    pushFrame(frameData);
+    CS_TRACE_COUNTER("process queue", m_count);
+    m_notEmpty.wakeOne();
+}
+
+void ProcessThread::setQueuePolicy(FRAME_QUEUE_POLICY policy, int everyNth)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queuePolicy = policy;
+    m_everyNth = qMax(1, everyNth);
+    m_frameIndex = 0;
+
+    m_notFull.wakeAll();
+}
+
+FrameQueueStats ProcessThread::getQueueStats()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queueStats;
+}
+
+void ProcessThread::resetQueueStats()
+{
+    QMutexLocker locker(&m_mutex);
+    m_queueStats = FrameQueueStats();
+}
+
+// must be called with m_mutex locked
+void ProcessThread::pushFrame(const FrameData& frameData)
+{
+    const int capacity = m_cachedFrameData.size();
+    m_cachedFrameData[(m_head + m_count) % capacity] = frameData;
+    m_count++;
+}
+
+// must be called with m_mutex locked
+void ProcessThread::popFrame(FrameData& frameData)
+{
+    const int capacity = m_cachedFrameData.size();
+    frameData = m_cachedFrameData[m_head];
+    // release the frame buffer
+    m_cachedFrameData[m_head] = FrameData();
+
+    m_head = (m_head + 1) % capacity;
+    m_count--;
+
+    m_notFull.wakeOne();
 }
\ No newline at end of file
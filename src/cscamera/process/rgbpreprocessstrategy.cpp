@@ -0,0 +1,78 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "process/rgbpreprocessstrategy.h"
+
+#include <QDebug>
+#include <cstracer.h>
+
+using namespace cs;
+
+RgbPreprocessStrategy::RgbPreprocessStrategy()
+    : ProcessStrategy(STRATEGY_RGB_PREPROCESS)
+{
+
+}
+
+void RgbPreprocessStrategy::doProcess(const FrameData& frameData, OutputDataPort& outputDataPort)
+{
+    for (const auto& data : frameData.data)
+    {
+        QImage image;
+        if (decodeRgbData(data, image))
+        {
+            outputDataPort.setRgbImage(image);
+            return;
+        }
+    }
+}
+
+bool RgbPreprocessStrategy::decodeRgbData(const StreamData& streamData, QImage& image)
+{
+    CS_TRACE_SCOPE("RgbPreprocessStrategy::decodeRgbData");
+    switch (streamData.dataInfo.format)
+    {
+    case STREAM_FORMAT_RGB8:
+    {
+        const int width = streamData.dataInfo.width;
+        const int height = streamData.dataInfo.height;
+        Q_ASSERT(streamData.data.size() >= width * height * 3);
+
+        QImage rgbImage((const uchar*)streamData.data.data(), width, height, QImage::Format_RGB888);
+        image = rgbImage.copy(rgbImage.rect());
+        break;
+    }
+    case STREAM_FORMAT_MJPG:
+        if (!image.loadFromData(streamData.data, "JPG"))
+        {
+            qWarning() << "decode jpg failed";
+            return false;
+        }
+
+        if (image.format() != QImage::Format_RGB888)
+        {
+            image = image.convertToFormat(QImage::Format_RGB888);
+        }
+        break;
+    default:
+        return false;
+    }
+
+    return !image.isNull();
+}
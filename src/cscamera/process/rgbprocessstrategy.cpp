@@ -20,13 +20,14 @@
 #include "process/rgbprocessstrategy.h"
 
 #include <QImage>
+#include "process/rgbpreprocessstrategy.h"
 
 using namespace cs;
 
 RgbProcessStrategy::RgbProcessStrategy()
     : ProcessStrategy(STRATEGY_RGB)
 {
-
+    m_dependentStrategys.push_back(STRATEGY_RGB_PREPROCESS);
 }
 
 void RgbProcessStrategy::doProcess(const FrameData& frameData, OutputDataPort& outputDataPort)
@@ -41,10 +42,8 @@ void RgbProcessStrategy::doProcess(const FrameData& frameData, OutputDataPort& o
         switch (format)
         {
         case STREAM_FORMAT_RGB8:
-            outputData = onProcessRGB8(data);
-            break;
         case STREAM_FORMAT_MJPG:
-            outputData = onProcessMJPG(data);
+            outputData = onProcessRGB(data, outputDataPort);
             break;
         default:
             break;
@@ -57,30 +56,19 @@ void RgbProcessStrategy::doProcess(const FrameData& frameData, OutputDataPort& o
     }
 }
 
-OutputData2D RgbProcessStrategy::onProcessRGB8(const StreamData& streamData)
+OutputData2D RgbProcessStrategy::onProcessRGB(const StreamData& streamData, const OutputDataPort& outputDataPort)
 {
-    const int width = streamData.dataInfo.width;
-    const int height = streamData.dataInfo.height;
-    const int dataSize = streamData.data.size();
+    // reuse the image decoded by the rgb preprocess strategy
+    QImage image = outputDataPort.getRgbImage();
+    if (image.isNull() && !RgbPreprocessStrategy::decodeRgbData(streamData, image))
+    {
+        return OutputData2D();
+    }
 
-    QImage image((uchar*)streamData.data.data(), width, height, QImage::Format_RGB888);
     OutputData2D outputData;
     outputData.info.cameraDataType = CAMERA_DATA_RGB;
-    outputData.image = image.copy(image.rect());
-    emit output2DUpdated(outputData);
-
-    return outputData;
-}
-
-OutputData2D RgbProcessStrategy::onProcessMJPG(const StreamData& streamData)
-{
-    QImage image;
-    image.loadFromData(streamData.data, "JPG");
-    //image = image.convertToFormat(QImage::Format_RGB888);
-
-    OutputData2D outputData;
+    outputData.info.receivedTime = m_receivedTime;
     outputData.image = image;
-    outputData.info.cameraDataType = CAMERA_DATA_RGB;
     emit output2DUpdated(outputData);
 
     return outputData;
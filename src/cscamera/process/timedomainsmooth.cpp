@@ -0,0 +1,163 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "process/timedomainsmooth.h"
+
+#include <string.h>
+#include <algorithm>
+#include <cstracer.h>
+
+using namespace cs;
+
+TimeDomainSmooth::TimeDomainSmooth()
+{
+
+}
+
+bool TimeDomainSmooth::process(float* dataPtr, int width, int height, int window)
+{
+    CS_TRACE_SCOPE("TimeDomainSmooth::process");
+    if (window <= 0 || width <= 0 || height <= 0)
+    {
+        return true;
+    }
+
+    if (width != m_width || height != m_height || window != m_window)
+    {
+        resize(width, height, window);
+    }
+
+    const int size = width * height;
+
+    // evict the oldest frame
+    if (m_count >= m_window)
+    {
+        removeFrame(m_head);
+        m_head = (m_head + 1) % m_window;
+        m_count--;
+    }
+
+    const int slot = (m_head + m_count) % m_window;
+    memcpy(m_frames.data() + (size_t)slot * size, dataPtr, size * sizeof(float));
+    addFrame(slot);
+    m_count++;
+
+    if (m_count < m_window)
+    {
+        return false;
+    }
+
+    const double* sumPtr = m_sum.data();
+    const int* countPtr = m_validCount.data();
+#pragma omp parallel for
+    for (int i = 0; i < size; i++)
+    {
+        const int count = countPtr[i];
+        dataPtr[i] = count > 0 ? (float)(sumPtr[i] / count) : 0;
+    }
+
+    return true;
+}
+
+void TimeDomainSmooth::reset()
+{
+    m_head = 0;
+    m_count = 0;
+
+    std::fill(m_sum.begin(), m_sum.end(), 0.0);
+    std::fill(m_validCount.begin(), m_validCount.end(), 0);
+}
+
+int TimeDomainSmooth::getCachedCount() const
+{
+    return m_count;
+}
+
+void TimeDomainSmooth::resize(int width, int height, int window)
+{
+    const int size = width * height;
+    const bool sameSize = (width == m_width && height == m_height);
+
+    // keep the newest (window - 1) frames if only the window changed
+    std::vector<float> keptFrames;
+    int keptCount = 0;
+    if (sameSize && m_count > 0)
+    {
+        keptCount = qMin(m_count, window - 1);
+        keptFrames.resize((size_t)keptCount * size);
+        for (int i = 0; i < keptCount; i++)
+        {
+            const int slot = (m_head + m_count - keptCount + i) % m_window;
+            memcpy(keptFrames.data() + (size_t)i * size, m_frames.data() + (size_t)slot * size, size * sizeof(float));
+        }
+    }
+
+    m_width = width;
+    m_height = height;
+    m_window = window;
+
+    m_frames.resize((size_t)window * size);
+    m_sum.assign(size, 0.0);
+    m_validCount.assign(size, 0);
+
+    m_head = 0;
+    m_count = 0;
+
+    for (int i = 0; i < keptCount; i++)
+    {
+        memcpy(m_frames.data() + (size_t)i * size, keptFrames.data() + (size_t)i * size, size * sizeof(float));
+        addFrame(i);
+        m_count++;
+    }
+}
+
+void TimeDomainSmooth::addFrame(int slot)
+{
+    const int size = m_width * m_height;
+    const float* framePtr = m_frames.data() + (size_t)slot * size;
+    double* sumPtr = m_sum.data();
+    int* countPtr = m_validCount.data();
+
+#pragma omp parallel for
+    for (int i = 0; i < size; i++)
+    {
+        const float v = framePtr[i];
+        const bool valid = v > 0;
+        sumPtr[i] += valid ? v : 0;
+        countPtr[i] += valid;
+    }
+}
+
+void TimeDomainSmooth::removeFrame(int slot)
+{
+    const int size = m_width * m_height;
+    const float* framePtr = m_frames.data() + (size_t)slot * size;
+    double* sumPtr = m_sum.data();
+    int* countPtr = m_validCount.data();
+
+#pragma omp parallel for
+    for (int i = 0; i < size; i++)
+    {
+        const float v = framePtr[i];
+        const bool valid = v > 0;
+        countPtr[i] -= valid;
+        // drop the rounding residue when no valid value is left
+        sumPtr[i] = (countPtr[i] > 0) ? (sumPtr[i] - (valid ? v : 0)) : 0;
+    }
+}
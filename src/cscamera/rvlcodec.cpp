@@ -0,0 +1,496 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "rvlcodec.h"
+
+#include <QDebug>
+#include <string.h>
+#include <limits.h>
+#include <vector>
+
+using namespace cs;
+
+#define RVL_MAGIC "CSRV"
+#define RVL_VERSION 1
+// rows of a band, the bands are encoded and decoded independently
+#define RVL_BAND_ROWS 32
+
+struct RvlHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 width;
+    quint32 height;
+    quint32 bitDepth;
+    quint32 bandCount;
+    // followed by the byte size of each band and the data of the bands
+};
+
+// the nibbles of the values less than this are looked up in a table when encoding
+#define RVL_ENCODE_TABLE_SIZE 4096
+// the values which take 3 nibbles at most are looked up by the leading 12 bits when decoding
+#define RVL_DECODE_TABLE_BITS 12
+
+struct NibbleTables
+{
+    NibbleTables()
+        : encodeCodes(RVL_ENCODE_TABLE_SIZE)
+        , encodeCounts(RVL_ENCODE_TABLE_SIZE)
+        , decodeValues(1 << RVL_DECODE_TABLE_BITS)
+        , decodeCounts(1 << RVL_DECODE_TABLE_BITS)
+    {
+        for (quint32 value = 0; value < RVL_ENCODE_TABLE_SIZE; value++)
+        {
+            quint32 code = 0, remain = value;
+            uchar count = 0;
+            do
+            {
+                quint32 nibble = remain & 0x7;
+                remain >>= 3;
+                if (remain)
+                {
+                    nibble |= 0x8;
+                }
+
+                code = (code << 4) | nibble;
+                count++;
+            } while (remain);
+
+            encodeCodes[value] = code;
+            encodeCounts[value] = count;
+        }
+
+        const int decodeNibbles = RVL_DECODE_TABLE_BITS / 4;
+        for (quint32 index = 0; index < (1u << RVL_DECODE_TABLE_BITS); index++)
+        {
+            quint32 value = 0;
+            decodeCounts[index] = 0;
+            for (int i = 0; i < decodeNibbles; i++)
+            {
+                const quint32 nibble = (index >> (RVL_DECODE_TABLE_BITS - 4 * (i + 1))) & 0xF;
+                value |= (nibble & 0x7) << (3 * i);
+                if (!(nibble & 0x8))
+                {
+                    decodeValues[index] = value;
+                    decodeCounts[index] = i + 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<quint32> encodeCodes;
+    std::vector<uchar> encodeCounts;
+    std::vector<quint32> decodeValues;
+    // 0 if the value takes more nibbles
+    std::vector<uchar> decodeCounts;
+};
+
+static const NibbleTables& nibbleTables()
+{
+    static NibbleTables tables;
+    return tables;
+}
+
+// writes values as nibbles of 3 bits data and a continuation bit, 8 nibbles are packed into a word
+class NibbleWriter
+{
+public:
+    NibbleWriter(quint32* output)
+        : m_begin(output)
+        , m_output(output)
+        , m_buffer(0)
+        , m_bitCount(0)
+        , m_codes(nibbleTables().encodeCodes.data())
+        , m_counts(nibbleTables().encodeCounts.data())
+    {
+
+    }
+
+    inline void write(quint32 value)
+    {
+        if (value < RVL_ENCODE_TABLE_SIZE)
+        {
+            put(m_codes[value], m_counts[value]);
+            return;
+        }
+
+        do
+        {
+            quint32 nibble = value & 0x7;
+            value >>= 3;
+            if (value)
+            {
+                nibble |= 0x8;
+            }
+
+            put(nibble, 1);
+        } while (value);
+    }
+
+    // return the byte size of the written words
+    int finish()
+    {
+        if (m_bitCount > 0)
+        {
+            *m_output++ = (quint32)(m_buffer << (32 - m_bitCount));
+            m_bitCount = 0;
+        }
+
+        return (int)(m_output - m_begin) * sizeof(quint32);
+    }
+private:
+    inline void put(quint32 code, int count)
+    {
+        m_buffer = (m_buffer << (4 * count)) | code;
+        m_bitCount += 4 * count;
+        if (m_bitCount >= 32)
+        {
+            m_bitCount -= 32;
+            *m_output++ = (quint32)(m_buffer >> m_bitCount);
+        }
+    }
+private:
+    quint32* m_begin;
+    quint32* m_output;
+    // the low m_bitCount bits are not written yet
+    quint64 m_buffer;
+    int m_bitCount;
+
+    const quint32* m_codes;
+    const uchar* m_counts;
+};
+
+class NibbleReader
+{
+public:
+    NibbleReader(const quint32* input, const quint32* end)
+        : m_input(input)
+        , m_end(end)
+        , m_buffer(0)
+        , m_bitCount(0)
+        , m_values(nibbleTables().decodeValues.data())
+        , m_counts(nibbleTables().decodeCounts.data())
+    {
+
+    }
+
+    // return false if the data is corrupted
+    inline bool read(quint32& value)
+    {
+        refill();
+
+        const int index = (int)(m_buffer >> (64 - RVL_DECODE_TABLE_BITS));
+        const int bitCount = 4 * m_counts[index];
+        if (bitCount != 0 && bitCount <= m_bitCount)
+        {
+            value = m_values[index];
+            m_buffer <<= bitCount;
+            m_bitCount -= bitCount;
+            return true;
+        }
+
+        value = 0;
+        for (int shift = 0; shift < 32; shift += 3)
+        {
+            if (m_bitCount == 0)
+            {
+                refill();
+                if (m_bitCount == 0)
+                {
+                    return false;
+                }
+            }
+
+            const quint32 nibble = (quint32)(m_buffer >> 60);
+            m_buffer <<= 4;
+            m_bitCount -= 4;
+
+            value |= (nibble & 0x7) << shift;
+            if (!(nibble & 0x8))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+private:
+    inline void refill()
+    {
+        if (m_bitCount <= 32 && m_input < m_end)
+        {
+            m_buffer |= (quint64)*m_input++ << (32 - m_bitCount);
+            m_bitCount += 32;
+        }
+    }
+private:
+    const quint32* m_input;
+    const quint32* m_end;
+    // the high m_bitCount bits are not read yet
+    quint64 m_buffer;
+    int m_bitCount;
+
+    const quint32* m_values;
+    const uchar* m_counts;
+};
+
+template<typename T>
+static int encodeBand(const T* data, int count, quint32* output)
+{
+    NibbleWriter writer(output);
+
+    const T* p = data;
+    const T* end = data + count;
+    int previous = 0;
+
+    while (p < end)
+    {
+        // zero pixels
+        const T* runBegin = p;
+        while (p < end && *p == 0)
+        {
+            p++;
+        }
+        writer.write((quint32)(p - runBegin));
+
+        // valid pixels
+        runBegin = p;
+        while (p < end && *p != 0)
+        {
+            p++;
+        }
+        writer.write((quint32)(p - runBegin));
+
+        for (const T* q = runBegin; q < p; q++)
+        {
+            const int delta = (int)*q - previous;
+            previous = *q;
+
+            // zigzag, small differences of both signs become small numbers
+            writer.write(((quint32)delta << 1) ^ (quint32)(delta >> 31));
+        }
+    }
+
+    return writer.finish();
+}
+
+template<typename T>
+static bool decodeBand(const quint32* input, int wordCount, T* output, int count)
+{
+    NibbleReader reader(input, input + wordCount);
+
+    T* p = output;
+    T* end = output + count;
+    int previous = 0;
+
+    while (p < end)
+    {
+        quint32 zeroCount = 0, validCount = 0;
+        if (!reader.read(zeroCount) || zeroCount > (quint32)(end - p))
+        {
+            return false;
+        }
+
+        memset(p, 0, zeroCount * sizeof(T));
+        p += zeroCount;
+
+        if (!reader.read(validCount) || validCount > (quint32)(end - p))
+        {
+            return false;
+        }
+
+        for (quint32 i = 0; i < validCount; i++)
+        {
+            quint32 value = 0;
+            if (!reader.read(value))
+            {
+                return false;
+            }
+
+            *p = (T)(previous + ((int)(value >> 1) ^ -(int)(value & 1)));
+            previous = *p++;
+        }
+    }
+
+    return true;
+}
+
+template<typename T>
+static bool encodeImage(const T* data, int width, int height, QByteArray& output)
+{
+    if (data == nullptr || width <= 0 || height <= 0)
+    {
+        qWarning() << "invalid image, width : " << width << ", height : " << height;
+        return false;
+    }
+
+    const int bandCount = (height + RVL_BAND_ROWS - 1) / RVL_BAND_ROWS;
+    const size_t bandPixels = (size_t)RVL_BAND_ROWS * width;
+    // a pixel takes 8 nibbles at most
+    const size_t maxBandWords = bandPixels + 1;
+
+    std::vector<quint32> buffer(bandCount * maxBandWords);
+    std::vector<quint32> bandSizes(bandCount);
+
+#pragma omp parallel for
+    for (int band = 0; band < bandCount; band++)
+    {
+        const int rows = qMin(RVL_BAND_ROWS, height - band * RVL_BAND_ROWS);
+        bandSizes[band] = encodeBand(data + band * bandPixels, rows * width, buffer.data() + band * maxBandWords);
+    }
+
+    int outputSize = sizeof(RvlHeader) + bandCount * sizeof(quint32);
+    for (auto size : bandSizes)
+    {
+        outputSize += size;
+    }
+
+    output.resize(outputSize);
+    char* outputPtr = output.data();
+
+    RvlHeader header;
+    memcpy(header.magic, RVL_MAGIC, sizeof(header.magic));
+    header.version = RVL_VERSION;
+    header.width = width;
+    header.height = height;
+    header.bitDepth = sizeof(T) * 8;
+    header.bandCount = bandCount;
+
+    memcpy(outputPtr, &header, sizeof(header));
+    outputPtr += sizeof(header);
+
+    memcpy(outputPtr, bandSizes.data(), bandCount * sizeof(quint32));
+    outputPtr += bandCount * sizeof(quint32);
+
+    for (int band = 0; band < bandCount; band++)
+    {
+        memcpy(outputPtr, buffer.data() + band * maxBandWords, bandSizes[band]);
+        outputPtr += bandSizes[band];
+    }
+
+    return true;
+}
+
+template<typename T>
+static bool decodeImage(const char* data, const quint32* bandSizes, int width, int height, int bandCount, QByteArray& pixData)
+{
+    // offsets of the bands
+    std::vector<const quint32*> bands(bandCount);
+    for (int band = 0; band < bandCount; band++)
+    {
+        bands[band] = (const quint32*)data;
+        data += bandSizes[band];
+    }
+
+    pixData.resize(width * height * sizeof(T));
+    T* pixPtr = (T*)pixData.data();
+
+    const size_t bandPixels = (size_t)RVL_BAND_ROWS * width;
+    int failedCount = 0;
+
+#pragma omp parallel for reduction(+:failedCount)
+    for (int band = 0; band < bandCount; band++)
+    {
+        const int rows = qMin(RVL_BAND_ROWS, height - band * RVL_BAND_ROWS);
+        if (!decodeBand(bands[band], bandSizes[band] / sizeof(quint32), pixPtr + band * bandPixels, rows * width))
+        {
+            failedCount++;
+        }
+    }
+
+    return failedCount == 0;
+}
+
+bool RvlCodec::encode(const ushort* data, int width, int height, QByteArray& output)
+{
+    return encodeImage(data, width, height, output);
+}
+
+bool RvlCodec::encode(const uchar* data, int width, int height, QByteArray& output)
+{
+    return encodeImage(data, width, height, output);
+}
+
+bool RvlCodec::decode(const QByteArray& data, int& width, int& height, int& bitDepth, QByteArray& pixData)
+{
+    RvlHeader header;
+    if (data.size() < (int)sizeof(header))
+    {
+        qWarning() << "decode rvl data failed, invalid size : " << data.size();
+        return false;
+    }
+
+    memcpy(&header, data.constData(), sizeof(header));
+    if (memcmp(header.magic, RVL_MAGIC, sizeof(header.magic)) != 0 || header.version != RVL_VERSION)
+    {
+        qWarning() << "decode rvl data failed, not a rvl data";
+        return false;
+    }
+
+    if ((header.bitDepth != 8 && header.bitDepth != 16) || header.width == 0 || header.height == 0
+        || (quint64)header.width * header.height * (header.bitDepth / 8) > INT_MAX
+        || header.bandCount != (header.height + RVL_BAND_ROWS - 1) / RVL_BAND_ROWS)
+    {
+        qWarning() << "decode rvl data failed, invalid header";
+        return false;
+    }
+
+    const qint64 bandSizesEnd = sizeof(header) + (qint64)header.bandCount * sizeof(quint32);
+    if (data.size() < bandSizesEnd)
+    {
+        qWarning() << "decode rvl data failed, invalid size : " << data.size();
+        return false;
+    }
+
+    // the band data is aligned to words
+    const quint32* bandSizes = (const quint32*)(data.constData() + sizeof(header));
+    qint64 dataSize = bandSizesEnd;
+    for (quint32 band = 0; band < header.bandCount; band++)
+    {
+        if (bandSizes[band] % sizeof(quint32) != 0)
+        {
+            qWarning() << "decode rvl data failed, invalid band size : " << bandSizes[band];
+            return false;
+        }
+        dataSize += bandSizes[band];
+    }
+
+    if (data.size() < dataSize)
+    {
+        qWarning() << "decode rvl data failed, invalid size : " << data.size();
+        return false;
+    }
+
+    width = header.width;
+    height = header.height;
+    bitDepth = header.bitDepth;
+
+    const char* bandData = data.constData() + bandSizesEnd;
+    bool result = (bitDepth == 16) ? decodeImage<ushort>(bandData, bandSizes, width, height, header.bandCount, pixData)
+        : decodeImage<uchar>(bandData, bandSizes, width, height, header.bandCount, pixData);
+
+    if (!result)
+    {
+        qWarning() << "decode rvl data failed, the data is corrupted";
+    }
+
+    return result;
+}
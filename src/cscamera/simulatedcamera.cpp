@@ -0,0 +1,1419 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "simulatedcamera.h"
+#include "capturedzipparser.h"
+#include "pipelinestats.h"
+
+#include <QDebug>
+#include <QSize>
+#include <QBuffer>
+#include <QImage>
+#include <QRectF>
+#include <QCoreApplication>
+#include <QtMath>
+#include <string.h>
+#include <cstracer.h>
+
+using namespace cs;
+using namespace cs::parameter;
+
+// the maximum size of the cached source frames
+#define FRAME_CACHE_MAX_SIZE (512 * 1024 * 1024)
+// the distance between the IR cameras of the synthetic scene, mm
+#define SYNTHETIC_BASELINE  50.0f
+
+struct SimulatedRange
+{
+    float min;
+    float max;
+    float step;
+};
+
+static CSRange CAMERA_HDR_LEVEL_RANGE = { 2, 8 };
+
+static const QMap<int, const char*> STREAM_FORMAT_MAP =
+{
+    { STREAM_FORMAT_MJPG,    "MJPG" },
+    { STREAM_FORMAT_RGB8,    "RGB8" },
+    { STREAM_FORMAT_Z16,     "Z16" },
+    { STREAM_FORMAT_Z16Y8Y8, "Z16Y8Y8" },
+    { STREAM_FORMAT_PAIR,    "PAIR" },
+};
+
+// the texts are translated in the context of CSCamera
+static const QMap<int, const char*> AUTO_EXPOSURE_MODE_MAP =
+{
+    { AUTO_EXPOSURE_MODE_CLOSE,             QT_TRANSLATE_NOOP("cs::CSCamera", "Close")},
+    { AUTO_EXPOSURE_MODE_FIX_FRAMETIME,     QT_TRANSLATE_NOOP("cs::CSCamera", "Speed First")},
+    { AUTO_EXPOSURE_MODE_HIGH_QUALITY,      QT_TRANSLATE_NOOP("cs::CSCamera", "Quality First")},
+    { AUTO_EXPOSURE_MODE_FORE_GROUND,       QT_TRANSLATE_NOOP("cs::CSCamera", "Foreground")},
+};
+
+static const QMap<int, const char*> FILTER_TYPE_MAP =
+{
+    { FILTER_CLOSE,      QT_TRANSLATE_NOOP("cs::CSCamera", "Close")},
+    { FILTER_SMOOTH,     QT_TRANSLATE_NOOP("cs::CSCamera", "Smooth")},
+    { FILTER_MEDIAN,     QT_TRANSLATE_NOOP("cs::CSCamera", "Median")},
+    { FILTER_TDSMOOTH,   QT_TRANSLATE_NOOP("cs::CSCamera", "TDSmooth")},
+};
+
+static const QMap<int, CSRange> FILTER_RANGE_MAP =
+{
+    { FILTER_CLOSE,      { 0, 0 }},
+    { FILTER_SMOOTH,     { 3, 9 }},
+    { FILTER_MEDIAN,     { 3, 5 }},
+    { FILTER_TDSMOOTH,   { 3, 7 }},
+};
+
+static const QMap<int, const char*> CAMERA_HDR_MAP =
+{
+    { HDR_MODE_CLOSE,       QT_TRANSLATE_NOOP("cs::CSCamera", "Close") },
+    { HDR_MODE_SHINE,       QT_TRANSLATE_NOOP("cs::CSCamera", "Shiny") },
+    { HDR_MODE_DARK,        QT_TRANSLATE_NOOP("cs::CSCamera", "Dark") },
+    { HDR_MODE_BOTH,        QT_TRANSLATE_NOOP("cs::CSCamera", "Both") },
+    { HDR_MODE_MANUAL,      QT_TRANSLATE_NOOP("cs::CSCamera", "Manual") },
+};
+
+// the ranges of the properties which are read from the device by CSCamera
+static const QMap<CAMERA_PARA_ID, SimulatedRange> PROPERTY_RANGE_MAP =
+{
+    { PARA_DEPTH_GAIN,              { 1.0f, 16.0f, 1.0f } },
+    { PARA_DEPTH_EXPOSURE,          { 1000.0f, 65000.0f, 100.0f } },
+    { PARA_DEPTH_FRAMETIME,         { 3000.0f, 100000.0f, 100.0f } },
+    { PARA_DEPTH_THRESHOLD,         { 0.0f, 40.0f, 1.0f } },
+    { PARA_RGB_GAIN,                { 1.0f, 16.0f, 1.0f } },
+    { PARA_RGB_EXPOSURE,            { 1.0f, 10000.0f, 1.0f } },
+    { PARA_RGB_WHITE_BALANCE,       { 2800.0f, 6500.0f, 100.0f } },
+};
+
+static const QList<QSize> DEPTH_RESOLUTIONS = { QSize(640, 400), QSize(320, 200) };
+static const QList<QSize> RGB_RESOLUTIONS = { QSize(1280, 800), QSize(640, 400) };
+
+// the same as the default stream type and parameters of CSCamera
+static const QMap<CAMERA_PARA_ID, QVariant> CAMERA_DEFAULT_STREAM_TYPE =
+{
+    { PARA_DEPTH_STREAM_FORMAT,   (int)STREAM_FORMAT_Z16 },
+    { PARA_DEPTH_RESOLUTION,      QSize(640, 400) },
+    { PARA_RGB_STREAM_FORMAT,     (int)STREAM_FORMAT_RGB8 },
+    { PARA_RGB_RESOLUTION,        QSize(1280, 800) },
+};
+
+static const QMap<CAMERA_PARA_ID, QVariant> CAMERA_DEFAULT_PARA_VALUE =
+{
+    { PARA_DEPTH_RANGE,          QVariant::fromValue(QPair<float, float>({ 50.0f, 2000.0f })) },
+    { PARA_DEPTH_GAIN,           1.0f },
+    { PARA_DEPTH_EXPOSURE,       7000.0f },
+    { PARA_TRIGGER_MODE,         (int)TRIGGER_MODE_OFF}
+};
+
+static Intrinsics genIntrinsics(int width, int height, float focal)
+{
+    Intrinsics intrinsics;
+    memset(&intrinsics, 0, sizeof(intrinsics));
+
+    intrinsics.width = width;
+    intrinsics.height = height;
+    intrinsics.fx = focal;
+    intrinsics.fy = focal;
+    intrinsics.cx = width / 2.0f;
+    intrinsics.cy = height / 2.0f;
+    intrinsics.one22 = 1.0f;
+
+    return intrinsics;
+}
+
+// the distance along z to the synthetic scene, a sphere moves in front of a tilted plane
+static float traceScene(float dx, float dy, double timeStamp, bool& onSphere, float& shade)
+{
+    const float radius = 120.0f;
+    const float centerX = 150.0f * qSin(2 * M_PI * timeStamp / 4000.0);
+    const float centerY = 0.0f;
+    const float centerZ = 600.0f;
+
+    // the ray is (dx, dy, 1) * t
+    const float a = dx * dx + dy * dy + 1.0f;
+    const float b = dx * centerX + dy * centerY + centerZ;
+    const float c = centerX * centerX + centerY * centerY + centerZ * centerZ - radius * radius;
+    const float disc = b * b - a * c;
+
+    if (disc >= 0.0f)
+    {
+        const float t = (b - qSqrt(disc)) / a;
+        onSphere = true;
+        shade = qBound(0.0f, (centerZ - t) / radius, 1.0f);
+        return t;
+    }
+
+    // plane : z = 900 + 0.25 * y
+    onSphere = false;
+    shade = 1.0f;
+    return 900.0f / (1.0f - 0.25f * dy);
+}
+
+static int hashPixel(int x, int y)
+{
+    uint h = (uint)x * 73856093u ^ (uint)y * 19349663u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    return (h >> 16) & 0xff;
+}
+
+SimulatedCameraConfig SimulatedCameraConfig::fromString(QString str)
+{
+    SimulatedCameraConfig config;
+
+    for (const auto& item : str.split(";", QString::SkipEmptyParts))
+    {
+        const int pos = item.indexOf("=");
+        if (pos < 0)
+        {
+            // a single value is the captured file
+            const QString value = item.trimmed();
+            config.sourceFile = (value == "synthetic") ? "" : value;
+            continue;
+        }
+
+        const QString key = item.left(pos).trimmed().toLower();
+        const QString value = item.mid(pos + 1).trimmed();
+
+        if (key == "file")
+        {
+            config.sourceFile = value;
+        }
+        else if (key == "fps")
+        {
+            config.fps = value.toFloat();
+        }
+        else if (key == "jitter")
+        {
+            config.jitter = value.toInt();
+        }
+        else if (key == "drop")
+        {
+            config.dropRate = value.toFloat();
+        }
+        else if (key == "seed")
+        {
+            config.seed = value.toUInt();
+        }
+        else if (key == "rgb")
+        {
+            config.hasRgb = (value != "0");
+        }
+        else
+        {
+            qWarning() << "unknown config of simulated camera : " << key;
+        }
+    }
+
+    return config;
+}
+
+SimulatedCamera::StreamThread::StreamThread(SimulatedCamera& camera)
+    : m_camera(camera)
+{
+    setObjectName("SimulatedStreamThread");
+}
+
+SimulatedCamera::StreamThread::~StreamThread()
+{
+    requestInterruption();
+    wait();
+    qDebug() << "~SimulatedStreamThread";
+}
+
+void SimulatedCamera::StreamThread::run()
+{
+    const SimulatedCameraConfig& config = m_camera.m_config;
+    const double interval = 1000.0 / qMax(config.fps, 0.1f);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 scheduledCount = 0;
+    int droppedCount = 0;
+    while (!isInterruptionRequested())
+    {
+        // the frames are due at a fixed rate, the jitter delays one frame but not the next ones
+        const int jitter = (config.jitter > 0) ? m_camera.m_random.bounded(config.jitter + 1) : 0;
+        const qint64 due = qRound64(scheduledCount * interval) + jitter;
+        scheduledCount++;
+
+        qint64 remaining = due - timer.elapsed();
+        while (remaining > 0 && !isInterruptionRequested())
+        {
+            QThread::msleep(qMin(remaining, (qint64)10));
+            remaining = due - timer.elapsed();
+        }
+
+        if (isInterruptionRequested())
+        {
+            break;
+        }
+
+        // skip the frames which are too late, as a camera does when the frames are not fetched in time
+        if (-remaining > interval)
+        {
+            const qint64 lateCount = qint64(-remaining / interval);
+            scheduledCount += lateCount;
+            m_camera.m_frameIndex += lateCount;
+        }
+
+        const int frameIndex = m_camera.m_frameIndex++;
+        if (config.dropRate > 0.0f && m_camera.m_random.generateDouble() < config.dropRate)
+        {
+            droppedCount++;
+            continue;
+        }
+
+        FrameData frameData;
+        if (m_camera.genFrame(frameIndex, frameData))
+        {
+            frameData.receivedTime = PipelineStats::now();
+            CS_TRACE_INSTANT_FRAME("frame received", frameData.receivedTime);
+            emit m_camera.framedDataUpdated(frameData);
+        }
+    }
+
+    if (droppedCount > 0)
+    {
+        qInfo() << "simulated camera dropped " << droppedCount << " frames";
+    }
+}
+
+SimulatedCamera::SimulatedCamera(const SimulatedCameraConfig& config)
+    : m_config(config)
+    , m_cameraState(CAMERA_DISCONNECTED)
+    , m_parser(nullptr)
+    , m_sourceFrameCount(0)
+    , m_isDepthStreamSup(false)
+    , m_isRgbStreamSup(false)
+    , m_depthScale(0.1f)
+    , m_frameCacheSize(0)
+    , m_frameCacheVersion(0)
+    , m_frameIndex(0)
+    , m_random(config.seed)
+    , m_streamThread(new StreamThread(*this))
+    , m_cameraThread(nullptr)
+{
+    memset(&m_depthIntrinsics, 0, sizeof(m_depthIntrinsics));
+    memset(&m_rgbIntrinsics, 0, sizeof(m_rgbIntrinsics));
+    memset(&m_extrinsics, 0, sizeof(m_extrinsics));
+
+    initCameraInfo();
+}
+
+SimulatedCamera::~SimulatedCamera()
+{
+    stopStreamThread();
+    delete m_streamThread;
+    delete m_parser;
+    qDebug() << "~SimulatedCamera";
+}
+
+bool SimulatedCamera::connectCamera()
+{
+    qInfo() << "connect simulated camera, source : " << (m_config.sourceFile.isEmpty() ? "synthetic" : m_config.sourceFile);
+
+    setCameraState(CAMERA_CONNECTING);
+
+    if (!loadSource())
+    {
+        setCameraState(CAMERA_CONNECTFAILED);
+        return false;
+    }
+
+    initStreamInfos();
+    initDefaultPara();
+    initCameraInfo();
+
+    setCameraState(CAMERA_CONNECTED);
+
+    return true;
+}
+
+bool SimulatedCamera::reconnectCamera()
+{
+    qInfo() << "SimulatedCamera, begin reconnect camera";
+    bool result = connectCamera();
+    qInfo() << "SimulatedCamera, reconnect camera end";
+
+    return result;
+}
+
+bool SimulatedCamera::disconnectCamera()
+{
+    qInfo() << "SimulatedCamera, begin disconenct camera";
+    if (getCameraState() == CAMERA_STARTED_STREAM || getCameraState() == CAMERA_PAUSED_STREAM)
+    {
+        stopStream();
+    }
+
+    setCameraState(CAMERA_DISCONNECTING);
+
+    m_isDepthStreamSup = false;
+    m_isRgbStreamSup = false;
+
+    setCameraState(CAMERA_DISCONNECTED);
+    qInfo() << "SimulatedCamera, disconenct camera end";
+
+    return true;
+}
+
+// the camera is connected again by CameraThread after restarting
+bool SimulatedCamera::restartCamera()
+{
+    qInfo() << "SimulatedCamera: restart camera";
+    setCameraState(CAMERA_RESTARTING_CAMERA);
+
+    stopStreamThread();
+
+    return true;
+}
+
+bool SimulatedCamera::startStream()
+{
+    setCameraState(CAMERA_STARTING_STREAM);
+
+    if (!m_isDepthStreamSup && !m_isRgbStreamSup)
+    {
+        qWarning("Error : start stream failed, the simulated camera has no stream.");
+        setCameraState(CAMERA_START_STREAM_FAILED);
+        return false;
+    }
+
+    // set default para
+    for (auto key : CAMERA_DEFAULT_PARA_VALUE.keys())
+    {
+        setCameraPara(key, CAMERA_DEFAULT_PARA_VALUE.value(key));
+    }
+
+    m_frameIndex = 0;
+    m_random.seed(m_config.seed);
+    m_streamTimer.start();
+
+    startStreamThread();
+
+    setCameraState(CAMERA_STARTED_STREAM);
+
+    return true;
+}
+
+bool SimulatedCamera::stopStream()
+{
+    stopStreamThread();
+
+    setCameraState(CAMERA_STOPPED_STREAM);
+    return true;
+}
+
+bool SimulatedCamera::restartStream()
+{
+    qInfo() << "begin restart stream.";
+
+    bool result = stopStream();
+    result &= startStream();
+
+    qDebug() << "restartStream end!";
+    return result;
+}
+
+bool SimulatedCamera::pauseStream()
+{
+    if (getCameraState() != CAMERA_STARTED_STREAM) {
+        qInfo() << "please pause stream latter, state = " << getCameraState();
+        return false;
+    }
+
+    stopStreamThread();
+    setCameraState(CAMERA_PAUSED_STREAM);
+
+    return true;
+}
+
+bool SimulatedCamera::resumeStream()
+{
+    if (getCameraState() != CAMERA_PAUSED_STREAM) {
+        qInfo() << "please resume stream latter, state = " << getCameraState();
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const bool isSoftTrigger = (m_paras.value(PARA_TRIGGER_MODE).toInt() == TRIGGER_MODE_SOFTWAER);
+    locker.unlock();
+
+    if (!isSoftTrigger)
+    {
+        startStreamThread();
+    }
+    setCameraState(CAMERA_STARTED_STREAM);
+
+    return true;
+}
+
+bool SimulatedCamera::softTrigger()
+{
+    if (getCameraState() != CAMERA_STARTED_STREAM)
+    {
+        qWarning() << "soft trigger failed, stream not started.";
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const int filterType = m_paras.value(PARA_DEPTH_FILTER_TYPE).toInt();
+    const int frameCount = (filterType == FILTER_TDSMOOTH) ? m_paras.value(PARA_DEPTH_FILTER).toInt() : 1;
+    locker.unlock();
+
+    // the frames of time domain smooth are notified together, the same as CSCamera
+    FrameData frameData;
+    for (int i = 0; i < frameCount; i++)
+    {
+        FrameData triggeredFrame;
+        if (genFrame(m_frameIndex++, triggeredFrame))
+        {
+            frameData.rgbIntrinsics = triggeredFrame.rgbIntrinsics;
+            frameData.depthIntrinsics = triggeredFrame.depthIntrinsics;
+            frameData.extrinsics = triggeredFrame.extrinsics;
+            frameData.depthScale = triggeredFrame.depthScale;
+            frameData.data.append(triggeredFrame.data);
+        }
+    }
+
+    if (frameData.data.size() > 0)
+    {
+        frameData.receivedTime = PipelineStats::now();
+        CS_TRACE_INSTANT_FRAME("frame received", frameData.receivedTime);
+        emit framedDataUpdated(frameData);
+    }
+
+    return frameData.data.size() > 0;
+}
+
+void SimulatedCamera::setCameraThread(QThread* thread)
+{
+    m_cameraThread = thread;
+    Q_ASSERT(m_cameraThread);
+
+    moveToThread(m_cameraThread);
+}
+
+CSCameraInfo SimulatedCamera::getCameraInfo() const
+{
+    return m_cameraInfo;
+}
+
+int SimulatedCamera::getCameraState() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cameraState;
+}
+
+void SimulatedCamera::setCameraState(CAMERA_STATE state)
+{
+    m_mutex.lock();
+    m_cameraState = state;
+    m_mutex.unlock();
+
+    emit cameraStateChanged(state);
+}
+
+bool SimulatedCamera::loadSource()
+{
+    if (m_config.sourceFile.isEmpty())
+    {
+        m_isDepthStreamSup = true;
+        m_isRgbStreamSup = m_config.hasRgb;
+
+        m_depthIntrinsics = genIntrinsics(640, 400, 520.0f);
+        m_rgbIntrinsics = genIntrinsics(1280, 800, 1040.0f);
+
+        // the RGB camera is at the same position as the depth camera
+        memset(&m_extrinsics, 0, sizeof(m_extrinsics));
+        m_extrinsics.rotation[0] = 1.0f;
+        m_extrinsics.rotation[4] = 1.0f;
+        m_extrinsics.rotation[8] = 1.0f;
+        m_depthScale = 0.1f;
+
+        return true;
+    }
+
+    delete m_parser;
+    m_parser = new CapturedZipParser(m_config.sourceFile);
+
+    if (!m_parser->checkFileValid() || !m_parser->parseCaptureInfo())
+    {
+        qWarning() << "load simulated camera source failed, file : " << m_config.sourceFile;
+        delete m_parser;
+        m_parser = nullptr;
+        return false;
+    }
+
+    m_sourceFrameCount = m_parser->getFrameCount();
+    m_sourceDataTypes = m_parser->getDataTypes();
+
+    const bool hasIr = m_sourceDataTypes.contains(CAMERA_DATA_L) && m_sourceDataTypes.contains(CAMERA_DATA_R);
+    m_isDepthStreamSup = m_sourceDataTypes.contains(CAMERA_DATA_DEPTH) || hasIr;
+    m_isRgbStreamSup = m_sourceDataTypes.contains(CAMERA_DATA_RGB);
+
+    if (m_sourceFrameCount <= 0 || (!m_isDepthStreamSup && !m_isRgbStreamSup))
+    {
+        qWarning() << "no frame to replay, file : " << m_config.sourceFile;
+        delete m_parser;
+        m_parser = nullptr;
+        return false;
+    }
+
+    m_depthIntrinsics = m_parser->getIntrinsics(CAMERA_DATA_DEPTH);
+    m_rgbIntrinsics = m_parser->getIntrinsics(CAMERA_DATA_RGB);
+    m_extrinsics = m_parser->getExtrinsics();
+    m_depthScale = m_parser->getDepthScale();
+
+    m_frameCache.clear();
+    m_frameCacheSize = 0;
+
+    return true;
+}
+
+CameraInfo SimulatedCamera::genCameraInfo()
+{
+    CameraInfo info;
+    memset(&info, 0, sizeof(info));
+    strncpy(info.name, "Simulated", sizeof(info.name) - 1);
+    strncpy(info.serial, SIMULATED_CAMERA_SERIAL, sizeof(info.serial) - 1);
+    strncpy(info.uniqueId, SIMULATED_CAMERA_SERIAL, sizeof(info.uniqueId) - 1);
+
+    return info;
+}
+
+void SimulatedCamera::initCameraInfo()
+{
+    m_cameraInfo.cameraInfo = genCameraInfo();
+    m_cameraInfo.model = "Simulated";
+    m_cameraInfo.connectType = CONNECT_TYPE_USB;
+    m_cameraInfo.sdkVersion = "";
+}
+
+void SimulatedCamera::initStreamInfos()
+{
+    m_depthStreamInfos.clear();
+    m_rgbStreamInfos.clear();
+
+    QList<STREAM_FORMAT> depthFormats = { STREAM_FORMAT_Z16, STREAM_FORMAT_Z16Y8Y8, STREAM_FORMAT_PAIR };
+    QList<QSize> depthResolutions = DEPTH_RESOLUTIONS;
+    QList<QSize> rgbResolutions = RGB_RESOLUTIONS;
+
+    // the captured frames are replayed in the captured resolution
+    if (m_parser)
+    {
+        depthResolutions = { m_parser->getResolution(CAMERA_DATA_DEPTH) };
+        rgbResolutions = { m_parser->getResolution(CAMERA_DATA_RGB) };
+
+        // only the IR images are captured
+        if (!m_sourceDataTypes.contains(CAMERA_DATA_DEPTH))
+        {
+            depthFormats = { STREAM_FORMAT_PAIR };
+        }
+    }
+
+    if (m_isDepthStreamSup)
+    {
+        for (auto format : depthFormats)
+        {
+            for (const auto& res : depthResolutions)
+            {
+                m_depthStreamInfos.push_back({ format, res.width(), res.height(), m_config.fps });
+            }
+        }
+    }
+
+    if (m_isRgbStreamSup)
+    {
+        for (auto format : { STREAM_FORMAT_RGB8, STREAM_FORMAT_MJPG })
+        {
+            for (const auto& res : rgbResolutions)
+            {
+                m_rgbStreamInfos.push_back({ format, res.width(), res.height(), m_config.fps });
+            }
+        }
+    }
+}
+
+void SimulatedCamera::initDefaultPara()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_paras.clear();
+
+    // default stream, the first stream is used if not find the default one
+    auto findStreamInfo = [](const QList<StreamInfo>& infos, STREAM_FORMAT format, QSize res) -> StreamInfo
+    {
+        StreamInfo result = infos.first();
+        for (const auto& info : infos)
+        {
+            if (info.format == format && info.width == res.width() && info.height == res.height())
+            {
+                return info;
+            }
+        }
+
+        return result;
+    };
+
+    if (m_isDepthStreamSup)
+    {
+        auto info = findStreamInfo(m_depthStreamInfos, (STREAM_FORMAT)CAMERA_DEFAULT_STREAM_TYPE[PARA_DEPTH_STREAM_FORMAT].toInt()
+            , CAMERA_DEFAULT_STREAM_TYPE[PARA_DEPTH_RESOLUTION].toSize());
+        m_paras[PARA_DEPTH_STREAM_FORMAT] = (int)info.format;
+        m_paras[PARA_DEPTH_RESOLUTION] = QSize(info.width, info.height);
+    }
+
+    if (m_isRgbStreamSup)
+    {
+        auto info = findStreamInfo(m_rgbStreamInfos, (STREAM_FORMAT)CAMERA_DEFAULT_STREAM_TYPE[PARA_RGB_STREAM_FORMAT].toInt()
+            , CAMERA_DEFAULT_STREAM_TYPE[PARA_RGB_RESOLUTION].toSize());
+        m_paras[PARA_RGB_STREAM_FORMAT] = (int)info.format;
+        m_paras[PARA_RGB_RESOLUTION] = QSize(info.width, info.height);
+    }
+
+    HdrExposureSetting hdrSetting;
+    memset(&hdrSetting, 0, sizeof(hdrSetting));
+
+    CameraIpSetting ipSetting;
+    memset(&ipSetting, 0, sizeof(ipSetting));
+
+    // depth
+    m_paras[PARA_TRIGGER_MODE] = (int)TRIGGER_MODE_OFF;
+    m_paras[PARA_CAMERA_IP] = QVariant::fromValue(ipSetting);
+    m_paras[PARA_DEPTH_RANGE] = CAMERA_DEFAULT_PARA_VALUE[PARA_DEPTH_RANGE];
+    m_paras[PARA_DEPTH_GAIN] = CAMERA_DEFAULT_PARA_VALUE[PARA_DEPTH_GAIN];
+    m_paras[PARA_DEPTH_EXPOSURE] = CAMERA_DEFAULT_PARA_VALUE[PARA_DEPTH_EXPOSURE];
+    m_paras[PARA_DEPTH_FRAMETIME] = 9000.0f;
+    m_paras[PARA_DEPTH_THRESHOLD] = 0;
+    m_paras[PARA_DEPTH_FILTER_TYPE] = (int)FILTER_CLOSE;
+    m_paras[PARA_DEPTH_FILTER] = 0;
+    m_paras[PARA_DEPTH_AUTO_EXPOSURE] = (int)AUTO_EXPOSURE_MODE_CLOSE;
+    m_paras[PARA_DEPTH_FILL_HOLE] = false;
+    m_paras[PARA_DEPTH_HDR_MODE] = (int)HDR_MODE_CLOSE;
+    m_paras[PARA_DEPTH_HDR_LEVEL] = CAMERA_HDR_LEVEL_RANGE.min;
+    m_paras[PARA_DEPTH_HDR_SETTINGS] = QVariant::fromValue(hdrSetting);
+    m_paras[PARA_DEPTH_ROI] = QRectF(0.0, 0.0, 1.0, 1.0);
+
+    // rgb
+    m_paras[PARA_RGB_GAIN] = 1.0f;
+    m_paras[PARA_RGB_EXPOSURE] = 1000.0f;
+    m_paras[PARA_RGB_AUTO_EXPOSURE] = 1.0f;
+    m_paras[PARA_RGB_WHITE_BALANCE] = 4600.0f;
+    m_paras[PARA_RGB_AUTO_WHITE_BALANCE] = 1.0f;
+}
+
+void SimulatedCamera::getCameraPara(CAMERA_PARA_ID paraId, QVariant& value)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto depthFormat = (STREAM_FORMAT)m_paras.value(PARA_DEPTH_STREAM_FORMAT).toInt();
+
+    switch (paraId)
+    {
+    case PARA_HAS_RGB:
+        value = m_isRgbStreamSup;
+        break;
+    case PARA_HAS_DEPTH:
+        value = m_isDepthStreamSup && (depthFormat != STREAM_FORMAT_PAIR);
+        break;
+    case PARA_DEPTH_HAS_IR:
+        value = m_isDepthStreamSup && ((depthFormat == STREAM_FORMAT_Z16Y8Y8) || (depthFormat == STREAM_FORMAT_PAIR));
+        break;
+    case PARA_DEPTH_SCALE:
+        value = m_depthScale;
+        break;
+    case PARA_DEPTH_INTRINSICS:
+        value = QVariant::fromValue(m_depthIntrinsics);
+        break;
+    case PARA_RGB_INTRINSICS:
+        value = QVariant::fromValue(m_rgbIntrinsics);
+        break;
+    case PARA_EXTRINSICS:
+        value = QVariant::fromValue(m_extrinsics);
+        break;
+    default:
+        if (m_paras.contains(paraId))
+        {
+            value = m_paras.value(paraId);
+        }
+        else
+        {
+            qDebug() << "unknow camera para : " << paraId;
+        }
+        break;
+    }
+}
+
+void SimulatedCamera::setCameraPara(CAMERA_PARA_ID paraId, QVariant value)
+{
+    switch (paraId)
+    {
+    case PARA_HAS_RGB:
+    case PARA_HAS_DEPTH:
+    case PARA_DEPTH_HAS_IR:
+    case PARA_DEPTH_SCALE:
+    case PARA_DEPTH_INTRINSICS:
+    case PARA_RGB_INTRINSICS:
+    case PARA_EXTRINSICS:
+        qDebug() << "the camera para is read only : " << paraId;
+        return;
+    case PARA_DEPTH_STREAM_FORMAT:
+        setFormat(STREAM_TYPE_DEPTH, (STREAM_FORMAT)value.toInt());
+        return;
+    case PARA_RGB_STREAM_FORMAT:
+        setFormat(STREAM_TYPE_RGB, (STREAM_FORMAT)value.toInt());
+        return;
+    case PARA_DEPTH_FILTER_TYPE:
+        setFilterType(value.toInt());
+        return;
+    case PARA_DEPTH_RESOLUTION:
+    case PARA_RGB_RESOLUTION:
+    {
+        m_mutex.lock();
+        const bool changed = (m_paras.value(paraId).toSize() != value.toSize());
+        m_mutex.unlock();
+
+        if (!changed)
+        {
+            return;
+        }
+
+        updateStreamType();
+
+        m_mutex.lock();
+        m_paras[paraId] = value.toSize();
+        m_frameCache.clear();
+        m_frameCacheSize = 0;
+        m_frameCacheVersion++;
+        m_mutex.unlock();
+        break;
+    }
+    case PARA_DEPTH_FILTER:
+    {
+        QMutexLocker locker(&m_mutex);
+        const CSRange range = FILTER_RANGE_MAP[m_paras.value(PARA_DEPTH_FILTER_TYPE).toInt()];
+        value = qBound(range.min, value.toInt(), range.max);
+        m_paras[paraId] = value;
+        break;
+    }
+    case PARA_DEPTH_EXPOSURE:
+    {
+        // update frame time before set exposure
+        const float moreTime = 2000; // us
+        setCameraPara(PARA_DEPTH_FRAMETIME, value.toFloat() + moreTime);
+
+        QMutexLocker locker(&m_mutex);
+        m_paras[paraId] = value;
+        break;
+    }
+    case PARA_TRIGGER_MODE:
+        m_mutex.lock();
+        m_paras[paraId] = value;
+        m_mutex.unlock();
+
+        onTriggerModeChanged(value.toInt() == TRIGGER_MODE_SOFTWAER);
+        break;
+    default:
+    {
+        QMutexLocker locker(&m_mutex);
+        m_paras[paraId] = value;
+        break;
+    }
+    }
+
+    emit cameraParaUpdated(paraId, value);
+}
+
+void SimulatedCamera::getCameraParaRange(CAMERA_PARA_ID paraId, QVariant& min, QVariant& max, QVariant& step)
+{
+    switch (paraId)
+    {
+    case PARA_DEPTH_RANGE:
+        min = 0;
+        max = qRound(65535 * m_depthScale);
+        step = 1;
+        break;
+    case PARA_DEPTH_FILTER:
+    {
+        QMutexLocker locker(&m_mutex);
+        const CSRange range = FILTER_RANGE_MAP[m_paras.value(PARA_DEPTH_FILTER_TYPE).toInt()];
+        min = range.min;
+        max = range.max;
+        step = 1;
+        break;
+    }
+    case PARA_DEPTH_HDR_LEVEL:
+        min = CAMERA_HDR_LEVEL_RANGE.min;
+        max = CAMERA_HDR_LEVEL_RANGE.max;
+        step = 1;
+        break;
+    default:
+        if (PROPERTY_RANGE_MAP.contains(paraId))
+        {
+            const SimulatedRange range = PROPERTY_RANGE_MAP.value(paraId);
+            min = range.min;
+            max = range.max;
+            step = range.step;
+        }
+        break;
+    }
+}
+
+void SimulatedCamera::getCameraParaItems(CAMERA_PARA_ID paraId, QList<QPair<QString, QVariant>>& list)
+{
+    switch (paraId)
+    {
+    case PARA_DEPTH_STREAM_FORMAT:
+        getFormats(STREAM_TYPE_DEPTH, list);
+        break;
+    case PARA_DEPTH_RESOLUTION:
+        getResolutions(STREAM_TYPE_DEPTH, list);
+        break;
+    case PARA_RGB_STREAM_FORMAT:
+        getFormats(STREAM_TYPE_RGB, list);
+        break;
+    case PARA_RGB_RESOLUTION:
+        getResolutions(STREAM_TYPE_RGB, list);
+        break;
+    case PARA_DEPTH_AUTO_EXPOSURE:
+        for (auto mode : AUTO_EXPOSURE_MODE_MAP.keys())
+        {
+            list.push_back({ QCoreApplication::translate("cs::CSCamera", AUTO_EXPOSURE_MODE_MAP[mode]), mode });
+        }
+        break;
+    case PARA_DEPTH_FILTER_TYPE:
+        for (auto type : FILTER_TYPE_MAP.keys())
+        {
+            list.push_back({ QCoreApplication::translate("cs::CSCamera", FILTER_TYPE_MAP[type]), type });
+        }
+        break;
+    case PARA_DEPTH_HDR_MODE:
+        for (auto mode : CAMERA_HDR_MAP.keys())
+        {
+            list.push_back({ QCoreApplication::translate("cs::CSCamera", CAMERA_HDR_MAP[mode]), mode });
+        }
+        break;
+    case PARA_DEPTH_HDR_LEVEL:
+        for (int i = CAMERA_HDR_LEVEL_RANGE.min; i <= CAMERA_HDR_LEVEL_RANGE.max; i++)
+        {
+            list.push_back({ QString::number(i), i });
+        }
+        break;
+    case PARA_DEPTH_GAIN:
+    case PARA_RGB_GAIN:
+    {
+        const SimulatedRange range = PROPERTY_RANGE_MAP.value(paraId);
+        for (int i = range.min; i <= range.max; i++)
+        {
+            list.push_back({ QString::number(i), i });
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void SimulatedCamera::getFormats(STREAM_TYPE sType, QList<QPair<QString, QVariant>>& formats) const
+{
+    const auto& streamInfos = (sType == STREAM_TYPE_DEPTH) ? m_depthStreamInfos : m_rgbStreamInfos;
+    for (const auto& info : streamInfos)
+    {
+        QPair<QString, QVariant> pair(STREAM_FORMAT_MAP[info.format], info.format);
+        if (!formats.contains(pair))
+        {
+            formats.push_back(pair);
+        }
+    }
+}
+
+void SimulatedCamera::getResolutions(STREAM_TYPE sType, QList<QPair<QString, QVariant>>& resolutions) const
+{
+    const auto& streamInfos = (sType == STREAM_TYPE_DEPTH) ? m_depthStreamInfos : m_rgbStreamInfos;
+
+    m_mutex.lock();
+    const int dstFormat = m_paras.value((sType == STREAM_TYPE_DEPTH) ? PARA_DEPTH_STREAM_FORMAT : PARA_RGB_STREAM_FORMAT).toInt();
+    m_mutex.unlock();
+
+    for (const auto& info : streamInfos)
+    {
+        if (info.format != dstFormat)
+        {
+            continue;
+        }
+
+        QString resStr = QString("%1x%2").arg(info.width).arg(info.height);
+        QPair<QString, QVariant> pair(resStr, QSize(info.width, info.height));
+
+        if (!resolutions.contains(pair))
+        {
+            resolutions.push_back(pair);
+        }
+    }
+}
+
+void SimulatedCamera::setFormat(STREAM_TYPE sType, STREAM_FORMAT format)
+{
+    const CAMERA_PARA_ID formatId = (sType == STREAM_TYPE_DEPTH) ? PARA_DEPTH_STREAM_FORMAT : PARA_RGB_STREAM_FORMAT;
+    const CAMERA_PARA_ID resolutionId = (sType == STREAM_TYPE_DEPTH) ? PARA_DEPTH_RESOLUTION : PARA_RGB_RESOLUTION;
+
+    m_mutex.lock();
+    const bool changed = (m_paras.value(formatId).toInt() != format);
+    m_mutex.unlock();
+
+    if (!changed)
+    {
+        return;
+    }
+
+    updateStreamType();
+
+    // 1. update format
+    m_mutex.lock();
+    m_paras[formatId] = (int)format;
+    m_frameCache.clear();
+    m_frameCacheSize = 0;
+    m_frameCacheVersion++;
+    m_mutex.unlock();
+
+    emit cameraParaUpdated(formatId, (int)format);
+
+    // 2. update resolution items
+    QList<QPair<QString, QVariant>> resolutions;
+    getResolutions(sType, resolutions);
+    if (resolutions.size() <= 0)
+    {
+        qWarning() << "Error, the resolutions is empty, stream type : " << sType;
+        return;
+    }
+
+    emit cameraParaItemsUpdated(resolutionId);
+
+    // 3. update resolution
+    m_mutex.lock();
+    bool findRes = false;
+    for (const auto& pair : resolutions)
+    {
+        if (pair.second.toSize() == m_paras.value(resolutionId).toSize())
+        {
+            findRes = true;
+            break;
+        }
+    }
+
+    if (!findRes)
+    {
+        m_paras[resolutionId] = resolutions.first().second.toSize();
+    }
+    const QSize resolution = m_paras.value(resolutionId).toSize();
+    m_mutex.unlock();
+
+    emit cameraParaUpdated(resolutionId, resolution);
+}
+
+void SimulatedCamera::setFilterType(int filterType)
+{
+    m_mutex.lock();
+    const bool changed = (m_paras.value(PARA_DEPTH_FILTER_TYPE).toInt() != filterType);
+    m_paras[PARA_DEPTH_FILTER_TYPE] = filterType;
+    m_mutex.unlock();
+
+    if (!changed)
+    {
+        return;
+    }
+
+    emit cameraParaUpdated(PARA_DEPTH_FILTER_TYPE, filterType);
+
+    // parameter linkage response
+    emit cameraParaRangeUpdated(PARA_DEPTH_FILTER);
+    setCameraPara(PARA_DEPTH_FILTER, FILTER_RANGE_MAP[filterType].min);
+}
+
+// stop the paused stream when the stream type is changed, the same as CSCamera
+void SimulatedCamera::updateStreamType()
+{
+    if (getCameraState() == CAMERA_PAUSED_STREAM)
+    {
+        setCameraState(CAMERA_STOPPING_STREAM);
+        stopStream();
+    }
+}
+
+void SimulatedCamera::onTriggerModeChanged(bool isSoftTrigger)
+{
+    if (isSoftTrigger)
+    {
+        stopStreamThread();
+    }
+    else if (getCameraState() == CAMERA_STARTED_STREAM)
+    {
+        startStreamThread();
+    }
+}
+
+void SimulatedCamera::stopStreamThread()
+{
+    if (m_streamThread->isRunning())
+    {
+        qInfo() << "stop simulated stream thread";
+        m_streamThread->requestInterruption();
+        m_streamThread->wait();
+    }
+}
+
+void SimulatedCamera::startStreamThread()
+{
+    if (!m_streamThread->isRunning())
+    {
+        qInfo() << "start simulated stream thread";
+        m_streamThread->start();
+    }
+}
+
+bool SimulatedCamera::genFrame(int frameIndex, FrameData& frameData)
+{
+    CS_TRACE_SCOPE("SimulatedCamera::genFrame");
+    const double timeStamp = m_streamTimer.nsecsElapsed() / 1000000.0;
+    const int sourceIndex = m_parser ? (frameIndex % m_sourceFrameCount) : frameIndex;
+
+    m_mutex.lock();
+    const auto depthFormat = (STREAM_FORMAT)m_paras.value(PARA_DEPTH_STREAM_FORMAT).toInt();
+    const QSize depthResolution = m_paras.value(PARA_DEPTH_RESOLUTION).toSize();
+    const auto rgbFormat = (STREAM_FORMAT)m_paras.value(PARA_RGB_STREAM_FORMAT).toInt();
+    const QSize rgbResolution = m_paras.value(PARA_RGB_RESOLUTION).toSize();
+    const int cacheVersion = m_frameCacheVersion;
+
+    const bool cached = m_parser && m_frameCache.contains(sourceIndex);
+    if (cached)
+    {
+        frameData.data = m_frameCache.value(sourceIndex);
+    }
+    m_mutex.unlock();
+
+    if (!cached)
+    {
+        StreamData streamData;
+        if (m_isDepthStreamSup)
+        {
+            if (!genDepthStream(sourceIndex, timeStamp, depthFormat, depthResolution, streamData))
+            {
+                return false;
+            }
+            frameData.data.push_back(streamData);
+        }
+
+        if (m_isRgbStreamSup)
+        {
+            if (!genRgbStream(sourceIndex, timeStamp, rgbFormat, rgbResolution, streamData))
+            {
+                return false;
+            }
+            frameData.data.push_back(streamData);
+        }
+
+        // the synthetic frames are changed with time, only the source frames are cached
+        if (m_parser)
+        {
+            qint64 size = 0;
+            for (const auto& data : frameData.data)
+            {
+                size += data.data.size();
+            }
+
+            QMutexLocker locker(&m_mutex);
+            if (cacheVersion == m_frameCacheVersion && m_frameCacheSize + size <= FRAME_CACHE_MAX_SIZE)
+            {
+                m_frameCache[sourceIndex] = frameData.data;
+                m_frameCacheSize += size;
+            }
+        }
+    }
+
+    for (auto& streamData : frameData.data)
+    {
+        streamData.dataInfo.timeStamp = timeStamp;
+    }
+
+    frameData.rgbIntrinsics = m_rgbIntrinsics;
+    frameData.depthIntrinsics = m_depthIntrinsics;
+    frameData.extrinsics = m_extrinsics;
+    frameData.depthScale = m_depthScale;
+
+    return true;
+}
+
+bool SimulatedCamera::genDepthStream(int frameIndex, double timeStamp, STREAM_FORMAT format, QSize resolution, StreamData& streamData)
+{
+    const int width = resolution.width();
+    const int height = resolution.height();
+    const bool withIr = (format == STREAM_FORMAT_Z16Y8Y8) || (format == STREAM_FORMAT_PAIR);
+
+    QByteArray depth, irL, irR;
+    if (m_parser)
+    {
+        if (!readSourceDepth(frameIndex, width, height, withIr, depth, irL, irR))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        genSyntheticDepth(width, height, timeStamp, depth);
+        if (withIr)
+        {
+            genSyntheticIr(width, height, depth, irL, irR);
+        }
+    }
+
+    QByteArray data;
+    switch (format)
+    {
+    case STREAM_FORMAT_Z16:
+        data = depth;
+        break;
+    case STREAM_FORMAT_Z16Y8Y8:
+        data.reserve(width * height * 4);
+        data.append(depth);
+        data.append(irL);
+        data.append(irR);
+        break;
+    case STREAM_FORMAT_PAIR:
+        data.reserve(width * height * 2);
+        data.append(irL);
+        data.append(irR);
+        break;
+    default:
+        qWarning() << "unsupported depth format of simulated camera : " << format;
+        return false;
+    }
+
+    streamData.dataInfo = { TYPE_DEPTH, format, width, height, timeStamp };
+    streamData.data = data;
+
+    return true;
+}
+
+bool SimulatedCamera::genRgbStream(int frameIndex, double timeStamp, STREAM_FORMAT format, QSize resolution, StreamData& streamData)
+{
+    const int width = resolution.width();
+    const int height = resolution.height();
+
+    QByteArray rgb;
+    if (m_parser)
+    {
+        if (!readSourceRgb(frameIndex, width, height, rgb))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        genSyntheticRgb(width, height, timeStamp, rgb);
+    }
+
+    QByteArray data;
+    switch (format)
+    {
+    case STREAM_FORMAT_RGB8:
+        data = rgb;
+        break;
+    case STREAM_FORMAT_MJPG:
+    {
+        QImage image((const uchar*)rgb.constData(), width, height, width * 3, QImage::Format_RGB888);
+
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        if (!image.save(&buffer, "JPG"))
+        {
+            qWarning() << "encode jpg failed";
+            return false;
+        }
+        break;
+    }
+    default:
+        qWarning() << "unsupported RGB format of simulated camera : " << format;
+        return false;
+    }
+
+    streamData.dataInfo = { TYPE_RGB, format, width, height, timeStamp };
+    streamData.data = data;
+
+    return true;
+}
+
+bool SimulatedCamera::readSourceDepth(int frameIndex, int width, int height, bool withIr, QByteArray& depth, QByteArray& irL, QByteArray& irR)
+{
+    const bool hasIr = m_sourceDataTypes.contains(CAMERA_DATA_L) && m_sourceDataTypes.contains(CAMERA_DATA_R);
+
+    if (m_sourceDataTypes.contains(CAMERA_DATA_DEPTH))
+    {
+        QByteArray data = m_parser->getFrameData(frameIndex, CAMERA_DATA_DEPTH);
+        if (!m_parser->decodeFrameData(CAMERA_DATA_DEPTH, data, depth) || depth.size() < width * height * 2)
+        {
+            qWarning() << "read depth of source frame failed, frame : " << frameIndex;
+            return false;
+        }
+        depth.resize(width * height * 2);
+    }
+
+    if (!withIr)
+    {
+        return true;
+    }
+
+    if (!hasIr)
+    {
+        genSyntheticIr(width, height, depth, irL, irR);
+        return true;
+    }
+
+    QByteArray data = m_parser->getFrameData(frameIndex, CAMERA_DATA_L);
+    bool result = m_parser->decodeFrameData(CAMERA_DATA_L, data, irL) && irL.size() >= width * height;
+
+    data = m_parser->getFrameData(frameIndex, CAMERA_DATA_R);
+    result &= m_parser->decodeFrameData(CAMERA_DATA_R, data, irR) && irR.size() >= width * height;
+
+    if (!result)
+    {
+        qWarning() << "read IR of source frame failed, frame : " << frameIndex;
+        return false;
+    }
+
+    irL.resize(width * height);
+    irR.resize(width * height);
+
+    return true;
+}
+
+bool SimulatedCamera::readSourceRgb(int frameIndex, int width, int height, QByteArray& rgb)
+{
+    QByteArray data = m_parser->getFrameData(frameIndex, CAMERA_DATA_RGB);
+    if (!m_parser->decodeFrameData(CAMERA_DATA_RGB, data, rgb) || rgb.size() < width * height * 3)
+    {
+        qWarning() << "read RGB of source frame failed, frame : " << frameIndex;
+        return false;
+    }
+
+    rgb.resize(width * height * 3);
+    return true;
+}
+
+void SimulatedCamera::genSyntheticDepth(int width, int height, double timeStamp, QByteArray& depth)
+{
+    depth.resize(width * height * sizeof(ushort));
+    ushort* depthPtr = (ushort*)depth.data();
+
+    // the intrinsics are scaled to the resolution
+    const float scale = float(width) / m_depthIntrinsics.width;
+    const float fx = m_depthIntrinsics.fx * scale;
+    const float fy = m_depthIntrinsics.fy * scale;
+    const float cx = m_depthIntrinsics.cx * scale;
+    const float cy = m_depthIntrinsics.cy * scale;
+
+    bool onSphere = false;
+    float shade = 0.0f;
+    for (int y = 0; y < height; y++)
+    {
+        const float dy = (y - cy) / fy;
+        for (int x = 0; x < width; x++)
+        {
+            const float z = traceScene((x - cx) / fx, dy, timeStamp, onSphere, shade);
+            depthPtr[y * width + x] = (ushort)qBound(0, qRound(z / m_depthScale), 65535);
+        }
+    }
+}
+
+void SimulatedCamera::genSyntheticIr(int width, int height, const QByteArray& depth, QByteArray& irL, QByteArray& irR)
+{
+    irL.resize(width * height);
+    irR.resize(width * height);
+
+    Q_ASSERT(depth.size() == width * height * sizeof(ushort));
+    const ushort* depthPtr = (const ushort*)depth.constData();
+    uchar* irLPtr = (uchar*)irL.data();
+    uchar* irRPtr = (uchar*)irR.data();
+
+    const float fx = (m_depthIntrinsics.width > 0) ? (m_depthIntrinsics.fx * width / m_depthIntrinsics.width) : width;
+
+    // the speckles are projected on the scene, and they are brighter when closer
+    for (int i = 0; i < width * height; i++)
+    {
+        const float z = depthPtr[i] * m_depthScale;
+        const int speckle = hashPixel(i % width, i / width) / 2 + 64;
+        irLPtr[i] = (uchar)qBound(0, qRound(speckle * 600.0f / qMax(z, 1.0f)), 255);
+    }
+
+    // the right camera sees the speckles shifted by the disparity
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const int i = y * width + x;
+            const float z = depthPtr[i] * m_depthScale;
+            const int srcX = x + qRound(SYNTHETIC_BASELINE * fx / qMax(z, 1.0f));
+            irRPtr[i] = (srcX < width) ? irLPtr[y * width + srcX] : 0;
+        }
+    }
+}
+
+void SimulatedCamera::genSyntheticRgb(int width, int height, double timeStamp, QByteArray& rgb)
+{
+    rgb.resize(width * height * 3);
+    uchar* rgbPtr = (uchar*)rgb.data();
+
+    const float scale = float(width) / m_rgbIntrinsics.width;
+    const float fx = m_rgbIntrinsics.fx * scale;
+    const float fy = m_rgbIntrinsics.fy * scale;
+    const float cx = m_rgbIntrinsics.cx * scale;
+    const float cy = m_rgbIntrinsics.cy * scale;
+
+    bool onSphere = false;
+    float shade = 0.0f;
+    for (int y = 0; y < height; y++)
+    {
+        const float dy = (y - cy) / fy;
+        for (int x = 0; x < width; x++)
+        {
+            const float dx = (x - cx) / fx;
+            const float z = traceScene(dx, dy, timeStamp, onSphere, shade);
+
+            uchar* pixel = rgbPtr + (y * width + x) * 3;
+            if (onSphere)
+            {
+                const float light = 0.3f + 0.7f * shade;
+                pixel[0] = (uchar)(255 * light);
+                pixel[1] = (uchar)(140 * light);
+                pixel[2] = (uchar)(40 * light);
+            }
+            else
+            {
+                // checkerboard of 100mm on the plane
+                const bool dark = ((qFloor(z * dx / 100.0f) + qFloor(z * dy / 100.0f)) & 1);
+                pixel[0] = dark ? 90 : 200;
+                pixel[1] = dark ? 90 : 200;
+                pixel[2] = dark ? 90 : 220;
+            }
+        }
+    }
+}
@@ -0,0 +1,638 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include "batchconverter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QBuffer>
+#include <QImage>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDebug>
+#include <stdio.h>
+
+#include <capturedzipparser.h>
+#include <plywriter.h>
+#include <imageutil.h>
+
+#define DEFAULT_DIR_NAME "output"
+// frames submitted to each worker at most, it limits the memory used by the decoded frames
+#define MAX_CONVERTING_PER_WORKER 2
+
+namespace cs
+{
+class ConvertTask : public QRunnable
+{
+public:
+    ConvertTask(BatchConverter* converter, BatchConverter::ConvertJob* job, int frameIndex)
+        : m_converter(converter)
+        , m_job(job)
+        , m_frameIndex(frameIndex)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_converter->runConvertTask(m_job, m_frameIndex);
+    }
+private:
+    BatchConverter* m_converter;
+    BatchConverter::ConvertJob* m_job;
+    int m_frameIndex;
+};
+}
+
+using namespace cs;
+
+static double nsToMs(qint64 ns)
+{
+    return qRound64(ns / 1000.0) / 1000.0;
+}
+
+static QString getDataTypeName(int dataType)
+{
+    switch (dataType)
+    {
+    case CAMERA_DATA_L:
+        return "IR(L)";
+    case CAMERA_DATA_R:
+        return "IR(R)";
+    case CAMERA_DATA_DEPTH:
+        return "Depth";
+    case CAMERA_DATA_RGB:
+        return "RGB";
+    case CAMERA_DATA_POINT_CLOUD:
+        return "Point Cloud";
+    default:
+        return "Unknown";
+    }
+}
+
+void BatchConverter::StageTimes::add(const StageTimes& other)
+{
+    read += other.read;
+    decode += other.decode;
+    generate += other.generate;
+    encode += other.encode;
+    write += other.write;
+}
+
+QJsonObject BatchConverter::StageTimes::toJson() const
+{
+    QJsonObject object;
+    object["read"] = nsToMs(read);
+    object["decode"] = nsToMs(decode);
+    object["generate"] = nsToMs(generate);
+    object["encode"] = nsToMs(encode);
+    object["write"] = nsToMs(write);
+
+    return object;
+}
+
+BatchConverter::BatchConverter(const ConvertOptions& options)
+    : m_options(options)
+{
+    m_threadPool.setMaxThreadCount(qMax(1, m_options.workerCount));
+}
+
+BatchConverter::~BatchConverter()
+{
+    m_threadPool.waitForDone();
+
+    for (auto job : m_jobs)
+    {
+        delete job->parser;
+        delete job;
+    }
+}
+
+int BatchConverter::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    for (const auto& file : m_options.sourceFiles)
+    {
+        ConvertJob* job = new ConvertJob();
+        job->sourceFile = file;
+        m_jobs.push_back(job);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    {
+        QJsonObject event;
+        event["event"] = "start";
+        event["files"] = m_jobs.size();
+        event["workers"] = m_threadPool.maxThreadCount();
+        event["formats"] = QJsonArray::fromStringList(m_options.formats);
+        printEvent(event);
+    }
+
+    const int maxConvertingCount = m_threadPool.maxThreadCount() * MAX_CONVERTING_PER_WORKER;
+
+    int jobIndex = 0;
+    bool jobOpened = false;
+    while (true)
+    {
+        // submit the frames of the files in order, and keep a bounded count of frames in flight
+        while (jobIndex < m_jobs.size() && m_convertingCount < maxConvertingCount)
+        {
+            ConvertJob* job = m_jobs.at(jobIndex);
+            if (!jobOpened)
+            {
+                QString error;
+
+                locker.unlock();
+                const bool result = openJob(job, error);
+                locker.relock();
+
+                QJsonObject event;
+                event["file"] = job->sourceFile;
+                if (!result)
+                {
+                    m_failedFileCount++;
+                    event["event"] = "file_failed";
+                    event["error"] = error;
+                    printEvent(event);
+
+                    jobIndex++;
+                    continue;
+                }
+
+                event["event"] = "file_start";
+                event["output"] = job->outputDir;
+                event["frames"] = job->frames.size();
+                printEvent(event);
+
+                jobOpened = true;
+                job->timer.start();
+            }
+
+            if (job->nextFrame < job->frames.size())
+            {
+                m_threadPool.start(new ConvertTask(this, job, job->frames.at(job->nextFrame)));
+                job->nextFrame++;
+                job->convertingCount++;
+                m_convertingCount++;
+            }
+
+            if (job->nextFrame >= job->frames.size())
+            {
+                // all the frames are converted already if there is no frame to convert
+                if (job->frames.isEmpty())
+                {
+                    finishJob(job);
+                }
+
+                jobIndex++;
+                jobOpened = false;
+            }
+        }
+
+        // the parsers of the finished files are not used any more
+        for (int i = 0; i < jobIndex; i++)
+        {
+            ConvertJob* job = m_jobs.at(i);
+            if (job->parser && job->nextFrame >= job->frames.size() && job->convertingCount == 0)
+            {
+                delete job->parser;
+                job->parser = nullptr;
+            }
+        }
+
+        if (jobIndex >= m_jobs.size() && m_convertingCount == 0)
+        {
+            break;
+        }
+
+        m_frameConverted.wait(&m_mutex);
+    }
+
+    QJsonObject event;
+    event["event"] = "done";
+    event["files"] = m_jobs.size();
+    event["failed_files"] = m_failedFileCount;
+    event["frames"] = m_successCount + m_failedCount;
+    event["failed_frames"] = m_failedCount;
+    event["elapsed_ms"] = timer.elapsed();
+    event["stages_ms"] = m_stageTimes.toJson();
+    printEvent(event);
+
+    return m_failedCount + m_failedFileCount;
+}
+
+bool BatchConverter::openJob(ConvertJob* job, QString& error)
+{
+    QFileInfo fileInfo(job->sourceFile);
+    if (!fileInfo.exists())
+    {
+        error = "file not found";
+        return false;
+    }
+
+    if (m_options.outputDir.isEmpty())
+    {
+        job->outputDir = fileInfo.absolutePath() + "/" + DEFAULT_DIR_NAME;
+    }
+    else if (m_options.sourceFiles.size() > 1)
+    {
+        // the files are converted to separate directories
+        job->outputDir = m_options.outputDir + "/" + fileInfo.completeBaseName();
+    }
+    else
+    {
+        job->outputDir = m_options.outputDir;
+    }
+
+    CapturedZipParser* parser = new CapturedZipParser(job->sourceFile);
+    if (!parser->checkFileValid())
+    {
+        error = "invalid file, not find CaptureParameters.yaml";
+        delete parser;
+        return false;
+    }
+
+    if (!parser->parseCaptureInfo())
+    {
+        error = "parse file failed";
+        delete parser;
+        return false;
+    }
+
+    const QVector<int> dataTypes = parser->getDataTypes();
+    if (m_options.formats.contains("ply") && !dataTypes.contains(CAMERA_DATA_DEPTH))
+    {
+        error = "no depth data to generate point cloud";
+        delete parser;
+        return false;
+    }
+
+    if (!QDir().mkpath(job->outputDir))
+    {
+        error = "make output directory failed";
+        delete parser;
+        return false;
+    }
+
+    job->parser = parser;
+    job->withTexture = m_options.withTexture && dataTypes.contains(CAMERA_DATA_RGB);
+    job->frames = genFrames(parser->getFrameCount());
+
+    return true;
+}
+
+QVector<int> BatchConverter::genFrames(int frameCount)
+{
+    QVector<int> frames;
+    if (m_options.frameRanges.isEmpty())
+    {
+        frames.reserve(frameCount);
+        for (int i = 0; i < frameCount; i++)
+        {
+            frames.push_back(i);
+        }
+        return frames;
+    }
+
+    QVector<bool> selected(frameCount, false);
+    for (const auto& range : m_options.frameRanges)
+    {
+        const int first = qMax(0, range.first);
+        const int last = (range.second < 0) ? (frameCount - 1) : qMin(range.second, frameCount - 1);
+        for (int i = first; i <= last; i++)
+        {
+            selected[i] = true;
+        }
+    }
+
+    for (int i = 0; i < frameCount; i++)
+    {
+        if (selected.at(i))
+        {
+            frames.push_back(i);
+        }
+    }
+
+    return frames;
+}
+
+void BatchConverter::runConvertTask(ConvertJob* job, int frameIndex)
+{
+    StageTimes times;
+    QString error;
+    const bool result = convertFrame(job, frameIndex, times, error);
+
+    QMutexLocker locker(&m_mutex);
+    job->stageTimes.add(times);
+    m_stageTimes.add(times);
+
+    if (result)
+    {
+        job->successCount++;
+        m_successCount++;
+    }
+    else
+    {
+        job->failedCount++;
+        m_failedCount++;
+    }
+
+    QJsonObject event;
+    event["event"] = "frame";
+    event["file"] = job->sourceFile;
+    event["frame"] = frameIndex;
+    event["status"] = result ? "ok" : "failed";
+    if (!result)
+    {
+        event["error"] = error;
+    }
+    event["done"] = job->successCount + job->failedCount;
+    event["total"] = job->frames.size();
+    event["stages_ms"] = times.toJson();
+    printEvent(event);
+
+    job->convertingCount--;
+    m_convertingCount--;
+
+    if (job->nextFrame >= job->frames.size() && job->convertingCount == 0)
+    {
+        finishJob(job);
+    }
+
+    m_frameConverted.wakeAll();
+}
+
+void BatchConverter::finishJob(ConvertJob* job)
+{
+    QJsonObject event;
+    event["event"] = "file_done";
+    event["file"] = job->sourceFile;
+    event["frames"] = job->frames.size();
+    event["failed_frames"] = job->failedCount;
+    event["elapsed_ms"] = job->timer.elapsed();
+    event["stages_ms"] = job->stageTimes.toJson();
+    printEvent(event);
+}
+
+bool BatchConverter::convertFrame(ConvertJob* job, int frameIndex, StageTimes& times, QString& error)
+{
+    bool result = true;
+
+    // the decoded depth is reused to generate the point cloud
+    QByteArray depthPixels;
+
+    if (m_options.formats.contains("png") || m_options.formats.contains("raw"))
+    {
+        for (int dataType : job->parser->getDataTypes())
+        {
+            if (dataType != CAMERA_DATA_POINT_CLOUD)
+            {
+                result &= convertImage(job, frameIndex, dataType, (dataType == CAMERA_DATA_DEPTH) ? &depthPixels : nullptr, times, error);
+            }
+        }
+    }
+
+    if (m_options.formats.contains("ply"))
+    {
+        result &= convertPointCloud(job, frameIndex, depthPixels, times, error);
+    }
+
+    return result;
+}
+
+bool BatchConverter::convertImage(ConvertJob* job, int frameIndex, int dataType, QByteArray* decodedPixels, StageTimes& times, QString& error)
+{
+    CapturedZipParser* parser = job->parser;
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray data = parser->getFrameData(frameIndex, dataType);
+    times.read += timer.nsecsElapsed();
+
+    if (data.isEmpty())
+    {
+        error = QString("read %1 failed").arg(getDataTypeName(dataType));
+        return false;
+    }
+
+    const bool isPngData = !parser->isRawFormat() && !parser->isEncodedByRvl(dataType);
+    const QSize resolution = parser->getResolution(dataType);
+    const int bytesPerPixel = (dataType == CAMERA_DATA_DEPTH) ? 2 : ((dataType == CAMERA_DATA_RGB) ? 3 : 1);
+
+    QByteArray pixData;
+    bool result = true;
+    for (const auto& format : m_options.formats)
+    {
+        if (format == "ply")
+        {
+            continue;
+        }
+
+        const QString filePath = job->outputDir + "/" + genFileName(job, frameIndex, dataType, "." + format);
+
+        // the PNG in the captured file is written as it is
+        if (format == "png" && isPngData)
+        {
+            result &= writeFile(filePath, data, times);
+            continue;
+        }
+
+        if (pixData.isEmpty())
+        {
+            timer.restart();
+            const bool decoded = parser->decodeFrameData(dataType, data, pixData);
+            times.decode += timer.nsecsElapsed();
+
+            if (!decoded || pixData.size() < resolution.width() * resolution.height() * bytesPerPixel)
+            {
+                error = QString("decode %1 failed").arg(getDataTypeName(dataType));
+                return false;
+            }
+        }
+
+        if (format == "raw")
+        {
+            result &= writeFile(filePath, pixData, times);
+            continue;
+        }
+
+        timer.restart();
+        QByteArray pngData;
+        bool encoded = false;
+        if (dataType == CAMERA_DATA_DEPTH)
+        {
+            encoded = ImageUtil::genPngDataFromGrayScale16(resolution.width(), resolution.height(), pixData, pngData);
+        }
+        else
+        {
+            QImage image((const uchar*)pixData.constData(), resolution.width(), resolution.height(), resolution.width() * bytesPerPixel,
+                (dataType == CAMERA_DATA_RGB) ? QImage::Format_RGB888 : QImage::Format_Grayscale8);
+
+            QBuffer buffer(&pngData);
+            buffer.open(QIODevice::WriteOnly);
+            encoded = image.save(&buffer, "PNG");
+        }
+        times.encode += timer.nsecsElapsed();
+
+        if (!encoded)
+        {
+            error = QString("encode %1 failed").arg(getDataTypeName(dataType));
+            return false;
+        }
+
+        result &= writeFile(filePath, pngData, times);
+    }
+
+    if (!result)
+    {
+        error = QString("write %1 failed").arg(getDataTypeName(dataType));
+    }
+
+    if (decodedPixels)
+    {
+        *decodedPixels = pixData;
+    }
+
+    return result;
+}
+
+bool BatchConverter::convertPointCloud(ConvertJob* job, int frameIndex, QByteArray depthPixels, StageTimes& times, QString& error)
+{
+    CapturedZipParser* parser = job->parser;
+
+    QElapsedTimer timer;
+    if (depthPixels.isEmpty())
+    {
+        timer.start();
+        QByteArray data = parser->getFrameData(frameIndex, CAMERA_DATA_DEPTH);
+        times.read += timer.nsecsElapsed();
+
+        if (data.isEmpty())
+        {
+            error = "read Depth failed";
+            return false;
+        }
+
+        timer.restart();
+        const bool decoded = parser->decodeFrameData(CAMERA_DATA_DEPTH, data, depthPixels);
+        times.decode += timer.nsecsElapsed();
+
+        if (!decoded)
+        {
+            error = "decode Depth failed";
+            return false;
+        }
+    }
+
+    QImage texImage;
+    if (job->withTexture)
+    {
+        // If the timestamp is valid, find the RGB frame index through the timestamp
+        int rgbIndex = parser->getIsTimeStampsValid() ? parser->getRgbFrameIndexByTimeStamp(frameIndex) : frameIndex;
+
+        timer.start();
+        texImage = parser->getImageOfFrame(rgbIndex, CAMERA_DATA_RGB);
+        times.decode += timer.nsecsElapsed();
+    }
+
+    timer.start();
+    Pointcloud pc;
+    const bool generated = parser->generatePointCloud(depthPixels, job->withTexture, pc);
+    times.generate += timer.nsecsElapsed();
+
+    if (!generated)
+    {
+        error = "generate point cloud failed";
+        return false;
+    }
+
+    timer.restart();
+    const QString filePath = job->outputDir + "/" + genFileName(job, frameIndex, CAMERA_DATA_POINT_CLOUD, ".ply");
+    const bool saved = PlyWriter::savePointCloud(filePath, pc, texImage, m_options.binaryPly);
+    times.write += timer.nsecsElapsed();
+
+    if (!saved)
+    {
+        error = "save point cloud failed";
+        return false;
+    }
+
+    return true;
+}
+
+bool BatchConverter::writeFile(QString filePath, const QByteArray& data, StageTimes& times)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(filePath);
+    bool result = file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+    file.close();
+
+    times.write += timer.nsecsElapsed();
+
+    if (!result)
+    {
+        qWarning() << "write file failed, file:" << filePath;
+    }
+
+    return result;
+}
+
+QString BatchConverter::genFileName(ConvertJob* job, int frameIndex, int dataType, QString suffix)
+{
+    QString fileName = job->parser->getCaptureName();
+    switch (dataType)
+    {
+    case CAMERA_DATA_L:
+        fileName = QString("%1-ir-L-%2").arg(fileName).arg(frameIndex, 4, 10, QChar('0'));
+        break;
+    case CAMERA_DATA_R:
+        fileName = QString("%1-ir-R-%2").arg(fileName).arg(frameIndex, 4, 10, QChar('0'));
+        break;
+    case CAMERA_DATA_DEPTH:
+        fileName = QString("%1-depth-%2").arg(fileName).arg(frameIndex, 4, 10, QChar('0'));
+        break;
+    case CAMERA_DATA_RGB:
+        fileName = QString("%1-RGB-%2").arg(fileName).arg(frameIndex, 4, 10, QChar('0'));
+        break;
+    case CAMERA_DATA_POINT_CLOUD:
+        fileName = QString("%1-%2").arg(fileName).arg(frameIndex, 4, 10, QChar('0'));
+        break;
+    default:
+        break;
+    }
+
+    return fileName + suffix;
+}
+
+void BatchConverter::printEvent(QJsonObject event)
+{
+    QByteArray line = QJsonDocument(event).toJson(QJsonDocument::Compact);
+    line.append('\n');
+
+    fwrite(line.constData(), 1, line.size(), stdout);
+    fflush(stdout);
+}
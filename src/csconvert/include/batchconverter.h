@@ -0,0 +1,134 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#ifndef _CS_BATCHCONVERTER_H
+#define _CS_BATCHCONVERTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+namespace cs
+{
+
+class CapturedZipParser;
+class ConvertTask;
+
+struct ConvertOptions
+{
+    QStringList sourceFiles;
+    // the output directory, the "output" directory beside the source file is used if it is empty
+    QString outputDir;
+    // ply, png or raw
+    QStringList formats;
+    // the inclusive frame ranges, -1 is the last frame, all the frames are converted if it is empty
+    QVector<QPair<int, int>> frameRanges;
+    bool withTexture = false;
+    bool binaryPly = false;
+    int workerCount = 1;
+};
+
+// Converts the captured files without UI.
+// The frames of all the files are converted by a pool of workers, the next file is opened while the frames of the previous file are converting.
+// The progress is written to stdout as JSON lines, with the time spent in each stage.
+class BatchConverter
+{
+public:
+    BatchConverter(const ConvertOptions& options);
+    ~BatchConverter();
+
+    // convert all the files, return the count of the failed frames and files
+    int run();
+private:
+    friend class ConvertTask;
+
+    // time spent in each stage, ns
+    struct StageTimes
+    {
+        qint64 read = 0;
+        qint64 decode = 0;
+        qint64 generate = 0;
+        qint64 encode = 0;
+        qint64 write = 0;
+
+        void add(const StageTimes& other);
+        QJsonObject toJson() const;
+    };
+
+    struct ConvertJob
+    {
+        QString sourceFile;
+        QString outputDir;
+        CapturedZipParser* parser = nullptr;
+        bool withTexture = false;
+
+        QVector<int> frames;
+        int nextFrame = 0;
+        int convertingCount = 0;
+        int successCount = 0;
+        int failedCount = 0;
+
+        QElapsedTimer timer;
+        StageTimes stageTimes;
+    };
+
+    bool openJob(ConvertJob* job, QString& error);
+    QVector<int> genFrames(int frameCount);
+    // all the frames of the file are converted, m_mutex must be locked
+    void finishJob(ConvertJob* job);
+
+    void runConvertTask(ConvertJob* job, int frameIndex);
+    bool convertFrame(ConvertJob* job, int frameIndex, StageTimes& times, QString& error);
+    // decodedPixels returns the decoded pixels if it is not null
+    bool convertImage(ConvertJob* job, int frameIndex, int dataType, QByteArray* decodedPixels, StageTimes& times, QString& error);
+    // depthPixels is decoded from the captured file if it is empty
+    bool convertPointCloud(ConvertJob* job, int frameIndex, QByteArray depthPixels, StageTimes& times, QString& error);
+    bool writeFile(QString filePath, const QByteArray& data, StageTimes& times);
+
+    QString genFileName(ConvertJob* job, int frameIndex, int dataType, QString suffix);
+
+    // write a line of JSON to stdout, m_mutex must be locked
+    void printEvent(QJsonObject event);
+private:
+    ConvertOptions m_options;
+
+    QThreadPool m_threadPool;
+    QMutex m_mutex;
+    QWaitCondition m_frameConverted;
+
+    QList<ConvertJob*> m_jobs;
+    int m_convertingCount = 0;
+
+    int m_successCount = 0;
+    int m_failedCount = 0;
+    int m_failedFileCount = 0;
+    StageTimes m_stageTimes;
+};
+
+}
+
+#endif // _CS_BATCHCONVERTER_H
@@ -0,0 +1,162 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QDebug>
+#include <stdio.h>
+
+#include "batchconverter.h"
+
+#define APP_NAME "csconvert"
+
+// exit codes
+#define EXIT_CODE_SUCCESS       0
+#define EXIT_CODE_FAILED        1
+#define EXIT_CODE_INVALID_ARGS  2
+
+static bool verboseLog = false;
+
+// stdout is used by the progress, the logs are written to stderr
+static void myMessageOutput(QtMsgType type, const QMessageLogContext& context, const QString& msg)
+{
+    if (!verboseLog && (type == QtDebugMsg || type == QtInfoMsg))
+    {
+        return;
+    }
+
+    fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+}
+
+// e.g. "0-99,120,200-", the last frame is -1
+static bool parseFrameRanges(QString text, QVector<QPair<int, int>>& ranges)
+{
+    for (const auto& part : text.split(",", QString::SkipEmptyParts))
+    {
+        const QStringList values = part.trimmed().split("-");
+        if (values.size() > 2)
+        {
+            return false;
+        }
+
+        bool ok = true;
+        const int first = values.first().trimmed().toInt(&ok);
+        if (!ok || first < 0)
+        {
+            return false;
+        }
+
+        int last = first;
+        if (values.size() == 2)
+        {
+            const QString lastText = values.last().trimmed();
+            last = lastText.isEmpty() ? -1 : lastText.toInt(&ok);
+            if (!ok || (last >= 0 && last < first))
+            {
+                return false;
+            }
+        }
+
+        ranges.push_back(qMakePair(first, last));
+    }
+
+    return !ranges.isEmpty();
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(APP_NAME);
+
+    qInstallMessageHandler(myMessageOutput);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Convert the captured files (.zip or .csr) to PLY, PNG or raw files.\n"
+        "The progress is written to stdout as JSON lines.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "The captured files to convert.", "<files...>");
+
+    QCommandLineOption outputOption({ "o", "output" }, "The output directory, a sub directory is created for each file if there are several files. "
+        "The \"output\" directory beside each file is used by default.", "dir");
+    QCommandLineOption formatOption({ "f", "format" }, "The output formats separated by commas: ply, png, raw.", "formats", "ply");
+    QCommandLineOption framesOption("frames", "The frames to convert, e.g. 0-99,120,200-. All the frames are converted by default.", "ranges");
+    QCommandLineOption textureOption({ "t", "texture" }, "Save the point cloud with the RGB texture.");
+    QCommandLineOption binaryOption("binary", "Save the point cloud as binary PLY.");
+    QCommandLineOption jobsOption({ "j", "jobs" }, "The count of the workers, the count of the CPU cores by default.", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption verboseOption({ "v", "verbose" }, "Write the info logs to stderr.");
+
+    parser.addOptions({ outputOption, formatOption, framesOption, textureOption, binaryOption, jobsOption, verboseOption });
+    parser.process(app);
+
+    verboseLog = parser.isSet(verboseOption);
+
+    cs::ConvertOptions options;
+    options.sourceFiles = parser.positionalArguments();
+    options.outputDir = parser.value(outputOption);
+    options.withTexture = parser.isSet(textureOption);
+    options.binaryPly = parser.isSet(binaryOption);
+
+    if (options.sourceFiles.isEmpty())
+    {
+        fprintf(stderr, "No file to convert.\n");
+        parser.showHelp(EXIT_CODE_INVALID_ARGS);
+    }
+
+    for (const auto& format : parser.value(formatOption).split(",", QString::SkipEmptyParts))
+    {
+        const QString value = format.trimmed().toLower();
+        if (value != "ply" && value != "png" && value != "raw")
+        {
+            fprintf(stderr, "Invalid format: %s\n", value.toLocal8Bit().constData());
+            return EXIT_CODE_INVALID_ARGS;
+        }
+
+        if (!options.formats.contains(value))
+        {
+            options.formats.push_back(value);
+        }
+    }
+
+    if (options.formats.isEmpty())
+    {
+        fprintf(stderr, "No output format.\n");
+        return EXIT_CODE_INVALID_ARGS;
+    }
+
+    if (parser.isSet(framesOption) && !parseFrameRanges(parser.value(framesOption), options.frameRanges))
+    {
+        fprintf(stderr, "Invalid frame ranges: %s\n", parser.value(framesOption).toLocal8Bit().constData());
+        return EXIT_CODE_INVALID_ARGS;
+    }
+
+    bool ok = false;
+    options.workerCount = parser.value(jobsOption).toInt(&ok);
+    if (!ok || options.workerCount <= 0)
+    {
+        fprintf(stderr, "Invalid count of workers: %s\n", parser.value(jobsOption).toLocal8Bit().constData());
+        return EXIT_CODE_INVALID_ARGS;
+    }
+
+    cs::BatchConverter converter(options);
+    const int failedCount = converter.run();
+
+    return (failedCount == 0) ? EXIT_CODE_SUCCESS : EXIT_CODE_FAILED;
+}
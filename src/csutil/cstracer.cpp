@@ -0,0 +1,343 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#include "cstracer.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QFile>
+#include <QDebug>
+#include <atomic>
+#include <chrono>
+
+#define TRACE_BUFFER_CAPACITY   (1 << 15)
+// bytes of the JSON buffer written to the file at once
+#define TRACE_WRITE_CHUNK_SIZE  (1 << 20)
+
+namespace
+{
+
+enum TRACE_EVENT_PHASE
+{
+    PHASE_COMPLETE = 'X',
+    PHASE_INSTANT = 'i',
+    PHASE_COUNTER = 'C'
+};
+
+struct TraceEvent
+{
+    const char* name;
+    qint64 time;
+    // duration of PHASE_COMPLETE, value of PHASE_COUNTER
+    qint64 value;
+    qint64 frameTime;
+    char phase;
+};
+
+// The events of a thread, written only by the thread. 
+// The buffers are never freed, so the events of finished threads can still be saved.
+struct TraceBuffer
+{
+    int threadId = 0;
+    QString threadName;
+    QVector<TraceEvent> events;
+    // count of the events ever written, the event n is at events[n % TRACE_BUFFER_CAPACITY]
+    std::atomic<quint64> writeIndex;
+    // the events before it are cleared
+    std::atomic<quint64> clearIndex;
+
+    TraceBuffer()
+        : events(TRACE_BUFFER_CAPACITY)
+        , writeIndex(0)
+        , clearIndex(0)
+    {
+    }
+};
+
+struct TraceRegistry
+{
+    QMutex mutex;
+    QVector<TraceBuffer*> buffers;
+    std::atomic<bool> enabled;
+
+    TraceRegistry()
+        : enabled(false)
+    {
+    }
+};
+
+TraceRegistry& getRegistry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+thread_local TraceBuffer* threadBuffer = nullptr;
+
+TraceBuffer* getThreadBuffer()
+{
+    if (threadBuffer)
+    {
+        return threadBuffer;
+    }
+
+    auto& registry = getRegistry();
+    QMutexLocker locker(&registry.mutex);
+
+    TraceBuffer* buffer = new TraceBuffer();
+    buffer->threadId = registry.buffers.size() + 1;
+
+    // the name of QThread or the thread of QThreadPool, the others are OpenMP or SDK threads
+    QThread* thread = QThread::currentThread();
+    auto app = QCoreApplication::instance();
+    if (app && thread == app->thread())
+    {
+        buffer->threadName = "main";
+    }
+    else
+    {
+        buffer->threadName = thread->objectName();
+    }
+
+    if (buffer->threadName.isEmpty())
+    {
+        buffer->threadName = QString("thread %1").arg(buffer->threadId);
+    }
+
+    registry.buffers.push_back(buffer);
+    threadBuffer = buffer;
+
+    return buffer;
+}
+
+void addEvent(TRACE_EVENT_PHASE phase, const char* name, qint64 time, qint64 value, qint64 frameTime)
+{
+    TraceBuffer* buffer = getThreadBuffer();
+    const quint64 index = buffer->writeIndex.load(std::memory_order_relaxed);
+
+    TraceEvent& event = buffer->events.data()[index % TRACE_BUFFER_CAPACITY];
+    event.name = name;
+    event.time = time;
+    event.value = value;
+    event.frameTime = frameTime;
+    event.phase = (char)phase;
+
+    buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+// time in microseconds as Chrome trace expects
+void appendTime(QByteArray& json, qint64 ns)
+{
+    json += QByteArray::number(ns / 1000);
+    json += '.';
+    json += QByteArray::number(ns % 1000).rightJustified(3, '0');
+}
+
+void appendString(QByteArray& json, const QByteArray& str)
+{
+    json += '"';
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            json += '\\';
+        }
+        json += c;
+    }
+    json += '"';
+}
+
+void appendEvent(QByteArray& json, const TraceEvent& event, qint64 pid, int tid)
+{
+    json += ",\n{\"name\":";
+    appendString(json, QByteArray(event.name));
+    json += ",\"cat\":\"cs\",\"ph\":\"";
+    json += event.phase;
+    json += "\",\"ts\":";
+    appendTime(json, event.time);
+
+    switch (event.phase)
+    {
+    case PHASE_COMPLETE:
+        json += ",\"dur\":";
+        appendTime(json, event.value);
+        break;
+    case PHASE_INSTANT:
+        json += ",\"s\":\"t\"";
+        break;
+    default:
+        break;
+    }
+
+    json += ",\"pid\":" + QByteArray::number(pid) + ",\"tid\":" + QByteArray::number(tid);
+
+    if (event.phase == PHASE_COUNTER)
+    {
+        json += ",\"args\":{\"value\":" + QByteArray::number(event.value) + "}";
+    }
+    else if (event.frameTime > 0)
+    {
+        // the frame is identified by its receipt time, the same as the ts of its "frame received" event
+        json += ",\"args\":{\"frame\":";
+        appendTime(json, event.frameTime);
+        json += "}";
+    }
+
+    json += "}";
+}
+
+}
+
+bool CSTracer::isSupported()
+{
+#ifdef CS_TRACE_ENABLED
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CSTracer::setEnabled(bool enable)
+{
+    if (enable && !isEnabled())
+    {
+        clear();
+    }
+
+    getRegistry().enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool CSTracer::isEnabled()
+{
+    return getRegistry().enabled.load(std::memory_order_relaxed);
+}
+
+void CSTracer::clear()
+{
+    auto& registry = getRegistry();
+    QMutexLocker locker(&registry.mutex);
+
+    for (auto buffer : registry.buffers)
+    {
+        buffer->clearIndex.store(buffer->writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+bool CSTracer::save(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "failed to open the trace file : " << filePath << ", " << file.errorString();
+        return false;
+    }
+
+    auto& registry = getRegistry();
+    QMutexLocker locker(&registry.mutex);
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    int eventCount = 0;
+
+    QByteArray json;
+    json.reserve(TRACE_WRITE_CHUNK_SIZE + 4096);
+    json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(pid) + ",\"tid\":0,\"args\":{\"name\":";
+    appendString(json, QCoreApplication::applicationName().toUtf8());
+    json += "}}";
+
+    bool result = true;
+    for (auto buffer : registry.buffers)
+    {
+        json += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(pid) 
+            + ",\"tid\":" + QByteArray::number(buffer->threadId) + ",\"args\":{\"name\":";
+        appendString(json, buffer->threadName.toUtf8());
+        json += "}}";
+
+        // the thread may be writing while the events are copied, 
+        // the events overwritten during the copy are dropped
+        const quint64 end = buffer->writeIndex.load(std::memory_order_acquire);
+        quint64 begin = qMax(buffer->clearIndex.load(std::memory_order_relaxed), (end > TRACE_BUFFER_CAPACITY) ? end - TRACE_BUFFER_CAPACITY : 0);
+
+        QVector<TraceEvent> events;
+        events.reserve((int)(end - begin));
+        for (quint64 i = begin; i < end; i++)
+        {
+            events.push_back(buffer->events.constData()[i % TRACE_BUFFER_CAPACITY]);
+        }
+
+        // the thread may be writing the event newEnd, which overwrites the event newEnd - TRACE_BUFFER_CAPACITY
+        const quint64 newEnd = buffer->writeIndex.load(std::memory_order_acquire);
+        const quint64 validBegin = (newEnd >= TRACE_BUFFER_CAPACITY) ? newEnd - TRACE_BUFFER_CAPACITY + 1 : 0;
+        const int skipped = (int)qMin<quint64>((validBegin > begin) ? validBegin - begin : 0, events.size());
+
+        for (int i = skipped; i < events.size(); i++)
+        {
+            appendEvent(json, events[i], pid, buffer->threadId);
+            eventCount++;
+
+            if (json.size() >= TRACE_WRITE_CHUNK_SIZE)
+            {
+                result &= (file.write(json) == json.size());
+                json.resize(0);
+            }
+        }
+    }
+
+    json += "\n]}\n";
+    result &= (file.write(json) == json.size());
+    file.close();
+
+    if (!result)
+    {
+        qWarning() << "failed to write the trace file : " << filePath << ", " << file.errorString();
+        return false;
+    }
+
+    qInfo() << "saved " << eventCount << " trace events to " << filePath;
+    return true;
+}
+
+qint64 CSTracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CSTracer::complete(const char* name, qint64 startTime, qint64 endTime, qint64 frameTime)
+{
+    addEvent(PHASE_COMPLETE, name, startTime, endTime - startTime, frameTime);
+}
+
+void CSTracer::instant(const char* name, qint64 frameTime)
+{
+    if (isEnabled())
+    {
+        addEvent(PHASE_INSTANT, name, now(), 0, frameTime);
+    }
+}
+
+void CSTracer::counter(const char* name, qint64 value)
+{
+    if (isEnabled())
+    {
+        addEvent(PHASE_COUNTER, name, now(), value, 0);
+    }
+}
@@ -20,36 +20,52 @@
 #include "imageutil.h"
 #include <png.h>
 #include <QDebug>
+#include <QFile>
 
-static FILE* openFile(QString& path)
+static void writePngDataCallBack(png_structp pngPtr, png_bytep data, png_size_t length)
 {
-    FILE* fp = nullptr;
+    QByteArray* pngData = (QByteArray*)png_get_io_ptr(pngPtr);
+    pngData->append((const char*)data, (int)length);
+}
 
-    QByteArray data = path.toLocal8Bit();
-    fp = fopen(data.data(), "wb");
+static void flushPngDataCallBack(png_structp pngPtr)
+{
 
-    return fp;
 }
 
 bool ImageUtil::saveGrayScale16ByLibpng(int width, int height, QByteArray data, QString path)
+{
+    QByteArray pngData;
+    if (!genPngDataFromGrayScale16(width, height, data, pngData))
+    {
+        return false;
+    }
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly))
+    {
+        qWarning() << "Open file failed, file : " << path;
+        return false;
+    }
+
+    return file.write(pngData) == pngData.size();
+}
+
+bool ImageUtil::genPngDataFromGrayScale16(int width, int height, const QByteArray& data, QByteArray& pngData)
 {
     png_structp pngPtr = nullptr;
     png_infop infoPtr = nullptr;
-    FILE* fp = nullptr;
 
     int bitDepth = 16;
-    uchar* pngData = (uchar*)data.data();
+    uchar* pixData = (uchar*)data.constData();
+
+    pngData.clear();
+    // the png of depth data is usually about half of the raw data
+    pngData.reserve(data.size() / 2);
 
     bool result = true;
     do
     {
-        fp = openFile(path);
-        if (fp == nullptr) {
-            qWarning() << "Open file failed, file : " << path;
-            result = false;
-            break;
-        }
-
         pngPtr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
         if (pngPtr == nullptr) {
             qWarning() << ("Could not allocate write struct");
@@ -71,7 +87,8 @@ bool ImageUtil::saveGrayScale16ByLibpng(int width, int height, QByteArray data,
             break;
         }
 
-        png_init_io(pngPtr, fp);
+        // write into memory
+        png_set_write_fn(pngPtr, &pngData, writePngDataCallBack, flushPngDataCallBack);
 
         png_set_IHDR(pngPtr, infoPtr, width, height, bitDepth, PNG_FORMAT_GRAY, PNG_INTERLACE_NONE,
             PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
@@ -84,17 +101,13 @@ bool ImageUtil::saveGrayScale16ByLibpng(int width, int height, QByteArray data,
 
         for (int i = 0; i < height; i++) {
             int offset = i * rowSize;
-            png_write_row(pngPtr, pngData + offset);
+            png_write_row(pngPtr, pixData + offset);
         }
 
         png_write_end(pngPtr, nullptr);
 
     } while (false);
 
-
-    if (fp != nullptr)
-        fclose(fp);
-
     if (pngPtr != nullptr || infoPtr != nullptr)
         png_destroy_write_struct(&pngPtr, &infoPtr);
 
@@ -0,0 +1,99 @@
+/*******************************************************************************
+* This file is part of the 3DViewer                                            *
+*                                                                              *
+* Copyright (C) 2022 Revopoint3D Company Ltd.                                  *
+* All rights reserved.                                                         *
+*                                                                              *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)             *
+* for more details.                                                            *
+*                                                                              *
+********************************************************************************/
+
+#ifndef _CS_TRACER_H
+#define _CS_TRACER_H
+
+#include <QString>
+
+#include "csutilsapi.h"
+
+// Trace points of the frame pipeline, written as Chrome trace events (chrome://tracing, ui.perfetto.dev).
+// The names must be string literals, they are kept as pointers until the trace is saved.
+// The trace points are compiled only if CS_TRACE_ENABLED is defined (cmake option USE_TRACE),
+// and they record nothing until CSTracer::setEnabled(true).
+#ifdef CS_TRACE_ENABLED
+    #define CS_TRACE_CONCAT_IMPL(a, b)              a##b
+    #define CS_TRACE_CONCAT(a, b)                   CS_TRACE_CONCAT_IMPL(a, b)
+    // trace the time from here to the end of the scope
+    #define CS_TRACE_SCOPE(name)                    CSTraceScope CS_TRACE_CONCAT(csTraceScope, __LINE__)(name)
+    // the same as CS_TRACE_SCOPE, with the receivedTime of the frame as argument to follow a frame through the threads
+    #define CS_TRACE_SCOPE_FRAME(name, frameTime)   CSTraceScope CS_TRACE_CONCAT(csTraceScope, __LINE__)(name, frameTime)
+    #define CS_TRACE_INSTANT(name)                  CSTracer::instant(name)
+    #define CS_TRACE_INSTANT_FRAME(name, frameTime) CSTracer::instant(name, frameTime)
+    #define CS_TRACE_COUNTER(name, value)           CSTracer::counter(name, value)
+#else
+    #define CS_TRACE_SCOPE(name)
+    #define CS_TRACE_SCOPE_FRAME(name, frameTime)
+    #define CS_TRACE_INSTANT(name)                  (void)0
+    #define CS_TRACE_INSTANT_FRAME(name, frameTime) (void)0
+    #define CS_TRACE_COUNTER(name, value)           (void)0
+#endif
+
+// The events are recorded into a ring buffer of the calling thread without locking,
+// the latest 32768 events (TRACE_BUFFER_CAPACITY) of each thread are kept.
+class CS_UTILS_EXPORT CSTracer
+{
+public:
+    // whether the trace points are compiled
+    static bool isSupported();
+
+    // enabling the tracer drops the events recorded before
+    static void setEnabled(bool enable);
+    static bool isEnabled();
+    static void clear();
+
+    // save the recorded events as Chrome trace JSON
+    static bool save(const QString& filePath);
+
+    // monotonic time in nanoseconds, the same clock as the receivedTime of the frames
+    static qint64 now();
+
+    static void complete(const char* name, qint64 startTime, qint64 endTime, qint64 frameTime = 0);
+    static void instant(const char* name, qint64 frameTime = 0);
+    static void counter(const char* name, qint64 value);
+};
+
+class CS_UTILS_EXPORT CSTraceScope
+{
+public:
+    CSTraceScope(const char* name, qint64 frameTime = 0)
+        : m_name(CSTracer::isEnabled() ? name : nullptr)
+        , m_frameTime(frameTime)
+        , m_startTime(m_name ? CSTracer::now() : 0)
+    {
+    }
+
+    ~CSTraceScope()
+    {
+        if (m_name)
+        {
+            CSTracer::complete(m_name, m_startTime, CSTracer::now(), m_frameTime);
+        }
+    }
+private:
+    CSTraceScope(const CSTraceScope&) = delete;
+    CSTraceScope& operator=(const CSTraceScope&) = delete;
+private:
+    const char* m_name;
+    const qint64 m_frameTime;
+    const qint64 m_startTime;
+};
+
+#endif // _CS_TRACER_H
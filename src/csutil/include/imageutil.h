@@ -29,6 +29,8 @@ class CS_UTILS_EXPORT ImageUtil
 {
 public:
     static bool saveGrayScale16ByLibpng(int width, int height, QByteArray data, QString path);
+    // encode 16 bits gray scale data to png data in memory
+    static bool genPngDataFromGrayScale16(int width, int height, const QByteArray& data, QByteArray& pngData);
     static bool genPixDataFromPngData(QByteArray pngData, int& width, int& height, int& bitDepth,  QByteArray& pixData);
 };
 
@@ -31,6 +31,7 @@ AppConfig::AppConfig()
     m_language = m_settings->value("language", "en").toString();
     m_defaultSavePath = m_settings->value("defaultSavePath", QDir::homePath()).toString();
     m_autoNameWhenCaptring = m_settings->value("autoNameWhenCapturing", false).toBool();
+    m_renderPointBudget = m_settings->value("renderPointBudget", 0).toInt();
 }
 
 AppConfig::~AppConfig()
@@ -65,6 +66,7 @@ void AppConfig::save()
     m_settings->setValue("language", m_language);
     m_settings->setValue("defaultSavePath", m_defaultSavePath);
     m_settings->setValue("autoNameWhenCapturing", m_autoNameWhenCaptring);
+    m_settings->setValue("renderPointBudget", m_renderPointBudget);
     m_settings->sync();
 }
 
@@ -77,4 +79,15 @@ void AppConfig::setAutoNameWhenCapturing(bool autoName)
 bool AppConfig::getAutoNameWhenCapturing() const
 {
     return m_autoNameWhenCaptring;
+}
+
+void AppConfig::setRenderPointBudget(int budget)
+{
+    m_renderPointBudget = budget;
+    save();
+}
+
+int AppConfig::getRenderPointBudget() const
+{
+    return m_renderPointBudget;
 }
\ No newline at end of file
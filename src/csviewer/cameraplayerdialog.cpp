@@ -23,6 +23,7 @@
 #include <QFileDialog>
 #include <QDebug>
 #include <QIntValidator>
+#include <QSignalBlocker>
 
 #include <cameraplayer.h>
 #include "appconfig.h"
@@ -40,6 +41,7 @@ CameraPlayerDialog::CameraPlayerDialog(QWidget* parent)
     m_ui->setupUi(this);
     m_ui->frameEdit->setValidator(new QIntValidator(-10000000, 10000000, this));
     m_ui->captureSingleButton->setToolTip(tr("Save current frame"));
+    m_ui->playButton->setToolTip(tr("Play"));
 
     m_dataTypeCheckBoxs[(int)CAMERA_DATA_DEPTH] = m_ui->checkBoxDepth;
     m_dataTypeCheckBoxs[(int)CAMERA_DATA_RGB] = m_ui->checkBoxRgb;
@@ -73,8 +75,10 @@ CameraPlayerDialog::CameraPlayerDialog(QWidget* parent)
 
     suc &= (bool)connect(m_ui->playerRenderWindow,  &RenderWindow::renderExit, this, &CameraPlayerDialog::onRenderExit);
     suc &= (bool)connect(m_ui->captureSingleButton, &QPushButton::clicked,     this, &CameraPlayerDialog::onClickedSave);
+    suc &= (bool)connect(m_ui->playButton,          &QPushButton::toggled,     this, &CameraPlayerDialog::playToggled);
+    suc &= (bool)connect(m_ui->playButton,          &QPushButton::toggled,     this, &CameraPlayerDialog::onPlayingChanged);
 
-    suc &= (bool)connect(this, &CameraPlayerDialog::output2DUpdated, m_ui->playerRenderWindow, &RenderWindow::onOutput2DUpdated);
+    suc &= (bool)connect(this, &CameraPlayerDialog::output2DUpdated, m_ui->playerRenderWindow, &RenderWindow::prepareOutput2D, Qt::DirectConnection);
     suc &= (bool)connect(this, &CameraPlayerDialog::output3DUpdated, m_ui->playerRenderWindow, &RenderWindow::onOutput3DUpdated);
     suc &= (bool)connect(cs::CSApplication::getInstance(), &cs::CSApplication::show3DTextureChanged, this, &CameraPlayerDialog::onShowTextureUpdated);
 
@@ -100,7 +104,7 @@ void CameraPlayerDialog::onLoadFile()
     qInfo() << "click load file";
     QString openDir = QString("file:///%1").arg(cs::CSApplication::getInstance()->getAppConfig()->getDefaultSavePath());
 
-    QString filters = "Zip file(*.zip)";
+    QString filters = "Captured file(*.zip *.csr);;Zip file(*.zip);;Record file(*.csr)";
     QUrl url = QFileDialog::getOpenFileUrl(this, tr("Load captured file"), openDir, filters);
 
     if (url.isValid())
@@ -111,11 +115,14 @@ void CameraPlayerDialog::onLoadFile()
             m_cameraPlayer = new cs::CameraPlayer();
 
             connect(m_cameraPlayer, &cs::CameraPlayer::playerStateChanged, this, &CameraPlayerDialog::onPlayerStateChanged);    
-            connect(m_cameraPlayer, &cs::CameraPlayer::output2DUpdated,    this, &CameraPlayerDialog::output2DUpdated);
+            connect(m_cameraPlayer, &cs::CameraPlayer::output2DUpdated,    this, &CameraPlayerDialog::output2DUpdated, Qt::DirectConnection);
             connect(m_cameraPlayer, &cs::CameraPlayer::output3DUpdated,    this, &CameraPlayerDialog::output3DUpdated);
             connect(this, &CameraPlayerDialog::loadFile, m_cameraPlayer,   &cs::CameraPlayer::onLoadFile);
             connect(this, &CameraPlayerDialog::currentFrameUpdated,      m_cameraPlayer, &cs::CameraPlayer::onPalyFrameUpdated);
             connect(this, &CameraPlayerDialog::saveCurrentFrame,         m_cameraPlayer, &cs::CameraPlayer::onSaveCurrentFrame);
+            connect(this, &CameraPlayerDialog::playToggled,              m_cameraPlayer, &cs::CameraPlayer::onPlayToggled);
+            connect(m_cameraPlayer, &cs::CameraPlayer::playFrameChanged, this, &CameraPlayerDialog::onPlayFrameChanged);
+            connect(m_cameraPlayer, &cs::CameraPlayer::playingChanged,   this, &CameraPlayerDialog::onPlayingChanged);
         }
 
         emit loadFile(filePath);
@@ -290,8 +297,24 @@ void CameraPlayerDialog::onClickedSave()
     }
 }
 
+void CameraPlayerDialog::onPlayFrameChanged(int curFrame)
+{
+    // the player moves to the frame already, don't request it again
+    QSignalBlocker blocker(m_ui->frameNumberSlider);
+    m_ui->frameNumberSlider->setValue(curFrame);
+    m_ui->frameEdit->setText(QString::number(curFrame));
+}
+
+void CameraPlayerDialog::onPlayingChanged(bool playing)
+{
+    QSignalBlocker blocker(m_ui->playButton);
+    m_ui->playButton->setChecked(playing);
+    m_ui->playButton->setToolTip(playing ? tr("Pause") : tr("Play"));
+}
+
 void CameraPlayerDialog::onTranslate()
 {
     m_ui->retranslateUi(this);
     m_ui->captureSingleButton->setToolTip(tr("Save current frame"));
+    m_ui->playButton->setToolTip(m_ui->playButton->isChecked() ? tr("Pause") : tr("Play"));
 }
\ No newline at end of file
@@ -35,7 +35,7 @@
 
 #include <cameracapturetool.h>
 
-static QStringList captureSaveFormats = { "images", "raw" };
+static QStringList captureSaveFormats = { "images", "raw", "rvl" };
 
 CaptureSettingDialog::CaptureSettingDialog(QWidget* parent)
     : QDialog(parent)
@@ -108,9 +108,13 @@ void CaptureSettingDialog::onStartCapture()
         return;
     }
 
-    QString filters = "Zip file(*.zip)";
+    // the record file is written without compression, for capturing at high frame rate
+    const QString zipFilter = "Zip file(*.zip)";
+    const QString recordFilter = "Record file(*.csr)";
+    QString filters = zipFilter + ";;" + recordFilter;
+    QString selectedFilter = m_captureConfig.saveRecordFile ? recordFilter : zipFilter;
     QString openDir = QString("file:///%1").arg(cs::CSApplication::getInstance()->getAppConfig()->getDefaultSavePath());
-    QUrl url = QFileDialog::getSaveFileUrl(this, tr("Capture frame data"), openDir, filters);
+    QUrl url = QFileDialog::getSaveFileUrl(this, tr("Capture frame data"), openDir, filters, &selectedFilter);
 
     if (url.isValid())
     {
@@ -120,7 +124,9 @@ void CaptureSettingDialog::onStartCapture()
 
         QString name = fileInfo.fileName();
 
-        m_captureConfig.saveName = name.endsWith(".zip") ? (name.replace(name.lastIndexOf(".zip"), 4, "")) : name;
+        m_captureConfig.saveRecordFile = name.endsWith(".csr") || (!name.endsWith(".zip") && selectedFilter == recordFilter);
+        QString suffix = m_captureConfig.saveRecordFile ? ".csr" : ".zip";
+        m_captureConfig.saveName = name.endsWith(suffix) ? (name.replace(name.lastIndexOf(suffix), 4, "")) : name;
         m_captureConfig.savePointCloudWithTexture = cs::CSApplication::getInstance()->getShow3DTexture();
 
         m_isCapturing = true;
@@ -193,6 +199,11 @@ void CaptureSettingDialog::onSaveFormatChanged(int index)
     }
 }
 
+void CaptureSettingDialog::onBinaryPlyChanged(bool checked)
+{
+    m_captureConfig.savePointCloudBinary = checked;
+}
+
 void CaptureSettingDialog::onCaptureFrameNumberChanged()
 {
     auto tex = m_ui->frameNumberLineEdit->text();
@@ -246,6 +257,7 @@ void CaptureSettingDialog::initDialog()
     // save format combobox
     m_ui->saveFormatComboBox->addItems(captureSaveFormats); 
     m_ui->frameNumberLineEdit->setText(QString::number(m_captureConfig.captureNumber));
+    m_ui->binaryPlyCheckBox->setChecked(m_captureConfig.savePointCloudBinary);
 
     m_ui->saveFormatComboBox->setView(new QListView(m_ui->saveFormatComboBox));
 }
@@ -262,6 +274,7 @@ void CaptureSettingDialog::initConnections()
     }
 
     suc &= (bool)connect(m_ui->saveFormatComboBox,  QOverload<int>::of(&QComboBox::currentIndexChanged), this, &CaptureSettingDialog::onSaveFormatChanged);
+    suc &= (bool)connect(m_ui->binaryPlyCheckBox,   &QCheckBox::toggled, this, &CaptureSettingDialog::onBinaryPlyChanged);
     auto app = cs::CSApplication::getInstance();
     suc &= (bool)connect(app, &cs::CSApplication::captureNumberUpdated, this, &CaptureSettingDialog::onCaptureNumberUpdated);
     suc &= (bool)connect(app, &cs::CSApplication::captureStateChanged,  this, &CaptureSettingDialog::onCaptureStateChanged);
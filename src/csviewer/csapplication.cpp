@@ -34,6 +34,8 @@
 #include "process/pointcloudprocessstrategy.h"
 #include "process/depthprocessstrategy.h"
 #include "process/rgbprocessstrategy.h"
+#include "process/depthpreprocessstrategy.h"
+#include "process/rgbpreprocessstrategy.h"
 
 using namespace cs;
 
@@ -63,6 +65,8 @@ CSApplication::CSApplication()
     m_processStrategys[cs::STRATEGY_DEPTH] = nullptr;
     m_processStrategys[cs::STRATEGY_RGB] = nullptr;
     m_processStrategys[cs::STRATEGY_CLOUD_POINT] = nullptr;
+    m_processStrategys[cs::STRATEGY_DEPTH_PREPROCESS] = nullptr;
+    m_processStrategys[cs::STRATEGY_RGB_PREPROCESS] = nullptr;
 }
 
 CSApplication::~CSApplication()
@@ -89,6 +93,13 @@ void CSApplication::start()
 {
     initConnections();
 
+    // e.g. CS_SIMULATED_CAMERA="file=capture.zip;fps=30;jitter=5;drop=0.01"
+    if (qEnvironmentVariableIsSet(SIMULATED_CAMERA_ENV))
+    {
+        auto config = SimulatedCameraConfig::fromString(qEnvironmentVariable(SIMULATED_CAMERA_ENV));
+        m_cameraThread->setSimulatedCamera(true, config);
+    }
+
     m_cameraThread->start();
 
     auto camera = m_cameraThread->getCamera();
@@ -121,6 +132,7 @@ void CSApplication::initConnections()
 
     suc &= (bool)connect(m_cameraCaptureTool.get(), &CameraCaptureTool::captureNumberUpdated, this, &CSApplication::captureNumberUpdated);
     suc &= (bool)connect(m_cameraCaptureTool.get(), &CameraCaptureTool::captureStateChanged,  this, &CSApplication::captureStateChanged);
+    suc &= (bool)connect(m_cameraCaptureTool.get(), &CameraCaptureTool::captureStateChanged,  this, &CSApplication::onCaptureStateChanged);
 
     suc &= (bool)connect(this,  &CSApplication::connectCamera,      m_cameraThread.get(),  &CameraThread::onConnectCamera);
     suc &= (bool)connect(this,  &CSApplication::disconnectCamera,   m_cameraThread.get(),  &CameraThread::onDisconnectCamera);
@@ -150,6 +162,17 @@ void CSApplication::onCameraStateChanged(int state)
     case CAMERA_CONNECTED:
         updateProcessStrategys();
         break;
+    case CAMERA_STARTED_STREAM:
+        resetPipelineStats();
+        break;
+    case CAMERA_STOPPED_STREAM:
+    {
+        // report the process queue once per stream instead of once per dropped frame
+        const FrameQueueStats queueStats = m_processThread->getQueueStats();
+        qInfo() << "process queue, received:" << queueStats.receivedCount << ", processed:" << queueStats.processedCount
+            << ", dropped:" << queueStats.droppedCount << ", skipped:" << queueStats.skippedCount;
+        break;
+    }
     default:
         break;
     }
@@ -183,12 +206,14 @@ void CSApplication::updateProcessStrategys()
 
     m_processStrategys[cs::STRATEGY_CLOUD_POINT] = new PointCloudProcessStrategy();
     m_processStrategys[cs::STRATEGY_DEPTH] = new DepthProcessStrategy();
+    m_processStrategys[cs::STRATEGY_DEPTH_PREPROCESS] = new DepthPreprocessStrategy();
 
     QVariant hasRgbV;
     m_cameraThread->getCamera()->getCameraPara(cs::parameter::PARA_HAS_RGB, hasRgbV);
     if (hasRgbV.toBool())
     {
         m_processStrategys[cs::STRATEGY_RGB] = new RgbProcessStrategy();
+        m_processStrategys[cs::STRATEGY_RGB_PREPROCESS] = new RgbPreprocessStrategy();
     }
 
     // add process strategys
@@ -199,8 +224,9 @@ void CSApplication::updateProcessStrategys()
         {
             // init connections
             bool suc = true;
-            suc &= (bool)connect(stra, &ProcessStrategy::output2DUpdated, this, &CSApplication::output2DUpdated);
-            suc &= (bool)connect(stra, &ProcessStrategy::output3DUpdated, this, &CSApplication::output3DUpdated);
+            // forward on the process thread, the receivers decide how to pass the outputs to the ui thread
+            suc &= (bool)connect(stra, &ProcessStrategy::output2DUpdated, this, &CSApplication::output2DUpdated, Qt::DirectConnection);
+            suc &= (bool)connect(stra, &ProcessStrategy::output3DUpdated, this, &CSApplication::output3DUpdated, Qt::DirectConnection);
 
             Q_ASSERT(suc);
 
@@ -212,6 +238,16 @@ void CSApplication::updateProcessStrategys()
 
 void CSApplication::onWindowLayoutChanged(QVector<int> windows)
 {
+    m_windows = windows;
+    updateStrategysEnable();
+}
+
+void CSApplication::updateStrategysEnable()
+{
+    const QVector<int>& windows = m_windows;
+    // without depth output the depth strategy only outputs the IR images
+    const bool outputDepth = windows.contains(CAMERA_DATA_DEPTH) || m_captureNeedsDepth;
+
     for (auto straType : m_processStrategys.keys())
     {
         auto stra = m_processStrategys[straType];
@@ -219,8 +255,9 @@ void CSApplication::onWindowLayoutChanged(QVector<int> windows)
         {
             if (straType == STRATEGY_DEPTH)
             {
-                bool enable = windows.contains(CAMERA_DATA_L) || windows.contains(CAMERA_DATA_R) || windows.contains(CAMERA_DATA_DEPTH);
+                bool enable = windows.contains(CAMERA_DATA_L) || windows.contains(CAMERA_DATA_R) || outputDepth;
                 stra->setStrategyEnable(enable);
+                stra->setProperty("outputDepth", outputDepth);
             }
             else if (straType == STRATEGY_CLOUD_POINT)
             {
@@ -231,6 +268,16 @@ void CSApplication::onWindowLayoutChanged(QVector<int> windows)
             {
                 stra->setStrategyEnable(windows.contains(CAMERA_DATA_RGB));
             }
+            else if (straType == STRATEGY_DEPTH_PREPROCESS)
+            {
+                bool enable = outputDepth || windows.contains(CAMERA_DATA_POINT_CLOUD);
+                stra->setStrategyEnable(enable);
+            }
+            else if (straType == STRATEGY_RGB_PREPROCESS)
+            {
+                bool enable = windows.contains(CAMERA_DATA_RGB) || windows.contains(CAMERA_DATA_POINT_CLOUD);
+                stra->setStrategyEnable(enable);
+            }
         }
     }
 }
@@ -255,9 +302,36 @@ void CSApplication::onShowCoordChanged(bool show, QPointF pos)
 
 void CSApplication::startCapture(CameraCaptureConfig config, bool autoName)
 {
+    // do not drop frames while capturing multiple frames
+    if (config.captureType == CAPTURE_TYPE_MULTIPLE)
+    {
+        m_processThread->setQueuePolicy(QUEUE_POLICY_FIFO);
+    }
+
+    // the point cloud is saved only if the depth is output, see OutputSaver::savePointCloud
+    if (config.captureDataTypes.contains(CAMERA_DATA_POINT_CLOUD))
+    {
+        m_captureNeedsDepth = true;
+        updateStrategysEnable();
+    }
+
     m_cameraCaptureTool->startCapture(config, autoName);
 }
 
+void CSApplication::onCaptureStateChanged(int captureType, int state, QString message)
+{
+    if (state == CAPTURE_FINISHED || state == CAPTURE_ERROR)
+    {
+        m_processThread->setQueuePolicy(QUEUE_POLICY_LATEST);
+
+        if (m_captureNeedsDepth)
+        {
+            m_captureNeedsDepth = false;
+            updateStrategysEnable();
+        }
+    }
+}
+
 void CSApplication::setCurOutputData(const CameraCaptureConfig& config)
 {
     m_cameraCaptureTool->setCurOutputData(config);
@@ -276,4 +350,15 @@ std::shared_ptr<AppConfig> CSApplication::getAppConfig()
 bool CSApplication::getShow3DTexture() const
 {
     return m_show3DTexture;
+}
+
+PipelineStatsSnapshot CSApplication::getPipelineStats() const
+{
+    return PipelineStats::getInstance()->snapshot();
+}
+
+void CSApplication::resetPipelineStats()
+{
+    PipelineStats::getInstance()->reset();
+    m_processThread->resetQueueStats();
 }
\ No newline at end of file
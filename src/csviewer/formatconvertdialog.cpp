@@ -67,14 +67,14 @@ void FormatConvertDialog::onClickedBrowseSource()
     qInfo() << "click select source file";
     QString openDir = QString("file:///%1").arg(cs::CSApplication::getInstance()->getAppConfig()->getDefaultSavePath());
 
-    QString filters = "Zip file(*.zip)";
+    QString filters = "Captured file(*.zip *.csr);;Zip file(*.zip);;Record file(*.csr)";
     QUrl url = QFileDialog::getOpenFileUrl(this, tr("Select source file"), openDir, filters);
 
     if (url.isValid())
     {
         QString filePath = url.toLocalFile();
 
-        if (!filePath.endsWith(".zip"))
+        if (!filePath.endsWith(".zip") && !filePath.endsWith(".csr"))
         {
             filePath += ".zip";
         }
@@ -31,10 +31,12 @@ public:
     void setLanguage(QString lan);
     void setDefaultSavePath(QString path);
     void setAutoNameWhenCapturing(bool autoName);
+    void setRenderPointBudget(int budget);
 
     QString getLanguage() const;
     QString getDefaultSavePath() const;
     bool getAutoNameWhenCapturing() const;
+    int getRenderPointBudget() const;
 
 private:
     void save();
@@ -48,6 +50,8 @@ private:
     QString m_language;
     // Auto name when capturing
     bool m_autoNameWhenCaptring = false;
+    // max number of points drawn in the 3D view, 0 is unlimited
+    int m_renderPointBudget = 0;
 };
 
 #endif //_CS_APP_CONFIG_H
\ No newline at end of file
@@ -55,8 +55,9 @@ signals:
     void loadFile(QString file);
     void currentFrameUpdated(int curFrame, bool updateForce = false);
     void output2DUpdated(OutputData2D outputData);
-    void output3DUpdated(cs::Pointcloud pointCloud, const QImage& image);
+    void output3DUpdated(cs::Pointcloud pointCloud, const QImage& image, qint64 receivedTime);
     void saveCurrentFrame(QString filePath);
+    void playToggled(bool play);
 private:
     void onPlayReady();
     void updateFrameRange(int frameNumer);
@@ -65,6 +66,8 @@ private slots:
     void onSliderValueChanged();
     void onLineEditFinished();
     void onClickedSave();
+    void onPlayFrameChanged(int curFrame);
+    void onPlayingChanged(bool playing);
 private:
     Ui::CameraPlayerWidget* m_ui;
     cs::CameraPlayer* m_cameraPlayer;
@@ -49,6 +49,7 @@ private slots:
     
     void onDataTypeChanged();
     void onSaveFormatChanged(int index);
+    void onBinaryPlyChanged(bool checked);
     void onCaptureFrameNumberChanged();
 private:
     void initDefaultCaptureConfig();
@@ -23,6 +23,7 @@
 #include <QImage>
 #include <memory>
 #include <cstypes.h>
+#include <pipelinestats.h>
 
 #include <hpp/Processing.hpp>
 
@@ -53,6 +54,10 @@ public:
 
     std::shared_ptr<AppConfig> getAppConfig();
     bool getShow3DTexture() const;
+
+    // latencies and drops of the frame pipeline since the last reset
+    PipelineStatsSnapshot getPipelineStats() const;
+    void resetPipelineStats();
 public slots:
     void onWindowLayoutChanged(QVector<int> windows);
     void onShowCoordChanged(bool show, QPointF pos);
@@ -70,7 +75,7 @@ signals:
 
     void cameraStateChanged(int state);
     void output2DUpdated(OutputData2D outputData);
-    void output3DUpdated(cs::Pointcloud pointCloud, const QImage& image);
+    void output3DUpdated(cs::Pointcloud pointCloud, const QImage& image, qint64 receivedTime);
     void removedCurrentCamera(QString serial);
 
     // save frame data
@@ -81,11 +86,13 @@ signals:
 private slots:
     void onCameraStateChanged(int state);
     void onCameraParaUpdated(int paraId, QVariant value);
+    void onCaptureStateChanged(int captureType, int state, QString message);
 private:
     CSApplication();    
     void initConnections();
     void disconnections();
     void updateProcessStrategys();
+    void updateStrategysEnable();
 private:
     std::shared_ptr<CameraThread> m_cameraThread;
     std::shared_ptr<Processor> m_processor;
@@ -97,6 +104,11 @@ private:
     std::shared_ptr<AppConfig> m_appConfig;
 
     bool m_show3DTexture = false;
+
+    // the windows shown in the layout
+    QVector<int> m_windows;
+    // the depth is output while capturing the point cloud, even if the depth window is not shown
+    bool m_captureNeedsDepth = false;
 };
 }
 
@@ -28,12 +28,18 @@
 #include <QPainter>
 #include <QPushButton>
 #include <QScrollArea>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
 
 #include <osgQOpenGL/osgQOpenGLWidget>
 #include <osgViewer/Viewer>
 #include <osg/Camera>
 #include <osg/MatrixTransform>
 #include <osg/Material>
+#include <osg/Geode>
+#include <osg/Geometry>
 #include <cstypes.h>
 #include <hpp/Processing.hpp>
 
@@ -78,8 +84,12 @@ public:
     void hideRenderFps();
     void setShowFullScreen(bool value) override;
     void onTranslate() override;
+    bool eventFilter(QObject* watched, QEvent* event) override;
 public slots:
     void onRenderDataUpdated(OutputData2D outputData);
+signals:
+    // the size the images are displayed at, empty if hidden
+    void imageSizeChanged(int renderId, QSize size);
 protected:
     void initWidget();
     void onFrameIncrease();
@@ -183,6 +193,7 @@ protected:
     osg::Vec3 m_translate;
 };
 
+class PointCloudPrepareTask;
 class RenderWidget3D : public RenderWidget
 {
     Q_OBJECT
@@ -193,17 +204,44 @@ public:
     void onTranslate() override;
     void setTextureEnable(bool enable);
     void setShowFullScreen(bool value) override;
+    // the max number of points drawn while streaming or interacting, 0 is unlimited
+    void setPointBudget(int budget);
+    bool eventFilter(QObject* watched, QEvent* event) override;
 public slots:
+    // the data of pointCloud is taken by the widget, the geometry is prepared on a worker thread
     void onRenderDataUpdated(cs::Pointcloud& pointCloud, const QImage& image);
 protected slots:
     void initWindow();
     void resizeEvent(QResizeEvent* event) override;
-
+private slots:
+    void onGeometryPrepared();
+    void onRefineTimeout();
 private:
+    // point cloud geometry with persistent arrays, only the first count points are drawn
+    struct PointCloudGeometry
+    {
+        osg::ref_ptr<osg::Geometry> geom;
+        osg::ref_ptr<osg::Vec3Array> vertexs;
+        osg::ref_ptr<osg::Vec3Array> normals;
+        osg::ref_ptr<osg::Vec3ubArray> colors;
+        osg::ref_ptr<osg::DrawArrays> drawArrays;
+        bool hasColor = false;
+        // every stride-th point of the point cloud is drawn
+        int stride = 1;
+    };
+
+    friend class PointCloudPrepareTask;
+
     void initNode();
-    void updateNodeVertexs(cs::Pointcloud& pointCloud);
-    void updateNodeTexture(cs::Pointcloud& pointCloud, const QImage& image);
-    void refresh();
+    void initGeometry(PointCloudGeometry& geometry);
+    void prepareGeometry();
+    void updateGeometryCapacity(PointCloudGeometry& geometry, int count);
+    void updateGeometryColors(PointCloudGeometry& geometry, cs::Pointcloud& pointCloud, const QImage& image, int count, int stride);
+    int getDisplayStride(int count) const;
+    void updateGeometryState();
+    void requestPrepare();
+    void onViewInteracted();
+    void requestRedraw();
     void updateButtonArea();
     void initButtons();
     osg::ref_ptr<osg::MatrixTransform> makeCoordinate();
@@ -216,7 +254,7 @@ private:
     osg::ref_ptr<osg::Group> m_rootNode;
     osg::ref_ptr<osg::MatrixTransform> m_sceneNode;
     osg::ref_ptr<osg::Material> m_material;
-    osg::ref_ptr<osg::Geometry> m_geom;
+    osg::ref_ptr<osg::Geode> m_geode;
     osg::ref_ptr<CSCustomCamera> m_trackballCamera;
 
     QPushButton* m_homeButton;
@@ -232,7 +270,30 @@ private:
     bool m_isReady = false;
     bool m_isFirstFrame = true;
 
-    cs::Pointcloud m_lastPointCloud;
-    QImage m_lastTextureImage;
+    // double buffered geometry, the front one is in the scene graph, the back one is prepared by the worker
+    PointCloudGeometry m_geometrys[2];
+    int m_frontIndex = 0;
+
+    // the latest data waiting to be prepared, guarded by m_pendingMutex
+    QMutex m_pendingMutex;
+    cs::Pointcloud m_pendingPointCloud;
+    QImage m_pendingImage;
+    bool m_hasPendingData = false;
+
+    // the data the back geometry is prepared from, only used by the worker
+    cs::Pointcloud m_sourcePointCloud;
+    QImage m_sourceImage;
+
+    // the worker is preparing, or the back geometry is waiting to be swapped in
+    bool m_isPreparing = false;
+    bool m_needPrepare = false;
+    std::atomic<bool> m_textureEnabled;
+
+    // level of detail, the budget stride is halved for every refine level
+    std::atomic<int> m_pointBudget;
+    std::atomic<int> m_refineLevel;
+    QTimer* m_refineTimer;
+
+    QThreadPool m_threadPool;
 };
 #endif // _CS_RENDERWIDGET2D_H
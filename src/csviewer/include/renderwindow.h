@@ -23,9 +23,13 @@
 #include <QWidget>
 #include <QVBoxLayout>
 #include <QImage>
+#include <QMutex>
 #include <cstypes.h>
+#include <pipelinestats.h>
 #include <hpp/Processing.hpp>
 
+class QLabel;
+class QTimer;
 class RenderWidget;
 class RenderWindow : public QWidget
 {
@@ -38,7 +42,14 @@ public:
     void hideRenderFps();
     void setShowTextureEnable(bool enable);
     void onTranslate();
+    // show the latencies and drops of the frame pipeline over the render widgets
+    void setStatsOverlayVisible(bool visible);
+    // the max number of points the 3D view draws while streaming, 0 is unlimited
+    void setPointBudget(int budget);
+protected:
+    void resizeEvent(QResizeEvent* event) override;
 signals:
+    void output2DPrepared(OutputData2D outputData);
     void roiRectFUpdated(QRectF rect);
     void renderExit(int renderId);
     void fullScreenUpdated(int renderID, bool value);
@@ -46,13 +57,17 @@ signals:
 public slots:
     void onRenderWindowsUpdated(QVector<int> windows);
     void onWindowLayoutModeUpdated(int mode);
+    // exec on the thread emitting the output, scale the image for its render widget and pass it to the ui thread
+    void prepareOutput2D(OutputData2D outputData);
     void onOutput2DUpdated(OutputData2D outputData);
-    void onOutput3DUpdated(cs::Pointcloud pointCloud, const QImage& image);
+    void onOutput3DUpdated(cs::Pointcloud pointCloud, const QImage& image, qint64 receivedTime);
     void onRoiEditStateChanged(bool edit,  QRectF rect);
 
 private slots:
     void onFullScreenUpdated(int renderId, bool value);
     void onShow3DTextureChanged(bool texture);
+    void onRenderImageSizeChanged(int renderId, QSize size);
+    void onStatsTimeout();
 private:
     void initRenderWidgetsTitle();
     void initRenderWidgetsTab();
@@ -61,6 +76,7 @@ private:
     void initGridLayout();
 
     void setRender3DTextureVisible(bool visible);
+    void updateStatsOverlayGeometry();
 private:
     WINDOWLAYOUT_MODE layoutMode = LAYOUT_TILE;// LAYOUT_TITLE;
     QVector<int> displayWindows;
@@ -71,6 +87,16 @@ private:
     QLayout* rootLayout;
     bool show3DTexture = false;
     bool showTextureEnable = true;
+    int pointBudget = 0;
+
+    // the image size of the visible 2D render widgets, guarded by displaySizeMutex
+    QMap<int, QSize> displaySizes;
+    QMutex displaySizeMutex;
+
+    QLabel* statsOverlay = nullptr;
+    QTimer* statsTimer = nullptr;
+    // the stats of the last refresh, the overlay shows the stats since then
+    cs::PipelineStatsSnapshot lastStats;
 };
 
 #endif //_CS_RENDER_WINDOWS_H
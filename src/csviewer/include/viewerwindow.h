@@ -96,6 +96,8 @@ private slots:
     void onTriggeredAbout();
     void onTriggeredGithub();
     void onTriggeredWebsite();
+    void onTriggeredRecordTrace(bool record);
+    void onTriggeredSaveTrace();
 
     void onAppExit();
 private slots:
@@ -108,6 +110,7 @@ private slots:
     void onTriggeredWindowsTile();
     void onTriggeredWindowsTabs();
     void onAutoNameMenuTriggered(QAction* action);
+    void onPointBudgetMenuTriggered(QAction* action);
 
     void onRenderExit(int renderId);
     void onWindowLayoutChanged();
@@ -100,6 +100,9 @@ void RenderWidget2D::initWidget()
     m_fpsLabel->setObjectName("fpsLabel");
     m_titleLabel->setVisible(false);
 
+    // feed the image size back to the producer of the images
+    m_imageLabel->installEventFilter(this);
+
     updateFps();
 }
 
@@ -143,8 +146,17 @@ void RenderWidget2D::onRenderDataUpdated(OutputData2D outputData)
 
     m_cachedImage = outputData.image;
 
-    QPixmap pixmap = QPixmap::fromImage(outputData.image);
-    pixmap = pixmap.scaled(m_imageLabel->size());
+    // the image is scaled by the producer, scale it here only if the size has changed since then
+    QPixmap pixmap;
+    if (outputData.displayImage.size() == m_imageLabel->size())
+    {
+        pixmap = QPixmap::fromImage(std::move(outputData.displayImage));
+    }
+    else
+    {
+        pixmap = QPixmap::fromImage(outputData.image);
+        pixmap = pixmap.scaled(m_imageLabel->size());
+    }
     m_painter.begin(&pixmap);
     //painter
     onPainterInfos(outputData);
@@ -381,6 +393,30 @@ void RenderWidget2D::onTranslate()
 
 }
 
+bool RenderWidget2D::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == m_imageLabel)
+    {
+        switch (event->type())
+        {
+        case QEvent::Resize:
+        case QEvent::Show:
+            if (m_imageLabel->isVisible())
+            {
+                emit imageSizeChanged(m_renderId, m_imageLabel->size());
+            }
+            break;
+        case QEvent::Hide:
+            emit imageSizeChanged(m_renderId, QSize());
+            break;
+        default:
+            break;
+        }
+    }
+
+    return RenderWidget::eventFilter(watched, event);
+}
+
 DepthRenderWidget2D::DepthRenderWidget2D(int renderId, QWidget* parent)
     : RenderWidget2D(renderId, parent)
     , m_mousePressPoint(0,0)
@@ -23,6 +23,8 @@
 #include <QDebug>
 #include <QHBoxLayout>
 #include <QPushButton>
+#include <QRunnable>
+#include <QMouseEvent>
 #include <osgViewer/Viewer>
 #include <osg/Node>
 #include <osg/Multisample>
@@ -37,10 +39,41 @@
 #include <osg/LineWidth>
 
 #include <osg/ShapeDrawable>
+#include <cstracer.h>
 
 #define AXIS_LEN  40
 #define AXIS_RADIUS 3
 
+// the arrays grow with some headroom and shrink when the point count drops below 1/4 of the capacity
+#define GEOMETRY_CAPACITY_HEADROOM(count) ((count) + (count) / 4)
+#define GEOMETRY_CAPACITY_SHRINK_RATIO 4
+// the decimated point cloud is refined step by step when no frame arrives and the view is not moved
+#define REFINE_IDLE_MS 300
+
+class PointCloudPrepareTask : public QRunnable
+{
+public:
+    PointCloudPrepareTask(RenderWidget3D* widget)
+        : m_widget(widget)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_widget->prepareGeometry();
+    }
+private:
+    RenderWidget3D* m_widget;
+};
+
+static void swapPointCloud(cs::Pointcloud& first, cs::Pointcloud& second)
+{
+    first.getVertices().swap(second.getVertices());
+    first.getNormals().swap(second.getNormals());
+    first.getTexcoords().swap(second.getTexcoords());
+}
+
 CSCustomCamera::CSCustomCamera()
 {
     initCamera();
@@ -113,7 +146,19 @@ RenderWidget3D::RenderWidget3D(int renderId, QWidget* parent)
     , m_topItem(new QWidget(this))
     , m_bottomItem(new QWidget(this))
     , m_exitButton(new QPushButton(this))
+    , m_textureEnabled(false)
+    , m_pointBudget(0)
+    , m_refineLevel(0)
+    , m_refineTimer(new QTimer(this))
 {
+    // one worker, the frames are prepared in order and the latest one wins
+    m_threadPool.setMaxThreadCount(1);
+    initGeometry(m_geometrys[0]);
+    initGeometry(m_geometrys[1]);
+
+    m_refineTimer->setSingleShot(true);
+    m_refineTimer->setInterval(REFINE_IDLE_MS);
+
     QHBoxLayout* pLayout = new QHBoxLayout(this);
     pLayout->setMargin(2);
     pLayout->addWidget(m_osgQOpenGLWidgetPtr);
@@ -123,13 +168,17 @@ RenderWidget3D::RenderWidget3D(int renderId, QWidget* parent)
     initButtons();
     updateButtonArea();
 
-    bool suc = connect(m_osgQOpenGLWidgetPtr, SIGNAL(initialized()), this, SLOT(initWindow()));
+    m_osgQOpenGLWidgetPtr->installEventFilter(this);
+
+    bool suc = true;
+    suc &= (bool)connect(m_osgQOpenGLWidgetPtr, SIGNAL(initialized()), this, SLOT(initWindow()));
+    suc &= (bool)connect(m_refineTimer, &QTimer::timeout, this, &RenderWidget3D::onRefineTimeout);
     Q_ASSERT(suc);
 }
 
 RenderWidget3D::~RenderWidget3D()
 {
-
+    m_threadPool.waitForDone();
 }
 
 void RenderWidget3D::resizeEvent(QResizeEvent* event)
@@ -240,152 +289,333 @@ void RenderWidget3D::initWindow()
     m_osgQOpenGLWidgetPtr->mutex()->writeUnlock();
 }
 
-void RenderWidget3D::updateNodeVertexs(cs::Pointcloud& pointCloud)
+void RenderWidget3D::onRenderDataUpdated(cs::Pointcloud& pointCloud, const QImage& image)
+{
+    m_pendingMutex.lock();
+    // take the data instead of copying it, an unprepared frame is replaced by the latest one
+    swapPointCloud(m_pendingPointCloud, pointCloud);
+    m_pendingImage = image;
+    m_hasPendingData = true;
+    m_pendingMutex.unlock();
+
+    // a new frame is drawn within the budget
+    m_refineLevel = 0;
+    requestPrepare();
+}
+
+void RenderWidget3D::requestPrepare()
+{
+    if (m_isPreparing)
+    {
+        m_needPrepare = true;
+        return;
+    }
+
+    m_isPreparing = true;
+    m_needPrepare = false;
+    m_threadPool.start(new PointCloudPrepareTask(this));
+}
+
+// exec on the worker thread, fill the back geometry which is not in the scene graph
+void RenderWidget3D::prepareGeometry()
 {
-    auto vertexArr = dynamic_cast<osg::Vec3Array*>(m_geom->getVertexArray());
-    auto normalArr = dynamic_cast<osg::Vec3Array*>(m_geom->getNormalArray());
-   
-    const int num_ver = qMin(pointCloud.getNormals().size(), pointCloud.getVertices().size());
-    vertexArr->resize(num_ver);
-    normalArr->resize(num_ver);
+    CS_TRACE_SCOPE("RenderWidget3D::prepareGeometry");
+
+    m_pendingMutex.lock();
+    if (m_hasPendingData)
+    {
+        swapPointCloud(m_sourcePointCloud, m_pendingPointCloud);
+        m_sourceImage = m_pendingImage;
+        m_pendingImage = QImage();
+        m_hasPendingData = false;
+    }
+    m_pendingMutex.unlock();
+
+    PointCloudGeometry& geometry = m_geometrys[1 - m_frontIndex];
+    const int count = (int)qMin(m_sourcePointCloud.getVertices().size(), m_sourcePointCloud.getNormals().size());
+    const int stride = getDisplayStride(count);
+    const int displayCount = (count + stride - 1) / stride;
+
+    updateGeometryCapacity(geometry, displayCount);
+    if (stride == 1 && count > 0)
+    {
+        memcpy((void*)geometry.vertexs->getDataPointer(), m_sourcePointCloud.getVertices().data(), sizeof(cs::float3) * count);
+        memcpy((void*)geometry.normals->getDataPointer(), m_sourcePointCloud.getNormals().data(), sizeof(cs::float3) * count);
+    }
+    else if (stride > 1)
+    {
+        // the points are in the row order of the depth map, so the stride samples the depth grid evenly
+        const cs::float3* pcVertex = m_sourcePointCloud.getVertices().data();
+        const cs::float3* pcNormal = m_sourcePointCloud.getNormals().data();
+        cs::float3* osgVertex = (cs::float3*)geometry.vertexs->getDataPointer();
+        cs::float3* osgNormal = (cs::float3*)geometry.normals->getDataPointer();
+
+        for (int i = 0; i < displayCount; ++i)
+        {
+            osgVertex[i] = pcVertex[i * stride];
+            osgNormal[i] = pcNormal[i * stride];
+        }
+    }
+    geometry.vertexs->dirty();
+    geometry.normals->dirty();
+
+    updateGeometryColors(geometry, m_sourcePointCloud, m_sourceImage, count, stride);
+
+    geometry.stride = stride;
+    geometry.drawArrays->setCount(displayCount);
+    geometry.geom->dirtyBound();
+    // compute the bound here instead of in the cull traversal on the ui thread
+    geometry.geom->getBound();
 
-    memcpy((void*)vertexArr->getDataPointer(), pointCloud.getVertices().data(), sizeof(cs::float3) * num_ver);
-    memcpy((void*)normalArr->getDataPointer(), pointCloud.getNormals().data(), sizeof(cs::float3) * num_ver);
+    QMetaObject::invokeMethod(this, "onGeometryPrepared", Qt::QueuedConnection);
+}
 
-    if (m_geom->getNumPrimitiveSets() > 0)
+// the arrays are only reallocated when the capacity changes, otherwise the vbos are updated in place
+void RenderWidget3D::updateGeometryCapacity(PointCloudGeometry& geometry, int count)
+{
+    const int capacity = (int)geometry.vertexs->size();
+    if (count <= capacity && count >= capacity / GEOMETRY_CAPACITY_SHRINK_RATIO)
     {
-        m_geom->removePrimitiveSet(0);
+        return;
     }
 
-    m_geom->insertPrimitiveSet(0, new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, num_ver));
+    const int newCapacity = GEOMETRY_CAPACITY_HEADROOM(count);
+    geometry.vertexs->resize(newCapacity);
+    geometry.normals->resize(newCapacity);
+    geometry.colors->resize(newCapacity);
+    geometry.colors->dirty();
 }
 
-void RenderWidget3D::updateNodeTexture(cs::Pointcloud& pointCloud, const QImage& image)
+void RenderWidget3D::updateGeometryColors(PointCloudGeometry& geometry, cs::Pointcloud& pointCloud, const QImage& image, int count, int stride)
 {
-    unsigned char* texFrame = (uchar*)image.bits();
+    geometry.hasColor = false;
+
     const int width = image.width();
     const int height = image.height();
+    const bool bTexture = (!image.isNull() && width > 0 && height > 0 && pointCloud.getTexcoords().size() >= size_t(count));
+    if (!bTexture || !m_textureEnabled)
+    {
+        return;
+    }
+
+    const QImage texImage = (image.format() == QImage::Format_RGB888) ? image : image.convertToFormat(QImage::Format_RGB888);
+    const uchar* texFrame = texImage.constBits();
+    const int bytesPerLine = texImage.bytesPerLine();
 
-    bool bTexture = (!image.isNull() && texFrame != nullptr && width > 0 && height > 0);
-    if (!bTexture || !m_textureButton->isChecked())
+    const cs::float2* pcTexcoord = pointCloud.getTexcoords().data();
+    osg::Vec3ub* osgColor = (osg::Vec3ub*)geometry.colors->getDataPointer();
+
+    for (int i = 0, j = 0; i < count; i += stride, ++j)
     {
-        osg::StateSet* ss = m_geom->getOrCreateStateSet();
-        m_geom->setColorBinding(osg::Geometry::BIND_OFF);
-        ss->setMode(GL_LIGHTING, osg::StateAttribute::ON | osg::StateAttribute::PROTECTED);
+        const int x = qBound(0, qRound(pcTexcoord[i].u * width), width - 1);
+        const int y = qBound(0, qRound(pcTexcoord[i].v * height), height - 1);
 
-        m_geom->getOrCreateStateSet()->setAttributeAndModes(m_material);
-        return;
+        const uchar* color = texFrame + y * bytesPerLine + x * 3;
+        osgColor[j].set(color[0], color[1], color[2]);
     }
-    
-    m_geom->getOrCreateStateSet()->removeAttribute(m_material);
 
-    auto colorArr = dynamic_cast<osg::Vec4Array*>(m_geom->getColorArray());
-    int numVer = qMin(pointCloud.getNormals().size(), pointCloud.getVertices().size());
-    numVer = qMin(pointCloud.getTexcoords().size(), size_t(numVer));
-    colorArr->resize(numVer);
-    
-    unsigned char* color;
-    cs::float2* pcTexcoord = pointCloud.getTexcoords().data();
-    osg::Vec4* osgColor = (osg::Vec4*)colorArr->getDataPointer();
-   
-    for (int i = 0; i < numVer; ++i)
+    geometry.colors->dirty();
+    geometry.hasColor = true;
+}
+
+void RenderWidget3D::onGeometryPrepared()
+{
+    CS_TRACE_SCOPE("RenderWidget3D::swapGeometry");
+
+    m_osgQOpenGLWidgetPtr->mutex()->writeLock();
+    PointCloudGeometry& front = m_geometrys[m_frontIndex];
+    PointCloudGeometry& back = m_geometrys[1 - m_frontIndex];
+    if (m_isReady)
+    {
+        m_geode->replaceDrawable(front.geom, back.geom);
+    }
+    m_frontIndex = 1 - m_frontIndex;
+
+    if (m_isReady)
     {
-        int x = qRound(pcTexcoord[i].u * width);
-        x = (x >= width) ? (width - 1) : x;
+        updateGeometryState();
 
-        int y = qRound(pcTexcoord[i].v * height);
-        y = (y >= height) ? (height - 1) : y;
+        if (m_isFirstFrame)
+        {
+            osgViewer::Viewer* pViewer = m_osgQOpenGLWidgetPtr->getOsgViewer();
+            if (pViewer)
+            {
+                pViewer->home();
+            }
 
-        color = texFrame + (y * width + x) * 3;
-        osgColor[i] = std::move(osg::Vec4(color[0] / 255.f, color[1] / 255.f, color[2] / 255.f, 1.f));
+            m_isFirstFrame = false;
+        }
+
+        requestRedraw();
     }
+    m_osgQOpenGLWidgetPtr->mutex()->writeUnlock();
 
-    osg::StateSet* ss = m_geom->getOrCreateStateSet();
-    m_geom->setColorArray(colorArr);
-    m_geom->setColorBinding(osg::Geometry::BIND_PER_VERTEX);
-    ss->setMode(GL_LIGHTING, osg::StateAttribute::ON | osg::StateAttribute::PROTECTED);
+    // refine the decimated point cloud if no other frame arrives
+    if (m_geometrys[m_frontIndex].stride > 1)
+    {
+        m_refineTimer->start();
+    }
+    else
+    {
+        m_refineTimer->stop();
+    }
+
+    m_isPreparing = false;
+    if (m_needPrepare)
+    {
+        requestPrepare();
+    }
 }
 
-void RenderWidget3D::onRenderDataUpdated(cs::Pointcloud& pointCloud, const QImage& image)
+// exec on the worker thread
+int RenderWidget3D::getDisplayStride(int count) const
 {
-    m_lastPointCloud = pointCloud;
-    m_lastTextureImage = image;
+    const int budget = m_pointBudget;
+    if (budget <= 0 || count <= budget)
+    {
+        return 1;
+    }
 
-    m_osgQOpenGLWidgetPtr->mutex()->writeLock();
-    if (!m_isReady)
+    const int stride = (count + budget - 1) / budget;
+    return qMax(1, stride >> qMin(int(m_refineLevel), 30));
+}
+
+void RenderWidget3D::setPointBudget(int budget)
+{
+    budget = qMax(0, budget);
+    if (budget == m_pointBudget)
     {
-        m_osgQOpenGLWidgetPtr->mutex()->writeUnlock();
         return;
     }
 
-    // update vertexs
-    updateNodeVertexs(pointCloud);
+    m_pointBudget = budget;
+    m_refineLevel = 0;
+    requestPrepare();
+}
+
+void RenderWidget3D::onRefineTimeout()
+{
+    // wait until the view is released
+    if (QApplication::mouseButtons() != Qt::NoButton && m_osgQOpenGLWidgetPtr->underMouse())
+    {
+        m_refineTimer->start();
+        return;
+    }
 
-    //update texture
-    updateNodeTexture(pointCloud, image);
+    m_refineLevel++;
+    requestPrepare();
+}
 
-    //draw
-    refresh();
+// the view is drawn within the budget while it is moved
+void RenderWidget3D::onViewInteracted()
+{
+    if (m_refineLevel > 0)
+    {
+        m_refineLevel = 0;
+        requestPrepare();
+    }
+    else if (m_geometrys[m_frontIndex].stride > 1)
+    {
+        m_refineTimer->start();
+    }
+}
 
-    if (m_isFirstFrame)
+bool RenderWidget3D::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == m_osgQOpenGLWidgetPtr)
     {
-        osgViewer::Viewer* pViewer = m_osgQOpenGLWidgetPtr->getOsgViewer();
-        if (pViewer)
+        switch (event->type())
         {
-            pViewer->home();
+        case QEvent::MouseButtonPress:
+        case QEvent::Wheel:
+            onViewInteracted();
+            break;
+        case QEvent::MouseMove:
+            if (static_cast<QMouseEvent*>(event)->buttons() != Qt::NoButton)
+            {
+                onViewInteracted();
+            }
+            break;
+        default:
+            break;
         }
-
-        m_isFirstFrame = false;
     }
-    
-    m_osgQOpenGLWidgetPtr->mutex()->writeUnlock();
+
+    return RenderWidget::eventFilter(watched, event);
 }
 
-void RenderWidget3D::refresh()
+// must be called with the mutex of m_osgQOpenGLWidgetPtr locked
+void RenderWidget3D::updateGeometryState()
 {
-    osgViewer::Viewer* pViewer = m_osgQOpenGLWidgetPtr->getOsgViewer();
-    static bool firstFlag = true;
-    if (firstFlag)
+    if (!m_geode.valid())
     {
-        pViewer->home();
-        firstFlag = false;
+        return;
     }
-   
-    m_geom->setUseVertexBufferObjects(true);
-    m_geom->setUseDisplayList(false);
 
-    m_geom->getVertexArray()->dirty();
-    m_geom->getNormalArray()->dirty();
-    m_geom->getColorArray()->dirty();
+    PointCloudGeometry& geometry = m_geometrys[m_frontIndex];
+    osg::StateSet* ss = m_geode->getOrCreateStateSet();
+    if (geometry.hasColor && m_textureButton->isChecked())
+    {
+        ss->removeAttribute(m_material);
+        geometry.geom->setColorBinding(osg::Geometry::BIND_PER_VERTEX);
+    }
+    else
+    {
+        geometry.geom->setColorBinding(osg::Geometry::BIND_OFF);
+        ss->setAttributeAndModes(m_material);
+    }
+}
 
-    pViewer->requestRedraw();
+void RenderWidget3D::requestRedraw()
+{
+    osgViewer::Viewer* pViewer = m_osgQOpenGLWidgetPtr->getOsgViewer();
+    if (pViewer)
+    {
+        pViewer->requestRedraw();
+    }
 }
 
-void RenderWidget3D::initNode()
+void RenderWidget3D::initGeometry(PointCloudGeometry& geometry)
 {
+    geometry.geom = new osg::Geometry;
+    geometry.geom->setUseDisplayList(false);
+    geometry.geom->setUseVertexBufferObjects(true);
+
     // vertex
-    m_geom = new osg::Geometry;
-    m_geom->setUseDisplayList(false);
-    m_geom->setVertexArray(new osg::Vec3Array());
+    geometry.vertexs = new osg::Vec3Array();
+    geometry.geom->setVertexArray(geometry.vertexs);
 
     // normal
-    m_geom->setNormalArray(new osg::Vec3Array());
-    m_geom->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
+    geometry.normals = new osg::Vec3Array();
+    geometry.geom->setNormalArray(geometry.normals);
+    geometry.geom->setNormalBinding(osg::Geometry::BIND_PER_VERTEX);
+
+    // texture, rgb bytes normalized to [0, 1]
+    geometry.colors = new osg::Vec3ubArray();
+    geometry.colors->setNormalize(true);
+    geometry.geom->setColorArray(geometry.colors);
+    geometry.geom->setColorBinding(osg::Geometry::BIND_OFF);
+
+    // the primitive set is kept, only its count is updated
+    geometry.drawArrays = new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, 0);
+    geometry.geom->addPrimitiveSet(geometry.drawArrays);
+}
 
-    // texture
-    m_geom->setColorArray(new osg::Vec4Array());
+void RenderWidget3D::initNode()
+{
+    m_geode = new osg::Geode;
+    m_geode->addDrawable(m_geometrys[m_frontIndex].geom);
 
-    osg::StateSet* ss = m_geom->getOrCreateStateSet();
+    osg::StateSet* ss = m_geode->getOrCreateStateSet();
     ss->setMode(GL_LIGHTING, osg::StateAttribute::ON | osg::StateAttribute::PROTECTED);
 
-    m_geom->setUseVertexBufferObjects(true);
     //set point size
-    m_geom->getOrCreateStateSet()->setAttribute(new osg::Point(2));
+    ss->setAttribute(new osg::Point(2));
+
+    updateGeometryState();
 
-    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
-    geode->addDrawable(m_geom);
     osg::ref_ptr<osg::MatrixTransform> mt = new osg::MatrixTransform;
-    mt->addChild(geode);
+    mt->addChild(m_geode);
 
     m_sceneNode->addChild(mt.release());
 }
@@ -460,7 +690,7 @@ void RenderWidget3D::initButtons()
                 m_trackballButton->setToolTip(tr("Hide track ball"));
             }
 
-            onRenderDataUpdated(m_lastPointCloud, m_lastTextureImage);
+            requestRedraw();
         });
     
 
@@ -487,7 +717,17 @@ void RenderWidget3D::initButtons()
                 m_textureButton->setToolTip(tr("Texture on"));
             }
 
-            onRenderDataUpdated(m_lastPointCloud, m_lastTextureImage);
+            m_textureEnabled = toggled;
+            m_osgQOpenGLWidgetPtr->mutex()->writeLock();
+            updateGeometryState();
+            m_osgQOpenGLWidgetPtr->mutex()->writeUnlock();
+
+            // the colors are only generated when the texture is on
+            if (toggled && !m_geometrys[m_frontIndex].hasColor)
+            {
+                requestPrepare();
+            }
+            requestRedraw();
             emit show3DTextureChanged(toggled);
         });
 
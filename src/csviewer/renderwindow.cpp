@@ -23,9 +23,18 @@
 #include <QVBoxLayout>
 #include <QGridLayout>
 #include <QTabWidget>
+#include <QLabel>
+#include <QTimer>
+#include <QResizeEvent>
+#include <QMutexLocker>
+#include <cstracer.h>
 #include "renderwidget.h"
 #include "csapplication.h"
 
+// refresh interval of the stats overlay
+#define STATS_OVERLAY_INTERVAL_MS   1000
+#define STATS_OVERLAY_MARGIN        10
+
 RenderWindow::RenderWindow(QWidget* parent)
     : QWidget(parent)
 {
@@ -33,6 +42,16 @@ RenderWindow::RenderWindow(QWidget* parent)
     setAttribute(Qt::WA_StyledBackground, true);
     rootLayout = new QVBoxLayout(this);
     rootLayout->setContentsMargins(0, 0, 0, 0);
+
+    statsOverlay = new QLabel(this);
+    statsOverlay->setObjectName("StatsOverlay");
+    statsOverlay->setAttribute(Qt::WA_TransparentForMouseEvents, true);
+    statsOverlay->setTextFormat(Qt::PlainText);
+    statsOverlay->setVisible(false);
+
+    statsTimer = new QTimer(this);
+    statsTimer->setInterval(STATS_OVERLAY_INTERVAL_MS);
+
     initConnections();
 }
 
@@ -45,6 +64,8 @@ void RenderWindow::initConnections()
 {
     bool suc = true;
     suc &= (bool)connect(this, &RenderWindow::fullScreenUpdated,   this, &RenderWindow::onFullScreenUpdated, Qt::QueuedConnection);
+    suc &= (bool)connect(this, &RenderWindow::output2DPrepared,    this, &RenderWindow::onOutput2DUpdated, Qt::QueuedConnection);
+    suc &= (bool)connect(statsTimer, &QTimer::timeout,               this, &RenderWindow::onStatsTimeout);
     Q_ASSERT(suc);
 }
 
@@ -62,6 +83,10 @@ void RenderWindow::onWindowLayoutUpdated()
     renderWidgets.clear();
     onShow3DTextureChanged(false);
 
+    displaySizeMutex.lock();
+    displaySizes.clear();
+    displaySizeMutex.unlock();
+
     if (renderMainWidget)
     {
         rootLayout->removeWidget(renderMainWidget);
@@ -109,6 +134,9 @@ void RenderWindow::onWindowLayoutUpdated()
 
     setRender3DTextureVisible(showTextureEnable);
     rootLayout->addWidget(renderMainWidget);
+
+    // keep the overlay above the new render widgets
+    statsOverlay->raise();
 }
 
 void RenderWindow::onRenderWindowsUpdated(QVector<int> windows)
@@ -240,6 +268,29 @@ void RenderWindow::initRenderWidgetsTab()
     }
 }
 
+void RenderWindow::prepareOutput2D(OutputData2D outputData)
+{
+    displaySizeMutex.lock();
+    const QSize size = displaySizes.value(outputData.info.cameraDataType);
+    displaySizeMutex.unlock();
+
+    // the render widget is hidden or its size is unknown yet
+    if (!size.isEmpty() && !outputData.image.isNull())
+    {
+        CS_TRACE_SCOPE_FRAME("RenderWindow::scale2D", outputData.info.receivedTime);
+        // RGB32 is the pixmap format, so the ui thread converts it without another copy
+        outputData.displayImage = outputData.image.scaled(size).convertToFormat(QImage::Format_RGB32);
+    }
+
+    emit output2DPrepared(outputData);
+}
+
+void RenderWindow::onRenderImageSizeChanged(int renderId, QSize size)
+{
+    QMutexLocker locker(&displaySizeMutex);
+    displaySizes[renderId] = size;
+}
+
 void RenderWindow::onOutput2DUpdated(OutputData2D outputData)
 {
     RenderWidget2D* widget = qobject_cast<RenderWidget2D*>(renderWidgets[outputData.info.cameraDataType]);
@@ -247,19 +298,23 @@ void RenderWindow::onOutput2DUpdated(OutputData2D outputData)
     {
         if (!widget->isHidden())
         {
+            CS_TRACE_SCOPE_FRAME("RenderWindow::render2D", outputData.info.receivedTime);
             widget->onRenderDataUpdated(outputData);
+            cs::PipelineStats::getInstance()->recordSince(cs::STAGE_RENDER, outputData.info.receivedTime);
         }
     }
 }
 
-void RenderWindow::onOutput3DUpdated(cs::Pointcloud pointCloud, const QImage& image)
+void RenderWindow::onOutput3DUpdated(cs::Pointcloud pointCloud, const QImage& image, qint64 receivedTime)
 {
     RenderWidget3D* widget = qobject_cast<RenderWidget3D*>(renderWidgets[CAMERA_DATA_POINT_CLOUD]);
     if (widget)
     {
         if (!widget->isHidden())
         {
+            CS_TRACE_SCOPE_FRAME("RenderWindow::render3D", receivedTime);
             widget->onRenderDataUpdated(pointCloud, image);
+            cs::PipelineStats::getInstance()->recordSince(cs::STAGE_RENDER, receivedTime);
         }
     }
 }
@@ -287,6 +342,9 @@ void RenderWindow::initRenderWidgets()
         {
             auto renderWidget = new RenderWidget2D((int)dataType);
             renderWidgets[dataType] = renderWidget;
+
+            bool suc = (bool)connect(renderWidget, &RenderWidget2D::imageSizeChanged, this, &RenderWindow::onRenderImageSizeChanged);
+            Q_ASSERT(suc);
             break;
         }
         case CAMERA_DATA_DEPTH:
@@ -297,6 +355,7 @@ void RenderWindow::initRenderWidgets()
             bool suc = true;
             suc &= (bool)connect(qobject_cast<DepthRenderWidget2D*>(renderWidget), &DepthRenderWidget2D::roiRectFUpdated, this, &RenderWindow::roiRectFUpdated);
             suc &= (bool)connect(qobject_cast<DepthRenderWidget2D*>(renderWidget), &DepthRenderWidget2D::showCoordChanged, cs::CSApplication::getInstance(), &cs::CSApplication::onShowCoordChanged);
+            suc &= (bool)connect(renderWidget, &RenderWidget2D::imageSizeChanged, this, &RenderWindow::onRenderImageSizeChanged);
             Q_ASSERT(suc);
 
             break;
@@ -305,6 +364,7 @@ void RenderWindow::initRenderWidgets()
         {
             auto renderWidget = new RenderWidget3D((int)dataType, this);
             renderWidgets[dataType] = renderWidget;
+            renderWidget->setPointBudget(pointBudget);
 
             connect(renderWidget, &RenderWidget3D::show3DTextureChanged, this, &RenderWindow::onShow3DTextureChanged, Qt::QueuedConnection);
             emit renderWidget->show3DTextureChanged(false);
@@ -409,6 +469,17 @@ void RenderWindow::setShowTextureEnable(bool enable)
     showTextureEnable = enable;
 }
 
+void RenderWindow::setPointBudget(int budget)
+{
+    pointBudget = budget;
+
+    RenderWidget3D* widget = qobject_cast<RenderWidget3D*>(renderWidgets[CAMERA_DATA_POINT_CLOUD]);
+    if (widget)
+    {
+        widget->setPointBudget(budget);
+    }
+}
+
 void RenderWindow::onTranslate()
 {
     for (auto widget : renderWidgets.values())
@@ -418,4 +489,77 @@ void RenderWindow::onTranslate()
             widget->onTranslate();
         }
     }
-}
\ No newline at end of file
+}
+
+void RenderWindow::setStatsOverlayVisible(bool visible)
+{
+    if (visible)
+    {
+        lastStats = cs::CSApplication::getInstance()->getPipelineStats();
+        statsOverlay->setText(tr("Collecting statistics..."));
+        statsTimer->start();
+    }
+    else
+    {
+        statsTimer->stop();
+    }
+
+    statsOverlay->setVisible(visible);
+    statsOverlay->raise();
+    updateStatsOverlayGeometry();
+}
+
+void RenderWindow::resizeEvent(QResizeEvent* event)
+{
+    QWidget::resizeEvent(event);
+    updateStatsOverlayGeometry();
+}
+
+void RenderWindow::updateStatsOverlayGeometry()
+{
+    if (!statsOverlay->isVisible())
+    {
+        return;
+    }
+
+    statsOverlay->adjustSize();
+    statsOverlay->move(width() - statsOverlay->width() - STATS_OVERLAY_MARGIN, STATS_OVERLAY_MARGIN);
+}
+
+void RenderWindow::onStatsTimeout()
+{
+    const auto stats = cs::CSApplication::getInstance()->getPipelineStats();
+    const auto interval = stats - lastStats;
+    const double seconds = qMax<qint64>(stats.time - lastStats.time, 1) / 1e9;
+    lastStats = stats;
+
+    auto toMs = [](qint64 ns) { return QString::number(ns / 1e6, 'f', 2); };
+
+    QStringList lines;
+    lines << QString("%1%2%3%4%5").arg("stage", -18).arg("p50 ms", 9).arg("p95 ms", 9).arg("p99 ms", 9).arg("/s", 8);
+    for (int i = 0; i < cs::STAGE_COUNT; i++)
+    {
+        const auto& stage = interval.stages[i];
+        if (stage.count == 0)
+        {
+            continue;
+        }
+
+        lines << QString("%1%2%3%4%5").arg(cs::PipelineStats::getStageName(i), -18)
+            .arg(toMs(stage.percentile(50)), 9)
+            .arg(toMs(stage.percentile(95)), 9)
+            .arg(toMs(stage.percentile(99)), 9)
+            .arg(QString::number(stage.count / seconds, 'f', 1), 8);
+    }
+
+    // the drops since the last reset
+    QStringList drops;
+    for (int i = 0; i < cs::DROP_COUNT; i++)
+    {
+        drops << QString("%1 %2").arg(cs::PipelineStats::getDropName(i)).arg(stats.drops[i]);
+    }
+    lines << QString("dropped: %1").arg(drops.join(", "));
+
+    statsOverlay->setText(lines.join("\n"));
+    updateStatsOverlayGeometry();
+}
@@ -240,6 +240,71 @@
         <source>Tabs</source>
         <translation type="unfinished"></translation>
     </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Pipeline Statistics</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Point Budget</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Unlimited</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>500K Points</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>1M Points</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>2M Points</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Record trace</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Save trace...</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>Start recording the trace</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>Stop recording the trace</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>Save trace</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>The trace is saved to </source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>Failed to save the trace</source>
+        <translation type="unfinished"></translation>
+    </message>
     <message>
         <location filename="../viewerwindow.ui"/>
         <source>Tile</source>
@@ -723,6 +788,11 @@ and the image quality of objects farther away may become worse.</translation>
         <source>Save Format</source>
         <translation type="unfinished"></translation>
     </message>
+    <message>
+        <location filename="../capturesetting.ui"/>
+        <source>Binary PLY</source>
+        <translation type="unfinished"></translation>
+    </message>
 </context>
 <context>
     <name>CaptureSettingDialog</name>
@@ -921,6 +991,21 @@ and the image quality of objects farther away may become worse.</translation>
         <source>Failed to compress zip file</source>
         <translation type="unfinished"></translation>
     </message>
+    <message>
+        <location filename="../../cscamera/cameracapturetool.cpp" line="628"/>
+        <source>Failed to create zip file</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../../cscamera/cameracapturetool.cpp" line="633"/>
+        <source>Failed to create record file</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../../cscamera/cameracapturetool.cpp" line="745"/>
+        <source>Failed to save record file</source>
+        <translation type="unfinished"></translation>
+    </message>
 </context>
 <context>
     <name>CameraPlayerDialog</name>
@@ -936,6 +1021,19 @@ and the image quality of objects farther away may become worse.</translation>
         <source>Load captured file</source>
         <translation type="unfinished"></translation>
     </message>
+    <message>
+        <location filename="../cameraplayerdialog.cpp" line="44"/>
+        <location filename="../cameraplayerdialog.cpp" line="312"/>
+        <location filename="../cameraplayerdialog.cpp" line="319"/>
+        <source>Play</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../cameraplayerdialog.cpp" line="312"/>
+        <location filename="../cameraplayerdialog.cpp" line="319"/>
+        <source>Pause</source>
+        <translation type="unfinished"></translation>
+    </message>
 </context>
 <context>
     <name>cs::CameraPlayer</name>
@@ -1129,4 +1227,12 @@ and the image quality of objects farther away may become worse.</translation>
         <translation type="unfinished"></translation>
     </message>
 </context>
+<context>
+    <name>RenderWindow</name>
+    <message>
+        <location filename="../renderwindow.cpp"/>
+        <source>Collecting statistics...</source>
+        <translation type="unfinished"></translation>
+    </message>
+</context>
 </TS>
@@ -292,6 +292,71 @@
         <source>Tabs</source>
         <translation type="unfinished">选项卡</translation>
     </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Pipeline Statistics</source>
+        <translation type="unfinished">管线统计</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Point Budget</source>
+        <translation type="unfinished">点数上限</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Unlimited</source>
+        <translation type="unfinished">不限制</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>500K Points</source>
+        <translation type="unfinished">50万点</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>1M Points</source>
+        <translation type="unfinished">100万点</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>2M Points</source>
+        <translation type="unfinished">200万点</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Record trace</source>
+        <translation type="unfinished">录制跟踪</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.ui"/>
+        <source>Save trace...</source>
+        <translation type="unfinished">保存跟踪...</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>Start recording the trace</source>
+        <translation type="unfinished">开始录制跟踪</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>Stop recording the trace</source>
+        <translation type="unfinished">停止录制跟踪</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>Save trace</source>
+        <translation type="unfinished">保存跟踪</translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>The trace is saved to </source>
+        <translation type="unfinished">跟踪已保存到 </translation>
+    </message>
+    <message>
+        <location filename="../viewerwindow.cpp"/>
+        <source>Failed to save the trace</source>
+        <translation type="unfinished">保存跟踪失败</translation>
+    </message>
     <message>
         <source>Title</source>
         <translation type="obsolete">平铺</translation>
@@ -908,6 +973,11 @@ and the image quality of objects farther away may become worse.</source>
         <source>Save Format</source>
         <translation type="unfinished">保存格式</translation>
     </message>
+    <message>
+        <location filename="../capturesetting.ui"/>
+        <source>Binary PLY</source>
+        <translation type="unfinished">二进制PLY</translation>
+    </message>
 </context>
 <context>
     <name>CaptureSettingDialog</name>
@@ -1106,6 +1176,21 @@ and the image quality of objects farther away may become worse.</source>
         <source>Failed to compress zip file</source>
         <translation type="unfinished">打包为ZIP失败</translation>
     </message>
+    <message>
+        <location filename="../../cscamera/cameracapturetool.cpp" line="628"/>
+        <source>Failed to create zip file</source>
+        <translation type="unfinished">创建ZIP文件失败</translation>
+    </message>
+    <message>
+        <location filename="../../cscamera/cameracapturetool.cpp" line="633"/>
+        <source>Failed to create record file</source>
+        <translation type="unfinished">创建录制文件失败</translation>
+    </message>
+    <message>
+        <location filename="../../cscamera/cameracapturetool.cpp" line="745"/>
+        <source>Failed to save record file</source>
+        <translation type="unfinished">保存录制文件失败</translation>
+    </message>
 </context>
 <context>
     <name>CameraPlayerDialog</name>
@@ -1121,6 +1206,19 @@ and the image quality of objects farther away may become worse.</source>
         <source>Load captured file</source>
         <translation type="unfinished">加载保存的文件</translation>
     </message>
+    <message>
+        <location filename="../cameraplayerdialog.cpp" line="44"/>
+        <location filename="../cameraplayerdialog.cpp" line="312"/>
+        <location filename="../cameraplayerdialog.cpp" line="319"/>
+        <source>Play</source>
+        <translation type="unfinished">播放</translation>
+    </message>
+    <message>
+        <location filename="../cameraplayerdialog.cpp" line="312"/>
+        <location filename="../cameraplayerdialog.cpp" line="319"/>
+        <source>Pause</source>
+        <translation type="unfinished">暂停</translation>
+    </message>
 </context>
 <context>
     <name>cs::CameraPlayer</name>
@@ -1326,4 +1424,12 @@ and the image quality of objects farther away may become worse.</source>
         <translation type="unfinished">构建于 %1</translation>
     </message>
 </context>
+<context>
+    <name>RenderWindow</name>
+    <message>
+        <location filename="../renderwindow.cpp"/>
+        <source>Collecting statistics...</source>
+        <translation type="unfinished">正在统计...</translation>
+    </message>
+</context>
 </TS>
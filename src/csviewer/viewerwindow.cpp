@@ -27,9 +27,12 @@
 #include <QTranslator>
 #include <QThread>
 #include <QMessageBox>
+#include <QDateTime>
+#include <QDir>
 
 #include <cstypes.h>
 #include <icscamera.h>
+#include <cstracer.h>
 
 #include "csapplication.h"
 #include "renderwidget.h"
@@ -129,12 +132,16 @@ void ViewerWindow::initConnections()
     suc &= (bool)connect(m_ui->actionGithub,            &QAction::triggered,   this, &ViewerWindow::onTriggeredGithub);
     suc &= (bool)connect(m_ui->actionWebSite,           &QAction::triggered,   this, &ViewerWindow::onTriggeredWebsite);
     suc &= (bool)connect(m_ui->actionAbout,             &QAction::triggered,   this, &ViewerWindow::onTriggeredAbout);
+    suc &= (bool)connect(m_ui->actionRecordTrace,       &QAction::triggered,   this, &ViewerWindow::onTriggeredRecordTrace);
+    suc &= (bool)connect(m_ui->actionSaveTrace,         &QAction::triggered,   this, &ViewerWindow::onTriggeredSaveTrace);
 
     suc &= (bool)connect(m_ui->actionTile,              &QAction::triggered,   this, &ViewerWindow::onTriggeredWindowsTile);
     suc &= (bool)connect(m_ui->actionTabs,              &QAction::triggered,   this, &ViewerWindow::onTriggeredWindowsTabs);
+    suc &= (bool)connect(m_ui->actionPipelineStats,     &QAction::toggled,     m_ui->renderWindow, &RenderWindow::setStatsOverlayVisible);
 
     suc &= (bool)connect(m_ui->menuViews,  &QMenu::triggered,   this, &ViewerWindow::onWindowsMenuTriggered);
     suc &= (bool)connect(m_ui->menuAutoNameWhenCapturuing, &QMenu::triggered, this, &ViewerWindow::onAutoNameMenuTriggered);
+    suc &= (bool)connect(m_ui->menuPointBudget, &QMenu::triggered, this, &ViewerWindow::onPointBudgetMenuTriggered);
 
     suc &= (bool)connect(this, &ViewerWindow::showProgressBar, this, [=](bool show) 
         {
@@ -168,6 +175,24 @@ void ViewerWindow::initWindow()
     bool autoName = config->getAutoNameWhenCapturing();
     m_ui->actionOff->setChecked(!autoName);
     m_ui->actionOn->setChecked(autoName);
+
+    // the point budget of the 3D view, other values can be set in the config file
+    m_ui->actionPointBudgetUnlimited->setData(0);
+    m_ui->actionPointBudget500K->setData(500000);
+    m_ui->actionPointBudget1M->setData(1000000);
+    m_ui->actionPointBudget2M->setData(2000000);
+
+    const int pointBudget = config->getRenderPointBudget();
+    for (auto action : m_ui->menuPointBudget->actions())
+    {
+        action->setChecked(action->data().toInt() == pointBudget);
+    }
+    m_ui->renderWindow->setPointBudget(pointBudget);
+
+    // the trace points are not compiled
+    m_ui->actionRecordTrace->setVisible(CSTracer::isSupported());
+    m_ui->actionSaveTrace->setVisible(CSTracer::isSupported());
+    m_ui->actionRecordTrace->setChecked(CSTracer::isEnabled());
 }
 
 void ViewerWindow::onRenderPageChanged(int idx)
@@ -488,7 +513,7 @@ void ViewerWindow::onCameraStreamStarted()
     
     bool suc = true;
     suc &= (bool)connect(app, &cs::CSApplication::output3DUpdated, m_ui->renderWindow, &RenderWindow::onOutput3DUpdated, Qt::QueuedConnection);
-    suc &= (bool)connect(app, &cs::CSApplication::output2DUpdated, m_ui->renderWindow, &RenderWindow::onOutput2DUpdated, Qt::QueuedConnection);
+    suc &= (bool)connect(app, &cs::CSApplication::output2DUpdated, m_ui->renderWindow, &RenderWindow::prepareOutput2D, Qt::DirectConnection);
 
     Q_ASSERT(suc);
 
@@ -500,7 +525,7 @@ void ViewerWindow::onCameraStreamStopped()
     m_circleProgressBar->close();
     auto app = cs::CSApplication::getInstance();
     disconnect(app, &cs::CSApplication::output3DUpdated, m_ui->renderWindow, &RenderWindow::onOutput3DUpdated);
-    disconnect(app, &cs::CSApplication::output2DUpdated, m_ui->renderWindow, &RenderWindow::onOutput2DUpdated);
+    disconnect(app, &cs::CSApplication::output2DUpdated, m_ui->renderWindow, &RenderWindow::prepareOutput2D);
 }
 
 void ViewerWindow::onWindowsMenuTriggered(QAction* action)
@@ -595,7 +620,7 @@ void ViewerWindow::destoryRenderWindows()
     auto app = cs::CSApplication::getInstance();
 
     disconnect(app, &cs::CSApplication::output3DUpdated, m_ui->renderWindow, &RenderWindow::onOutput3DUpdated);
-    disconnect(app, &cs::CSApplication::output2DUpdated, m_ui->renderWindow, &RenderWindow::onOutput2DUpdated);
+    disconnect(app, &cs::CSApplication::output2DUpdated, m_ui->renderWindow, &RenderWindow::prepareOutput2D);
 
     onRenderWindowUpdated();
 }
@@ -652,6 +677,20 @@ void ViewerWindow::onAutoNameMenuTriggered(QAction* action)
     config->setAutoNameWhenCapturing(autoName);
 }
 
+void ViewerWindow::onPointBudgetMenuTriggered(QAction* action)
+{
+    for (auto item : m_ui->menuPointBudget->actions())
+    {
+        item->setChecked(item == action);
+    }
+
+    const int pointBudget = action->data().toInt();
+    m_ui->renderWindow->setPointBudget(pointBudget);
+
+    auto config = cs::CSApplication::getInstance()->getAppConfig();
+    config->setRenderPointBudget(pointBudget);
+}
+
 // If the current language is Chinese, open the Chinese manual or English manual
 void ViewerWindow::onTriggeredManual()
 {
@@ -688,6 +727,36 @@ void ViewerWindow::onTriggeredWebsite()
     QDesktopServices::openUrl(QUrl(WEBSITE_URL));
 }
 
+void ViewerWindow::onTriggeredRecordTrace(bool record)
+{
+    qInfo() << "record trace : " << record;
+    CSTracer::setEnabled(record);
+
+    onShowStatusBarMessage(record ? tr("Start recording the trace") : tr("Stop recording the trace"), 3000);
+}
+
+void ViewerWindow::onTriggeredSaveTrace()
+{
+    auto config = cs::CSApplication::getInstance()->getAppConfig();
+    QString fileName = QString("trace_%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMddhhmmss"));
+    QString filePath = QFileDialog::getSaveFileName(this, tr("Save trace"), config->getDefaultSavePath() + QDir::separator() + fileName, "JSON (*.json)");
+
+    if (filePath.isEmpty())
+    {
+        qInfo() << "Cancel save trace";
+        return;
+    }
+
+    if (CSTracer::save(filePath))
+    {
+        onShowStatusBarMessage(tr("The trace is saved to ") + filePath, 3000);
+    }
+    else
+    {
+        onShowStatusBarMessage(tr("Failed to save the trace"), 3000);
+    }
+}
+
 void ViewerWindow::closeEvent(QCloseEvent* event)
 {
     QMessageBox msgBox;